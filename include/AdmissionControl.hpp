@@ -0,0 +1,188 @@
+#ifndef ADMISSION_CONTROL_HPP
+#define ADMISSION_CONTROL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <sys/socket.h>
+
+/**
+ * @struct AdmissionSettings
+ * @brief Rate limits and budgets applied before any work is spent on a client. A rate of 0 disables its limit.
+ */
+struct AdmissionSettings {
+    int sourceRate = 0;       ///< Connections plus frames per second allowed from one source address.
+    int sourceBurst = 0;      ///< How many of them a source may send at once; 0 for sourceRate.
+    int identityRate = 0;     ///< Frames per second allowed for one chain, whichever connection carries them.
+    int identityBurst = 0;    ///< How many of them a chain may send at once; 0 for identityRate.
+    int verifyBudget = 0;     ///< Hashes that may be in flight for verification across all event loops at once.
+};
+
+/**
+ * @class AdmissionControl
+ * @brief Decides, before anything is hashed, whether a connection or frame may be processed.
+ *
+ * Each source address and each enrolled chain draws from a token bucket; a
+ * global budget caps the verification hashes in flight across event loops.
+ *
+ * Source buckets live in a fixed table of 65536 atomics updated with
+ * compare-and-swap, so the event loops of a multi-threaded server share them
+ * without a lock. They are indexed by a hash of the address mixed with a
+ * random seed, so a client cannot choose an address that lands in a given
+ * bucket. Addresses that still collide share a bucket, which can only make
+ * their limit stricter; with many thousands of active addresses some do.
+ *
+ * A chain's bucket is not kept here: it is a state word beside the chain's
+ * record (see ChainRegistry::admitFrame()), charged through admitChainFrame().
+ * Every chain therefore has a bucket of its own however many are enrolled, and
+ * only frames of a session that holds the chain are charged to it, so knowing a
+ * chain's anchor does not let anyone else drain its bucket.
+ */
+class AdmissionControl {
+public:
+    /**
+     * @struct Stats
+     * @brief What has been turned away since construction.
+     */
+    struct Stats {
+        std::uint64_t connectionsRefused = 0; ///< Connections refused by their source's bucket.
+        std::uint64_t framesLimited = 0;      ///< Frames refused by their source's or chain's bucket.
+        std::uint64_t verifiesShed = 0;       ///< Verifications refused because the budget was spent.
+    };
+
+    /**
+     * @brief Constructs an AdmissionControl. Bucket tables are only allocated for enabled limits.
+     * @param settings The limits; out-of-range values are clamped.
+     */
+    explicit AdmissionControl(const AdmissionSettings& settings = AdmissionSettings());
+
+    AdmissionControl(const AdmissionControl&) = delete;
+    AdmissionControl& operator=(const AdmissionControl&) = delete;
+
+    /**
+     * @brief Derives the key of a source from its address.
+     * @param address The raw address bytes (e.g. a 16-byte IPv6 or IPv4-mapped address).
+     * @param len The number of bytes.
+     * @return The key; never 0.
+     */
+    static std::uint64_t sourceKey(const std::uint8_t* address, std::size_t len);
+
+    /**
+     * @brief Derives the key of a peer, keying IPv4 peers by their IPv4-mapped IPv6 address.
+     * @param peer The peer address from accept().
+     * @return The key; never 0.
+     */
+    static std::uint64_t sourceKey(const sockaddr_storage& peer);
+
+    /**
+     * @brief Charges a new connection to its source.
+     * @param source The source key; 0 is never limited.
+     * @return False if the source is over its rate and the connection should be refused.
+     */
+    bool admitConnection(std::uint64_t source);
+
+    /**
+     * @brief Charges one received frame to its source.
+     * @param source The source key; 0 is never limited.
+     * @return False if the source is over its rate.
+     */
+    bool admitFrame(std::uint64_t source);
+
+    /**
+     * @brief Checks whether chains are rate limited, i.e. whether admitChainFrame() needs calling at all.
+     * @return True if identityRate is set.
+     */
+    bool limitsChains() const;
+
+    /**
+     * @brief Charges one frame to a chain's own bucket.
+     * @param bucket The chain's bucket state, zero for a full bucket; the caller guards it.
+     * @return False if the chain is over its rate; the bucket is then unchanged.
+     */
+    bool admitChainFrame(std::uint64_t& bucket);
+
+    /**
+     * @brief Reserves verification hashes from the global budget.
+     * @param hashes The number of hashes about to be computed.
+     * @return False if the budget cannot cover them; nothing is reserved then.
+     */
+    bool acquireVerify(std::uint32_t hashes);
+
+    /**
+     * @brief Returns hashes reserved with acquireVerify() once they are computed.
+     * @param hashes The number reserved.
+     */
+    void releaseVerify(std::uint32_t hashes);
+
+    /**
+     * @brief Gets what has been turned away so far.
+     * @return The counters.
+     */
+    Stats stats() const;
+
+private:
+    static constexpr std::size_t BUCKETS = std::size_t(1) << 16; ///< Buckets per table.
+
+    /**
+     * @struct Limit
+     * @brief A token bucket rate and, for sources, the table of per-key bucket states it applies to.
+     *
+     * A state packs the time of the last charge (low 32 bits, ms) and the bucket's
+     * deficit, the tokens spent and not yet refilled (high 32 bits, in 1/1000 tokens),
+     * so a zero state is a full bucket.
+     */
+    struct Limit {
+        std::uint32_t rate = 0;                               ///< Tokens per second, which is 1/1000 tokens per ms.
+        std::uint32_t capacity = 0;                           ///< The burst size, in 1/1000 tokens.
+        std::unique_ptr<std::atomic<std::uint64_t>[]> states; ///< One state per bucket; null if disabled or kept by the caller.
+    };
+
+    /**
+     * @brief Enables a limit.
+     * @param limit The limit.
+     * @param rate Tokens per second; 0 leaves it disabled.
+     * @param burst The burst size in tokens.
+     * @param table True to allocate the table of bucket states.
+     */
+    static void configure(Limit& limit, int rate, int burst, bool table);
+
+    /**
+     * @brief Computes a bucket's state after taking one token, refilling it for the time since its last charge.
+     * @param limit The limit.
+     * @param state The current state.
+     * @param now The current time in ms.
+     * @param next Receives the new state.
+     * @return False if the bucket is empty.
+     */
+    static bool charge(const Limit& limit, std::uint64_t state, std::uint32_t now, std::uint64_t& next);
+
+    /**
+     * @brief Takes one token from a key's bucket in the limit's table.
+     * @param limit The limit.
+     * @param key The key.
+     * @param now The current time in ms.
+     * @return False if the bucket is empty; nothing is taken then.
+     */
+    bool take(Limit& limit, std::uint64_t key, std::uint32_t now) const;
+
+    /**
+     * @brief Gets the time since construction, truncated to 32 bits.
+     * @return Milliseconds.
+     */
+    std::uint32_t now() const;
+
+    Limit m_source;                                      ///< Per source address.
+    Limit m_identity;                                    ///< Per chain; the states are kept with the chains.
+    std::uint64_t m_seed = 0;                            ///< Mixed into keys, so bucket indexes cannot be predicted.
+    std::int64_t m_verifyBudget = 0;                     ///< The hashes that may be in flight; 0 for no budget.
+    std::atomic<std::int64_t> m_verifyInFlight{0};       ///< The hashes currently reserved.
+    std::atomic<std::uint64_t> m_connectionsRefused{0};  ///< See Stats.
+    std::atomic<std::uint64_t> m_framesLimited{0};       ///< See Stats.
+    std::atomic<std::uint64_t> m_verifiesShed{0};        ///< See Stats.
+    std::chrono::steady_clock::time_point m_epoch;       ///< Time base of the bucket states.
+};
+
+#endif
\ No newline at end of file
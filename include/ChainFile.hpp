@@ -0,0 +1,115 @@
+#ifndef CHAIN_FILE_HPP
+#define CHAIN_FILE_HPP
+
+#include "CryptoUtils.hpp"
+#include "Digest.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @class ChainFile
+ * @brief A hash chain stored on disk and memory-mapped for O(1) link lookup.
+ *
+ * File layout (all integers little-endian):
+ *
+ *     offset  size  field
+ *          0     8  magic "LMPCHAIN"
+ *          8     4  version (1)
+ *         12     1  chain format (ChainFormat)
+ *         13     1  hash algorithm (HashAlgorithm)
+ *         14     2  record size (32)
+ *         16     8  chain length n
+ *         24    32  SHA-256 of all records
+ *         56     8  reserved, zero
+ *         64  32*n  records h_1, h_2, ..., h_n
+ *
+ * Files are streamed to disk in fixed-size chunks while they are generated, so
+ * neither generation nor lookup ever holds the chain in RAM; the page cache
+ * brings in only the links that are actually read.
+ */
+class ChainFile {
+public:
+    static constexpr std::size_t HEADER_SIZE = 64; ///< Size of the file header in bytes.
+    static constexpr std::uint32_t VERSION = 1;    ///< Current file format version.
+
+    ChainFile() = default;
+    ~ChainFile();
+
+    ChainFile(const ChainFile&) = delete;
+    ChainFile& operator=(const ChainFile&) = delete;
+    ChainFile(ChainFile&& other) noexcept;
+    ChainFile& operator=(ChainFile&& other) noexcept;
+
+    /**
+     * @brief Generates a chain from a seed and streams it to a new chain file.
+     * The file is written under a temporary name and renamed into place once complete.
+     * @param path The path of the file to create (replaced if it exists).
+     * @param seed The initial secret value (h_0).
+     * @param len The length of the chain (n), at least 1.
+     * @param chainParams The format and hash function of the chain.
+     * @param progress Optional progress callback; returning false cancels the generation.
+     * @return True on success, false if the file could not be written or the generation was cancelled.
+     */
+    static bool generate(const std::string& path, const std::string& seed, std::uint64_t len,
+                         const ChainParams& chainParams, const ChainProgress& progress = ChainProgress());
+
+    /**
+     * @brief Maps an existing chain file read-only.
+     * Only the header and the file size are checked; see verify() for the records.
+     * @param path The path of the chain file.
+     * @return True if the file is a well-formed chain file, false otherwise.
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Unmaps the file. Safe to call when nothing is open.
+     */
+    void close();
+
+    /**
+     * @brief Checks whether a chain file is mapped.
+     * @return True after a successful open().
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Recomputes the checksum over all records and compares it with the header.
+     * Reads the whole file, so it is meant for tooling rather than for every start-up.
+     * @return True if the records are intact.
+     */
+    bool verify() const;
+
+    /**
+     * @brief Gets the link at a given position of the chain.
+     * @param position The 1-based position k of the link h_k, with 1 <= k <= n.
+     * @return The link h_k.
+     */
+    Digest linkAt(std::uint64_t position) const;
+
+    /**
+     * @brief Gets the final link of the chain (h_n).
+     * @return The last link.
+     */
+    Digest lastLink() const;
+
+    /**
+     * @brief Gets the length of the chain.
+     * @return The number of links (n).
+     */
+    std::uint64_t length() const;
+
+    /**
+     * @brief Gets the format and hash function recorded in the header.
+     * @return The chain parameters.
+     */
+    ChainParams chainParams() const;
+
+private:
+    const std::uint8_t* mapping = nullptr; ///< Start of the read-only mapping (the header).
+    std::size_t mappingSize = 0;           ///< Size of the mapping in bytes.
+    std::uint64_t chainLength = 0;         ///< The length of the chain (n).
+    ChainParams params;                    ///< Format and hash function of the chain.
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef CHAIN_GENERATOR_HPP
+#define CHAIN_GENERATOR_HPP
+
+#include <QObject>
+#include <QThread>
+#include <atomic>
+#include <string>
+#include "LamportAuth.hpp"
+
+/**
+ * @class ChainGenerator
+ * @brief Builds a client's hash chain on a worker thread.
+ *
+ * Generating n links takes n hashes, which for large chains would block the
+ * event loop (and with it the GUI and all socket I/O) if done inside a slot.
+ * The generator builds a LamportAuth on its own thread, reports progress and
+ * can be cancelled; the finished chain is handed over with takeResult() once
+ * finished() has been received.
+ */
+class ChainGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @struct Request
+     * @brief The chain to build.
+     */
+    struct Request {
+        std::string seed;                            ///< The initial secret value (h_0).
+        int length = 0;                              ///< The length of the chain (n).
+        ChainParams params;                          ///< The format and hash function of the chain.
+        ChainStorage storage = ChainStorage::Full;   ///< How an in-memory chain is kept.
+        std::string chainFile;                       ///< Stream the chain to this file and map it; empty to keep it in memory.
+    };
+
+    /**
+     * @brief Constructs an idle ChainGenerator.
+     * @param parent The parent QObject, for memory management.
+     */
+    explicit ChainGenerator(QObject* parent = nullptr);
+
+    /**
+     * @brief Cancels a running generation and waits for the worker thread.
+     */
+    ~ChainGenerator();
+
+    /**
+     * @brief Starts building a chain on a worker thread.
+     * @param request The chain to build.
+     * @return False if a generation is already running.
+     */
+    bool start(const Request& request);
+
+    /**
+     * @brief Asks a running generation to stop; finished(false) follows. Does nothing when idle.
+     */
+    void cancel();
+
+    /**
+     * @brief Checks whether a generation is running.
+     * @return True between start() and the delivery of finished().
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Hands over the chain built by the last generation.
+     * @return The chain; only meaningful after finished(true).
+     */
+    LamportAuth takeResult();
+
+    /**
+     * @brief Checks whether the last generation wrote the requested chain file.
+     * @return False if the chain was kept in memory because the file could not be written.
+     */
+    bool wroteChainFile() const;
+
+signals:
+    /**
+     * @brief Emitted about every CHAIN_PROGRESS_INTERVAL links.
+     * @param done The number of links computed.
+     * @param total The length of the chain.
+     */
+    void progress(quint64 done, quint64 total);
+
+    /**
+     * @brief Emitted when the generation ends.
+     * @param ok True if the chain is complete, false if it was cancelled.
+     */
+    void finished(bool ok);
+
+private:
+    /**
+     * @brief Builds the requested chain; runs on the worker thread.
+     */
+    void run();
+
+    /**
+     * @brief Delivers the end of a generation on the generator's own thread.
+     * @param ok True if the chain is complete.
+     */
+    void onWorkerDone(bool ok);
+
+    Request m_request;                  ///< The chain being built.
+    LamportAuth m_result;               ///< The chain, written by the worker thread only while running.
+    bool m_wroteChainFile = false;      ///< Whether m_result maps the requested chain file.
+    QThread* m_thread = nullptr;        ///< The worker thread of the current or last generation.
+    bool m_running = false;             ///< True between start() and finished().
+    std::atomic<bool> m_cancel{false};  ///< Set by cancel(); polled by the progress callback.
+};
+
+#endif
\ No newline at end of file
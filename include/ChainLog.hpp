@@ -0,0 +1,121 @@
+#ifndef CHAIN_LOG_HPP
+#define CHAIN_LOG_HPP
+
+#include "ChainVerifier.hpp"
+#include "Digest.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @namespace ChainLog
+ * @brief The records describing changes to the chain registry, as logged by ChainStore and replicated to a standby.
+ *
+ * Every record is a type byte, a 32-byte anchor, a type-specific payload and a
+ * CRC-32 of all of it (integers little-endian):
+ *
+ *   - Enroll:    chain format (1), hash algorithm (1)
+ *   - Advance:   last verified link (32), last verified counter (4)
+ *   - Remove, Exhaust: nothing
+ *   - SyncBegin, SyncEnd, Heartbeat: nothing; the anchor is zero (replication only)
+ *
+ * Records are self-delimiting: the type byte determines the size.
+ */
+namespace ChainLog {
+
+    constexpr std::size_t CRC_SIZE = 4; ///< Size of the CRC trailer of a record.
+
+    /**
+     * @enum RecordType
+     * @brief The type byte of a record.
+     */
+    enum class RecordType : std::uint8_t {
+        Enroll = 1,    ///< A chain was enrolled; its verifier starts at the anchor.
+        Advance = 2,   ///< A chain's last verified link and counter moved forward.
+        Remove = 3,    ///< A chain was forgotten.
+        SyncBegin = 4, ///< The primary's full state follows, as Enroll and Advance records.
+        SyncEnd = 5,   ///< The end of the primary's full state; it replaces the standby's.
+        Heartbeat = 6, ///< The primary is alive but has nothing to send.
+        Exhaust = 7    ///< Every link of a chain was used; its anchor stays known so that it is never accepted again.
+    };
+
+    constexpr std::size_t ENROLL_RECORD_SIZE = 1 + Digest::SIZE + 2 + CRC_SIZE;       ///< Size of an Enroll record.
+    constexpr std::size_t ADVANCE_RECORD_SIZE = 1 + 2 * Digest::SIZE + 4 + CRC_SIZE;  ///< Size of an Advance record.
+    constexpr std::size_t MARKER_RECORD_SIZE = 1 + Digest::SIZE + CRC_SIZE;           ///< Size of the other records.
+    constexpr std::size_t MAX_RECORD_SIZE = ADVANCE_RECORD_SIZE;                      ///< Size of the largest record.
+
+    /**
+     * @struct Record
+     * @brief A decoded record; fields not carried by its type are left untouched.
+     */
+    struct Record {
+        RecordType type;                     ///< The record type.
+        Digest anchor;                       ///< The anchor of the chain.
+        ChainParams params;                  ///< The chain parameters (Enroll).
+        Digest link;                         ///< The last verified link (Advance).
+        std::int32_t verifiedIteration = 0;  ///< The last verified counter (Advance).
+    };
+
+    /**
+     * @brief Writes an Enroll record.
+     * @param out Buffer of at least ENROLL_RECORD_SIZE bytes.
+     * @param anchor The anchor.
+     * @param verifier The freshly enrolled verifier.
+     * @return The number of bytes written.
+     */
+    std::size_t encodeEnroll(std::uint8_t* out, const Digest& anchor, const ChainVerifier& verifier);
+
+    /**
+     * @brief Writes an Advance record.
+     * @param out Buffer of at least ADVANCE_RECORD_SIZE bytes.
+     * @param anchor The anchor.
+     * @param verifier The verifier holding the last verified link.
+     * @param verifiedIteration The challenge number of the last verified response.
+     * @return The number of bytes written.
+     */
+    std::size_t encodeAdvance(std::uint8_t* out, const Digest& anchor, const ChainVerifier& verifier,
+                              std::int32_t verifiedIteration);
+
+    /**
+     * @brief Writes a record that carries only an anchor: Remove, Exhaust, SyncBegin, SyncEnd or Heartbeat.
+     * @param out Buffer of at least MARKER_RECORD_SIZE bytes.
+     * @param type The record type.
+     * @param anchor The anchor, or a zero digest for the replication-only types.
+     * @return The number of bytes written.
+     */
+    std::size_t encodeMarker(std::uint8_t* out, RecordType type, const Digest& anchor = Digest());
+
+    /**
+     * @brief Gets the size of a record from its type byte.
+     * @param type The first byte of the record.
+     * @return The record size, or 0 if the type is unknown.
+     */
+    std::size_t recordSize(std::uint8_t type);
+
+    /**
+     * @brief Decodes a complete record.
+     * @param data The record; at least recordSize(data[0]) bytes.
+     * @param record Receives the decoded fields.
+     * @return False if the CRC does not match or the chain parameters are unknown.
+     */
+    bool decode(const std::uint8_t* data, Record& record);
+
+    /**
+     * @brief Computes the CRC-32 (IEEE 802.3) of a buffer, continuing from a previous value.
+     * @param data The bytes.
+     * @param size The number of bytes.
+     * @param crc The CRC of the bytes before, or 0.
+     * @return The CRC.
+     */
+    std::uint32_t crc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc = 0);
+
+    /**
+     * @brief Decodes stored chain parameters, accepting only known values.
+     * @param format The stored ChainFormat.
+     * @param algorithm The stored HashAlgorithm.
+     * @param params Receives the parameters.
+     * @return True if both are known.
+     */
+    bool decodeParams(std::uint8_t format, std::uint8_t algorithm, ChainParams& params);
+}
+
+#endif
@@ -0,0 +1,279 @@
+#ifndef CHAIN_REGISTRY_HPP
+#define CHAIN_REGISTRY_HPP
+
+#include "AdmissionControl.hpp"
+#include "ChainLog.hpp"
+#include "ChainStore.hpp"
+#include "ChainVerifier.hpp"
+#include "ReplicationSender.hpp"
+#include "SessionTable.hpp"
+#include "VerifierTable.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @struct ChainRecord
+ * @brief The server's lasting state of one enrolled chain, kept across connections.
+ */
+struct ChainRecord {
+    ChainVerifier verifier;              ///< Chain parameters and last verified link.
+    std::int32_t verifiedIteration = 0;  ///< The challenge number of the last verified response.
+    SessionId owner = 0;                 ///< The session using the chain, if attached.
+    bool attached = false;               ///< True while a connected session uses the chain.
+};
+
+/**
+ * @class ChainRegistry
+ * @brief Every enrolled chain, looked up by its anchor h_n, so that a client can resume after reconnecting.
+ *
+ * A chain is enrolled once; afterwards it can only be resumed, by one session at a
+ * time, from its last verified counter. Re-enrolling a known anchor would reset its
+ * verifier and allow replaying OTPs already seen, so it is refused. For the same
+ * reason a chain whose links are all used is never forgotten: it stays as an
+ * exhausted tombstone, which refuses both Enroll and Resume. The lasting
+ * state of every chain is a fixed-width record in a VerifierTable, addressed by
+ * its record number; sessions hold the number of their chain. Which session a
+ * chain is attached to is kept beside the table, since it does not outlive the process.
+ *
+ * One registry can be shared by the event loops of a multi-threaded server: a
+ * client resumes its chain whichever loop the kernel hands its new connection
+ * to. The lock is split so that the loops do not queue behind each other on
+ * every verification: the table's layout has a shared lock, taken exclusively
+ * only to enroll, remove or replace chains, and the contents of the records are
+ * guarded by striped locks picked by record number. Advancing, attaching or
+ * exhausting a chain takes the layout lock shared and its record's stripe.
+ *
+ * With persist(), every enrollment, advance, exhaustion and removal is also logged to a
+ * ChainStore while the chain's locks are held, so each chain's log order matches the
+ * registry's, and the registry survives a server restart. The table is authoritative and
+ * serves as the store's snapshot: at startup only the log written since its last
+ * checkpoint is replayed onto it. save() returns the log position of the advance, which
+ * an event loop compares with durablePosition() before it challenges the chain again; it
+ * learns of each sync through watchDurable(). With replicate(), the same changes
+ * are streamed to a hot standby, which applies them with apply() and replaceAll().
+ */
+class ChainRegistry {
+public:
+    static constexpr std::uint32_t NONE = VerifierTable::NONE; ///< "No chain" index.
+
+    /**
+     * @brief Keeps the records in a memory-mapped table file instead of anonymous memory.
+     * Call before persist() and before the registry is shared; chains in the file start out detached.
+     * @param path The table file; created if missing.
+     * @param capacity The record capacity of a new file; the table grows when it is full.
+     * @return False if the file cannot be used; the registry is then empty and in memory only.
+     */
+    bool map(const std::string& path, std::uint32_t capacity);
+
+    /**
+     * @brief Replays a store directory's log onto the table and logs every later change to it.
+     * Call after map(), if at all, and before the registry is shared; recovered chains start
+     * out detached. Without a mapped file, the table is kept in the store directory.
+     * @param directory The store directory; created if missing.
+     * @param snapshotEvery How many log records may accumulate before the table is checkpointed and the log cut.
+     * @return False if the store cannot be opened, or its log does not reach back to the table's
+     *         last checkpoint; the registry is then not persisted.
+     */
+    bool persist(const std::string& directory, std::uint64_t snapshotEvery);
+
+    /**
+     * @brief Streams every later change to a standby listening on a Unix socket.
+     * Each time the standby connects it is first sent every chain.
+     * @param socketPath The standby's socket; the sender keeps reconnecting to it.
+     */
+    void replicate(const std::string& socketPath);
+
+    /**
+     * @brief Applies a change replicated from the primary: an Enroll, Advance, Exhaust or Remove record.
+     * Used by a standby before it takes over; the change is persisted but not replicated further.
+     * @param record The record.
+     */
+    void apply(const ChainLog::Record& record);
+
+    /**
+     * @brief Replaces every chain with the primary's full state. Used by a standby, like apply().
+     * @param replacement Every chain of the primary.
+     */
+    void replaceAll(const std::vector<ChainStore::Entry>& replacement);
+
+    /**
+     * @brief Registers a new chain attached to a session.
+     * @param anchor The anchor h_n; identifies the chain.
+     * @param verifier The freshly enrolled verifier.
+     * @param owner The session enrolling it.
+     * @return The record index, or NONE if the anchor is already known.
+     */
+    std::uint32_t enroll(const Digest& anchor, const ChainVerifier& verifier, SessionId owner);
+
+    /**
+     * @brief Attaches a known, currently unattached chain to a session.
+     * @param anchor The anchor the chain was enrolled with.
+     * @param owner The resuming session.
+     * @return The record index, or NONE if the chain is unknown, exhausted or in use by another session.
+     */
+    std::uint32_t attach(const Digest& anchor, SessionId owner);
+
+    /**
+     * @brief Detaches a chain from its session, keeping it for a later resume.
+     * @param index The record index; NONE is ignored.
+     */
+    void detach(std::uint32_t index);
+
+    /**
+     * @brief Marks a chain as used up and detaches it. Its record is kept, so that its
+     * anchor can be neither enrolled nor resumed again.
+     * @param index The record index; NONE is ignored.
+     */
+    void exhaust(std::uint32_t index);
+
+    /**
+     * @brief Forgets a chain, making its anchor enrollable again.
+     * @param index The record index; NONE is ignored.
+     */
+    void remove(std::uint32_t index);
+
+    /**
+     * @brief Charges one frame of an attached chain to the chain's own rate limit.
+     * @param index The record index; NONE is never limited.
+     * @param admission The limits; the bucket state is kept with the chain's attachment.
+     * @return False if the chain is over its rate.
+     */
+    bool admitFrame(std::uint32_t index, AdmissionControl& admission);
+
+    /**
+     * @brief Gets a copy of a record.
+     * @param index A valid record index.
+     * @return The record.
+     */
+    ChainRecord load(std::uint32_t index) const;
+
+    /**
+     * @brief Records the progress of an attached chain.
+     * @param index A valid record index.
+     * @param verifier The verifier holding the last verified link.
+     * @param verifiedIteration The challenge number of the last verified response.
+     * @return The store's log position after the advance; 0 when not persisted.
+     */
+    std::uint64_t save(std::uint32_t index, const ChainVerifier& verifier, std::int32_t verifiedIteration);
+
+    /**
+     * @brief Gets the store's log position after everything logged so far, e.g. a resumed chain's last advance.
+     * @return The position; 0 when not persisted.
+     */
+    std::uint64_t logPosition() const;
+
+    /**
+     * @brief Gets how far the store's log is on disk. Lock-free.
+     * @return The position, to compare with those of save() and logPosition(); every position is
+     *         durable when not persisted.
+     */
+    std::uint64_t durablePosition() const;
+
+    /**
+     * @brief Registers a function to call, from the store's flusher thread, whenever durablePosition() moves.
+     * May be called whether or not the registry is persisted yet.
+     * @param owner Identifies the listener for unwatchDurable().
+     * @param listener The function; it must not block.
+     */
+    void watchDurable(const void* owner, std::function<void()> listener);
+
+    /**
+     * @brief Removes the listeners of an owner; none of them runs any more once this returns.
+     * @param owner The owner given to watchDurable().
+     */
+    void unwatchDurable(const void* owner);
+
+    /**
+     * @brief Gets the number of known chains.
+     * @return The chain count.
+     */
+    std::size_t size() const;
+
+private:
+    /**
+     * @struct Attachment
+     * @brief Which session, if any, uses a chain.
+     */
+    struct Attachment {
+        SessionId owner = 0;        ///< The session using the chain, if attached.
+        bool attached = false;      ///< True while a connected session uses the chain.
+        std::uint64_t bucket = 0;   ///< The chain's AdmissionControl token bucket state; zero is full.
+    };
+
+    /**
+     * @brief Applies a record replayed from the store. The table may already be ahead of it,
+     * so changes only move a chain forward: a known anchor is not re-enrolled nor its counter lowered.
+     * @param record The record.
+     */
+    void replay(const ChainLog::Record& record);
+
+    /**
+     * @brief Syncs the table file and records a store segment as its checkpoint; runs on the store's flusher thread.
+     * @param segment The segment the store has just started; every change logged before it is in the table.
+     * @return False if the file could not be synced, or grew into a new file meanwhile.
+     */
+    bool checkpoint(std::uint64_t segment);
+
+    /**
+     * @brief Copies every live chain. Called with the layout lock held exclusively.
+     * @return The chains.
+     */
+    std::vector<ChainStore::Entry> entries() const;
+
+    /**
+     * @brief Hands every chain to the replication sender, for a standby that has just connected.
+     */
+    void resyncReplica();
+
+    /**
+     * @brief Gets the lock of a record's stripe.
+     * @param number The record number.
+     * @return The lock guarding the record's contents and attachment.
+     */
+    std::mutex& stripeOf(std::uint32_t number) const;
+
+    /**
+     * @brief Grows the attachments to cover every record number of the table.
+     */
+    void coverTable();
+
+    /**
+     * @brief Stores a verifier and counter in a table record.
+     * @param number The record number.
+     * @param verifier The verifier.
+     * @param verifiedIteration The last verified challenge number.
+     */
+    void storeRecord(std::uint32_t number, const ChainVerifier& verifier, std::int32_t verifiedIteration);
+
+    /**
+     * @brief Adds a stored chain to the table: recovered from the store or received from the primary.
+     * @param entry The chain.
+     */
+    void insertEntry(const ChainStore::Entry& entry);
+
+    /**
+     * @struct Stripe
+     * @brief One of the locks over record contents, on a cache line of its own.
+     */
+    struct alignas(64) Stripe {
+        std::mutex lock;   ///< Guards the records whose number falls on this stripe.
+    };
+
+    static constexpr std::size_t STRIPES = 64;   ///< The number of record locks.
+
+    VerifierTable table;                  ///< The lasting state of every chain.
+    std::vector<Attachment> attachments;  ///< The attachment of each record number.
+    ChainStore store;                     ///< The on-disk log, when persisted.
+    bool replicating = false;             ///< True once replicate() has started the sender.
+    mutable std::shared_mutex layout;     ///< Guards the table's index and mapping and the attachments' size.
+    mutable std::array<Stripe, STRIPES> stripes; ///< Guard the records and attachments, by record number.
+    ReplicationSender replica;            ///< Streams changes to a standby; declared last, so its thread stops first.
+};
+
+#endif
\ No newline at end of file
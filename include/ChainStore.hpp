@@ -0,0 +1,263 @@
+#ifndef CHAIN_STORE_HPP
+#define CHAIN_STORE_HPP
+
+#include "ChainLog.hpp"
+#include "ChainVerifier.hpp"
+#include "Digest.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @class ChainStore
+ * @brief Keeps the server's enrolled chains on disk: a write-ahead log with group commit, checkpointed into the registry's table.
+ *
+ * Every enrollment, verified advance, exhaustion and removal is appended to an in-memory
+ * buffer; a flusher thread writes whatever has accumulated to the current log
+ * segment and syncs it with one fdatasync(), at most one per millisecond, so
+ * sessions on all event loops share each sync and the event loops never wait
+ * for the disk. An advance is durable about one sync after it was verified.
+ * Each append returns the log position it ends at, and the server holds back
+ * the challenges that follow an advance until durablePosition() has reached
+ * it; listeners registered with watchDurable() are called after every synced
+ * batch, so the event loops know when to look. A crash can thus roll a chain
+ * back over at most pipelineDepth revealed links: the replay window documented
+ * with chainStoreDir.
+ *
+ * Files in the store's directory (all integers little-endian):
+ *
+ *     chains-<seq>.wal   log segment: 16-byte header ("LMPWAL\0\0", version), then records
+ *
+ * Log records are ChainLog records; replay stops at the first torn or corrupt record.
+ * The snapshot is the registry's VerifierTable file, which holds every change
+ * logged before its log segment once synced. Recovery replays segments
+ * <seg>, <seg>+1, ... onto the table in order. Once a log has grown by
+ * snapshotEvery records, the flusher starts a new segment and asks the registry
+ * to checkpoint: sync its table and record the new segment in it. The segments
+ * before it are then deleted. Nothing is copied, and the event loops go on
+ * verifying meanwhile. Segments written since the table took over are numbered
+ * from 1, so a table marked 0 has never been checkpointed.
+ *
+ * Stores written before the table took over kept a chains.snap snapshot (header
+ * "LMPSNAP\0", version, seq, count; entries; CRC-32); it is replayed once into a
+ * table that has never been checkpointed, then deleted.
+ */
+class ChainStore {
+public:
+    /**
+     * @struct Entry
+     * @brief The persistent state of one chain.
+     */
+    struct Entry {
+        Digest anchor;                       ///< The anchor h_n the chain was enrolled with.
+        ChainVerifier verifier;              ///< Chain parameters and last verified link.
+        std::int32_t verifiedIteration = 0;  ///< The challenge number of the last verified response.
+        bool exhausted = false;              ///< True once every link is used; the anchor is then only kept to be refused.
+    };
+
+    /**
+     * @brief Called with every recovered record, in log order.
+     */
+    typedef std::function<void(const ChainLog::Record& record)> Replay;
+
+    /**
+     * @brief Called after a new segment was started: must sync the table, so that it holds every change
+     * logged before the segment, then record the segment in it. Returns false if that failed.
+     */
+    typedef std::function<bool(std::uint64_t segment)> Checkpoint;
+
+    /**
+     * @brief A function called after every synced batch, with the object that registered it.
+     */
+    typedef std::pair<const void*, std::function<void()>> Listener;
+
+    ChainStore() = default;
+
+    /**
+     * @brief Flushes everything appended and stops the flusher thread.
+     */
+    ~ChainStore();
+
+    ChainStore(const ChainStore&) = delete;
+    ChainStore& operator=(const ChainStore&) = delete;
+
+    /**
+     * @brief Opens a store, replaying the log behind the table, and starts the flusher thread.
+     * The replayed state is checkpointed right away, so every run starts on a short log. The directory
+     * stays under an exclusive flock until close(), so two processes never share a store.
+     * @param directory The directory of the store; created if missing.
+     * @param snapshotEvery How many log records may accumulate before a checkpoint; at least 1.
+     * @param firstSegment The table's log segment: the first segment to replay.
+     * @param replay Receives every record from that segment on.
+     * @param checkpoint Syncs the table; called by open() and then from the flusher thread.
+     * @return False if the directory or the files in it cannot be used, if another process holds the
+     *         directory, or if the log no longer
+     *         reaches back to @p firstSegment, i.e. the table is not this store's.
+     */
+    bool open(const std::string& directory, std::uint64_t snapshotEvery, std::uint64_t firstSegment,
+              const Replay& replay, Checkpoint checkpoint);
+
+    /**
+     * @brief Writes out and syncs everything appended, then stops the flusher thread. Safe to call when closed.
+     */
+    void close();
+
+    /**
+     * @brief Checks whether the store is open.
+     * @return True between a successful open() and close().
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Logs a newly enrolled chain.
+     * @param anchor The anchor.
+     * @param verifier The freshly enrolled verifier.
+     */
+    void logEnroll(const Digest& anchor, const ChainVerifier& verifier);
+
+    /**
+     * @brief Logs a chain's progress after a successful verification.
+     * @param anchor The anchor.
+     * @param verifier The verifier holding the last verified link.
+     * @param verifiedIteration The challenge number of the last verified response.
+     * @return The log position the record ends at; the advance is on disk once durablePosition() reaches it.
+     */
+    std::uint64_t logAdvance(const Digest& anchor, const ChainVerifier& verifier, std::int32_t verifiedIteration);
+
+    /**
+     * @brief Logs that every link of a chain was used.
+     * @param anchor The anchor.
+     */
+    void logExhaust(const Digest& anchor);
+
+    /**
+     * @brief Logs that a chain was forgotten.
+     * @param anchor The anchor.
+     */
+    void logRemove(const Digest& anchor);
+
+    /**
+     * @brief Waits until everything appended so far has been synced to disk.
+     * @return False if the store failed to write.
+     */
+    bool sync();
+
+    /**
+     * @brief Gets the log position after the last record appended.
+     * @return The position; 0 before anything is appended.
+     */
+    std::uint64_t appendedPosition() const;
+
+    /**
+     * @brief Gets the log position up to which every record is synced. Lock-free, for the event loops.
+     * @return The position; UINT64_MAX once the store has failed and no longer logs anything.
+     */
+    std::uint64_t durablePosition() const;
+
+    /**
+     * @brief Registers a function the flusher calls after each synced batch. It must not block or call into
+     * the store; an event loop uses it to wake itself and release the challenges it held back.
+     * @param owner Identifies the listener for unwatchDurable().
+     * @param listener The function; called from the flusher thread.
+     */
+    void watchDurable(const void* owner, std::function<void()> listener);
+
+    /**
+     * @brief Removes the listeners registered by an owner. Once it returns, they are not running and
+     * will not be called again.
+     * @param owner The owner given to watchDurable().
+     */
+    void unwatchDurable(const void* owner);
+
+private:
+    /**
+     * @brief Appends one encoded record to the pending buffer and wakes the flusher.
+     * @param record The record.
+     * @param size The size of the record.
+     * @return The log position after the record; 0 once the store has failed.
+     */
+    std::uint64_t append(const std::uint8_t* record, std::size_t size);
+
+    /**
+     * @brief Replays the log segments of the directory from a segment on, and sets m_segment past them.
+     * @param firstSegment The first segment to replay.
+     * @param replay Receives the records.
+     * @return False if a file cannot be read or a segment is missing.
+     */
+    bool recover(std::uint64_t firstSegment, const Replay& replay);
+
+    /**
+     * @brief Replays a snapshot left by an older store as records, for a table never checkpointed.
+     * @param replay Receives an Enroll, an Advance and possibly an Exhaust record per chain.
+     * @param seq Receives the first segment after the snapshot; left alone without one.
+     * @return False if the snapshot is corrupt.
+     */
+    bool replayOldSnapshot(const Replay& replay, std::uint64_t& seq);
+
+    /**
+     * @brief Closes the descriptor that holds the directory's lock, if any.
+     */
+    void releaseDirectory();
+
+    /**
+     * @brief Creates log segment m_segment and makes it current.
+     * @return False on an I/O error.
+     */
+    bool openSegment();
+
+    /**
+     * @brief Deletes the log segments before a sequence number.
+     * @param seq The first segment to keep.
+     * @return The lowest segment number seen, kept or not; UINT64_MAX if there is none.
+     */
+    std::uint64_t removeSegmentsBefore(std::uint64_t seq);
+
+    /**
+     * @brief Gets the path of a log segment.
+     * @param seq The segment's sequence number.
+     * @return The path.
+     */
+    std::string segmentPath(std::uint64_t seq) const;
+
+    /**
+     * @brief Starts a new segment and checkpoints the table at it; called by the flusher after a synced batch.
+     * @return False if the new segment cannot be created; a failed checkpoint only keeps the old segments.
+     */
+    bool rotate();
+
+    /**
+     * @brief The flusher thread: writes and syncs pending records, and checkpoints every snapshotEvery records.
+     */
+    void run();
+
+    std::string m_directory;                  ///< The directory of the store.
+    std::uint64_t m_snapshotEvery = 0;        ///< Records between checkpoints.
+    Checkpoint m_checkpoint;                  ///< Syncs the table; called by the flusher.
+    int m_fd = -1;                            ///< The current log segment; used by the flusher only.
+    int m_directoryLock = -1;                 ///< The directory, flocked from open() to close().
+    std::uint64_t m_segment = 0;              ///< The sequence number of the current segment.
+
+    mutable std::mutex m_lock;                ///< Guards the members below.
+    std::condition_variable m_wake;           ///< Wakes the flusher.
+    std::condition_variable m_synced;         ///< Wakes sync() callers.
+    std::vector<std::uint8_t> m_pending;      ///< Records appended since the last hand-over to the flusher.
+    std::uint64_t m_appended = 0;             ///< Bytes appended since open().
+    std::atomic<std::uint64_t> m_durable{0};  ///< Bytes synced since open(); read without the lock by durablePosition().
+    bool m_stopping = false;                  ///< Set by close().
+    bool m_failed = false;                    ///< Set on the first I/O error; later records are dropped.
+
+    std::atomic<std::uint64_t> m_recordsSinceSnapshot{0}; ///< Records logged since the last checkpoint.
+    std::thread m_flusher;                    ///< The flusher thread, while open.
+
+    std::mutex m_listenerLock;                ///< Guards m_listeners; held while they are called.
+    std::vector<Listener> m_listeners;        ///< Called after each synced batch.
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef CHAIN_TRAVERSER_HPP
+#define CHAIN_TRAVERSER_HPP
+
+#include "CryptoUtils.hpp"
+#include "Digest.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class ChainTraverser
+ * @brief Walks a hash chain backwards while storing only O(log n) links.
+ *
+ * Lamport OTPs are revealed in the reverse order of generation (h_{n-1}, h_{n-2}, ...).
+ * Instead of keeping all n links, the traverser keeps a stack of checkpoints
+ * ("pebbles") at successively halved distances below the next link to be revealed.
+ * Reaching a link hashes forward from the nearest checkpoint, dropping new
+ * checkpoints halfway each time, which costs O(log n) hashes per link amortised
+ * over a full backwards traversal and never more than log2(n) + 1 stored links.
+ */
+class ChainTraverser {
+public:
+    /**
+     * @brief Computes h_n and lays down the checkpoints needed for h_{n-1}.
+     * @param seed The initial secret value (h_0).
+     * @param len The length of the chain (n).
+     * @param chainParams The format and hash function of the chain.
+     * @param progress Optional progress callback; returning false cancels the walk.
+     * @return False if cancelled; the traverser is then empty.
+     */
+    bool init(const std::string& seed, std::uint64_t len, const ChainParams& chainParams,
+              const ChainProgress& progress = ChainProgress());
+
+    /**
+     * @brief Gets the link at a given position of the chain.
+     * Requests for decreasing positions are served in O(log n) amortised hashes.
+     * Going back up the chain is supported but costs a forward walk from the nearest checkpoint.
+     * @param position The 1-based position k of the link h_k, with 1 <= k <= n.
+     * @return The link h_k.
+     */
+    Digest linkAt(std::uint64_t position);
+
+    /**
+     * @brief Gets the final link of the chain (h_n).
+     * @return The last link.
+     */
+    Digest lastLink() const;
+
+    /**
+     * @brief Gets the length of the chain.
+     * @return The number of links (n).
+     */
+    std::uint64_t length() const;
+
+    /**
+     * @brief Gets the number of checkpoints currently stored.
+     * @return The size of the checkpoint stack.
+     */
+    std::size_t checkpointCount() const;
+
+private:
+    /**
+     * @brief A stored link together with its position in the chain.
+     */
+    struct Pebble {
+        std::uint64_t position; ///< The position k of the stored link.
+        Digest value;           ///< The link h_k.
+    };
+
+    /**
+     * @brief Gets the position of the next checkpoint between a stored link and a target.
+     * @param from The position of the highest checkpoint below the target.
+     * @param target The position being walked to.
+     * @return The midpoint, rounded up, so that the remaining distance halves.
+     */
+    static std::uint64_t midpoint(std::uint64_t from, std::uint64_t target);
+
+    /**
+     * @brief Computes h_n, keeping the checkpoints for h_{n-1}, with a compile-time hash policy.
+     * @param link h_1.
+     * @param progress Optional progress callback.
+     * @return False if cancelled.
+     */
+    template <typename Hash>
+    bool walkToEnd(Digest link, const ChainProgress& progress);
+
+    /**
+     * @brief Pushes checkpoints from the top of the stack up to a target, with a compile-time hash policy.
+     * @param position The target position.
+     */
+    template <typename Hash>
+    void walkTo(std::uint64_t position);
+
+    std::vector<Pebble> pebbles;            ///< Checkpoints, with increasing positions; pebbles[0] is h_1.
+    Digest last;                            ///< The final link h_n.
+    std::uint64_t chainLength = 0;          ///< The length of the chain (n).
+    ChainParams params;                     ///< How links are derived from each other.
+};
+
+#endif
\ No newline at end of file
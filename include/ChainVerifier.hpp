@@ -0,0 +1,91 @@
+#ifndef CHAIN_VERIFIER_HPP
+#define CHAIN_VERIFIER_HPP
+
+#include "CryptoUtils.hpp"
+#include "Digest.hpp"
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * @class ChainVerifier
+ * @brief The server-side (Alice) state of one Lamport chain: its parameters and last verified link.
+ *
+ * A verifier is a small fixed-size value with no heap members, so many of them can
+ * be kept inline in a session table.
+ */
+class ChainVerifier {
+public:
+    /**
+     * @brief Stores the anchor (h_n) of a chain, replacing any previous state.
+     * @param chainParams The format and hash function announced by the client.
+     * @param anchor The last link of the chain, or the last verified link when resuming.
+     */
+    void enroll(const ChainParams& chainParams, const Digest& anchor);
+
+    /**
+     * @brief Checks whether an anchor has been stored.
+     * @return True after enroll().
+     */
+    bool isEnrolled() const;
+
+    /**
+     * @brief Gets the last successfully verified link (initially the anchor).
+     * @return The last verified link h_i.
+     */
+    const Digest& lastVerifiedHash() const;
+
+    /**
+     * @brief Gets the format and hash function of the chain.
+     * @return The chain parameters.
+     */
+    const ChainParams& chainParams() const;
+
+    /**
+     * @brief Verifies a received OTP: accepts it if H(response) equals the last verified link.
+     * @param response The OTP (h_{i-1}) received from the client.
+     * @return True if the OTP is valid; the verifier then advances to it.
+     */
+    bool verify(const Digest& response);
+
+    /**
+     * @brief Verifies a received OTP that may be up to @p window links behind the last verified link.
+     * @param response The OTP received from the client.
+     * @param window The largest number of hashes to try; 1 is the same as verify(response).
+     * @param offset Receives the number of positions advanced on success, 0 otherwise.
+     * @return True if the OTP is valid within the window.
+     */
+    bool verify(const Digest& response, int window, int& offset);
+
+    /**
+     * @brief Verifies consecutive OTPs of one chain in order, as received from a pipelined client.
+     * responses[0] must hash to the last verified link and each later response to the one before it.
+     * These checks are independent, so all responses are hashed together by the multi-buffer kernel.
+     * @param responses Array of @p count OTPs, h_{i-1}, h_{i-2}, ...
+     * @param count The number of OTPs; at most MAX_SEQUENCE.
+     * @return The number of leading OTPs that verified; the verifier advances past them.
+     */
+    std::size_t verifySequence(const Digest* responses, std::size_t count);
+
+    static constexpr std::size_t MAX_SEQUENCE = 64; ///< Largest batch accepted by verifySequence().
+
+    /**
+     * @brief Verifies one pending OTP for each of several independent verifiers.
+     * Responses are grouped by chain parameters and hashed together by the multi-buffer
+     * kernel in fixed-size stack chunks; no heap memory is used.
+     * @param verifiers Array of @p count verifiers.
+     * @param responses Array of @p count OTPs; responses[i] is checked against verifiers[i].
+     * @param count The number of verifiers.
+     * @param results Receives @p count results, true where the OTP was valid.
+     */
+    static void verifyBatch(ChainVerifier* const* verifiers, const Digest* responses,
+                            std::size_t count, bool* results);
+
+private:
+    Digest lastVerified;      ///< The last successfully verified link (h_i).
+    ChainParams params;       ///< Format and hash function of the chain.
+    bool enrolled = false;    ///< True once the anchor has been stored.
+};
+
+static_assert(std::is_trivially_copyable<ChainVerifier>::value, "ChainVerifier must stay a plain value");
+
+#endif
@@ -4,9 +4,11 @@
 #include <QObject>
 #include <QTcpSocket>
 #include <QHostAddress>
+#include "ChainGenerator.hpp"
 #include "ConfigManager.hpp"
 #include "LamportAuth.hpp"
 #include "CryptoUtils.hpp"
+#include "Protocol.hpp"
 
 /**
  * @class Client
@@ -14,7 +16,11 @@
  *
  * This class handles connecting to the server, generating the Lamport hash chain,
  * sending the initial hash, and responding to authentication challenges with the
- * appropriate one-time passwords (OTPs).
+ * appropriate one-time passwords (OTPs). The chain is kept across reconnects (and,
+ * with clientStateFile, across restarts), so a reconnect resumes it from the last
+ * verified counter instead of enrolling a new one. Chains are generated on a worker
+ * thread (see ChainGenerator) while the connection is being set up, so the client
+ * stays responsive and sends h_n as soon as it is known.
  */
 class Client : public QObject
 {
@@ -62,6 +68,19 @@ private slots:
      */
     void onReadyRead();
 
+    /**
+     * @brief Logs the progress of the chain generation in steps of 10%.
+     * @param done The number of links computed.
+     * @param total The length of the chain.
+     */
+    void onChainProgress(quint64 done, quint64 total);
+
+    /**
+     * @brief Takes over the chain built by the generator and starts the handshake if connected.
+     * @param ok False if the generation was cancelled.
+     */
+    void onChainGenerated(bool ok);
+
 signals:
     // --- Signals to communicate with the UI (MainWindow) ---
 
@@ -90,22 +109,66 @@ private:
     void startClient();
 
     /**
-     * @brief Serializes an integer into a QByteArray.
-     * @param source The integer to serialize.
-     * @return The resulting QByteArray.
+     * @brief Starts generating a new chain in the background, or maps a pre-generated chain file.
+     */
+    void createChain();
+
+    /**
+     * @brief Marks the current chain as ready, saves the client state and starts the handshake if connected.
+     */
+    void finishChain();
+
+    /**
+     * @brief Sends Resume for a chain the server already knows, or Enroll for a new one.
      */
-    QByteArray IntToArray(qint32 source);
+    void sendHandshake();
 
     /**
-     * @brief Deserializes a QByteArray into an integer.
-     * @param input The QByteArray to deserialize.
-     * @return The resulting integer.
+     * @brief Sends the anchor (h_n) and chain parameters of the current chain.
      */
-    int getNumberFromQByteArray(const QByteArray& input);
+    void sendEnrollment();
 
-    QTcpSocket* m_socket;   ///< The TCP socket for communication with the server.
-    ConfigManager m_config; ///< Manages configuration data.
-    LamportAuth m_auth;     ///< Handles Lamport authentication logic.
+    /**
+     * @brief Gets the chain format and hash function selected in the configuration.
+     * @return The chain parameters.
+     */
+    ChainParams configuredChainParams();
+
+    /**
+     * @brief Writes the chain's seed, parameters, anchor and last answered challenge to clientStateFile.
+     */
+    void saveState();
+
+    /**
+     * @brief Restores the chain saved in clientStateFile, if any.
+     * @return True if the chain was restored or is being rebuilt in the background.
+     */
+    bool restoreState();
+
+    /**
+     * @brief Handles one frame received from the server, queueing the response to a challenge.
+     * @param frame The frame.
+     * @param challengeNumber Receives the challenge answered, or 0 if the frame was ignored.
+     * @return False on a protocol error, true otherwise.
+     */
+    bool handleFrame(const Protocol::Frame& frame, int& challengeNumber);
+
+    QTcpSocket* m_socket;            ///< The TCP socket for communication with the server.
+    ConfigManager m_config;          ///< Manages configuration data.
+    LamportAuth m_auth;              ///< Handles Lamport authentication logic.
+    Protocol::FrameParser m_parser;  ///< Reassembles frames from the server's byte stream.
+    std::uint8_t m_readBuffer[4096]; ///< Receives socket data before it is parsed.
+    ChainGenerator* m_generator;     ///< Builds chains on a worker thread.
+    bool m_chainReady = false;       ///< True once a chain has been generated or restored.
+    bool m_enrolled = false;         ///< True once the chain's anchor has been sent, so that it is resumed instead.
+    bool m_restoring = false;        ///< True while the generator rebuilds the chain saved in the state file.
+    int m_restoredChallenge = 0;     ///< The last answered challenge read from the state file.
+    int m_progressStep = 0;          ///< The last 10% step of the generation that was logged.
+    Digest m_anchor;                 ///< The anchor (h_n) the chain was enrolled with; identifies it to the server.
+    QString m_seed;                  ///< The chain's seed, saved to the state file; empty for pre-generated chain files.
+    int m_lastChallenge = 0;         ///< The highest challenge answered.
+    bool m_resuming = false;         ///< True while waiting for the answer to a Resume frame.
+    bool m_stopping = false;         ///< Set by stopClient(); suppresses the reconnect.
 };
 
 #endif // CLIENT_HPP
\ No newline at end of file
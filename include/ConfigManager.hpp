@@ -1,24 +1,21 @@
 #ifndef CONFIG_MANAGER_HPP
 #define CONFIG_MANAGER_HPP
 
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonValue>
-#include <QFile>
+#include "ConfigSnapshot.hpp"
 #include <QString>
-#include <QDebug>
 
 /**
  * @class ConfigManager
  * @brief Handles loading and accessing configuration settings from a JSON file.
  *
- * This class parses a JSON configuration file upon construction and provides
- * getter methods to retrieve specific configuration values like IP addresses,
- * ports, and other parameters.
+ * This class parses a JSON configuration file upon construction into a typed,
+ * validated ConfigSnapshot and provides getter methods to retrieve specific
+ * configuration values like IP addresses, ports, and other parameters. Getters
+ * only read a field; nothing is looked up or converted after construction.
  */
 class ConfigManager {
 private:
-    QJsonObject configObj; ///< Stores the parsed JSON configuration object.
+    ConfigSnapshot config; ///< The parsed configuration; defaults if the file could not be loaded.
 
     /**
      * @brief Loads and parses the specified JSON configuration file.
@@ -33,6 +30,12 @@ public:
      */
     ConfigManager(const QString& filePath);
 
+    /**
+     * @brief Gets every value at once.
+     * @return The parsed configuration.
+     */
+    const ConfigSnapshot& snapshot() const;
+
     // --- Getters for configuration values ---
 
     QString getAliceIP() const;
@@ -41,6 +44,29 @@ public:
     quint16 getAlicePort() const;
     int getSleepTime() const;
     int getNumberOfIterations() const;
+    int getChainFormat() const;
+    QString getChainStorage() const;
+    QString getHashAlgorithm() const;
+    QString getChainFile() const;
+    int getSkipWindow() const;
+    int getServerThreads() const;
+    bool getPinThreads() const;
+    int getPipelineDepth() const;
+    QString getClientStateFile() const;
+    int getReconnectDelay() const;
+    int getResponseTimeout() const;
+    int getIdleTimeout() const;
+    int getSourceRate() const;
+    int getSourceBurst() const;
+    int getIdentityRate() const;
+    int getIdentityBurst() const;
+    int getVerifyBudget() const;
+    QString getChainStoreDir() const;
+    int getSnapshotEvery() const;
+    QString getVerifierTable() const;
+    int getVerifierTableCapacity() const;
+    QString getReplicaSocket() const;
+    int getStandbyTimeout() const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef CONFIG_SNAPSHOT_HPP
+#define CONFIG_SNAPSHOT_HPP
+
+#include "ServerCore.hpp"
+#include <cstdint>
+#include <string>
+
+class JsonConfig;
+
+/**
+ * @struct ConfigSnapshot
+ * @brief Every config.json value, parsed once into typed fields and validated.
+ *
+ * Fields are named after their keys and hold the documented default when a key
+ * is missing or has the wrong type; values outside their range are clamped, so
+ * code reading a snapshot never converts or checks anything. A snapshot is never
+ * modified once built: LiveConfig publishes a new one when the file changes.
+ */
+struct ConfigSnapshot {
+    std::string aliceIP;                     ///< Address the server listens on and the client connects to.
+    std::uint16_t alicePort = 0;             ///< Port the server listens on and the client connects to.
+    std::string bobIP;                       ///< Reserved.
+    std::uint16_t bobPort = 0;               ///< Reserved.
+    int sleepDuration = 0;                   ///< Seconds between challenge rounds; at least 0.
+    int numberOfIterations = 0;              ///< The chain length n.
+    int chainFormat = 1;                     ///< The client's ChainFormat.
+    std::string chainStorage = "full";       ///< "full" or "checkpointed".
+    std::string hashAlgorithm = "SHA-256";   ///< The client's hash function.
+    std::string chainFile;                   ///< The client's chain file, or empty.
+    int skipWindow = 1;                      ///< Links a response may be behind; at least 1.
+    int serverThreads = 1;                   ///< Event loops; 0 or less means one per core.
+    bool pinThreads = false;                 ///< Pin event loop i to CPU i.
+    int pipelineDepth = 1;                   ///< Outstanding challenges per session; at least 1.
+    std::string clientStateFile;             ///< The client's state file, or empty.
+    int reconnectDelay = 0;                  ///< Seconds before the client reconnects; 0 disables.
+    int responseTimeout = 0;                 ///< Seconds a challenge may stay unanswered; 0 disables.
+    int idleTimeout = 0;                     ///< Seconds a client may stay silent; 0 disables.
+    int sourceRate = 0;                      ///< Connections plus frames per second per source; 0 disables.
+    int sourceBurst = 0;                     ///< The source burst; 0 for sourceRate.
+    int identityRate = 0;                    ///< Frames per second per chain; 0 disables.
+    int identityBurst = 0;                   ///< The chain burst; 0 for identityRate.
+    int verifyBudget = 0;                    ///< Verification hashes in flight; 0 disables.
+    std::string chainStoreDir;               ///< The chain store directory, or empty; a crash reopens a replay window of about one sync.
+    int snapshotEvery = 100000;              ///< Log records between snapshots; at least 1.
+    std::string verifierTable;               ///< The verifier table file, or empty.
+    int verifierTableCapacity = 65536;       ///< Records of a new verifier table; at least 1.
+    std::string replicaSocket;               ///< The standby's Unix socket, or empty.
+    int standbyTimeout = 3;                  ///< Seconds of primary silence before a takeover; at least 2.
+    std::string shards;                      ///< The router's comma-separated shard addresses.
+    int routerReportInterval = 60;           ///< Seconds between router load reports; 0 reports on exit only.
+    int routerFirstFrameTimeout = 10;        ///< Seconds the router waits for a client's first frame; 0 waits forever.
+
+    /**
+     * @brief Reads and validates every value of a parsed configuration file.
+     * @param config The parsed file.
+     * @return The snapshot.
+     */
+    static ConfigSnapshot from(const JsonConfig& config);
+
+    /**
+     * @brief Gets the settings the server side of the protocol depends on.
+     * @return The protocol and admission settings.
+     */
+    ServerSettings serverSettings() const;
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef COUNTING_ALLOCATOR_HPP
+#define COUNTING_ALLOCATOR_HPP
+
+/**
+ * @file CountingAllocator.hpp
+ * @brief Replaces every global operator new and delete with versions that count allocations.
+ *
+ * Include it from exactly one source file of a program that wants to measure its
+ * own allocations (a benchmark or a test), never from lamport-core: the
+ * replacements apply to the whole program. Read allocationCount and
+ * allocationBytes before and after the code under test.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<std::uint64_t> allocationCount{0};  ///< Allocations made so far by the whole program.
+static std::atomic<std::uint64_t> allocationBytes{0};  ///< Bytes requested by them.
+
+/**
+ * @brief Counts and makes one allocation; every replaced operator new ends up here.
+ * Kept out of line like operator delete(void*) below, so that GCC does not pair the
+ * malloc() inside it with an operator delete and report a mismatch.
+ * @param size The requested size.
+ * @param alignment The requested alignment, or 0 for the default one.
+ * @return The memory, or nullptr when out of memory.
+ */
+__attribute__((noinline)) static void* countedAllocate(std::size_t size, std::size_t alignment)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+    void* p = nullptr;
+    return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+}
+
+void* operator new(std::size_t size)
+{
+    if (void* p = countedAllocate(size, 0)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void* p = countedAllocate(size, static_cast<std::size_t>(alignment))) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return ::operator new(size, alignment);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return ::operator new(size, tag);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept
+{
+    return ::operator new(size, alignment, tag);
+}
+
+// malloc() and posix_memalign() memory is released the same way, so every delete ends up in the first one.
+// It is kept out of line: inlined into its callers, the free() would be diagnosed as not matching operator new
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    ::operator delete(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    ::operator delete(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    ::operator delete(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    ::operator delete(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    ::operator delete(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    ::operator delete(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    ::operator delete(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    ::operator delete(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+    ::operator delete(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    ::operator delete(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    ::operator delete(p);
+}
+
+#endif
@@ -1,35 +1,163 @@
 #ifndef CRYPTO_UTILS_HPP
 #define CRYPTO_UTILS_HPP
 
+#include "Digest.hpp"
+#include "HashPolicy.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 
+/**
+ * @enum ChainFormat
+ * @brief Selects how each link of a hash chain is derived from the previous one.
+ *
+ * The value is part of the enrollment so that a server can verify chains
+ * produced by older clients.
+ */
+enum class ChainFormat : std::uint8_t {
+    HexV1 = 1,   ///< Legacy: h_{i+1} = H(uppercase hex text of h_i).
+    BinaryV2 = 2 ///< h_{i+1} = H(32 raw bytes of h_i).
+};
+
+/**
+ * @struct ChainParams
+ * @brief Everything needed, besides the seed, to rebuild or verify a chain.
+ *
+ * Chosen by the client, announced at enrollment and stored with the anchor.
+ */
+struct ChainParams {
+    ChainFormat format = ChainFormat::HexV1;         ///< How links are derived from each other.
+    HashAlgorithm algorithm = HashAlgorithm::Sha256; ///< The hash function H.
+};
+
+/**
+ * @brief Reports the progress of a long chain computation and lets the caller cancel it.
+ *
+ * Called as progress(done, total) every CHAIN_PROGRESS_INTERVAL links, from the thread
+ * doing the work; returning false cancels the computation.
+ */
+using ChainProgress = std::function<bool(std::uint64_t done, std::uint64_t total)>;
+
+constexpr std::uint64_t CHAIN_PROGRESS_INTERVAL = 1 << 16; ///< Links between two ChainProgress calls.
+
 /**
  * @namespace CryptoUtils
  * @brief A collection of utility functions for cryptographic operations.
  *
- * This namespace provides functions for generating SHA-256 hashes, creating
+ * This namespace provides functions for generating hashes, creating
  * Lamport hash chains, and generating random data, leveraging the Crypto++ library.
  */
 namespace CryptoUtils{
 
     /**
-     * @brief Generates a SHA-256 hash of a given input string.
-     * @param input The string to be hashed.
-     * @return The resulting hash as a hexadecimal string.
+     * @brief Derives the next chain link with a compile-time hash policy.
+     * @tparam Hash A hash policy such as Sha256Policy.
+     * @param link The previous link h_i.
+     * @param format How the link is fed to the hash function.
+     * @return The next link h_{i+1}.
+     */
+    template <typename Hash>
+    inline Digest genNextLinkWith(const Digest& link, ChainFormat format)
+    {
+        Digest next;
+        if (format == ChainFormat::HexV1) {
+            char hex[2 * Digest::SIZE];
+            link.toHex(hex);
+            Hash::hash(reinterpret_cast<const std::uint8_t*>(hex), sizeof(hex), next.data());
+        } else {
+            Hash::hash(link.data(), Digest::SIZE, next.data());
+        }
+        return next;
+    }
+
+    /**
+     * @brief Generates a hash of a given input string.
+     * @param input The bytes to be hashed.
+     * @param algorithm The hash function to use.
+     * @return The resulting 32-byte digest.
+     */
+    Digest genHash(std::string_view input, HashAlgorithm algorithm = HashAlgorithm::Sha256);
+
+    /**
+     * @brief Hashes a byte span into a caller-provided digest. Never allocates.
+     * @param input The bytes to be hashed.
+     * @param out Receives the digest.
+     * @param algorithm The hash function to use.
      */
-    std::string genHash(const std::string& input);
+    void hashInto(std::string_view input, Digest& out, HashAlgorithm algorithm = HashAlgorithm::Sha256);
+
+    /**
+     * @brief Derives the next chain link from the previous one.
+     * @param link The previous link h_i.
+     * @param params The format and hash function of the chain.
+     * @return The next link h_{i+1}.
+     */
+    Digest genNextLink(const Digest& link, const ChainParams& params);
+
+    /**
+     * @brief Derives the next chain link into a caller-provided digest. Never allocates.
+     * @param link The previous link h_i.
+     * @param params The format and hash function of the chain.
+     * @param out Receives h_{i+1}; may alias @p link.
+     */
+    void genNextLinkInto(const Digest& link, const ChainParams& params, Digest& out);
+
+    /**
+     * @brief Generates the SHA-256 hashes of many strings in one call.
+     * Inputs of equal length are hashed together by the multi-buffer kernel.
+     * @param inputs The strings to be hashed.
+     * @return The resulting digests, in the order of @p inputs.
+     */
+    std::vector<Digest> genHashBatch(const std::vector<std::string>& inputs);
+
+    /**
+     * @brief Derives the next link of many independent chains in one call.
+     * SHA-256 chains go through the multi-buffer kernel.
+     * @param links The previous links, one per chain.
+     * @param params The format and hash function shared by all chains.
+     * @return The next links, in the order of @p links.
+     */
+    std::vector<Digest> genNextLinkBatch(const std::vector<Digest>& links, const ChainParams& params);
+
+    /**
+     * @brief Derives the next link of many independent chains into a caller-provided array.
+     * Scratch space is taken from the stack in fixed-size chunks, so this never allocates.
+     * @param links Array of @p count previous links.
+     * @param count The number of links.
+     * @param params The format and hash function shared by all chains.
+     * @param out Receives @p count next links; may alias @p links.
+     */
+    void genNextLinkBatch(const Digest* links, std::size_t count, const ChainParams& params, Digest* out);
 
     /**
      * @brief Generates a Lamport hash chain from a seed value.
      * @param seed The initial value (h_0) for the chain.
      * @param len The desired length (n) of the hash chain.
-     * @return A vector of strings representing the hash chain [h_1, h_2, ..., h_n].
+     * @param params The format and hash function of the chain.
+     * @param progress Optional progress callback; returning false cancels the generation.
+     * @return A vector of digests representing the hash chain [h_1, h_2, ..., h_n], or an empty vector if cancelled.
+     */
+    std::vector<Digest> genHashChain(const std::string& seed, int len, const ChainParams& params,
+                                     const ChainProgress& progress = ChainProgress());
+
+    /**
+     * @brief Computes the anchors (h_n) of many independent chains without storing any links.
+     * The chains advance in lockstep so that every step goes through genNextLinkBatch().
+     * @param seeds Array of @p count seeds (h_0), one per chain.
+     * @param count The number of chains.
+     * @param len The common chain length (n), at least 1.
+     * @param params The format and hash function shared by all chains.
+     * @param anchors Receives @p count anchors, in the order of @p seeds.
      */
-    std::vector<std::string> genHashChain(const std::string& seed, int len);
+    void genChainAnchors(const std::string* seeds, std::size_t count, std::uint64_t len,
+                         const ChainParams& params, Digest* anchors);
 
     /**
      * @brief Generates a cryptographically secure random seed.
+     * Each thread draws from its own generator, seeded once from the operating system.
      * @param size The desired size of the seed in bytes.
      * @return The generated seed as a hexadecimal string.
      */
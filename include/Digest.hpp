@@ -0,0 +1,81 @@
+#ifndef DIGEST_HPP
+#define DIGEST_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/**
+ * @struct Digest
+ * @brief A fixed-size 32-byte hash value (one link of a Lamport hash chain).
+ *
+ * Digests are plain values: they live on the stack or inline in containers,
+ * copy with memcpy and never allocate. Hex strings are only produced at the
+ * display, log and wire edges via toHex() and fromHex().
+ */
+struct Digest {
+    static constexpr std::size_t SIZE = 32; ///< Size of a digest in bytes.
+
+    std::array<std::uint8_t, SIZE> bytes{}; ///< The raw digest bytes.
+
+    /**
+     * @brief Gets a pointer to the raw digest bytes.
+     * @return Pointer to the first of SIZE bytes.
+     */
+    const std::uint8_t* data() const { return bytes.data(); }
+
+    /**
+     * @brief Gets a mutable pointer to the raw digest bytes.
+     * @return Pointer to the first of SIZE bytes.
+     */
+    std::uint8_t* data() { return bytes.data(); }
+
+    /**
+     * @brief Encodes the digest as an uppercase hexadecimal string.
+     * @return A 64-character hex string.
+     */
+    std::string toHex() const;
+
+    /**
+     * @brief Writes the uppercase hexadecimal encoding into a caller-provided buffer.
+     * @param out Receives exactly 2 * SIZE characters (no terminator).
+     */
+    void toHex(char* out) const;
+
+    /**
+     * @brief Decodes a 64-character hexadecimal string (either case).
+     * @param hex Pointer to the hex characters.
+     * @param len The number of characters; must be 2 * SIZE.
+     * @param out Receives the decoded digest on success.
+     * @return True if @p hex was a well-formed digest, false otherwise.
+     */
+    static bool fromHex(const char* hex, std::size_t len, Digest& out);
+
+    /**
+     * @brief Decodes a 64-character hexadecimal string (either case).
+     * @param hex The hex string.
+     * @param out Receives the decoded digest on success.
+     * @return True if @p hex was a well-formed digest, false otherwise.
+     */
+    static bool fromHex(const std::string& hex, Digest& out);
+};
+
+static_assert(std::is_trivially_copyable<Digest>::value, "Digest must stay trivially copyable");
+static_assert(sizeof(Digest) == Digest::SIZE, "Digest must not carry padding");
+
+/**
+ * @brief Compares two digests in constant time.
+ * The running time does not depend on where the digests first differ.
+ * @return True if both digests hold the same bytes.
+ */
+bool operator==(const Digest& lhs, const Digest& rhs);
+
+/**
+ * @brief Compares two digests in constant time.
+ * @return True if the digests differ.
+ */
+bool operator!=(const Digest& lhs, const Digest& rhs);
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef EPOLL_SERVER_HPP
+#define EPOLL_SERVER_HPP
+
+#include "ServerCore.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @class EpollServer
+ * @brief A headless, Qt-free server: one epoll reactor thread driving a ServerCore.
+ *
+ * Sockets are non-blocking; the reactor reads into one shared buffer, hands the bytes
+ * to the core, and writes the core's frames straight to the socket, buffering only
+ * what the kernel does not take at once. The core's timers are driven by the
+ * epoll_wait timeout, and the loop is woken after each sync of the chain store,
+ * whose challenges the core may be holding. Several servers can share a port
+ * with SO_REUSEPORT, one per thread.
+ */
+class EpollServer : private ServerTransport
+{
+public:
+    /**
+     * @brief Constructs an EpollServer.
+     * @param settings The protocol settings.
+     * @param verbose Print every log message of the core to stdout.
+     * @param chains The chain registry shared by all event loops, or nullptr for a private one.
+     * @param admission The admission control shared by all event loops, or nullptr for a private one.
+     * @param config The configuration whose reloads the core follows, or nullptr.
+     */
+    EpollServer(const ServerSettings& settings, bool verbose, ChainRegistry* chains = nullptr,
+                AdmissionControl* admission = nullptr, const LiveConfig* config = nullptr);
+
+    /**
+     * @brief Closes every connection and the listener.
+     */
+    ~EpollServer();
+
+    EpollServer(const EpollServer&) = delete;
+    EpollServer& operator=(const EpollServer&) = delete;
+
+    /**
+     * @brief Binds and listens on an address.
+     * @param address The numeric IPv4 or IPv6 address.
+     * @param port The port.
+     * @param reusePort Set SO_REUSEPORT so that other servers can share the port.
+     * @return False on error; the reason is printed to stderr.
+     */
+    bool listen(const std::string& address, std::uint16_t port, bool reusePort);
+
+    /**
+     * @brief Runs the event loop on the calling thread until stop() is called.
+     * Authentication is started first, so every client is challenged as soon as it has enrolled.
+     */
+    void run();
+
+    /**
+     * @brief Makes run() return. Safe to call from any thread.
+     */
+    void stop();
+
+    /**
+     * @brief Gets the number of connected clients.
+     * @return The number of open sessions.
+     */
+    std::size_t sessionCount() const;
+
+private:
+    /**
+     * @brief The state of one client socket.
+     */
+    struct Connection {
+        int fd = -1;                        ///< The socket.
+        SessionId session = 0;              ///< The session in the core.
+        std::vector<std::uint8_t> pending;  ///< Bytes the kernel has not accepted yet.
+        bool broken = false;                ///< Set when a write fails or the core times it out; closed after the current event.
+    };
+
+    /**
+     * @brief Accepts every pending connection.
+     */
+    void acceptAll();
+
+    /**
+     * @brief Reads everything available on a connection and hands it to the core.
+     * @param connection The connection.
+     */
+    void readFrom(Connection* connection);
+
+    /**
+     * @brief Writes as much of a connection's pending bytes as the kernel accepts.
+     * @param connection The connection.
+     */
+    void flushPending(Connection* connection);
+
+    /**
+     * @brief Enables or disables write readiness notification for a connection.
+     * @param connection The connection.
+     * @param enable True while bytes are pending.
+     */
+    void watchWritable(Connection* connection, bool enable);
+
+    /**
+     * @brief Closes a connection and its session.
+     * @param connection The connection.
+     */
+    void closeConnection(Connection* connection);
+
+    /**
+     * @brief Closes every connection whose write failed.
+     */
+    void closeBroken();
+
+    /**
+     * @brief Wakes the event loop from any thread.
+     */
+    void wake();
+
+    // --- ServerTransport ---
+
+    void send(void* connection, const std::uint8_t* data, std::size_t len) override;
+    void log(const std::string& message) override;
+    bool verbose() const override;
+    void drop(void* connection) override;
+
+    ServerCore m_core;                                      ///< Sessions, challenge schedule and verification.
+    bool m_verbose = false;                                 ///< Print log messages.
+    ChainRegistry* m_chains = nullptr;                      ///< The shared registry, whose store wakes the loop; or nullptr.
+    int m_epoll = -1;                                       ///< The epoll instance.
+    int m_listener = -1;                                    ///< The listening socket.
+    int m_wake = -1;                                        ///< eventfd used by stop().
+    std::atomic<bool> m_running{false};                     ///< Cleared by stop().
+    std::vector<std::unique_ptr<Connection>> m_connections; ///< Open connections, indexed by socket.
+    std::vector<int> m_broken;                              ///< Sockets whose write failed during the current event.
+    std::uint8_t m_readBuffer[64 * 1024];                   ///< Receives socket data; shared by all connections.
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,105 @@
+#ifndef HASH_POLICY_HPP
+#define HASH_POLICY_HPP
+
+#include "Digest.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @enum HashAlgorithm
+ * @brief Identifies the 256-bit hash function a chain is built with.
+ *
+ * The numeric values are recorded alongside stored anchors, so they must never change.
+ */
+enum class HashAlgorithm : std::uint8_t {
+    Sha256 = 1,     ///< SHA-256 (SHA-NI / multi-buffer accelerated, see Sha256).
+    Sha512_256 = 2, ///< SHA-512/256, faster than SHA-256 on 64-bit CPUs without SHA-NI.
+    Blake2s = 3     ///< BLAKE2s-256, via Crypto++.
+};
+
+/**
+ * @struct Sha256Policy
+ * @brief Hash policy for SHA-256.
+ */
+struct Sha256Policy {
+    static constexpr HashAlgorithm algorithm = HashAlgorithm::Sha256;
+
+    /**
+     * @brief Hashes a message.
+     * @param data The message bytes.
+     * @param len The message length in bytes.
+     * @param out Receives the 32-byte digest.
+     */
+    static void hash(const std::uint8_t* data, std::size_t len, std::uint8_t* out);
+};
+
+/**
+ * @struct Sha512_256Policy
+ * @brief Hash policy for SHA-512/256 (FIPS 180-4).
+ */
+struct Sha512_256Policy {
+    static constexpr HashAlgorithm algorithm = HashAlgorithm::Sha512_256;
+
+    /**
+     * @brief Hashes a message.
+     * @param data The message bytes.
+     * @param len The message length in bytes.
+     * @param out Receives the 32-byte digest.
+     */
+    static void hash(const std::uint8_t* data, std::size_t len, std::uint8_t* out);
+};
+
+/**
+ * @struct Blake2sPolicy
+ * @brief Hash policy for BLAKE2s with a 256-bit digest.
+ */
+struct Blake2sPolicy {
+    static constexpr HashAlgorithm algorithm = HashAlgorithm::Blake2s;
+
+    /**
+     * @brief Hashes a message.
+     * @param data The message bytes.
+     * @param len The message length in bytes.
+     * @param out Receives the 32-byte digest.
+     */
+    static void hash(const std::uint8_t* data, std::size_t len, std::uint8_t* out);
+};
+
+/**
+ * @brief Calls a generic function object with the policy matching a runtime algorithm.
+ *
+ * This is the single point where the runtime choice (negotiated at enrollment) is
+ * turned into a compile-time policy, so that chain loops instantiated for the
+ * policy contain no per-hash dispatch.
+ * @param algorithm The algorithm to dispatch on.
+ * @param fn A callable taking a policy object, e.g. [&](auto policy) { ... }.
+ * @return Whatever @p fn returns.
+ */
+template <typename Fn>
+auto withHashPolicy(HashAlgorithm algorithm, Fn&& fn) -> decltype(fn(Sha256Policy{}))
+{
+    switch (algorithm) {
+    case HashAlgorithm::Sha512_256: return fn(Sha512_256Policy{});
+    case HashAlgorithm::Blake2s: return fn(Blake2sPolicy{});
+    case HashAlgorithm::Sha256:
+    default: return fn(Sha256Policy{});
+    }
+}
+
+/**
+ * @brief Gets the canonical name of a hash algorithm, as used in configs and enrollment.
+ * @param algorithm The algorithm.
+ * @return "SHA-256", "SHA-512/256" or "BLAKE2s".
+ */
+const char* hashAlgorithmName(HashAlgorithm algorithm);
+
+/**
+ * @brief Looks up a hash algorithm by its canonical name.
+ * @param name The name, as returned by hashAlgorithmName().
+ * @param algorithm Receives the algorithm on success.
+ * @return True if @p name is a supported algorithm, false otherwise.
+ */
+bool parseHashAlgorithm(std::string_view name, HashAlgorithm& algorithm);
+
+#endif
\ No newline at end of file
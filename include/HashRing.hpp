@@ -0,0 +1,86 @@
+#ifndef HASH_RING_HPP
+#define HASH_RING_HPP
+
+#include "Digest.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class HashRing
+ * @brief Maps identities to server shards by consistent hashing.
+ *
+ * Each shard is placed on a 64-bit ring at VIRTUAL_NODES points, derived from
+ * its name by SHA-256, and an identity (the anchor h_n of its chain) belongs to
+ * the shard of the first point at or after the anchor's own position. Placement
+ * depends only on the shard names, so every router and tool that is given the
+ * same names computes the same owners, whatever the order of the list. Adding
+ * a shard moves only the identities that fall to its new points, about 1/N of
+ * them; removing a shard moves only the identities it held.
+ */
+class HashRing {
+public:
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1); ///< "No shard" index.
+    static constexpr unsigned VIRTUAL_NODES = 128;                    ///< Ring points per shard.
+
+    /**
+     * @brief Adds a shard.
+     * @param name The shard's name; its "host:port" address for the router.
+     * @return False if a shard of that name is already on the ring.
+     */
+    bool addShard(const std::string& name);
+
+    /**
+     * @brief Removes a shard; the indices of the shards after it shift down by one.
+     * @param name The shard's name.
+     * @return False if no shard has that name.
+     */
+    bool removeShard(const std::string& name);
+
+    /**
+     * @brief Gets the number of shards.
+     * @return The shard count.
+     */
+    std::size_t shardCount() const;
+
+    /**
+     * @brief Gets the name of a shard.
+     * @param shard A shard index below shardCount(), in the order the shards were added.
+     * @return The name.
+     */
+    const std::string& shardName(std::size_t shard) const;
+
+    /**
+     * @brief Finds the shard that owns an identity.
+     * @param anchor The identity's anchor.
+     * @return The shard index, or NONE if the ring is empty.
+     */
+    std::size_t shardFor(const Digest& anchor) const;
+
+    /**
+     * @brief Gets the fraction of the ring each shard owns, i.e. its expected share of the identities.
+     * @return One fraction per shard, by shard index; they add up to 1.
+     */
+    std::vector<double> shares() const;
+
+private:
+    /**
+     * @struct Point
+     * @brief One virtual node.
+     */
+    struct Point {
+        std::uint64_t position;  ///< The position on the ring.
+        std::uint32_t shard;     ///< The shard index.
+    };
+
+    /**
+     * @brief Rebuilds the sorted points from the shard names.
+     */
+    void rebuild();
+
+    std::vector<std::string> shards;  ///< The shard names, by index.
+    std::vector<Point> points;        ///< Every shard's points, sorted by position.
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef JSON_CONFIG_HPP
+#define JSON_CONFIG_HPP
+
+#include <map>
+#include <string>
+
+/**
+ * @class JsonConfig
+ * @brief Reads a flat JSON configuration file without Qt.
+ *
+ * Used by the headless server in place of ConfigManager. Only the subset of JSON
+ * that config.json uses is supported: one object whose values are strings,
+ * numbers, booleans or null.
+ */
+class JsonConfig {
+public:
+    /**
+     * @brief Loads and parses a configuration file, replacing any values loaded before.
+     * @param filePath The path to the JSON file.
+     * @return False if the file cannot be read or is not a flat JSON object; an error is printed.
+     */
+    bool load(const std::string& filePath);
+
+    /**
+     * @brief Gets a string value.
+     * @param key The key.
+     * @param fallback Returned if the key is missing or not a string.
+     * @return The value.
+     */
+    std::string getString(const std::string& key, const std::string& fallback = "") const;
+
+    /**
+     * @brief Gets an integer value.
+     * @param key The key.
+     * @param fallback Returned if the key is missing or not a number.
+     * @return The value, truncated toward zero.
+     */
+    int getInt(const std::string& key, int fallback = 0) const;
+
+    /**
+     * @brief Gets a boolean value.
+     * @param key The key.
+     * @param fallback Returned if the key is missing or not a boolean.
+     * @return The value.
+     */
+    bool getBool(const std::string& key, bool fallback = false) const;
+
+private:
+    /**
+     * @brief A parsed value; strings are unescaped, other values keep their JSON text.
+     */
+    struct Value {
+        enum Type { String, Number, Bool, Null } type; ///< The JSON type.
+        std::string text;                               ///< The string contents or literal text.
+    };
+
+    /**
+     * @brief Parses the text of a configuration file.
+     * @param text The JSON text.
+     * @param values Receives the key/value pairs.
+     * @param error Receives a description of the first error.
+     * @return True on success.
+     */
+    static bool parse(const std::string& text, std::map<std::string, Value>& values, std::string& error);
+
+    std::map<std::string, Value> values; ///< The parsed key/value pairs.
+};
+
+#endif
\ No newline at end of file
@@ -1,9 +1,25 @@
 #ifndef LAMPORT_AUTH_HPP
 #define LAMPORT_AUTH_HPP
 
+#include "ChainFile.hpp"
+#include "ChainTraverser.hpp"
+#include "ChainVerifier.hpp"
 #include "CryptoUtils.hpp"
+#include "Digest.hpp"
+#include <cstddef>
 #include <vector>
 #include <string>
+#include <string_view>
+
+/**
+ * @enum ChainStorage
+ * @brief Selects how the client keeps its hash chain in memory.
+ */
+enum class ChainStorage {
+    Full,        ///< All n links are stored; every OTP is a lookup.
+    Checkpointed, ///< Only O(log n) checkpoints are stored; OTPs are recomputed (see ChainTraverser).
+    Mapped        ///< Links are read from a memory-mapped chain file (see ChainFile).
+};
 
 /**
  * @class LamportAuth
@@ -15,32 +31,91 @@
  */
 class LamportAuth {
 private:
-    // --- Server-side (Alice) variable ---
-    std::string lastVerifiedHash;   ///< Stores the last successfully verified hash (h_i).
+    // --- Server-side (Alice) variables ---
+    ChainVerifier verifier;                     ///< The last successfully verified hash (h_i) and its chain.
+
+    ChainParams params;                         ///< Format and hash function of this chain.
+
+    // --- Client-side (Bob) variables ---
+    ChainStorage storage = ChainStorage::Full;  ///< How the client's chain is kept in memory.
+    ChainTraverser traverser;                   ///< Checkpoints of the chain in ChainStorage::Checkpointed mode.
+    ChainFile chainFile;                        ///< The mapped chain in ChainStorage::Mapped mode.
 
 public:
     // --- Client-side (Bob) variables and functions ---
-    std::vector<std::string> chain; ///< Stores the generated hash chain [h_1, h_2, ..., h_n].
+    std::vector<Digest> chain; ///< Stores the generated hash chain [h_1, h_2, ..., h_n] (ChainStorage::Full only).
 
     /**
      * @brief Initializes the hash chain from a given seed.
      * @param seed The initial secret value (h_0).
      * @param len The length of the chain (n).
+     * @param chainParams The format and hash function of the chain.
+     * @param chainStorage Whether to store every link or only O(log n) checkpoints.
+     * @param progress Optional progress callback, e.g. for a generation running on a worker thread;
+     *        returning false cancels the generation.
+     * @return False if the generation was cancelled; the chain is then empty.
+     */
+    bool initChain(const std::string& seed, int len, const ChainParams& chainParams = ChainParams(),
+                   ChainStorage chainStorage = ChainStorage::Full, const ChainProgress& progress = ChainProgress());
+
+    /**
+     * @brief Uses a chain file generated by ChainFile::generate() instead of an in-memory chain.
+     * The chain parameters are taken from the file header.
+     * @param path The path of the chain file.
+     * @return True if the file was mapped, false if it is missing or malformed.
      */
-    void initChain(const std::string& seed, int len);
+    bool openChainFile(const std::string& path);
 
     /**
      * @brief Retrieves the correct one-time password (OTP) for a given challenge.
      * @param c The challenge number from the server.
      * @return The corresponding OTP (h_{n-c}).
      */
-    std::string getOTPForChallenge(int c);
+    Digest getOTPForChallenge(int c);
 
     /**
      * @brief Gets the last hash in the chain (h_n).
      * @return The final hash value.
      */
-    std::string getLastHash();
+    Digest getLastHash();
+
+    /**
+     * @brief Gets the length of the client's chain, whichever way it is stored.
+     * @return The number of links (n).
+     */
+    std::uint64_t getChainLength() const;
+
+    /**
+     * @brief Gets the format and hash function of this chain.
+     * @return The chain parameters.
+     */
+    ChainParams getChainParams() const;
+
+    /**
+     * @brief Sets the format and hash function of the chain being verified.
+     * @param chainParams The parameters announced by the client at enrollment.
+     */
+    void setChainParams(const ChainParams& chainParams);
+
+    /**
+     * @brief Encodes an anchor and its chain parameters as the client's enrollment message.
+     * SHA-256 chains keep the shorter forms understood by older servers
+     * (bare hex for format 1, "2:<hex>" for format 2); other hash functions
+     * use "<format>:<algorithm>:<hex>".
+     * @param chainParams The chain parameters.
+     * @param anchor The final link h_n.
+     * @return The enrollment message.
+     */
+    static std::string encodeEnrollment(const ChainParams& chainParams, const Digest& anchor);
+
+    /**
+     * @brief Decodes an enrollment message produced by encodeEnrollment().
+     * @param message The received message.
+     * @param chainParams Receives the announced chain parameters.
+     * @param anchor Receives the anchor h_n.
+     * @return True if the message is well formed and names a supported algorithm.
+     */
+    static bool decodeEnrollment(std::string_view message, ChainParams& chainParams, Digest& anchor);
 
 
     // --- Server-side (Alice) functions ---
@@ -51,19 +126,58 @@ public:
      * @param response The OTP (h_{i-1}) received from the client.
      * @return True if the OTP is valid, false otherwise.
      */
-    bool verifyOTP(const std::string& response);
+    bool verifyOTP(const Digest& response);
+
+    /**
+     * @brief Verifies a received OTP that may be up to @p window links behind the last verified hash.
+     * Accepts the response if H^j(response) == lastVerifiedHash for some 1 <= j <= window,
+     * which lets the verifier resynchronise after j - 1 lost rounds.
+     * @param response The OTP received from the client.
+     * @param window The largest number of hashes to try; 1 is the same as verifyOTP(response).
+     * @param offset Receives j on success (the number of chain positions advanced), 0 otherwise.
+     * @return True if the OTP is valid within the window, false otherwise.
+     */
+    bool verifyOTP(const Digest& response, int window, int& offset);
+
+    /**
+     * @brief Verifies one pending OTP for each of several independent verifiers.
+     * All responses are hashed together by the multi-buffer kernel; every verifier
+     * that accepts its response is updated exactly as by verifyOTP().
+     * @param verifiers The verifiers to check against, typically one per session.
+     * @param responses The OTPs received, one per verifier.
+     * @return One result per verifier, true where the OTP was valid.
+     */
+    static std::vector<bool> verifyOTPBatch(const std::vector<LamportAuth*>& verifiers,
+                                            const std::vector<Digest>& responses);
+
+    /**
+     * @brief Verifies one pending OTP for each of several independent verifiers, without allocating.
+     * Same semantics as the vector overload; results are written to a caller-provided array.
+     * @param verifiers Array of @p count verifiers.
+     * @param responses Array of @p count OTPs; responses[i] is checked against verifiers[i].
+     * @param count The number of verifiers.
+     * @param results Receives @p count results, true where the OTP was valid.
+     */
+    static void verifyOTPBatch(LamportAuth* const* verifiers, const Digest* responses,
+                               std::size_t count, bool* results);
 
     /**
      * @brief Sets the last verified hash. Used for initialization (with h_n) and updates.
      * @param hash The hash value to set.
      */
-    void setLastHash(const std::string& hash);
+    void setLastHash(const Digest& hash);
 
     /**
      * @brief Gets the last successfully verified hash.
      * @return The last verified hash value (h_i).
      */
-    std::string getLastVerifiedHash();
+    Digest getLastVerifiedHash();
+
+    /**
+     * @brief Checks whether the initial hash (h_n) has been received.
+     * @return True if a verified hash is stored, false otherwise.
+     */
+    bool hasLastVerifiedHash() const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,94 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class LatencyHistogram
+ * @brief A high-dynamic-range histogram of latencies in microseconds, with three significant digits.
+ *
+ * Values below 2048 get a bucket each; above that, every power of two is split
+ * into 1024 linear sub-buckets, so a recorded value is off by at most 1/1024
+ * (about 0.1%) from 1 us up to the largest value, 2^36 us (19 hours); larger
+ * values are clamped. Recording is an index computation and an increment and
+ * never allocates, and the memory used is fixed whatever is recorded.
+ * Histograms of several threads are combined with merge().
+ */
+class LatencyHistogram {
+public:
+    /**
+     * @brief Constructs an empty histogram.
+     */
+    LatencyHistogram();
+
+    /**
+     * @brief Records one value.
+     * @param micros The latency in microseconds.
+     */
+    void record(std::uint64_t micros);
+
+    /**
+     * @brief Adds every value of another histogram to this one.
+     * @param other The histogram to add.
+     */
+    void merge(const LatencyHistogram& other);
+
+    /**
+     * @brief Removes every value.
+     */
+    void reset();
+
+    /**
+     * @brief Gets the number of recorded values.
+     * @return The count.
+     */
+    std::uint64_t count() const { return total; }
+
+    /**
+     * @brief Gets the value at a percentile.
+     * @param percent The percentile, from 0 to 100.
+     * @return The highest value equivalent to the one below which @p percent of the values lie; 0 if empty.
+     */
+    std::uint64_t percentile(double percent) const;
+
+    /**
+     * @brief Gets the largest recorded value, to the histogram's precision.
+     * @return The value; 0 if empty.
+     */
+    std::uint64_t max() const;
+
+    /**
+     * @brief Gets the mean of the recorded values.
+     * @return The mean; 0 if empty.
+     */
+    double mean() const;
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 11;                                ///< log2 of the exact range.
+    static constexpr std::uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;       ///< Values recorded exactly.
+    static constexpr std::uint64_t HALF = SUB_BUCKETS / 2;                    ///< Sub-buckets per power of two.
+    static constexpr int MAX_BITS = 36;                                       ///< log2 of the clamp value.
+    static constexpr std::uint64_t MAX_VALUE = (std::uint64_t(1) << MAX_BITS) - 1; ///< Largest recordable value.
+
+    /**
+     * @brief Gets the bucket of a value.
+     * @param value The value, at most MAX_VALUE.
+     * @return The bucket index.
+     */
+    static std::size_t indexOf(std::uint64_t value);
+
+    /**
+     * @brief Gets the largest value a bucket stands for.
+     * @param index The bucket index.
+     * @return The value.
+     */
+    static std::uint64_t highestValueAt(std::size_t index);
+
+    std::vector<std::uint64_t> counts;  ///< Values per bucket.
+    std::uint64_t total = 0;            ///< Values recorded.
+    double sum = 0;                     ///< Sum of the values, for mean().
+};
+
+#endif
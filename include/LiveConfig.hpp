@@ -0,0 +1,95 @@
+#ifndef LIVE_CONFIG_HPP
+#define LIVE_CONFIG_HPP
+
+#include "ConfigSnapshot.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+/**
+ * @class LiveConfig
+ * @brief Publishes the current ConfigSnapshot of a configuration file and reloads it when the file changes.
+ *
+ * Readers take the current snapshot with snapshot(), an atomic shared_ptr load,
+ * and keep it as long as they like; a reload publishes a new snapshot and never
+ * touches the old one. Hot paths need not even do that: they keep a copy of the
+ * values they use and compare version() (one relaxed atomic load) to notice a
+ * reload. watch() starts a thread that follows the file with inotify. It
+ * watches the file's directory, so a file replaced by rename, as most editors
+ * and deployment tools do, is followed as well as one written in place. A
+ * file that fails to parse is reported and the previous snapshot stays.
+ */
+class LiveConfig {
+public:
+    LiveConfig();
+
+    /**
+     * @brief Stops watching.
+     */
+    ~LiveConfig();
+
+    LiveConfig(const LiveConfig&) = delete;
+    LiveConfig& operator=(const LiveConfig&) = delete;
+
+    /**
+     * @brief Parses a configuration file and publishes it. The file is the one watch() follows.
+     * @param filePath The path to the JSON file.
+     * @return False if the file cannot be read or parsed; the current snapshot is kept and an error is printed.
+     */
+    bool load(const std::string& filePath);
+
+    /**
+     * @brief Gets the current snapshot. Safe to call from any thread.
+     * @return The snapshot; defaults until a file has been loaded.
+     */
+    std::shared_ptr<const ConfigSnapshot> snapshot() const;
+
+    /**
+     * @brief Gets the number of snapshots published so far. Safe to call from any thread.
+     * @return The version; it changes whenever snapshot() does.
+     */
+    std::uint64_t version() const;
+
+    /**
+     * @brief Starts a thread that reloads the file loaded last whenever it is written or replaced.
+     * @return False if no file was loaded or inotify is unavailable.
+     */
+    bool watch();
+
+    /**
+     * @brief Stops the watching thread. Safe to call when not watching.
+     */
+    void stop();
+
+private:
+    /**
+     * @brief Parses a configuration file and publishes it as the next snapshot.
+     * @param filePath The path to the JSON file.
+     * @return False if the file cannot be read or parsed.
+     */
+    bool publish(const std::string& filePath);
+
+    /**
+     * @brief The watching thread: waits for inotify events on the file's directory and reloads the file.
+     * @param inotify The inotify descriptor.
+     * @param wake The eventfd that stop() signals.
+     */
+    void run(int inotify, int wake);
+
+    /**
+     * @brief Reports the values that changed, and those among them that only take effect after a restart.
+     * @param before The previous snapshot.
+     * @param after The new snapshot.
+     */
+    static void reportChanges(const ConfigSnapshot& before, const ConfigSnapshot& after);
+
+    std::string path;                                ///< The file loaded last.
+    std::shared_ptr<const ConfigSnapshot> current;   ///< The published snapshot; accessed with std::atomic_load/store.
+    std::atomic<std::uint64_t> published{0};         ///< Incremented after each publication.
+    int wakeFd = -1;                                 ///< eventfd that stops the watching thread.
+    std::thread watcher;                             ///< The watching thread, while watching.
+};
+
+#endif
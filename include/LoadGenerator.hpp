@@ -0,0 +1,266 @@
+#ifndef LOAD_GENERATOR_HPP
+#define LOAD_GENERATOR_HPP
+
+#include "CryptoUtils.hpp"
+#include "LamportAuth.hpp"
+#include "LatencyHistogram.hpp"
+#include "Protocol.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+
+/**
+ * @class LoadGenerator
+ * @brief Many simulated clients on one epoll reactor, each enrolling a chain and answering the server's challenges.
+ *
+ * Every session connects, enrolls a fresh chain of rounds + 1 links and answers
+ * each challenge as soon as it arrives (closed loop), or no faster than a given
+ * rate per session. After its last round it disconnects and starts over with a
+ * new chain, so enrollment stays part of the load. A session the server drops
+ * is counted as a failure and reconnects a second later. New connections are
+ * paced by a connection rate. The latencies of every phase are recorded in
+ * LatencyHistograms owned by the reactor's thread and read with latencies().
+ */
+class LoadGenerator
+{
+public:
+    /**
+     * @struct Options
+     * @brief What the simulated clients do.
+     */
+    struct Options {
+        sockaddr_storage server = {};   ///< The server's address.
+        socklen_t serverLength = 0;     ///< The length of @p server.
+        ChainParams params;             ///< The chain format and hash function of every session.
+        int rounds = 100;               ///< Challenges a session answers before it enrolls a new chain.
+        double connectRate = 0;         ///< Connections opened per second; 0 opens them all at once.
+        double roundRate = 0;           ///< Responses per second per session; 0 answers at once.
+    };
+
+    /**
+     * @struct Counters
+     * @brief Running totals. Safe to read from any thread.
+     */
+    struct Counters {
+        std::atomic<std::uint64_t> connects{0};    ///< Connections opened.
+        std::atomic<std::uint64_t> enrolled{0};    ///< Enrollments answered with a first challenge.
+        std::atomic<std::uint64_t> rounds{0};      ///< Responses sent.
+        std::atomic<std::uint64_t> completed{0};   ///< Chains answered to their last round.
+        std::atomic<std::uint64_t> failures{0};    ///< Connections refused or dropped before their last round.
+        std::atomic<std::uint64_t> active{0};      ///< Sessions currently connected.
+    };
+
+    /**
+     * @struct Latencies
+     * @brief The latency histograms, in microseconds.
+     */
+    struct Latencies {
+        LatencyHistogram connect;   ///< Connect call to established connection.
+        LatencyHistogram enroll;    ///< Enroll written to first challenge received.
+        LatencyHistogram verify;    ///< Response written to the next challenge received: one verification round trip.
+        LatencyHistogram round;     ///< Challenge received to the next challenge received: one full round.
+
+        /**
+         * @brief Adds every value of other histograms to these.
+         * @param other The histograms to add.
+         */
+        void merge(const Latencies& other);
+    };
+
+    /**
+     * @brief Constructs a LoadGenerator with its epoll instance.
+     * @param options What the sessions do.
+     * @param sessions The number of concurrent sessions.
+     */
+    LoadGenerator(const Options& options, std::size_t sessions);
+
+    /**
+     * @brief Closes every connection.
+     */
+    ~LoadGenerator();
+
+    LoadGenerator(const LoadGenerator&) = delete;
+    LoadGenerator& operator=(const LoadGenerator&) = delete;
+
+    /**
+     * @brief Runs the sessions on the calling thread until stop() is called.
+     */
+    void run();
+
+    /**
+     * @brief Makes run() return. Safe to call from any thread.
+     */
+    void stop();
+
+    /**
+     * @brief Gets the running totals. Safe to call from any thread.
+     * @return The counters.
+     */
+    const Counters& counters() const { return m_counters; }
+
+    /**
+     * @brief Gets a copy of the latency histograms. Safe to call from any thread.
+     * @return The histograms recorded so far.
+     */
+    Latencies latencies() const;
+
+    /**
+     * @brief Resolves a numeric address into Options::server.
+     * @param host The numeric IPv4 or IPv6 address.
+     * @param port The port.
+     * @param options Receives the address.
+     * @return False if the address is malformed.
+     */
+    static bool resolve(const std::string& host, std::uint16_t port, Options& options);
+
+private:
+    /**
+     * @enum Phase
+     * @brief Where a session is in its life.
+     */
+    enum class Phase : std::uint8_t {
+        Idle,         ///< Not connected; waiting in the connect queue or for a retry.
+        Connecting,   ///< Non-blocking connect in progress.
+        Enrolling,    ///< Enroll written; waiting for the first challenge.
+        Running       ///< Answering challenges.
+    };
+
+    /**
+     * @enum TimerKind
+     * @brief What a scheduled timer does to its session.
+     */
+    enum class TimerKind : std::uint8_t {
+        Respond,      ///< Answer the next queued challenge.
+        Reconnect     ///< Queue the session for a new connection.
+    };
+
+    /**
+     * @struct Session
+     * @brief One simulated client.
+     */
+    struct Session {
+        int socket = -1;                           ///< The connection, while connected.
+        Phase phase = Phase::Idle;                 ///< The session's phase.
+        LamportAuth chain;                         ///< The current chain; rebuilt for every connection.
+        Protocol::FrameParser parser;              ///< Reassembles the server's frames.
+        std::vector<std::uint64_t> queued;         ///< Challenges received and not answered yet, in order.
+        std::vector<std::uint8_t> output;          ///< Bytes the kernel has not accepted yet.
+        std::int64_t phaseStart = 0;               ///< When the connect or the Enroll was issued, in us.
+        std::int64_t lastChallenge = 0;            ///< When challenges last arrived, in us; 0 before the first.
+        std::int64_t lastResponse = 0;             ///< When responses were last written, in us; 0 once answered.
+        std::int64_t nextResponse = 0;             ///< Earliest time of the next response under roundRate, in us.
+        bool responseTimer = false;                ///< Set while a Respond timer is scheduled.
+        bool finished = false;                     ///< Set once the last round is answered.
+    };
+
+    /**
+     * @struct Timer
+     * @brief A scheduled action on a session, ordered by due time.
+     */
+    struct Timer {
+        std::int64_t due;           ///< When it fires, in us.
+        std::size_t session;        ///< The session.
+        TimerKind kind;             ///< What it does.
+
+        bool operator>(const Timer& other) const { return due > other.due; }
+    };
+
+    /**
+     * @brief Gets the current time.
+     * @return Microseconds on the steady clock.
+     */
+    static std::int64_t now();
+
+    /**
+     * @brief Opens queued connections, as many as the connection rate allows.
+     * @param time The current time.
+     */
+    void connectQueued(std::int64_t time);
+
+    /**
+     * @brief Builds a new chain for a session and starts connecting it.
+     * @param index The session.
+     */
+    void connect(std::size_t index);
+
+    /**
+     * @brief Completes a non-blocking connect and writes the Enroll frame.
+     * @param index The session.
+     */
+    void connected(std::size_t index);
+
+    /**
+     * @brief Reads what the server sent and answers the challenges it completes.
+     * @param index The session.
+     */
+    void readable(std::size_t index);
+
+    /**
+     * @brief Handles one frame from the server.
+     * @param index The session.
+     * @param frame The frame.
+     * @param time When it was read.
+     * @return False on a protocol error.
+     */
+    bool handleFrame(std::size_t index, const Protocol::Frame& frame, std::int64_t time);
+
+    /**
+     * @brief Writes the responses to a session's queued challenges, as many as roundRate allows.
+     * @param index The session.
+     * @param time The current time.
+     */
+    void respond(std::size_t index, std::int64_t time);
+
+    /**
+     * @brief Writes bytes to a session, keeping what the kernel does not accept.
+     * @param index The session.
+     * @param data The bytes.
+     * @param size The number of bytes.
+     * @return False if the connection failed and was closed.
+     */
+    bool send(std::size_t index, const std::uint8_t* data, std::size_t size);
+
+    /**
+     * @brief Writes a session's pending output.
+     * @param index The session.
+     * @return False if the connection failed and was closed.
+     */
+    bool flush(std::size_t index);
+
+    /**
+     * @brief Closes a session's connection and schedules its next one.
+     * @param index The session.
+     * @param failed True if the connection ended before the last round: counted, and retried after a pause.
+     */
+    void disconnect(std::size_t index, bool failed);
+
+    /**
+     * @brief Records a latency in one of the histograms.
+     * @param histogram The histogram, a member of m_latencies.
+     * @param micros The latency.
+     */
+    void record(LatencyHistogram& histogram, std::int64_t micros);
+
+    Options m_options;                                          ///< What the sessions do.
+    int m_epoll = -1;                                           ///< The epoll instance.
+    int m_wake = -1;                                            ///< eventfd used by stop().
+    std::atomic<bool> m_running{true};                          ///< Cleared by stop().
+    std::vector<std::unique_ptr<Session>> m_sessions;           ///< Every session, by index.
+    std::queue<std::size_t> m_connectQueue;                     ///< Sessions waiting to connect, in order.
+    std::int64_t m_nextConnect = 0;                             ///< Earliest time of the next connect under connectRate.
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> m_timers; ///< Pending timers, earliest first.
+    Counters m_counters;                                        ///< Running totals.
+    mutable std::mutex m_latencyLock;                           ///< Guards m_latencies for latencies().
+    Latencies m_latencies;                                      ///< The latency histograms.
+    std::uint8_t m_readBuffer[16 * 1024];                       ///< Receives socket data; shared by all sessions.
+};
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include "CryptoUtils.hpp"
+#include "Digest.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @namespace Protocol
+ * @brief The framed binary wire protocol between client and server.
+ *
+ * Every message is a frame with a 4-byte header followed by its payload
+ * (all integers big-endian):
+ *
+ *     offset  size  field
+ *          0     1  protocol version (VERSION)
+ *          1     1  message type (MessageType)
+ *          2     2  payload length
+ *          4     n  payload
+ *
+ * Payloads:
+ *   - Enroll    (client -> server): chain format (1), hash algorithm (1), anchor h_n (32)
+ *   - Challenge (server -> client): counter c (8)
+ *   - Response  (client -> server): counter c (8), OTP h_{n-c} (32)
+ *   - Resume    (client -> server): anchor h_n (32) of a chain enrolled earlier
+ *   - ResumeAck (server -> client): accepted (1), last verified counter (8)
+ *
+ * A client starts a connection with Enroll, or with Resume to continue a chain from
+ * the last verified counter; if the server rejects the resume, the client enrolls.
+ *
+ * Frames may be split or coalesced arbitrarily by TCP; FrameParser reassembles them.
+ */
+namespace Protocol {
+
+    constexpr std::uint8_t VERSION = 1;         ///< Version byte of every frame.
+    constexpr std::size_t HEADER_SIZE = 4;      ///< Size of the frame header in bytes.
+    constexpr std::size_t MAX_FRAME_SIZE = 64;  ///< Largest frame accepted; bigger frames are a protocol error.
+
+    /**
+     * @enum MessageType
+     * @brief The type byte of a frame.
+     */
+    enum class MessageType : std::uint8_t {
+        Enroll = 1,    ///< The client's anchor and chain parameters.
+        Challenge = 2, ///< A challenge counter.
+        Response = 3,  ///< The OTP answering a challenge.
+        Resume = 4,    ///< Continue a previously enrolled chain.
+        ResumeAck = 5  ///< The server's answer to Resume.
+    };
+
+    constexpr std::size_t ENROLL_FRAME_SIZE = HEADER_SIZE + 2 + Digest::SIZE;    ///< Size of an Enroll frame.
+    constexpr std::size_t CHALLENGE_FRAME_SIZE = HEADER_SIZE + 8;                ///< Size of a Challenge frame.
+    constexpr std::size_t RESPONSE_FRAME_SIZE = HEADER_SIZE + 8 + Digest::SIZE;  ///< Size of a Response frame.
+    constexpr std::size_t RESUME_FRAME_SIZE = HEADER_SIZE + Digest::SIZE;        ///< Size of a Resume frame.
+    constexpr std::size_t RESUME_ACK_FRAME_SIZE = HEADER_SIZE + 1 + 8;           ///< Size of a ResumeAck frame.
+
+    /**
+     * @struct Frame
+     * @brief A complete frame; the payload points into the parser's input or its reassembly buffer.
+     */
+    struct Frame {
+        MessageType type;             ///< The message type.
+        const std::uint8_t* payload;  ///< The payload bytes; valid only during the FrameParser callback.
+        std::size_t length;           ///< The payload length.
+    };
+
+    /**
+     * @brief Writes an Enroll frame.
+     * @param out Buffer of at least ENROLL_FRAME_SIZE bytes.
+     * @param chainParams The chain format and hash function.
+     * @param anchor The anchor h_n.
+     * @return The number of bytes written.
+     */
+    std::size_t encodeEnroll(std::uint8_t* out, const ChainParams& chainParams, const Digest& anchor);
+
+    /**
+     * @brief Writes a Challenge frame.
+     * @param out Buffer of at least CHALLENGE_FRAME_SIZE bytes.
+     * @param counter The challenge counter c.
+     * @return The number of bytes written.
+     */
+    std::size_t encodeChallenge(std::uint8_t* out, std::uint64_t counter);
+
+    /**
+     * @brief Writes a Response frame.
+     * @param out Buffer of at least RESPONSE_FRAME_SIZE bytes.
+     * @param counter The challenge counter c being answered.
+     * @param otp The OTP h_{n-c}.
+     * @return The number of bytes written.
+     */
+    std::size_t encodeResponse(std::uint8_t* out, std::uint64_t counter, const Digest& otp);
+
+    /**
+     * @brief Writes a Resume frame.
+     * @param out Buffer of at least RESUME_FRAME_SIZE bytes.
+     * @param anchor The anchor h_n the chain was enrolled with.
+     * @return The number of bytes written.
+     */
+    std::size_t encodeResume(std::uint8_t* out, const Digest& anchor);
+
+    /**
+     * @brief Writes a ResumeAck frame.
+     * @param out Buffer of at least RESUME_ACK_FRAME_SIZE bytes.
+     * @param accepted Whether the chain was resumed.
+     * @param counter The last verified challenge counter of the chain (0 if rejected).
+     * @return The number of bytes written.
+     */
+    std::size_t encodeResumeAck(std::uint8_t* out, bool accepted, std::uint64_t counter);
+
+    /**
+     * @brief Decodes the payload of an Enroll frame.
+     * @param frame The frame.
+     * @param chainParams Receives the chain parameters.
+     * @param anchor Receives the anchor.
+     * @return True if the frame is a well-formed Enroll frame with a supported format and algorithm.
+     */
+    bool decodeEnroll(const Frame& frame, ChainParams& chainParams, Digest& anchor);
+
+    /**
+     * @brief Decodes the payload of a Challenge frame.
+     * @param frame The frame.
+     * @param counter Receives the challenge counter.
+     * @return True if the frame is a well-formed Challenge frame.
+     */
+    bool decodeChallenge(const Frame& frame, std::uint64_t& counter);
+
+    /**
+     * @brief Decodes the payload of a Response frame.
+     * @param frame The frame.
+     * @param counter Receives the challenge counter.
+     * @param otp Receives the OTP.
+     * @return True if the frame is a well-formed Response frame.
+     */
+    bool decodeResponse(const Frame& frame, std::uint64_t& counter, Digest& otp);
+
+    /**
+     * @brief Decodes the payload of a Resume frame.
+     * @param frame The frame.
+     * @param anchor Receives the anchor.
+     * @return True if the frame is a well-formed Resume frame.
+     */
+    bool decodeResume(const Frame& frame, Digest& anchor);
+
+    /**
+     * @brief Decodes the payload of a ResumeAck frame.
+     * @param frame The frame.
+     * @param accepted Receives whether the chain was resumed.
+     * @param counter Receives the last verified challenge counter.
+     * @return True if the frame is a well-formed ResumeAck frame.
+     */
+    bool decodeResumeAck(const Frame& frame, bool& accepted, std::uint64_t& counter);
+
+    /**
+     * @class FrameParser
+     * @brief Incremental frame parser for a byte stream.
+     *
+     * Complete frames inside the input are handed out in place, without copying;
+     * only a frame split across two reads is copied into a small fixed buffer.
+     * The parser never allocates, so one can be kept inline per connection.
+     */
+    class FrameParser {
+    public:
+        /**
+         * @brief Consumes received bytes and reports every frame they complete.
+         * @param data The received bytes.
+         * @param len The number of bytes.
+         * @param fn Called as fn(const Frame&) for each frame, in order; returning false stops parsing.
+         * @return False on a protocol error (bad version or oversized frame) or if @p fn stopped parsing.
+         */
+        template <typename Fn>
+        bool feed(const std::uint8_t* data, std::size_t len, Fn&& fn)
+        {
+            if (failed) return false;
+
+            // Finish a frame started by an earlier read
+            if (pendingSize > 0) {
+                std::size_t need = (pendingSize < HEADER_SIZE) ? HEADER_SIZE - pendingSize : 0;
+                std::size_t take = (need < len) ? need : len;
+                std::memcpy(pending + pendingSize, data, take);
+                pendingSize += take;
+                data += take;
+                len -= take;
+                if (pendingSize < HEADER_SIZE) return true;
+
+                std::size_t frameSize = 0;
+                if (!checkHeader(pending, frameSize)) return fail();
+                take = frameSize - pendingSize;
+                if (take > len) take = len;
+                std::memcpy(pending + pendingSize, data, take);
+                pendingSize += take;
+                data += take;
+                len -= take;
+                if (pendingSize < frameSize) return true;
+
+                pendingSize = 0;
+                if (!fn(makeFrame(pending, frameSize))) return fail();
+            }
+
+            // Frames wholly inside the input are handed out in place
+            while (len >= HEADER_SIZE) {
+                std::size_t frameSize = 0;
+                if (!checkHeader(data, frameSize)) return fail();
+                if (len < frameSize) break;
+                if (!fn(makeFrame(data, frameSize))) return fail();
+                data += frameSize;
+                len -= frameSize;
+            }
+
+            // Keep the start of a frame that continues in the next read
+            std::memcpy(pending, data, len);
+            pendingSize = len;
+            return true;
+        }
+
+        /**
+         * @brief Checks whether the stream has hit a protocol error.
+         * @return True once feed() has failed; the connection should be closed.
+         */
+        bool hasFailed() const { return failed; }
+
+    private:
+        /**
+         * @brief Validates a frame header.
+         * @param header The 4 header bytes.
+         * @param frameSize Receives the total frame size.
+         * @return True if the version is supported and the frame fits MAX_FRAME_SIZE.
+         */
+        static bool checkHeader(const std::uint8_t* header, std::size_t& frameSize)
+        {
+            frameSize = HEADER_SIZE + ((std::size_t(header[2]) << 8) | header[3]);
+            return header[0] == VERSION && frameSize <= MAX_FRAME_SIZE;
+        }
+
+        static Frame makeFrame(const std::uint8_t* frame, std::size_t frameSize)
+        {
+            return Frame{static_cast<MessageType>(frame[1]), frame + HEADER_SIZE, frameSize - HEADER_SIZE};
+        }
+
+        bool fail()
+        {
+            failed = true;
+            return false;
+        }
+
+        std::uint8_t pending[MAX_FRAME_SIZE]; ///< The start of a frame split across reads.
+        std::size_t pendingSize = 0;          ///< The number of bytes in @p pending.
+        bool failed = false;                  ///< Set on a protocol error.
+    };
+}
+
+#endif
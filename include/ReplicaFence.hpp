@@ -0,0 +1,49 @@
+#ifndef REPLICA_FENCE_HPP
+#define REPLICA_FENCE_HPP
+
+#include <string>
+
+/**
+ * @class ReplicaFence
+ * @brief Keeps a single server active per replicaSocket: an flock() on the lock file <replicaSocket>.lock.
+ *
+ * The active server holds the lock for as long as its process lives, and the
+ * kernel releases it however the process ends. A standby takes over only once
+ * it has taken the lock itself. A replication link that merely dropped, say
+ * after a send timeout while the primary is still serving, therefore sends the
+ * standby back to following instead of starting a second active server whose
+ * chains diverge from the primary's. An active server takes the lock before
+ * it opens its table and store, and listeners, and with them SO_REUSEPORT,
+ * are only opened once the lock is held.
+ */
+class ReplicaFence {
+public:
+    ReplicaFence() = default;
+
+    /**
+     * @brief Releases the lock.
+     */
+    ~ReplicaFence();
+
+    ReplicaFence(const ReplicaFence&) = delete;
+    ReplicaFence& operator=(const ReplicaFence&) = delete;
+
+    /**
+     * @brief Takes the lock without waiting; may be retried.
+     * @param socketPath The replica socket; the lock file is created beside it.
+     * @return True if this process holds the lock, false if another one does or the file cannot be opened.
+     */
+    bool acquire(const std::string& socketPath);
+
+    /**
+     * @brief Checks whether this process holds the lock.
+     * @return True after a successful acquire().
+     */
+    bool isHeld() const;
+
+private:
+    int m_fd = -1;         ///< The open lock file.
+    bool m_held = false;   ///< True once the lock is taken.
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef REPLICATION_RECEIVER_HPP
+#define REPLICATION_RECEIVER_HPP
+
+#include "ChainRegistry.hpp"
+#include "ReplicaFence.hpp"
+#include <string>
+
+/**
+ * @class ReplicationReceiver
+ * @brief The standby's side of replication: applies the primary's stream to a chain registry until the primary is lost.
+ *
+ * The standby listens on a Unix socket and accepts one primary at a time. The
+ * primary's full state, between SyncBegin and SyncEnd, replaces the registry's
+ * chains; every record after it is applied as it arrives. Once synchronised, a
+ * closed connection or a silence longer than the timeout (the primary sends a
+ * heartbeat every second) means the link is gone. The standby takes over only
+ * once it also holds the ReplicaFence, i.e. the primary's process has exited:
+ * follow() then returns so that the standby can take over the listener, with
+ * every chain at its last replicated counter. A primary that is still alive
+ * is waited for until it reconnects or exits.
+ */
+class ReplicationReceiver {
+public:
+    ReplicationReceiver() = default;
+
+    /**
+     * @brief Closes the socket.
+     */
+    ~ReplicationReceiver();
+
+    ReplicationReceiver(const ReplicationReceiver&) = delete;
+    ReplicationReceiver& operator=(const ReplicationReceiver&) = delete;
+
+    /**
+     * @brief Listens on a Unix socket, replacing a stale socket file.
+     * @param socketPath The path of the socket.
+     * @return False if the socket cannot be created.
+     */
+    bool listen(const std::string& socketPath);
+
+    /**
+     * @brief Applies the stream of each primary that connects, until a synchronised primary is gone for good.
+     * @param chains The registry to keep in step with the primary's.
+     * @param timeoutSeconds How long the primary may stay silent before its link is considered lost,
+     *        and how often the fence is retried while no primary is connected.
+     * @param fence Taken once the link is lost; held on return.
+     * @return True once the fence is held, false if the socket failed.
+     */
+    bool follow(ChainRegistry& chains, int timeoutSeconds, ReplicaFence& fence);
+
+    /**
+     * @brief Closes the socket and removes its file. Safe to call when closed.
+     */
+    void close();
+
+private:
+    /**
+     * @brief Applies one connection's stream.
+     * @param fd The connection.
+     * @param chains The registry.
+     * @param synced Set once a full state has been applied.
+     * @return True if the primary was lost (the connection closed or went silent), false on a corrupt stream.
+     */
+    bool receive(int fd, ChainRegistry& chains, bool& synced);
+
+    std::string m_socketPath;  ///< The socket file.
+    int m_fd = -1;             ///< The listening socket.
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef REPLICATION_SENDER_HPP
+#define REPLICATION_SENDER_HPP
+
+#include "ChainStore.hpp"
+#include "ChainVerifier.hpp"
+#include "Digest.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ReplicationSender
+ * @brief Streams the changes of the primary's chain registry to a hot standby over a Unix socket.
+ *
+ * Every enrollment, advance, exhaustion and removal is appended as a ChainLog record to an
+ * in-memory buffer; a sender thread writes whatever has accumulated in one
+ * send(), so the event loops only copy a record and never wait for the standby.
+ * Whenever the sender (re)connects, and whenever the standby has fallen so far
+ * behind that the buffer overflows, it asks the registry for its full state and
+ * sends it first, between SyncBegin and SyncEnd. When idle it sends a Heartbeat
+ * every second, so the standby can tell a quiet primary from a dead one.
+ */
+class ReplicationSender {
+public:
+    ReplicationSender() = default;
+
+    /**
+     * @brief Stops the sender thread.
+     */
+    ~ReplicationSender();
+
+    ReplicationSender(const ReplicationSender&) = delete;
+    ReplicationSender& operator=(const ReplicationSender&) = delete;
+
+    /**
+     * @brief Starts the sender thread, which connects to the standby and keeps reconnecting.
+     * @param socketPath The path of the standby's Unix socket.
+     * @param resync Called by the sender thread when the standby needs the full state; must call resend().
+     */
+    void start(const std::string& socketPath, std::function<void()> resync);
+
+    /**
+     * @brief Sends what is buffered and stops the sender thread. Safe to call when stopped.
+     */
+    void stop();
+
+    /**
+     * @brief Checks whether changes are being streamed.
+     * @return True while connected to a standby.
+     */
+    bool isConnected() const;
+
+    /**
+     * @brief Queues a newly enrolled chain.
+     * @param anchor The anchor.
+     * @param verifier The freshly enrolled verifier.
+     */
+    void logEnroll(const Digest& anchor, const ChainVerifier& verifier);
+
+    /**
+     * @brief Queues a chain's progress after a successful verification.
+     * @param anchor The anchor.
+     * @param verifier The verifier holding the last verified link.
+     * @param verifiedIteration The challenge number of the last verified response.
+     */
+    void logAdvance(const Digest& anchor, const ChainVerifier& verifier, std::int32_t verifiedIteration);
+
+    /**
+     * @brief Queues that every link of a chain was used.
+     * @param anchor The anchor.
+     */
+    void logExhaust(const Digest& anchor);
+
+    /**
+     * @brief Queues that a chain was forgotten.
+     * @param anchor The anchor.
+     */
+    void logRemove(const Digest& anchor);
+
+    /**
+     * @brief Replaces everything queued with the full state. Must be called under a lock
+     * that excludes the log*() calls, so that no change falls between the state and the records after it.
+     * @param entries Every chain, as of this call.
+     */
+    void resend(const std::vector<ChainStore::Entry>& entries);
+
+private:
+    /**
+     * @brief Appends one encoded record if connected, and wakes the sender thread.
+     * @param record The record.
+     * @param size The size of the record.
+     */
+    void append(const std::uint8_t* record, std::size_t size);
+
+    /**
+     * @brief Connects to the standby's socket.
+     * @return The socket, or -1.
+     */
+    int connectToStandby() const;
+
+    /**
+     * @brief The sender thread: connects, resyncs and writes batches until stopped.
+     */
+    void run();
+
+    std::string m_socketPath;                 ///< The standby's Unix socket.
+    std::function<void()> m_resync;           ///< Asks the registry for its full state.
+
+    mutable std::mutex m_lock;                ///< Guards the members below.
+    std::condition_variable m_wake;           ///< Wakes the sender thread.
+    std::vector<std::uint8_t> m_pending;      ///< Records queued since the last send.
+    bool m_connected = false;                 ///< True while a standby receives the records.
+    bool m_resyncNeeded = false;              ///< Set when queued records had to be dropped.
+    bool m_stopping = false;                  ///< Set by stop().
+    std::thread m_sender;                     ///< The sender thread, while started.
+};
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef ROUTER_HPP
+#define ROUTER_HPP
+
+#include "AdmissionControl.hpp"
+#include "HashRing.hpp"
+#include "TimerWheel.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+
+/**
+ * @class Router
+ * @brief A front process that spreads clients over server shards by the identity they authenticate.
+ *
+ * The router listens where clients expect the server and reads only the first
+ * frame of each connection, which is always an Enroll or a Resume carrying the
+ * identity's anchor. The HashRing names the shard that holds that identity's
+ * chain; the router connects to it, forwards the first frame and from then on
+ * copies bytes both ways without parsing them. A client therefore reaches the
+ * same shard every time it reconnects, and each shard serves its own identities
+ * with its own verifier table. Like EpollServer, it is one epoll reactor; while
+ * one side is not draining, the router stops reading from the other.
+ *
+ * Until its first frame is complete a connection costs the router a socket and
+ * a buffer without reaching any shard, so it has a deadline: a client that has
+ * not identified itself within firstFrameTimeout seconds is dropped. New
+ * connections are charged to their source address in an AdmissionControl, so
+ * one source cannot open unidentified connections faster than its rate.
+ */
+class Router
+{
+public:
+    /**
+     * @struct ShardLoad
+     * @brief The load the router has sent to one shard.
+     */
+    struct ShardLoad {
+        std::string name;               ///< The shard's "host:port".
+        double share = 0;               ///< Its fraction of the hash ring.
+        std::size_t active = 0;         ///< Clients currently routed to it.
+        std::uint64_t routed = 0;       ///< Clients ever routed to it.
+        std::uint64_t unreachable = 0;  ///< Clients dropped because it could not be reached.
+        std::uint64_t bytesIn = 0;      ///< Bytes forwarded from clients to it.
+        std::uint64_t bytesOut = 0;     ///< Bytes forwarded from it to clients.
+    };
+
+    /**
+     * @brief Constructs a Router with its epoll instance.
+     * @param verbose Print every routed connection to stdout.
+     * @param firstFrameTimeout Seconds a client may take to send its first frame; 0 waits forever.
+     * @param admission The per-source connection rate; only sourceRate and sourceBurst apply.
+     */
+    explicit Router(bool verbose, int firstFrameTimeout = 0, const AdmissionSettings& admission = AdmissionSettings());
+
+    /**
+     * @brief Closes every connection and the listener.
+     */
+    ~Router();
+
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
+
+    /**
+     * @brief Adds a shard to the ring. Must be called before run().
+     * @param address The shard's numeric "host:port", or "[host]:port" for IPv6.
+     * @return False if the address is malformed or already added.
+     */
+    bool addShard(const std::string& address);
+
+    /**
+     * @brief Binds and listens on an address.
+     * @param address The numeric IPv4 or IPv6 address.
+     * @param port The port.
+     * @return False on error; the reason is printed to stderr.
+     */
+    bool listen(const std::string& address, std::uint16_t port);
+
+    /**
+     * @brief Runs the event loop on the calling thread until stop() is called.
+     */
+    void run();
+
+    /**
+     * @brief Makes run() return. Safe to call from any thread.
+     */
+    void stop();
+
+    /**
+     * @brief Gets the load of every shard. Safe to call from any thread.
+     * @return One entry per shard, in the order they were added.
+     */
+    std::vector<ShardLoad> load() const;
+
+    /**
+     * @brief Prints load() as a table.
+     * @param out The stream.
+     */
+    void report(std::ostream& out) const;
+
+private:
+    /**
+     * @struct Shard
+     * @brief A shard's address and counters.
+     */
+    struct Shard {
+        sockaddr_storage address = {};  ///< The resolved address.
+        socklen_t addressLength = 0;    ///< The length of @p address.
+        ShardLoad load;                 ///< The counters, guarded by loadLock.
+    };
+
+    /**
+     * @struct Link
+     * @brief One client connection and, once routed, its connection to a shard.
+     */
+    struct Link {
+        int client = -1;                       ///< The client's socket.
+        int shard = -1;                        ///< The shard's socket, once the first frame is read.
+        std::size_t shardIndex = 0;            ///< The shard, once routed.
+        TimerWheel::TimerId deadline = TimerWheel::NONE; ///< Drops the client if its first frame is late.
+        bool connected = false;                ///< Set when the shard's socket has connected.
+        std::vector<std::uint8_t> toShard;     ///< The first frame, then bytes the shard has not accepted yet.
+        std::vector<std::uint8_t> toClient;    ///< Bytes the client has not accepted yet.
+    };
+
+    /**
+     * @brief Accepts every pending connection.
+     */
+    void acceptAll();
+
+    /**
+     * @brief Gets the current time.
+     * @return Milliseconds since construction.
+     */
+    std::int64_t now() const;
+
+    /**
+     * @brief Drops every client whose first frame is overdue.
+     */
+    void expireDeadlines();
+
+    /**
+     * @brief Reads the first frame of an unrouted client and, once complete, connects it to its shard.
+     * @param link The link.
+     * @return False if the link was closed.
+     */
+    bool readFirstFrame(Link* link);
+
+    /**
+     * @brief Starts connecting a link to the shard that owns its identity.
+     * @param link The link; toShard holds the first frame.
+     * @param anchor The identity's anchor.
+     * @return False if the link was closed.
+     */
+    bool route(Link* link, const Digest& anchor);
+
+    /**
+     * @brief Copies what one side has sent to the other, until the source is drained or the destination is full.
+     * @param link The link.
+     * @param fromClient True to copy client to shard, false for shard to client.
+     * @return False if the link was closed.
+     */
+    bool relay(Link* link, bool fromClient);
+
+    /**
+     * @brief Writes the bytes pending towards one side.
+     * @param link The link.
+     * @param toClient True to flush towards the client, false towards the shard.
+     * @return False if the link was closed.
+     */
+    bool flush(Link* link, bool toClient);
+
+    /**
+     * @brief Sets the readiness a socket of a link is watched for, from what is pending on the link.
+     * @param link The link.
+     */
+    void watch(Link* link);
+
+    /**
+     * @brief Closes both sockets of a link.
+     * @param link The link; invalid afterwards.
+     */
+    void closeLink(Link* link);
+
+    bool m_verbose = false;                        ///< Print routed connections.
+    int m_epoll = -1;                              ///< The epoll instance.
+    int m_listener = -1;                           ///< The listening socket.
+    int m_wake = -1;                               ///< eventfd used by stop().
+    std::atomic<bool> m_running{false};            ///< Cleared by stop().
+    HashRing m_ring;                               ///< Identity to shard mapping.
+    std::vector<Shard> m_shards;                   ///< The shards, by ring index.
+    mutable std::mutex m_loadLock;                 ///< Guards the shards' counters for load().
+    std::vector<std::unique_ptr<Link>> m_links;    ///< Open links, indexed by client socket.
+    std::vector<int> m_owners;                     ///< The client socket of every open socket, indexed by socket.
+    int m_firstFrameTimeout = 0;                   ///< Seconds allowed for a first frame; 0 for no deadline.
+    AdmissionControl m_admission;                  ///< Charges new connections to their source.
+    std::chrono::steady_clock::time_point m_epoch; ///< Time base of the deadlines.
+    TimerWheel m_deadlines;                        ///< First-frame deadlines, keyed by client socket.
+    std::uint8_t m_readBuffer[64 * 1024];          ///< Receives socket data; shared by all links.
+};
+
+#endif
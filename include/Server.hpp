@@ -5,17 +5,18 @@
 #include <QTcpSocket>
 #include <QTimer>
 #include "ConfigManager.hpp"
-#include "LamportAuth.hpp"
+#include "ServerCore.hpp"
 
 /**
  * @class Server
  * @brief Manages the server-side logic for the Lamport authentication.
  *
- * This class handles listening for incoming client connections, sending
- * authentication challenges, and verifying the responses (OTPs) received
- * from the client.
+ * This class is the Qt adapter of ServerCore: it listens for incoming client
+ * connections, feeds their data to the core, delivers the challenges the core
+ * sends, and drives the core's challenge schedule with a single timer. The
+ * protocol itself (enrollment, challenges, verification) lives in ServerCore.
  */
-class Server : public QTcpServer
+class Server : public QTcpServer, private ServerTransport
 {
     Q_OBJECT
 
@@ -24,8 +25,25 @@ public:
      * @brief Constructs a Server object.
      * @param filePath The path to the configuration file.
      * @param parent The parent QObject, for memory management.
+     * @param reusePort Listen with SO_REUSEPORT so that several servers (one per event loop)
+     *        can share the port, the kernel spreading new connections across them.
+     * @param chains The chain registry shared by all event loops, or nullptr for a private one;
+     *        must outlive the Server.
+     * @param admission The admission control shared by all event loops, or nullptr for a private
+     *        one; must outlive the Server.
+     * @param liveConfig The watched configuration whose reloads the protocol settings follow, or
+     *        nullptr to keep the settings read from @p filePath; must outlive the Server.
      */
-    explicit Server(const QString& filePath, QObject *parent = nullptr);
+    explicit Server(const QString& filePath, QObject *parent = nullptr, bool reusePort = false,
+                    ChainRegistry* chains = nullptr, AdmissionControl* admission = nullptr,
+                    const LiveConfig* liveConfig = nullptr);
+
+    /**
+     * @brief Reads the protocol settings from the configuration.
+     * @param config The configuration.
+     * @return The settings for ServerCore.
+     */
+    static ServerSettings settingsFrom(const ConfigManager& config);
 
     /**
      * @brief Destroys the Server object.
@@ -41,11 +59,12 @@ public:
 
     /**
      * @brief Starts the periodic sending of authentication challenges.
+     * Every enrolled session is challenged, as is every session that enrolls while running.
      */
     void startAuthentication();
 
     /**
-     * @brief Stops the authentication process.
+     * @brief Stops the authentication process for all sessions.
      */
     void stopAuthentication();
 
@@ -59,10 +78,16 @@ public:
 
     /**
      * @brief Checks if there is an active client connection.
-     * @return True if a client is connected, false otherwise.
+     * @return True if at least one client is connected, false otherwise.
      */
     bool hasActiveClient() const;
 
+    /**
+     * @brief Gets the number of connected clients.
+     * @return The number of open sessions.
+     */
+    std::size_t sessionCount() const;
+
     /**
      * @brief Checks if the authentication challenge process is running.
      * @return True if the process is active, false otherwise.
@@ -78,19 +103,9 @@ private slots:
     void handleNewConnection();
 
     /**
-     * @brief Sends the next authentication challenge to the client.
-     */
-    void sendChallenge();
-
-    /**
-     * @brief Receives and processes a response (OTP) from the client.
-     */
-    void receiveResponse();
-
-    /**
-     * @brief Handles the disconnection of the client.
+     * @brief Fires the core's due timers: challenges, response timeouts and idle evictions.
      */
-    void onClientDisconnected();
+    void processTimers();
 
 signals:
     // --- Signals to communicate with the UI (MainWindow) ---
@@ -130,17 +145,42 @@ private:
     void startServer();
 
     /**
-     * @brief Serializes an integer into a QByteArray for network transmission.
-     * @param source The integer to serialize.
-     * @return The resulting QByteArray.
+     * @brief Creates a listening socket with SO_REUSEPORT and hands it to QTcpServer.
+     * @param address The address to bind.
+     * @param port The port to bind.
+     * @return True on success, false otherwise.
      */
-    QByteArray IntToArray(qint32 source);
+    bool listenReusePort(const QHostAddress& address, quint16 port);
+
+    /**
+     * @brief Reads everything a client sent and passes it to the core.
+     * @param id The session the data arrived on.
+     */
+    void receiveResponse(SessionId id);
+
+    /**
+     * @brief Handles the disconnection of a client. Cleans up its session.
+     * @param id The session of the client.
+     */
+    void onClientDisconnected(SessionId id);
+
+    /**
+     * @brief Arms the tick timer for the core's next timer.
+     */
+    void armTickTimer();
+
+    // --- ServerTransport ---
+
+    void send(void* connection, const std::uint8_t* data, std::size_t len) override;
+    void log(const std::string& message) override;
+    void drop(void* connection) override;
 
-    QTcpSocket* m_clientSocket = nullptr; ///< Socket for the connected client.
-    ConfigManager m_config;               ///< Manages configuration data.
-    LamportAuth m_auth;                   ///< Handles Lamport authentication logic.
-    QTimer* m_challengeTimer = nullptr;   ///< Timer for sending challenges periodically.
-    int m_currentIteration = 1;           ///< Tracks the current authentication iteration/challenge number.
+    ConfigManager m_config;             ///< Manages configuration data.
+    bool m_reusePort = false;           ///< Listen with SO_REUSEPORT (one of several event loops).
+    ServerCore m_core;                  ///< Sessions, challenge schedule and verification.
+    ChainRegistry* m_chains = nullptr;  ///< The shared registry, whose store triggers processTimers(); or nullptr.
+    QTimer m_tickTimer;                 ///< Single-shot timer driving the core's timing wheel.
+    std::uint8_t m_readBuffer[4096];    ///< Receives socket data before it is parsed; shared by all sessions.
 };
 
 #endif // SERVER_HPP
\ No newline at end of file
@@ -0,0 +1,362 @@
+#ifndef SERVER_CORE_HPP
+#define SERVER_CORE_HPP
+
+#include "AdmissionControl.hpp"
+#include "ChainRegistry.hpp"
+#include "Protocol.hpp"
+#include "SessionTable.hpp"
+#include "TimerWheel.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class LiveConfig;
+
+/**
+ * @struct ServerSettings
+ * @brief The configuration values the server side of the protocol depends on.
+ */
+struct ServerSettings {
+    int sleepDuration = 1;        ///< Seconds between challenge rounds (sleepDuration).
+    int numberOfIterations = 0;   ///< The chain length n; challenges run from 1 to n - 1.
+    int skipWindow = 1;           ///< How many links behind a response may be.
+    int pipelineDepth = 1;        ///< How many challenges a session may have outstanding.
+    int responseTimeout = 0;      ///< Seconds a client may leave a challenge unanswered before it is dropped; 0 disables.
+    int idleTimeout = 0;          ///< Seconds a client may send nothing before it is evicted; 0 disables.
+    AdmissionSettings admission;  ///< Rate limits and verification budget; used when no AdmissionControl is shared.
+};
+
+/**
+ * @class ServerTransport
+ * @brief What ServerCore needs from the I/O layer it runs on.
+ *
+ * Implemented by the Qt Server and by the epoll reactor of the headless server.
+ */
+class ServerTransport {
+public:
+    virtual ~ServerTransport() = default;
+
+    /**
+     * @brief Sends bytes to a client as one write.
+     * @param connection The connection given to ServerCore::openSession().
+     * @param data The bytes.
+     * @param len The number of bytes.
+     */
+    virtual void send(void* connection, const std::uint8_t* data, std::size_t len) = 0;
+
+    /**
+     * @brief Reports a log message.
+     * @param message The message, prefixed with "Server: ".
+     */
+    virtual void log(const std::string& message) = 0;
+
+    /**
+     * @brief Tells whether the messages of every round (challenges sent, responses verified) are wanted.
+     * The core checks it before formatting them, so a quiet transport costs the verify path no allocation.
+     * @return True to receive them through log().
+     */
+    virtual bool verbose() const { return true; }
+
+    /**
+     * @brief Closes a connection the core has given up on (a timeout or idle eviction).
+     * The transport closes the session with ServerCore::closeSession(), at once or later.
+     * @param connection The connection given to ServerCore::openSession().
+     */
+    virtual void drop(void* connection) = 0;
+};
+
+/**
+ * @class ServerCore
+ * @brief The server (Alice) side of the protocol, independent of Qt and of the I/O model.
+ *
+ * Owns the session table, the chain registry and the timers of all sessions: parses
+ * each client's frames, enrolls or resumes chains, verifies responses, and decides
+ * when to send challenges and when to drop a client that does not answer or stays
+ * idle. Every connection and frame passes an AdmissionControl first, so floods are
+ * turned away before any hashing. All timers live in one TimerWheel, so the transport needs a single tick
+ * source: it feeds the core received bytes, delivers what it sends, and calls
+ * processTimers() when msUntilNextTimer() has elapsed.
+ *
+ * With a persisted ChainRegistry, no challenge goes out before the store has
+ * synced the advance it follows: challenge j follows the advance to j minus
+ * pipelineDepth, or the session's last advance if that is older. A challenge
+ * that must wait is held, and processTimers() sends it once durablePosition()
+ * has caught up; the transport registers with ChainRegistry::watchDurable() to
+ * run processTimers() after a sync whenever holdsChallenges() says so. A
+ * pipelined session thus keeps answering the challenges already outstanding
+ * while its advance is synced.
+ *
+ * Given a LiveConfig, the core picks up a reloaded configuration on its own
+ * thread, the next time it processes timers or opens a session: the challenge
+ * schedule, skip window, pipeline depth and timeouts change for every session,
+ * connected or not, without dropping any.
+ */
+class ServerCore {
+public:
+    /**
+     * @brief Constructs a ServerCore.
+     * @param settings The protocol settings; out-of-range values are clamped.
+     * @param transport The I/O layer; must outlive the core.
+     * @param chains The chain registry to share with the cores of other event loops,
+     *        or nullptr to keep one of its own; must outlive the core.
+     * @param admission The admission control to share with the cores of other event loops,
+     *        or nullptr to keep one of its own built from settings.admission; must outlive the core.
+     * @param config The configuration to follow when it is reloaded, or nullptr to keep @p settings; must outlive the core.
+     */
+    ServerCore(const ServerSettings& settings, ServerTransport& transport, ChainRegistry* chains = nullptr,
+               AdmissionControl* admission = nullptr, const LiveConfig* config = nullptr);
+
+    /**
+     * @brief Decides whether to accept a new connection, before any session is opened for it.
+     * @param source The AdmissionControl::sourceKey() of the client's address.
+     * @return False if the address is over its rate; the transport should close the connection at once.
+     */
+    bool admitConnection(std::uint64_t source);
+
+    /**
+     * @brief Opens a session for a new connection.
+     * @param connection The transport's connection object, passed back to ServerTransport::send().
+     * @param source The AdmissionControl::sourceKey() of the client's address, or 0 to exempt it from the source limit.
+     * @return The session identifier.
+     */
+    SessionId openSession(void* connection, std::uint64_t source = 0);
+
+    /**
+     * @brief Closes a session. Its chain stays registered for a later resume; once all
+     * of its links are used it is marked exhausted instead, and its anchor is refused from
+     * then on. Stale identifiers are ignored.
+     * @param id The session identifier.
+     */
+    void closeSession(SessionId id);
+
+    /**
+     * @brief Looks up the connection of a session.
+     * @param id The session identifier.
+     * @return The connection, or nullptr if the session is closed.
+     */
+    void* connection(SessionId id);
+
+    /**
+     * @brief Processes bytes received from a client.
+     * @param id The session the bytes arrived on.
+     * @param data The bytes.
+     * @param len The number of bytes.
+     * @return False if the client broke the protocol or failed verification; the transport should then drop it.
+     */
+    bool receive(SessionId id, const std::uint8_t* data, std::size_t len);
+
+    /**
+     * @brief Starts challenging every enrolled session, and every session that enrolls while running.
+     * @return False if the process was already running.
+     */
+    bool startAuthentication();
+
+    /**
+     * @brief Stops the challenges of all sessions.
+     * @return False if the process was not running.
+     */
+    bool stopAuthentication();
+
+    /**
+     * @brief Checks if the authentication process is running.
+     * @return True between startAuthentication() and stopAuthentication().
+     */
+    bool isAuthRunning() const;
+
+    /**
+     * @brief Fires every timer that is due: sends challenges whose turn has come,
+     * drops clients whose response timed out and evicts idle ones. Then sends the
+     * challenges held for advances the store has synced since.
+     */
+    void processTimers();
+
+    /**
+     * @brief Tells whether challenges wait for the chain store's next sync. Safe to call from any thread.
+     * @return True if processTimers() should run after the store's next sync.
+     */
+    bool holdsChallenges() const;
+
+    /**
+     * @brief Gets the time until processTimers() next has work to do. With a LiveConfig it is at
+     * most a second, so that a reload is applied even while no timer is due.
+     * @return Milliseconds (0 if already due), or -1 if no timer is scheduled.
+     */
+    std::int64_t msUntilNextTimer() const;
+
+    /**
+     * @brief Gets the number of open sessions.
+     * @return The session count.
+     */
+    std::size_t sessionCount() const;
+
+    /**
+     * @brief Gets the number of registered chains, attached or waiting to be resumed.
+     * @return The chain count.
+     */
+    std::size_t chainCount() const;
+
+    /**
+     * @brief Calls a function for every open session.
+     * @param fn A callable taking (SessionId, Session&).
+     */
+    template <typename Fn>
+    void forEachSession(Fn&& fn) { m_sessions.forEach(fn); }
+
+    /**
+     * @brief Builds the log prefix for a session.
+     * @param id The session identifier.
+     * @return "Server: Session <slot>: ".
+     */
+    static std::string sessionLabel(SessionId id);
+
+private:
+    /**
+     * @brief What a session timer is for; stored as the timer's kind.
+     */
+    enum TimerKind : std::uint8_t {
+        ChallengeTimer = 0, ///< Send the next challenge.
+        ResponseTimer = 1,  ///< Check that outstanding challenges have been answered.
+        IdleTimer = 2       ///< Check that the client has sent something recently.
+    };
+
+    /**
+     * @brief Gets the time since construction.
+     * @return Milliseconds on a monotonic clock.
+     */
+    std::int64_t now() const;
+
+    /**
+     * @brief Applies the reloadable settings of a new LiveConfig snapshot, if one was published.
+     * Timers armed under the old settings are re-armed where the new ones make them due sooner.
+     */
+    void refreshSettings();
+
+    /**
+     * @brief Clamps the settings to their valid ranges.
+     */
+    void clampSettings();
+
+    /**
+     * @brief Handles one frame received from a client: its enrollment or a response.
+     * @param id The session identifier.
+     * @param session The session.
+     * @param frame The frame.
+     * @return False if the frame is malformed, unexpected or fails verification.
+     */
+    bool handleFrame(SessionId id, Session& session, const Protocol::Frame& frame);
+
+    /**
+     * @brief Handles the first frame of a session: Enroll registers a new chain, Resume attaches a known one.
+     * @param id The session identifier.
+     * @param session The session.
+     * @param frame The frame.
+     * @return False if the frame is malformed or enrolls a chain that is already known.
+     */
+    bool attachChain(SessionId id, Session& session, const Protocol::Frame& frame);
+
+    /**
+     * @brief Copies a session's verifier and counter to its chain record after a successful verification.
+     * @param session The session; its logPosition is set to the advance's.
+     */
+    void saveProgress(Session& session);
+
+    /**
+     * @brief Verifies the in-order responses gathered in m_responseBatch in one multi-buffer batch.
+     * @param id The session identifier.
+     * @param session The session the responses belong to.
+     * @return False if any of them fails verification, or the verification budget is spent.
+     */
+    bool flushResponses(SessionId id, Session& session);
+
+    /**
+     * @brief Sends the next challenge of a session, or fills its pipeline window, and reschedules it.
+     * @param id The session identifier.
+     * @param session The session.
+     */
+    void sendChallenge(SessionId id, Session& session);
+
+    /**
+     * @brief Writes up to @p count consecutive challenges of a session in one write.
+     * @param id The session identifier.
+     * @param session The session.
+     * @param count The number of challenges; fewer are sent at the end of the chain.
+     */
+    void sendChallenges(SessionId id, Session& session, int count);
+
+    /**
+     * @brief Sends the challenges held for sessions whose advances the store has synced since.
+     */
+    void releaseHeldChallenges();
+
+    /**
+     * @brief Gets how many challenges a session may be sent before the store syncs more of its advances.
+     * @param session The session; the advances synced meanwhile are moved into its durableIteration.
+     * @return The number of challenges, possibly zero or less; INT32_MAX if every advance is synced.
+     */
+    int durableRoom(Session& session);
+
+    /**
+     * @brief Records where the store logged a session's latest advance.
+     * @param session The session.
+     * @param position The log position after the advance; 0 when nothing waits for the store.
+     */
+    static void noteAdvance(Session& session, std::uint64_t position);
+
+    /**
+     * @brief Gets how many more challenges a pipelined session may be sent.
+     * @param session The session.
+     * @return pipelineDepth minus the challenges still unanswered.
+     */
+    int pipelineRoom(const Session& session) const;
+
+    /**
+     * @brief Schedules a session's next challenge, one sleepDuration from now.
+     * @param id The session identifier.
+     * @param session The session.
+     */
+    void scheduleChallenge(SessionId id, Session& session);
+
+    /**
+     * @brief Arms a session's response timeout if challenges are outstanding and it is not armed yet.
+     * @param id The session identifier.
+     * @param session The session.
+     */
+    void armResponseTimer(SessionId id, Session& session);
+
+    /**
+     * @brief Handles a fired timer.
+     * @param id The session the timer belongs to.
+     * @param kind What the timer is for.
+     */
+    void handleTimer(SessionId id, std::uint8_t kind);
+
+    /**
+     * @brief Gets the number of challenges a session has been sent but not answered.
+     * @param session The session.
+     * @return The outstanding challenge count.
+     */
+    static int outstanding(const Session& session);
+
+    ServerSettings m_settings;                           ///< Protocol settings.
+    const LiveConfig* m_config;                          ///< The configuration followed on reload, or nullptr.
+    std::uint64_t m_configVersion = 0;                   ///< The LiveConfig version m_settings was taken from.
+    ServerTransport& m_transport;                        ///< Delivers frames and log messages.
+    SessionTable m_sessions;                             ///< Verifier state, counters and scheduling of every client.
+    ChainRegistry m_ownChains;                           ///< The registry used when none is shared.
+    ChainRegistry& m_chains;                             ///< Every enrolled chain, kept across reconnects.
+    AdmissionControl m_ownAdmission;                     ///< The admission control used when none is shared.
+    AdmissionControl& m_admission;                       ///< Rate limits and verification budget.
+    std::chrono::steady_clock::time_point m_epoch;       ///< Time base of now() and of the timers.
+    TimerWheel m_timers;                                 ///< The challenge, response and idle timers of all sessions.
+    bool m_authRunning = false;                          ///< True between startAuthentication() and stopAuthentication().
+    Digest m_responseBatch[ChainVerifier::MAX_SEQUENCE]; ///< Consecutive responses of the session being read, awaiting verification.
+    std::size_t m_batchSize = 0;                         ///< The number of responses in m_responseBatch.
+    std::vector<SessionId> m_held;                       ///< Sessions whose challenges wait for the store's sync.
+    std::vector<SessionId> m_releasing;                  ///< m_held while releaseHeldChallenges() walks it.
+    std::atomic<bool> m_holding{false};                  ///< Set while m_held may be non-empty; read by the flusher.
+};
+
+#endif
\ No newline at end of file
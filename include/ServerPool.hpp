@@ -0,0 +1,66 @@
+#ifndef SERVER_POOL_HPP
+#define SERVER_POOL_HPP
+
+#include "AdmissionControl.hpp"
+#include "ChainRegistry.hpp"
+#include "LiveConfig.hpp"
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <vector>
+
+/**
+ * @class ServerPool
+ * @brief Runs one Server per thread, each with its own event loop, listener and sessions.
+ *
+ * Every Server listens on the same port with SO_REUSEPORT, so the kernel spreads
+ * incoming connections across the event loops and each loop owns a disjoint shard
+ * of the sessions. The only state shared between threads is the chain registry,
+ * so that a reconnecting client can resume its chain on any loop, and the
+ * admission control, so that rate limits hold across loops. Threads can
+ * optionally be pinned to one CPU each.
+ */
+class ServerPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Starts the worker threads, each creating and starting its own Server.
+     * With a replicaSocket, construct the pool only once the ReplicaFence is held, since its listeners share the port.
+     * @param filePath The path to the configuration file.
+     * @param threads The number of event loops to run.
+     * @param pinThreads Pin worker i to CPU i (modulo the CPU count).
+     * @param chains The chain registry shared by the event loops; must outlive the pool.
+     * @param liveConfig The watched configuration the event loops follow, or nullptr; must outlive the pool.
+     * @param parent The parent QObject, for memory management.
+     */
+    ServerPool(const QString& filePath, int threads, bool pinThreads, ChainRegistry& chains,
+               const LiveConfig* liveConfig = nullptr, QObject *parent = nullptr);
+
+    /**
+     * @brief Stops every event loop and waits for the worker threads to finish.
+     */
+    ~ServerPool();
+
+    /**
+     * @brief Gets the number of event loops.
+     * @return The number of worker threads.
+     */
+    int threadCount() const;
+
+private:
+    /**
+     * @brief Pins the calling thread to a single CPU.
+     * @param cpu The CPU index.
+     * @return True on success, false if pinning is unsupported or failed.
+     */
+    static bool pinCurrentThread(int cpu);
+
+    ChainRegistry& m_chains;         ///< Every enrolled chain, shared by the event loops.
+    const LiveConfig* m_liveConfig;  ///< The watched configuration, or nullptr.
+    AdmissionControl m_admission;    ///< Rate limits and verification budget, shared by the event loops.
+    std::vector<QThread*> m_threads; ///< The worker threads, one event loop each.
+};
+
+#endif
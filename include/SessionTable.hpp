@@ -0,0 +1,120 @@
+#ifndef SESSION_TABLE_HPP
+#define SESSION_TABLE_HPP
+
+#include "ChainVerifier.hpp"
+#include "Protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Identifies a session: the slot index in the low 32 bits, the slot's generation in the high 32 bits.
+ *
+ * A closed session's identifier never matches a later session reusing the same slot,
+ * so stale identifiers held by timers or callbacks are detected by SessionTable::find().
+ */
+typedef std::uint64_t SessionId;
+
+/**
+ * @struct LogMark
+ * @brief An advance of a session's chain logged to the ChainStore, and how far the log must be synced to hold it.
+ */
+struct LogMark {
+    std::int32_t iteration = 0;   ///< The challenge number verified.
+    std::uint64_t position = 0;   ///< The log position after the advance's record.
+};
+
+/**
+ * @struct Session
+ * @brief The per-connection state of one client of the server.
+ *
+ * A fixed-size record kept inline in the session table: the chain verifier, the
+ * challenge counters, its timers and the frame reassembly buffer.
+ * Nothing in it allocates.
+ */
+struct Session {
+    static constexpr int MAX_PENDING_ADVANCES = 4; ///< Unsynced advances tracked one by one; later ones are merged.
+
+    ChainVerifier verifier;              ///< Anchor / last verified link and chain parameters.
+    void* connection = nullptr;          ///< The transport object owning this session (e.g. its socket).
+    std::int32_t currentIteration = 1;   ///< The next challenge number to send.
+    std::int32_t verifiedIteration = 0;  ///< The challenge number of the last verified response.
+    std::uint32_t challengeTimer = UINT32_MAX;  ///< The timer of the next challenge, while one is scheduled.
+    std::uint32_t responseTimer = UINT32_MAX;   ///< The response timeout, while challenges are outstanding.
+    std::uint32_t idleTimer = UINT32_MAX;       ///< The idle eviction timer.
+    std::int64_t lastActivity = 0;       ///< When the client last sent anything, in ServerCore time (ms).
+    std::int64_t awaitingSince = 0;      ///< When the oldest unanswered challenge was sent, or the last one answered.
+    std::uint32_t chain = UINT32_MAX;    ///< The session's record in the ChainRegistry, if enrolled or resumed.
+    std::uint64_t source = 0;            ///< The AdmissionControl key of the client's address; 0 if unknown.
+    std::int32_t durableIteration = 0;   ///< The last verified challenge whose advance the ChainStore has synced.
+    LogMark pendingAdvances[MAX_PENDING_ADVANCES]; ///< Advances logged since, oldest first.
+    std::uint8_t pendingCount = 0;       ///< The number of entries in pendingAdvances.
+    bool held = false;                   ///< True while the session waits in ServerCore's list of held challenges.
+    Protocol::FrameParser parser;        ///< Reassembles the client's frames across reads.
+};
+
+/**
+ * @class SessionTable
+ * @brief A slot table of sessions with O(1) open, close and lookup.
+ *
+ * Sessions live in one contiguous array; closed slots are recycled through a
+ * free list, and each slot's generation is bumped on close.
+ */
+class SessionTable {
+public:
+    /**
+     * @brief Opens a new session in a free slot.
+     * @param connection The transport object the session belongs to.
+     * @return The identifier of the new session.
+     */
+    SessionId open(void* connection);
+
+    /**
+     * @brief Closes a session, freeing its slot. Stale identifiers are ignored.
+     * @param id The session to close.
+     */
+    void close(SessionId id);
+
+    /**
+     * @brief Looks up a session.
+     * @param id The session identifier.
+     * @return The session, or nullptr if it has been closed.
+     */
+    Session* find(SessionId id);
+
+    /**
+     * @brief Gets the number of open sessions.
+     * @return The session count.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Calls a function for every open session.
+     * @param fn A callable taking (SessionId, Session&).
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn)
+    {
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].inUse) fn(makeId(static_cast<std::uint32_t>(i), entries[i].generation), entries[i].session);
+        }
+    }
+
+private:
+    /**
+     * @brief A slot of the table.
+     */
+    struct Slot {
+        Session session;                ///< The session stored in the slot.
+        std::uint32_t generation = 0;   ///< Bumped every time the slot is freed.
+        bool inUse = false;             ///< True while the slot holds an open session.
+    };
+
+    static SessionId makeId(std::uint32_t index, std::uint32_t generation);
+
+    std::vector<Slot> entries;              ///< All slots, open or free.
+    std::vector<std::uint32_t> freeSlots;   ///< Indices of free slots, reused last-in first-out.
+    std::size_t openCount = 0;              ///< The number of open sessions.
+};
+
+#endif
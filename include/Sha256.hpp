@@ -0,0 +1,69 @@
+#ifndef SHA256_HPP
+#define SHA256_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @namespace Sha256
+ * @brief A self-contained SHA-256 engine used on the verification hot path.
+ *
+ * Single messages are hashed with the x86 SHA extensions (SHA-NI) when the CPU
+ * has them. Independent, equal-length messages can also be hashed together by a
+ * multi-buffer kernel running in parallel SIMD lanes (4 lanes on SSE4.1, 8 on AVX2,
+ * 16 on AVX-512). Backends are selected once, on first use, from the running CPU;
+ * other CPUs and compilers fall back to the portable scalar code.
+ */
+namespace Sha256 {
+
+    constexpr std::size_t DIGEST_SIZE = 32; ///< Size of a SHA-256 digest in bytes.
+    constexpr std::size_t BLOCK_SIZE = 64;  ///< Size of a SHA-256 message block in bytes.
+
+    /**
+     * @brief Hashes a single message with the active backend (see backend()).
+     * @param data Pointer to the message bytes.
+     * @param len The message length in bytes.
+     * @param out Receives the 32-byte digest.
+     */
+    void hash(const std::uint8_t* data, std::size_t len, std::uint8_t out[DIGEST_SIZE]);
+
+    /**
+     * @brief Hashes a single message with the portable scalar implementation.
+     * Always available; mainly useful as a reference and benchmark baseline.
+     * @param data Pointer to the message bytes.
+     * @param len The message length in bytes.
+     * @param out Receives the 32-byte digest.
+     */
+    void hashPortable(const std::uint8_t* data, std::size_t len, std::uint8_t out[DIGEST_SIZE]);
+
+    /**
+     * @brief Gets a short name of the active single-message backend, for logging.
+     * @return "sha-ni" or "scalar".
+     */
+    const char* backend();
+
+    /**
+     * @brief Hashes many independent messages of the same length.
+     * Messages are processed in groups of laneCount() using the multi-buffer kernel.
+     * @param messages Array of @p count pointers to the messages.
+     * @param len The common length of every message in bytes.
+     * @param count The number of messages.
+     * @param out Receives @p count digests, in the order of @p messages.
+     */
+    void hashMany(const std::uint8_t* const* messages, std::size_t len, std::size_t count,
+                  std::uint8_t (*out)[DIGEST_SIZE]);
+
+    /**
+     * @brief Gets the number of messages the active multi-buffer kernel hashes at once.
+     * @return 16, 8, 4 or 1 (scalar fallback).
+     */
+    std::size_t laneCount();
+
+    /**
+     * @brief Gets a short name of the active multi-buffer kernel, for logging.
+     * @return "avx512", "avx2", "sse4.1" or "scalar".
+     */
+    const char* multiBufferBackend();
+}
+
+#endif
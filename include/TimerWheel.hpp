@@ -0,0 +1,133 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class TimerWheel
+ * @brief A hierarchical timing wheel with millisecond ticks and O(1) schedule and cancel.
+ *
+ * Four levels of 256 slots each cover 2^8, 2^16, 2^24 and 2^32 ms. A timer is
+ * placed in the lowest level whose span holds its due tick, and moves one level
+ * down each time its slot comes up (cascading), so it is touched at most four
+ * times however many timers exist. Timers are nodes in one array, linked into
+ * their slot's list, and recycled through a free list; each level keeps an
+ * occupancy bitmap so that empty stretches of time are skipped at once.
+ *
+ * Each timer carries a 64-bit key and an 8-bit kind, handed back when it fires.
+ */
+class TimerWheel {
+public:
+    typedef std::uint32_t TimerId;                  ///< Identifies a scheduled timer.
+    static constexpr TimerId NONE = UINT32_MAX;     ///< "No timer".
+
+    /**
+     * @brief Constructs an empty wheel.
+     * @param now The current time in ms; times passed later must not go backwards.
+     */
+    explicit TimerWheel(std::int64_t now = 0);
+
+    /**
+     * @brief Schedules a timer.
+     * @param due When it fires, in ms; times in the past fire on the next advance(). At most 2^31 ms ahead.
+     * @param key Returned to the callback, e.g. a session identifier.
+     * @param kind Returned to the callback, e.g. what the timer is for.
+     * @return The timer, valid until it fires or is cancelled.
+     */
+    TimerId schedule(std::int64_t due, std::uint64_t key, std::uint8_t kind);
+
+    /**
+     * @brief Cancels a timer that has neither fired nor been cancelled.
+     * @param id The timer; NONE is ignored.
+     */
+    void cancel(TimerId id);
+
+    /**
+     * @brief Fires every timer due at or before a time, in due order.
+     * Each timer is removed before its callback runs, so the callback may schedule
+     * or cancel any timer, including ones due in the same call.
+     * @param now The current time in ms.
+     * @param fn Called as fn(key, kind) for each timer.
+     */
+    template <typename Fn>
+    void advance(std::int64_t now, Fn&& fn)
+    {
+        for (;;) {
+            std::int64_t tick = nextTick();
+            if (tick < 0 || tick > now) break;
+            current = tick;
+            cascade();
+            std::uint32_t slot = current & SLOT_MASK;
+            while (heads[slot] != NONE) {
+                TimerId id = heads[slot];
+                std::uint64_t key = nodes[id].key;
+                std::uint8_t kind = nodes[id].kind;
+                cancel(id);
+                fn(key, kind);
+            }
+            ++current;
+        }
+        if (current <= now) current = now + 1;
+    }
+
+    /**
+     * @brief Gets the time until the wheel next needs advance(): a timer fires or a slot cascades.
+     * @param now The current time in ms.
+     * @return Milliseconds (0 if overdue), or -1 if no timer is scheduled.
+     */
+    std::int64_t msUntilNext(std::int64_t now) const;
+
+    /**
+     * @brief Gets the number of scheduled timers.
+     * @return The timer count.
+     */
+    std::size_t size() const { return count; }
+
+private:
+    static constexpr int LEVELS = 4;                              ///< Levels of the wheel.
+    static constexpr int SLOT_BITS = 8;                           ///< log2 of the slots per level.
+    static constexpr std::uint32_t SLOTS = 1u << SLOT_BITS;       ///< Slots per level.
+    static constexpr std::uint32_t SLOT_MASK = SLOTS - 1;         ///< Masks a slot index.
+    static constexpr std::uint32_t WORDS = SLOTS / 64;            ///< Bitmap words per level.
+
+    /**
+     * @brief A timer, linked into the list of its slot or into the free list.
+     */
+    struct Node {
+        std::int64_t due = 0;         ///< When the timer fires.
+        std::uint64_t key = 0;        ///< The caller's key.
+        TimerId prev = NONE;          ///< Previous node in the slot list.
+        TimerId next = NONE;          ///< Next node in the slot or free list.
+        std::uint16_t slot = 0;       ///< The slot (level * SLOTS + index) holding the node.
+        std::uint8_t kind = 0;        ///< The caller's kind.
+        bool live = false;            ///< True while scheduled.
+    };
+
+    /**
+     * @brief Links a node into the slot its due tick belongs to, relative to the current tick.
+     * @param id The node.
+     */
+    void place(TimerId id);
+
+    /**
+     * @brief Moves the timers of every higher-level slot that starts at the current tick one level down.
+     */
+    void cascade();
+
+    /**
+     * @brief Finds the earliest tick at which a slot needs processing.
+     * @return The tick, or -1 if the wheel is empty.
+     */
+    std::int64_t nextTick() const;
+
+    std::vector<Node> nodes;                    ///< All nodes, scheduled or free.
+    TimerId freeList = NONE;                    ///< Head of the list of free nodes.
+    TimerId heads[LEVELS * SLOTS];              ///< Head node of each slot.
+    std::uint64_t occupied[LEVELS][WORDS];      ///< One bit per non-empty slot.
+    std::int64_t current;                       ///< The next tick to process.
+    std::size_t count = 0;                      ///< The number of scheduled timers.
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,266 @@
+#ifndef VERIFIER_TABLE_HPP
+#define VERIFIER_TABLE_HPP
+
+#include "Digest.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/**
+ * @class VerifierTable
+ * @brief Fixed-width verifier records with an open-addressing index, in one memory-mapped file.
+ *
+ * Each identity (the anchor h_n its chain was enrolled with) has one record
+ * holding its last verified link, counter and chain parameters. Records are
+ * addressed by a stable record number; the index maps an anchor to its record
+ * number by linear probing, so lookups and updates are O(1) and no per-identity
+ * object is ever allocated. Opening an existing table maps it and checks its
+ * header: nothing is parsed or rebuilt, however many identities it holds.
+ *
+ * File layout (native byte order, little-endian on every supported target):
+ *
+ *     offset  size   field
+ *          0     8   magic "LMPVTAB\0"
+ *          8     4   version (2)
+ *         12     4   record size (80)
+ *         16     8   record capacity C (a power of two)
+ *         24     8   records ever used (high-water mark)
+ *         32     8   live records
+ *         40     8   index tombstones
+ *         48     8   index hash seed
+ *         56     4   head of the free record list
+ *         60     4   reserved, zero
+ *         64     8   log segment (see below)
+ *         72    56   reserved, zero
+ *        128   8*C   index: 2C slots of record number + 1 (0 empty, UINT32_MAX removed)
+ *     128+8C  80*C   records
+ *
+ * Without a file the same layout lives in anonymous memory. When every record
+ * is used the table doubles: a larger table is built beside the old one, synced
+ * and renamed over it. Record numbers survive growth; removed records are reused.
+ * Version 1 tables, with a 64-byte header and no log segment, are rebuilt once
+ * in the current format when opened.
+ *
+ * Writes go to the page cache, so they survive a server crash but not a power
+ * loss. Paired with a ChainStore, the table is the store's snapshot: the log
+ * segment is the first store segment whose changes the synced file may lack,
+ * and it is only raised once the file has been synced (see ChainRegistry).
+ */
+class VerifierTable {
+public:
+    static constexpr std::uint32_t NONE = UINT32_MAX; ///< "No record" number.
+    static constexpr std::uint32_t VERSION = 2;       ///< Current file format version.
+
+    /**
+     * @struct Record
+     * @brief The lasting state of one identity, exactly as stored.
+     */
+    struct Record {
+        Digest anchor;                 ///< The anchor h_n; identifies the record.
+        Digest link;                   ///< The last verified link.
+        std::uint64_t counter;         ///< The challenge number of the last verified response.
+        std::uint8_t flags;            ///< LIVE while the record is in use, plus EXHAUSTED once its chain is used up.
+        std::uint8_t format;           ///< The ChainFormat of the chain.
+        std::uint8_t algorithm;        ///< The HashAlgorithm of the chain.
+        std::uint8_t reserved[5];      ///< Zero.
+    };
+
+    static constexpr std::uint8_t LIVE = 1;      ///< Record flag: the record holds an identity.
+    static constexpr std::uint8_t EXHAUSTED = 2; ///< Record flag: every link of the chain is used; the anchor is only kept to be refused.
+
+    VerifierTable() = default;
+    ~VerifierTable();
+
+    VerifierTable(const VerifierTable&) = delete;
+    VerifierTable& operator=(const VerifierTable&) = delete;
+
+    /**
+     * @brief Maps a table file, creating an empty one if it does not exist, and drops any table in memory.
+     *
+     * The file stays under an exclusive flock until close(), so two processes never map the same table.
+     * @param path The path of the table file.
+     * @param capacity The record capacity of a new file; rounded up to a power of two.
+     * @return False if the file cannot be created, is not a well-formed table or is open in another process.
+     */
+    bool open(const std::string& path, std::uint32_t capacity);
+
+    /**
+     * @brief Syncs and unmaps the table. Safe to call when nothing is mapped.
+     */
+    void close();
+
+    /**
+     * @brief Checks whether the table is backed by a file.
+     * @return True after a successful open().
+     */
+    bool isFile() const;
+
+    /**
+     * @brief Gets the first ChainStore log segment whose changes the synced file may lack.
+     * @return The segment of the last checkpoint; 0 for a new table.
+     */
+    std::uint64_t logSegment() const;
+
+    /**
+     * @brief Records that the file holds every change logged before a store segment.
+     * Call only once the file has been synced after those changes, and sync it again to make the mark durable.
+     * @param segment The first segment still needed.
+     */
+    void setLogSegment(std::uint64_t segment);
+
+    /**
+     * @brief Opens a second descriptor of the table file, so that it can be synced while the table is in use.
+     * @return The descriptor, which the caller closes; -1 without a file.
+     */
+    int duplicateFile() const;
+
+    /**
+     * @brief Checks whether a descriptor from duplicateFile() still refers to the mapped file.
+     * @param descriptor The descriptor.
+     * @return False once the table has grown into a new file since the descriptor was taken.
+     */
+    bool mapsFile(int descriptor) const;
+
+    /**
+     * @brief Looks up an identity.
+     * @param anchor The anchor.
+     * @return Its record number, or NONE.
+     */
+    std::uint32_t find(const Digest& anchor) const;
+
+    /**
+     * @brief Adds an identity with a zeroed record, growing the table if it is full.
+     * @param anchor The anchor.
+     * @return The new record number, or NONE if the anchor is known or the table cannot grow.
+     */
+    std::uint32_t insert(const Digest& anchor);
+
+    /**
+     * @brief Removes an identity; its record number may be reused.
+     * @param number A live record number.
+     */
+    void remove(std::uint32_t number);
+
+    /**
+     * @brief Removes every identity.
+     */
+    void clear();
+
+    /**
+     * @brief Gets a record; valid until the next insert().
+     * @param number A record number below end().
+     * @return The record.
+     */
+    Record& record(std::uint32_t number);
+
+    /**
+     * @brief Gets a record; valid until the next insert().
+     * @param number A record number below end().
+     * @return The record.
+     */
+    const Record& record(std::uint32_t number) const;
+
+    /**
+     * @brief Gets the number of record numbers ever used; live records are below it and have the LIVE flag.
+     * @return The high-water mark.
+     */
+    std::uint32_t end() const;
+
+    /**
+     * @brief Gets the number of live records.
+     * @return The identity count.
+     */
+    std::size_t size() const;
+
+private:
+    struct Header;
+
+    /**
+     * @brief Maps a new, empty table of the given capacity, in a file or anonymous memory.
+     * @param path The file to create, or empty for anonymous memory.
+     * @param capacity The record capacity; a power of two.
+     * @param seed The index hash seed.
+     * @param base Receives the mapping.
+     * @param size Receives the size of the mapping.
+     * @param descriptor Receives the open file, or -1 for anonymous memory.
+     * @return False on an I/O error.
+     */
+    static bool create(const std::string& path, std::uint64_t capacity, std::uint64_t seed,
+                       std::uint8_t*& base, std::size_t& size, int& descriptor);
+
+    /**
+     * @brief Allocates an anonymous table if none is mapped yet.
+     * @return False if memory cannot be mapped.
+     */
+    bool ensureMapped();
+
+    /**
+     * @brief Moves every record into a table of twice the capacity and maps it in place of this one.
+     * @return False on an I/O error; the table is then unchanged.
+     */
+    bool grow();
+
+    /**
+     * @brief Builds a new table beside the mapped one, synced and renamed over it, and maps it instead.
+     * @param capacity The record capacity of the new table.
+     * @param entries The records to copy: the first header()->used of them.
+     * @param segment The log segment of the new table.
+     * @return False on an I/O error; the table is then unchanged.
+     */
+    bool relocate(std::uint64_t capacity, const Record* entries, std::uint64_t segment);
+
+    /**
+     * @brief Rebuilds the index from the live records, dropping its tombstones.
+     */
+    void rebuildIndex();
+
+    /**
+     * @brief Adds a record number to the index.
+     * @param anchor The record's anchor.
+     * @param number The record number.
+     */
+    void indexInsert(const Digest& anchor, std::uint32_t number);
+
+    /**
+     * @brief Finds the index slot holding an anchor.
+     * @param anchor The anchor.
+     * @return The slot, or NONE.
+     */
+    std::uint32_t indexFind(const Digest& anchor) const;
+
+    /**
+     * @brief Hashes an anchor with the table's seed; anchors are chosen by clients, so all 32 bytes are mixed.
+     * @param anchor The anchor.
+     * @return The hash.
+     */
+    std::uint64_t slotHash(const Digest& anchor) const;
+
+    /**
+     * @brief Gets the header of the mapping.
+     * @return The header.
+     */
+    Header* header() const;
+
+    /**
+     * @brief Gets the index slots of the mapping.
+     * @return The first of 2C slots.
+     */
+    std::uint32_t* index() const;
+
+    /**
+     * @brief Gets the records of the mapping.
+     * @return The first of C records.
+     */
+    Record* records() const;
+
+    std::string path;                 ///< The table file, or empty for anonymous memory.
+    std::uint8_t* base = nullptr;     ///< The mapping.
+    std::size_t mappingSize = 0;      ///< The size of the mapping.
+    int descriptor = -1;              ///< The table file, kept open for duplicateFile(); -1 for anonymous memory.
+};
+
+static_assert(sizeof(VerifierTable::Record) == 80, "VerifierTable::Record is an on-disk format");
+static_assert(std::is_trivially_copyable<VerifierTable::Record>::value, "VerifierTable::Record must stay a plain value");
+
+#endif
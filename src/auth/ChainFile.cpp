@@ -0,0 +1,269 @@
+#include "ChainFile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cryptopp/sha.h>
+
+namespace {
+
+    const char MAGIC[8] = {'L', 'M', 'P', 'C', 'H', 'A', 'I', 'N'};
+    const std::size_t CHECKSUM_OFFSET = 24;
+    const std::size_t WRITE_CHUNK = 4096; ///< Links buffered per write() during generation.
+
+    void storeLe(std::uint8_t* p, std::uint64_t v, std::size_t bytes)
+    {
+        for (std::size_t i = 0; i < bytes; ++i) p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+    }
+
+    std::uint64_t loadLe(const std::uint8_t* p, std::size_t bytes)
+    {
+        std::uint64_t v = 0;
+        for (std::size_t i = 0; i < bytes; ++i) v |= std::uint64_t(p[i]) << (8 * i);
+        return v;
+    }
+
+    /**
+     * @brief Writes a whole buffer, retrying on short writes and EINTR.
+     * @return True if every byte was written.
+     */
+    bool writeAll(int fd, const void* data, std::size_t size)
+    {
+        const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+        while (size > 0) {
+            ssize_t written = ::write(fd, p, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+}
+
+ChainFile::~ChainFile()
+{
+    close();
+}
+
+ChainFile::ChainFile(ChainFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+ChainFile& ChainFile::operator=(ChainFile&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        mapping = other.mapping;
+        mappingSize = other.mappingSize;
+        chainLength = other.chainLength;
+        params = other.params;
+        other.mapping = nullptr;
+        other.mappingSize = 0;
+        other.chainLength = 0;
+    }
+    return *this;
+}
+
+/**
+ * @brief Generates a chain and streams it to disk.
+ * Links are produced in chunks of WRITE_CHUNK and the checksum is updated as they are written.
+ * @param path The destination path.
+ * @param seed The seed (h_0).
+ * @param len The chain length (n).
+ * @param chainParams The chain format and hash function.
+ * @param progress Called about every CHAIN_PROGRESS_INTERVAL links; may cancel.
+ * @return True on success.
+ */
+bool ChainFile::generate(const std::string& path, const std::string& seed, std::uint64_t len,
+                         const ChainParams& chainParams, const ChainProgress& progress)
+{
+    if (len == 0) return false;
+
+    std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) return false;
+
+    std::uint8_t header[HEADER_SIZE] = {};
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    storeLe(header + 8, VERSION, 4);
+    header[12] = static_cast<std::uint8_t>(chainParams.format);
+    header[13] = static_cast<std::uint8_t>(chainParams.algorithm);
+    storeLe(header + 14, Digest::SIZE, 2);
+    storeLe(header + 16, len, 8);
+
+    // The checksum is not known yet; the header is rewritten once all records are out
+    bool ok = writeAll(fd, header, sizeof(header));
+
+    CryptoPP::SHA256 checksum;
+    std::vector<Digest> buffer(static_cast<std::size_t>(std::min<std::uint64_t>(len, WRITE_CHUNK)));
+    withHashPolicy(chainParams.algorithm, [&](auto policy) {
+        using Hash = decltype(policy);
+        Digest link = CryptoUtils::genHash(seed, chainParams.algorithm);
+        std::uint64_t done = 0;
+        while (ok && done < len) {
+            std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(len - done, buffer.size()));
+            for (std::size_t i = 0; i < n; ++i) {
+                if (done + i > 0) link = CryptoUtils::genNextLinkWith<Hash>(link, chainParams.format);
+                buffer[i] = link;
+            }
+            const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(buffer.data());
+            checksum.Update(bytes, n * Digest::SIZE);
+            ok = writeAll(fd, bytes, n * Digest::SIZE);
+            done += n;
+            // Reported once per interval crossed; a cancelled file is removed below like a failed one
+            if (ok && progress && done / CHAIN_PROGRESS_INTERVAL != (done - n) / CHAIN_PROGRESS_INTERVAL) {
+                ok = progress(done, len);
+            }
+        }
+    });
+
+    if (ok) {
+        checksum.Final(header + CHECKSUM_OFFSET);
+        ok = ::pwrite(fd, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    }
+    ok = ok && ::fsync(fd) == 0;
+    ok = (::close(fd) == 0) && ok;
+    if (ok) ok = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+    if (!ok) std::remove(tmpPath.c_str());
+    return ok;
+}
+
+/**
+ * @brief Maps a chain file and validates its header against the file size.
+ * @param path The chain file.
+ * @return True on success.
+ */
+bool ChainFile::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<std::uint64_t>(st.st_size) < HEADER_SIZE + Digest::SIZE) {
+        ::close(fd);
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps its own reference to the file, which may even be unlinked from now on
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    const std::uint8_t* header = static_cast<const std::uint8_t*>(mapped);
+    std::uint64_t len = loadLe(header + 16, 8);
+    std::uint8_t format = header[12];
+    std::uint8_t algorithm = header[13];
+    bool valid = std::memcmp(header, MAGIC, sizeof(MAGIC)) == 0
+              && loadLe(header + 8, 4) == VERSION
+              && loadLe(header + 14, 2) == Digest::SIZE
+              && (format == static_cast<std::uint8_t>(ChainFormat::HexV1)
+                  || format == static_cast<std::uint8_t>(ChainFormat::BinaryV2))
+              && algorithm >= static_cast<std::uint8_t>(HashAlgorithm::Sha256)
+              && algorithm <= static_cast<std::uint8_t>(HashAlgorithm::Blake2s)
+              && len > 0 && len == (size - HEADER_SIZE) / Digest::SIZE
+              && (size - HEADER_SIZE) % Digest::SIZE == 0;
+    if (!valid) {
+        ::munmap(mapped, size);
+        return false;
+    }
+
+    // OTPs are requested in descending order across the whole file, so readahead would be wasted
+    ::madvise(mapped, size, MADV_RANDOM);
+
+    mapping = header;
+    mappingSize = size;
+    chainLength = len;
+    params.format = static_cast<ChainFormat>(format);
+    params.algorithm = static_cast<HashAlgorithm>(algorithm);
+    return true;
+}
+
+/**
+ * @brief Unmaps the file, if any.
+ */
+void ChainFile::close()
+{
+    if (mapping) ::munmap(const_cast<std::uint8_t*>(mapping), mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+    chainLength = 0;
+}
+
+/**
+ * @brief Checks whether a chain file is mapped.
+ * @return True if open.
+ */
+bool ChainFile::isOpen() const
+{
+    return mapping != nullptr;
+}
+
+/**
+ * @brief Recomputes the SHA-256 of the records and compares it with the stored checksum.
+ * @return True if the records match the header.
+ */
+bool ChainFile::verify() const
+{
+    if (!mapping) return false;
+    Digest computed;
+    Digest stored;
+    CryptoPP::SHA256 checksum;
+    checksum.Update(mapping + HEADER_SIZE, mappingSize - HEADER_SIZE);
+    checksum.Final(computed.data());
+    std::memcpy(stored.data(), mapping + CHECKSUM_OFFSET, Digest::SIZE);
+    return computed == stored;
+}
+
+/**
+ * @brief Reads a link straight from the mapping.
+ * @param position The 1-based position k of h_k.
+ * @return The link h_k.
+ */
+Digest ChainFile::linkAt(std::uint64_t position) const
+{
+    Digest link;
+    std::memcpy(link.data(), mapping + HEADER_SIZE + (position - 1) * Digest::SIZE, Digest::SIZE);
+    return link;
+}
+
+/**
+ * @brief Gets the final link of the chain (h_n).
+ * @return The last link.
+ */
+Digest ChainFile::lastLink() const
+{
+    return linkAt(chainLength);
+}
+
+/**
+ * @brief Gets the length of the chain.
+ * @return The number of links (n).
+ */
+std::uint64_t ChainFile::length() const
+{
+    return chainLength;
+}
+
+/**
+ * @brief Gets the chain parameters recorded in the header.
+ * @return The chain parameters.
+ */
+ChainParams ChainFile::chainParams() const
+{
+    return params;
+}
@@ -0,0 +1,129 @@
+#include "ChainTraverser.hpp"
+
+/**
+ * @brief Computes h_n in a single forward pass, keeping the checkpoints for h_{n-1} on the way.
+ * @param seed The initial secret value (h_0).
+ * @param len The length of the chain (n).
+ * @param chainParams The format and hash function of the chain.
+ * @param progress Called every CHAIN_PROGRESS_INTERVAL links; may cancel.
+ * @return False if cancelled.
+ */
+bool ChainTraverser::init(const std::string& seed, std::uint64_t len, const ChainParams& chainParams,
+                          const ChainProgress& progress)
+{
+    pebbles.clear();
+    chainLength = len;
+    params = chainParams;
+    if (len == 0) return true;
+
+    // h_1 is the hash of the seed and is the bottom checkpoint for the whole traversal
+    Digest link = CryptoUtils::genHash(seed, params.algorithm);
+    pebbles.push_back({1, link});
+
+    bool finished = false;
+    withHashPolicy(params.algorithm, [&](auto policy) { finished = walkToEnd<decltype(policy)>(link, progress); });
+    if (!finished) {
+        pebbles.clear();
+        chainLength = 0;
+    }
+    return finished;
+}
+
+/**
+ * @brief Hashes from h_1 to h_n, dropping the checkpoints that lead to h_{n-1} as they are passed.
+ * @param link h_1.
+ * @param progress Optional progress callback.
+ * @return False if cancelled.
+ */
+template <typename Hash>
+bool ChainTraverser::walkToEnd(Digest link, const ChainProgress& progress)
+{
+    std::uint64_t target = (chainLength > 1) ? chainLength - 1 : 1;
+    std::uint64_t nextCheckpoint = midpoint(1, target);
+    for (std::uint64_t position = 2; position <= chainLength; ++position) {
+        link = CryptoUtils::genNextLinkWith<Hash>(link, params.format);
+        if (position == nextCheckpoint && position <= target) {
+            pebbles.push_back({position, link});
+            nextCheckpoint = midpoint(position, target);
+        }
+        if (position % CHAIN_PROGRESS_INTERVAL == 0 && progress && !progress(position, chainLength)) return false;
+    }
+    last = link;
+    return true;
+}
+
+/**
+ * @brief Gets the link h_k, walking forward from the nearest checkpoint below it.
+ * @param position The 1-based position k, with 1 <= k <= n.
+ * @return The link h_k.
+ */
+Digest ChainTraverser::linkAt(std::uint64_t position)
+{
+    if (pebbles.empty() || position >= chainLength) return last;
+    if (position < 1) position = 1;
+
+    // Checkpoints above the target are no longer needed on the way down
+    while (pebbles.back().position > position) pebbles.pop_back();
+
+    if (pebbles.back().position < position) {
+        withHashPolicy(params.algorithm, [&](auto policy) { walkTo<decltype(policy)>(position); });
+    }
+
+    return pebbles.back().value;
+}
+
+/**
+ * @brief Walks up to the target, leaving a checkpoint halfway each time.
+ * @param position The target position; the top checkpoint ends up there.
+ */
+template <typename Hash>
+void ChainTraverser::walkTo(std::uint64_t position)
+{
+    while (pebbles.back().position < position) {
+        Pebble next = pebbles.back();
+        std::uint64_t stop = midpoint(next.position, position);
+        while (next.position < stop) {
+            next.value = CryptoUtils::genNextLinkWith<Hash>(next.value, params.format);
+            ++next.position;
+        }
+        pebbles.push_back(next);
+    }
+}
+
+/**
+ * @brief Gets the final link of the chain (h_n).
+ * @return The last link.
+ */
+Digest ChainTraverser::lastLink() const
+{
+    return last;
+}
+
+/**
+ * @brief Gets the length of the chain.
+ * @return The number of links (n).
+ */
+std::uint64_t ChainTraverser::length() const
+{
+    return chainLength;
+}
+
+/**
+ * @brief Gets the number of checkpoints currently stored.
+ * @return The size of the checkpoint stack.
+ */
+std::size_t ChainTraverser::checkpointCount() const
+{
+    return pebbles.size();
+}
+
+/**
+ * @brief Gets the halfway point between a checkpoint and a target, rounded up.
+ * @param from The checkpoint position.
+ * @param target The target position (target > from).
+ * @return The next checkpoint position.
+ */
+std::uint64_t ChainTraverser::midpoint(std::uint64_t from, std::uint64_t target)
+{
+    return from + (target - from + 1) / 2;
+}
\ No newline at end of file
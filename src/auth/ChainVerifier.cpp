@@ -0,0 +1,162 @@
+#include "ChainVerifier.hpp"
+
+#include <algorithm>
+
+/**
+ * @brief Stores the chain parameters and anchor.
+ * @param chainParams The chain parameters.
+ * @param anchor The anchor h_n.
+ */
+void ChainVerifier::enroll(const ChainParams& chainParams, const Digest& anchor)
+{
+    params = chainParams;
+    lastVerified = anchor;
+    enrolled = true;
+}
+
+/**
+ * @brief Checks whether an anchor has been stored.
+ * @return True if enrolled.
+ */
+bool ChainVerifier::isEnrolled() const
+{
+    return enrolled;
+}
+
+/**
+ * @brief Gets the last verified link.
+ * @return The last verified link.
+ */
+const Digest& ChainVerifier::lastVerifiedHash() const
+{
+    return lastVerified;
+}
+
+/**
+ * @brief Gets the chain parameters.
+ * @return The chain parameters.
+ */
+const ChainParams& ChainVerifier::chainParams() const
+{
+    return params;
+}
+
+/**
+ * @brief Verifies a received one-time password (OTP).
+ * Checks if H(response) == lastVerified.
+ * @param response The received OTP (h_{i-1}).
+ * @return True if verification is successful, false otherwise.
+ */
+bool ChainVerifier::verify(const Digest& response)
+{
+    // The received response should be h_{i-1}. Hashing it should yield h_i.
+    bool isCorrect = enrolled && (CryptoUtils::genNextLink(response, params) == lastVerified);
+    // If correct, update the last verified hash to the new, lower-index hash
+    if (isCorrect) lastVerified = response;
+    return isCorrect;
+}
+
+/**
+ * @brief Verifies an OTP that may skip up to window - 1 positions of the chain.
+ * Hashes forward from the response and stops at the first match with the last verified link.
+ * @param response The received OTP (h_{i-j}).
+ * @param window The largest j to try.
+ * @param offset Receives j on success, 0 otherwise.
+ * @return True if verification is successful, false otherwise.
+ */
+bool ChainVerifier::verify(const Digest& response, int window, int& offset)
+{
+    offset = 0;
+    if (!enrolled) return false;
+
+    withHashPolicy(params.algorithm, [&](auto policy) {
+        Digest link = response;
+        for (int j = 1; j <= window; ++j) {
+            link = CryptoUtils::genNextLinkWith<decltype(policy)>(link, params.format);
+            if (link == lastVerified) {
+                offset = j;
+                return;
+            }
+        }
+    });
+
+    if (offset > 0) lastVerified = response;
+    return offset > 0;
+}
+
+/**
+ * @brief Verifies a run of consecutive OTPs of this chain.
+ * Each link is checked against the previous response rather than against state updated
+ * along the way, so the whole run is hashed in one batch before any comparison.
+ * @param responses The received OTPs, in challenge order.
+ * @param count The number of OTPs, at most MAX_SEQUENCE.
+ * @return The number of OTPs accepted before the first failure.
+ */
+std::size_t ChainVerifier::verifySequence(const Digest* responses, std::size_t count)
+{
+    if (!enrolled || count == 0) return 0;
+    if (count > MAX_SEQUENCE) count = MAX_SEQUENCE;
+
+    Digest hashes[MAX_SEQUENCE];
+    CryptoUtils::genNextLinkBatch(responses, count, params, hashes);
+
+    std::size_t accepted = 0;
+    const Digest* expected = &lastVerified;
+    while (accepted < count && hashes[accepted] == *expected) {
+        expected = &responses[accepted];
+        ++accepted;
+    }
+    if (accepted > 0) lastVerified = responses[accepted - 1];
+    return accepted;
+}
+
+/**
+ * @brief Verifies a batch of OTPs into a caller-provided result array.
+ * There are only six possible chain parameter combinations, so each one is handled
+ * in its own pass; matching responses are gathered into fixed-size stack chunks and
+ * hashed together.
+ * @param verifiers The verifiers.
+ * @param responses The received OTPs.
+ * @param count The number of verifiers and responses.
+ * @param results Receives the verification result for each verifier.
+ */
+void ChainVerifier::verifyBatch(ChainVerifier* const* verifiers, const Digest* responses,
+                                std::size_t count, bool* results)
+{
+    std::fill(results, results + count, false);
+
+    const std::size_t CHUNK = 64;
+    std::size_t indices[CHUNK];
+    Digest pending[CHUNK];
+    Digest hashes[CHUNK];
+
+    for (ChainFormat format : {ChainFormat::HexV1, ChainFormat::BinaryV2}) {
+        for (HashAlgorithm algorithm : {HashAlgorithm::Sha256, HashAlgorithm::Sha512_256, HashAlgorithm::Blake2s}) {
+            ChainParams group;
+            group.format = format;
+            group.algorithm = algorithm;
+            std::size_t n = 0;
+
+            // Hash every pending response of the chunk at once, then compare each against its own verifier
+            auto flush = [&]() {
+                CryptoUtils::genNextLinkBatch(pending, n, group, hashes);
+                for (std::size_t k = 0; k < n; ++k) {
+                    ChainVerifier* verifier = verifiers[indices[k]];
+                    bool ok = verifier->enrolled && (hashes[k] == verifier->lastVerified);
+                    if (ok) verifier->lastVerified = pending[k];
+                    results[indices[k]] = ok;
+                }
+                n = 0;
+            };
+
+            for (std::size_t i = 0; i < count; ++i) {
+                const ChainParams& p = verifiers[i]->params;
+                if (p.format != format || p.algorithm != algorithm) continue;
+                indices[n] = i;
+                pending[n] = responses[i];
+                if (++n == CHUNK) flush();
+            }
+            if (n > 0) flush();
+        }
+    }
+}
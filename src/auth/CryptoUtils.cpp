@@ -1,53 +1,221 @@
 #include "CryptoUtils.hpp"
+#include "Sha256.hpp"
+
+#include <algorithm>
+#include <cstdint>
 
-#include <cryptopp/sha.h>
 #include <cryptopp/hex.h>
 #include <cryptopp/filters.h>
 #include <cryptopp/files.h>
 #include <cryptopp/osrng.h>   // For AutoSeededRandomPool
 
 /**
- * @brief Generates a SHA-256 hash of a given string.
- * @param input The string to hash.
- * @return The resulting hash as an uppercase hexadecimal string.
+ * @brief Generates a hash of a given string.
+ * SHA-256 uses the SHA-NI backend of the Sha256 engine when the CPU supports it.
+ * @param input The bytes to hash.
+ * @param algorithm The hash function to use.
+ * @return The resulting 32-byte digest.
  */
-std::string CryptoUtils::genHash(const std::string& input)
+Digest CryptoUtils::genHash(std::string_view input, HashAlgorithm algorithm)
 {
-    std::string destination{};
-    CryptoPP::SHA256 hash;
+    Digest destination;
+    hashInto(input, destination, algorithm);
+    return destination;
+}
 
-    // A Crypto++ pipeline to hash the input and then hex-encode the result.
-    CryptoPP::StringSource ss(input, true,
-        new CryptoPP::HashFilter(hash, 
-            new CryptoPP::HexEncoder(
-                new CryptoPP::StringSink(destination)
-            )));
+/**
+ * @brief Hashes a byte span straight into a caller-provided digest.
+ * No pipeline, hex encoding or heap memory is involved.
+ * @param input The bytes to hash.
+ * @param out Receives the digest.
+ * @param algorithm The hash function to use.
+ */
+void CryptoUtils::hashInto(std::string_view input, Digest& out, HashAlgorithm algorithm)
+{
+    withHashPolicy(algorithm, [&](auto policy) {
+        decltype(policy)::hash(reinterpret_cast<const std::uint8_t*>(input.data()), input.size(), out.data());
+    });
+}
 
-    return destination;
+/**
+ * @brief Derives the next chain link from the previous one.
+ * Legacy (HexV1) chains hash the uppercase hex text of the link, BinaryV2 chains its raw bytes.
+ * @param link The previous link h_i.
+ * @param params The chain format and hash function.
+ * @return The next link h_{i+1}.
+ */
+Digest CryptoUtils::genNextLink(const Digest& link, const ChainParams& params)
+{
+    Digest next;
+    genNextLinkInto(link, params, next);
+    return next;
+}
+
+/**
+ * @brief Derives the next chain link into a caller-provided digest.
+ * @param link The previous link h_i.
+ * @param params The chain format and hash function.
+ * @param out Receives h_{i+1}.
+ */
+void CryptoUtils::genNextLinkInto(const Digest& link, const ChainParams& params, Digest& out)
+{
+    withHashPolicy(params.algorithm, [&](auto policy) {
+        out = genNextLinkWith<decltype(policy)>(link, params.format);
+    });
+}
+
+/**
+ * @brief Generates the SHA-256 hashes of many strings in one call.
+ * Inputs are grouped by length so that each group can be fed to the multi-buffer kernel.
+ * @param inputs The strings to hash.
+ * @return The resulting digests, in input order.
+ */
+std::vector<Digest> CryptoUtils::genHashBatch(const std::vector<std::string>& inputs)
+{
+    // Order the inputs by length; in practice every OTP has the same length and there is one group
+    std::vector<std::size_t> order(inputs.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&inputs](std::size_t a, std::size_t b) {
+        return inputs[a].size() < inputs[b].size();
+    });
+
+    std::vector<const std::uint8_t*> messages(inputs.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        messages[i] = reinterpret_cast<const std::uint8_t*>(inputs[order[i]].data());
+    }
+    std::vector<Digest> sorted(inputs.size());
+    auto digests = reinterpret_cast<std::uint8_t (*)[Sha256::DIGEST_SIZE]>(sorted.data());
+
+    // Hash each run of equal-length inputs with a single multi-buffer call
+    for (std::size_t begin = 0; begin < order.size();) {
+        std::size_t len = inputs[order[begin]].size();
+        std::size_t end = begin;
+        while (end < order.size() && inputs[order[end]].size() == len) ++end;
+        Sha256::hashMany(messages.data() + begin, len, end - begin, digests + begin);
+        begin = end;
+    }
+
+    // Put each digest back into its input's slot
+    std::vector<Digest> hashes(inputs.size());
+    for (std::size_t i = 0; i < order.size(); ++i) hashes[order[i]] = sorted[i];
+
+    return hashes;
+}
+
+/**
+ * @brief Derives the next link of many independent chains.
+ * @param links The previous links.
+ * @param params The chain format and hash function shared by all links.
+ * @return The next links, in input order.
+ */
+std::vector<Digest> CryptoUtils::genNextLinkBatch(const std::vector<Digest>& links, const ChainParams& params)
+{
+    std::vector<Digest> next(links.size());
+    genNextLinkBatch(links.data(), links.size(), params, next.data());
+    return next;
+}
+
+/**
+ * @brief Derives the next link of many independent chains into a caller-provided array.
+ * SHA-256 links go through the multi-buffer kernel in fixed-size chunks whose scratch
+ * space lives on the stack; other hash functions are applied one by one.
+ * @param links The previous links.
+ * @param count The number of links.
+ * @param params The chain format and hash function shared by all links.
+ * @param out Receives the next links, in input order.
+ */
+void CryptoUtils::genNextLinkBatch(const Digest* links, std::size_t count, const ChainParams& params, Digest* out)
+{
+    if (params.algorithm != HashAlgorithm::Sha256) {
+        withHashPolicy(params.algorithm, [&](auto policy) {
+            for (std::size_t i = 0; i < count; ++i) {
+                out[i] = genNextLinkWith<decltype(policy)>(links[i], params.format);
+            }
+        });
+        return;
+    }
+
+    const std::size_t CHUNK = 64;
+    const std::uint8_t* messages[CHUNK];
+    char hex[CHUNK][2 * Digest::SIZE];
+    std::size_t len = (params.format == ChainFormat::HexV1) ? sizeof(hex[0]) : Digest::SIZE;
+
+    for (std::size_t begin = 0; begin < count; begin += CHUNK) {
+        std::size_t n = std::min(CHUNK, count - begin);
+        for (std::size_t i = 0; i < n; ++i) {
+            if (params.format == ChainFormat::HexV1) {
+                // Legacy links are hashed as their 64-character hex text
+                links[begin + i].toHex(hex[i]);
+                messages[i] = reinterpret_cast<const std::uint8_t*>(hex[i]);
+            } else {
+                messages[i] = links[begin + i].data();
+            }
+        }
+        // The kernel reads every message of a lane group before writing its digests, so out may alias links
+        Sha256::hashMany(messages, len, n, reinterpret_cast<std::uint8_t (*)[Sha256::DIGEST_SIZE]>(out + begin));
+    }
 }
 
 /**
  * @brief Generates a Lamport hash chain of a specified length from a seed.
+ * The hash function is resolved once, so the loop runs on a compile-time policy.
  * @param seed The initial value (h_0) for the chain.
  * @param len The number of hashes to generate (n).
- * @return A vector of strings containing the hash chain [h_1, h_2, ..., h_n].
+ * @param params How each link is derived from the previous one.
+ * @param progress Called every CHAIN_PROGRESS_INTERVAL links; may cancel.
+ * @return A vector of digests containing the hash chain [h_1, h_2, ..., h_n], empty if cancelled.
  */
-std::vector<std::string> CryptoUtils::genHashChain(const std::string& seed, int len)
+std::vector<Digest> CryptoUtils::genHashChain(const std::string& seed, int len, const ChainParams& params,
+                                              const ChainProgress& progress)
 {
-    std::vector<std::string> chain;
-    std::string input{seed};
-    
-    // Iteratively generate n hashes
-    for(int i = 0; i < len; ++i)
-    {
-        // The hash of the previous value becomes the next value in the chain
-        chain.push_back(CryptoUtils::genHash(input));
-        input = chain.back();
-    }
+    std::vector<Digest> chain;
+    if (len <= 0) return chain;
+    chain.reserve(len);
 
+    // h_1 is the hash of the seed itself
+    chain.push_back(CryptoUtils::genHash(seed, params.algorithm));
+
+    // The hash of the previous value becomes the next value in the chain
+    bool cancelled = false;
+    withHashPolicy(params.algorithm, [&](auto policy) {
+        for(int i = 1; i < len; ++i)
+        {
+            chain.push_back(genNextLinkWith<decltype(policy)>(chain.back(), params.format));
+            if (i % CHAIN_PROGRESS_INTERVAL == 0 && progress && !progress(i + 1, len)) {
+                cancelled = true;
+                return;
+            }
+        }
+    });
+
+    if (cancelled) chain.clear();
     return chain;
 }
 
+/**
+ * @brief Computes the anchors of many chains, advancing them together.
+ * Chains are processed in groups small enough to stay in L1 cache; each step of a
+ * group is one multi-buffer pass for SHA-256 chains.
+ * @param seeds The seeds.
+ * @param count The number of chains.
+ * @param len The chain length.
+ * @param params The chain format and hash function.
+ * @param anchors Receives h_n of each chain.
+ */
+void CryptoUtils::genChainAnchors(const std::string* seeds, std::size_t count, std::uint64_t len,
+                                  const ChainParams& params, Digest* anchors)
+{
+    const std::size_t GROUP = 64;
+    for (std::size_t begin = 0; begin < count; begin += GROUP) {
+        std::size_t n = std::min(GROUP, count - begin);
+        Digest* links = anchors + begin;
+
+        // h_1 is the hash of the seed itself
+        for (std::size_t i = 0; i < n; ++i) hashInto(seeds[begin + i], links[i], params.algorithm);
+        for (std::uint64_t step = 1; step < len; ++step) genNextLinkBatch(links, n, params, links);
+    }
+}
+
 /**
  * @brief Generates a cryptographically secure random seed.
  * @param size The desired size of the seed in bytes.
@@ -55,8 +223,9 @@ std::vector<std::string> CryptoUtils::genHashChain(const std::string& seed, int
  */
 std::string CryptoUtils::generateRandomSeed(int size)
 {
-    // Use the operating system's random number generator
-    CryptoPP::AutoSeededRandomPool rng;
+    // One generator per thread, seeded from the operating system on first use; constructing
+    // a pool per call would reseed from the OS every time
+    thread_local CryptoPP::AutoSeededRandomPool rng;
 
     // Generate a block of random bytes
     std::string seed;
@@ -0,0 +1,94 @@
+#include "Digest.hpp"
+
+namespace {
+
+    const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+    /**
+     * @brief Decodes one hexadecimal character.
+     * @param c The character.
+     * @return Its value 0-15, or -1 if @p c is not a hex digit.
+     */
+    int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+}
+
+/**
+ * @brief Encodes the digest as an uppercase hexadecimal string.
+ * @return The 64-character hex encoding.
+ */
+std::string Digest::toHex() const
+{
+    std::string hex(2 * SIZE, '0');
+    toHex(&hex[0]);
+    return hex;
+}
+
+/**
+ * @brief Writes the uppercase hexadecimal encoding into a caller-provided buffer.
+ * @param out Buffer of at least 2 * SIZE characters.
+ */
+void Digest::toHex(char* out) const
+{
+    for (std::size_t i = 0; i < SIZE; ++i) {
+        out[2 * i] = HEX_DIGITS[bytes[i] >> 4];
+        out[2 * i + 1] = HEX_DIGITS[bytes[i] & 0x0F];
+    }
+}
+
+/**
+ * @brief Decodes a hexadecimal digest.
+ * @param hex Pointer to the hex characters.
+ * @param len The number of characters.
+ * @param out Receives the digest if decoding succeeds.
+ * @return True on success, false if the length or any character is invalid.
+ */
+bool Digest::fromHex(const char* hex, std::size_t len, Digest& out)
+{
+    if (len != 2 * SIZE) return false;
+    Digest decoded;
+    for (std::size_t i = 0; i < SIZE; ++i) {
+        int hi = hexValue(hex[2 * i]);
+        int lo = hexValue(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        decoded.bytes[i] = static_cast<std::uint8_t>((hi << 4) | lo);
+    }
+    out = decoded;
+    return true;
+}
+
+/**
+ * @brief Decodes a hexadecimal digest.
+ * @param hex The hex string.
+ * @param out Receives the digest if decoding succeeds.
+ * @return True on success, false otherwise.
+ */
+bool Digest::fromHex(const std::string& hex, Digest& out)
+{
+    return fromHex(hex.data(), hex.size(), out);
+}
+
+/**
+ * @brief Constant-time equality: every byte is always inspected.
+ */
+bool operator==(const Digest& lhs, const Digest& rhs)
+{
+    std::uint8_t diff = 0;
+    for (std::size_t i = 0; i < Digest::SIZE; ++i) {
+        diff |= static_cast<std::uint8_t>(lhs.bytes[i] ^ rhs.bytes[i]);
+    }
+    return diff == 0;
+}
+
+/**
+ * @brief Constant-time inequality.
+ */
+bool operator!=(const Digest& lhs, const Digest& rhs)
+{
+    return !(lhs == rhs);
+}
@@ -0,0 +1,162 @@
+#include "HashPolicy.hpp"
+#include "Sha256.hpp"
+
+#include <cstring>
+
+#include <cryptopp/blake2.h>
+
+namespace {
+
+    // SHA-512 round constants (FIPS 180-4, section 4.2.3).
+    const std::uint64_t K512[80] = {
+        0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+        0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+        0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+        0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+        0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+        0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+        0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+        0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+        0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+        0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+        0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+        0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+        0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+        0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+        0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+        0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+        0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+        0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+        0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+        0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+    };
+
+    // SHA-512/256 initial hash value (FIPS 180-4, section 5.3.6.2).
+    const std::uint64_t IV512_256[8] = {
+        0x22312194fc2bf72cULL, 0x9f555fa3c84c64c2ULL, 0x2393b86b6f53b151ULL, 0x963877195940eabdULL,
+        0x96283ee2a88effe3ULL, 0xbe5e1e2553863992ULL, 0x2b0199fc2c85b8aaULL, 0x0eb72ddc81c52ca2ULL
+    };
+
+    inline std::uint64_t rotr64(std::uint64_t x, int n) { return (x >> n) | (x << (64 - n)); }
+
+    inline std::uint64_t loadBe64(const std::uint8_t* p)
+    {
+        std::uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) v = (v << 8) | p[i];
+        return v;
+    }
+
+    inline void storeBe64(std::uint8_t* p, std::uint64_t v)
+    {
+        for (int i = 7; i >= 0; --i) {
+            p[i] = static_cast<std::uint8_t>(v);
+            v >>= 8;
+        }
+    }
+
+    /**
+     * @brief Runs the SHA-512 compression function on one 128-byte block.
+     * @param state The eight 64-bit state words.
+     * @param block The message block.
+     */
+    void compress512(std::uint64_t state[8], const std::uint8_t* block)
+    {
+        std::uint64_t w[80];
+        for (int t = 0; t < 16; ++t) w[t] = loadBe64(block + 8 * t);
+        for (int t = 16; t < 80; ++t) {
+            std::uint64_t s0 = rotr64(w[t - 15], 1) ^ rotr64(w[t - 15], 8) ^ (w[t - 15] >> 7);
+            std::uint64_t s1 = rotr64(w[t - 2], 19) ^ rotr64(w[t - 2], 61) ^ (w[t - 2] >> 6);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        std::uint64_t a = state[0], b = state[1], c = state[2], d = state[3];
+        std::uint64_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 80; ++t) {
+            std::uint64_t t1 = h + (rotr64(e, 14) ^ rotr64(e, 18) ^ rotr64(e, 41))
+                             + ((e & f) ^ (~e & g)) + K512[t] + w[t];
+            std::uint64_t t2 = (rotr64(a, 28) ^ rotr64(a, 34) ^ rotr64(a, 39))
+                             + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+/**
+ * @brief Hashes a message with SHA-256 through the accelerated Sha256 engine.
+ */
+void Sha256Policy::hash(const std::uint8_t* data, std::size_t len, std::uint8_t* out)
+{
+    Sha256::hash(data, len, out);
+}
+
+/**
+ * @brief Hashes a message with SHA-512/256: SHA-512 with its own IV, truncated to 256 bits.
+ */
+void Sha512_256Policy::hash(const std::uint8_t* data, std::size_t len, std::uint8_t* out)
+{
+    const std::size_t blockSize = 128;
+    std::uint64_t state[8];
+    std::memcpy(state, IV512_256, sizeof(state));
+
+    std::size_t fullBlocks = len / blockSize;
+    for (std::size_t b = 0; b < fullBlocks; ++b) compress512(state, data + b * blockSize);
+
+    // Pad with 0x80, zeros and the 128-bit big-endian bit length (messages here never exceed 2^64 bits)
+    std::size_t tailLen = len - fullBlocks * blockSize;
+    std::size_t tailBlocks = (tailLen + 17 > blockSize) ? 2 : 1;
+    std::uint8_t tail[2 * blockSize] = {};
+    std::memcpy(tail, data + fullBlocks * blockSize, tailLen);
+    tail[tailLen] = 0x80;
+    storeBe64(tail + tailBlocks * blockSize - 8, std::uint64_t(len) * 8);
+    for (std::size_t b = 0; b < tailBlocks; ++b) compress512(state, tail + b * blockSize);
+
+    std::uint8_t full[64];
+    for (int j = 0; j < 8; ++j) storeBe64(full + 8 * j, state[j]);
+    std::memcpy(out, full, Digest::SIZE);
+}
+
+/**
+ * @brief Hashes a message with BLAKE2s-256 using Crypto++.
+ * The hasher object is reused per thread; CalculateDigest() restarts it after every message.
+ */
+void Blake2sPolicy::hash(const std::uint8_t* data, std::size_t len, std::uint8_t* out)
+{
+    thread_local CryptoPP::BLAKE2s blake;
+    blake.CalculateDigest(out, data, len);
+}
+
+/**
+ * @brief Gets the canonical name of a hash algorithm.
+ * @param algorithm The algorithm.
+ * @return Its name.
+ */
+const char* hashAlgorithmName(HashAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case HashAlgorithm::Sha256: return "SHA-256";
+    case HashAlgorithm::Sha512_256: return "SHA-512/256";
+    case HashAlgorithm::Blake2s: return "BLAKE2s";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Looks up a hash algorithm by name.
+ * @param name The canonical name.
+ * @param algorithm Receives the algorithm on success.
+ * @return True if the name is known.
+ */
+bool parseHashAlgorithm(std::string_view name, HashAlgorithm& algorithm)
+{
+    for (HashAlgorithm candidate : {HashAlgorithm::Sha256, HashAlgorithm::Sha512_256, HashAlgorithm::Blake2s}) {
+        if (name == hashAlgorithmName(candidate)) {
+            algorithm = candidate;
+            return true;
+        }
+    }
+    return false;
+}
\ No newline at end of file
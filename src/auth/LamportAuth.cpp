@@ -1,14 +1,47 @@
 #include "LamportAuth.hpp"
 
+#include <algorithm>
+#include <memory>
+
 /**
  * @brief Initializes the Lamport scheme by generating a hash chain.
  * @param seed The initial secret seed (h_0).
  * @param len The length of the hash chain (n).
+ * @param chainParams The format and hash function of the chain.
+ * @param chainStorage Whether to keep the full chain or only checkpoints.
+ * @param progress Called every CHAIN_PROGRESS_INTERVAL links; may cancel.
+ * @return False if cancelled.
  */
-void LamportAuth::initChain(const std::string& seed, int len)
+bool LamportAuth::initChain(const std::string& seed, int len, const ChainParams& chainParams, ChainStorage chainStorage,
+                            const ChainProgress& progress)
 {
+    params = chainParams;
+    storage = chainStorage;
+    chainFile.close();
+    if (storage == ChainStorage::Checkpointed) {
+        // Only h_n and O(log n) checkpoints are kept; OTPs are recomputed on demand
+        chain.clear();
+        chain.shrink_to_fit();
+        return traverser.init(seed, len > 0 ? static_cast<std::uint64_t>(len) : 0, params, progress);
+    }
     // Generate the entire chain h_1, h_2, ..., h_n from the seed
-    chain = CryptoUtils::genHashChain(seed,len);
+    chain = CryptoUtils::genHashChain(seed, len, params, progress);
+    return len <= 0 || !chain.empty();
+}
+
+/**
+ * @brief Maps a chain file; OTPs are then read from it in O(1) without loading the chain.
+ * @param path The chain file.
+ * @return True on success.
+ */
+bool LamportAuth::openChainFile(const std::string& path)
+{
+    if (!chainFile.open(path)) return false;
+    params = chainFile.chainParams();
+    storage = ChainStorage::Mapped;
+    chain.clear();
+    chain.shrink_to_fit();
+    return true;
 }
 
 /**
@@ -16,10 +49,19 @@ void LamportAuth::initChain(const std::string& seed, int len)
  * The chain is stored as [h_1, h_2, ..., h_n].
  * For challenge c, the required OTP is h_{n-c}.
  * @param c The challenge number (1-based index).
- * @return The corresponding OTP string (h_{n-c}).
+ * @return The corresponding OTP (h_{n-c}).
  */
-std::string LamportAuth::getOTPForChallenge(int c)
+Digest LamportAuth::getOTPForChallenge(int c)
 {
+    if (storage == ChainStorage::Checkpointed) {
+        // Successive challenges walk down the chain, which the traverser serves cheaply
+        return traverser.linkAt(traverser.length() - static_cast<std::uint64_t>(c));
+    }
+    if (storage == ChainStorage::Mapped) {
+        return chainFile.linkAt(chainFile.length() - static_cast<std::uint64_t>(c));
+    }
+
+
     // Index is calculated as (size - 1) - (c - 1) = size - c.
     // However, the prompt says for challenge c, we send h_{n-c}.
     // Our chain is [h_1, ... h_{n-c}, ... h_n].
@@ -28,13 +70,94 @@ std::string LamportAuth::getOTPForChallenge(int c)
     return chain[chain.size() - c - 1];
 }
 
+/**
+ * @brief Gets the length of the client's chain.
+ * @return The number of links (n).
+ */
+std::uint64_t LamportAuth::getChainLength() const
+{
+    if (storage == ChainStorage::Checkpointed) return traverser.length();
+    if (storage == ChainStorage::Mapped) return chainFile.length();
+    return chain.size();
+}
+
+/**
+ * @brief Gets the format and hash function of this chain.
+ * @return The chain parameters.
+ */
+ChainParams LamportAuth::getChainParams() const
+{
+    return params;
+}
+
+/**
+ * @brief Sets the format and hash function of the chain being verified.
+ * @param chainParams The chain parameters.
+ */
+void LamportAuth::setChainParams(const ChainParams& chainParams)
+{
+    params = chainParams;
+    if (verifier.isEnrolled()) verifier.enroll(params, verifier.lastVerifiedHash());
+}
+
+/**
+ * @brief Encodes the enrollment message, keeping the legacy forms for SHA-256 chains.
+ * @param chainParams The chain parameters.
+ * @param anchor The final link h_n.
+ * @return The enrollment message.
+ */
+std::string LamportAuth::encodeEnrollment(const ChainParams& chainParams, const Digest& anchor)
+{
+    std::string message = anchor.toHex();
+    if (chainParams.algorithm != HashAlgorithm::Sha256) {
+        return std::to_string(static_cast<int>(chainParams.format)) + ":"
+             + hashAlgorithmName(chainParams.algorithm) + ":" + message;
+    }
+    if (chainParams.format == ChainFormat::BinaryV2) return "2:" + message;
+    return message;
+}
+
+/**
+ * @brief Decodes an enrollment message: "<hex>", "<format>:<hex>" or "<format>:<algorithm>:<hex>".
+ * @param message The received message.
+ * @param chainParams Receives the chain parameters.
+ * @param anchor Receives the anchor.
+ * @return True on success.
+ */
+bool LamportAuth::decodeEnrollment(std::string_view message, ChainParams& chainParams, Digest& anchor)
+{
+    ChainParams decoded;
+    std::string_view hex = message;
+
+    // Fields are sliced out of the message in place; nothing is copied
+    std::size_t first = message.find(':');
+    if (first != std::string_view::npos) {
+        std::string_view format = message.substr(0, first);
+        if (format == "1") decoded.format = ChainFormat::HexV1;
+        else if (format == "2") decoded.format = ChainFormat::BinaryV2;
+        else return false;
+
+        std::size_t second = message.find(':', first + 1);
+        if (second != std::string_view::npos) {
+            if (!parseHashAlgorithm(message.substr(first + 1, second - first - 1), decoded.algorithm)) return false;
+            hex = message.substr(second + 1);
+        } else {
+            hex = message.substr(first + 1);
+        }
+    }
+
+    if (!Digest::fromHex(hex.data(), hex.size(), anchor)) return false;
+    chainParams = decoded;
+    return true;
+}
+
 /**
  * @brief Sets or updates the last successfully verified hash.
  * @param hash The hash value (h_i) to store.
  */
-void LamportAuth::setLastHash(const std::string& hash)
+void LamportAuth::setLastHash(const Digest& hash)
 {
-    lastVerifiedHash = hash;
+    verifier.enroll(params, hash);
 }
 
 /**
@@ -43,28 +166,85 @@ void LamportAuth::setLastHash(const std::string& hash)
  * @param response The received OTP (h_{i-1}).
  * @return True if verification is successful, false otherwise.
  */
-bool LamportAuth::verifyOTP(const std::string& response)
+bool LamportAuth::verifyOTP(const Digest& response)
 {
-    // The received response should be h_{i-1}. Hashing it should yield h_i.
-    bool isCorrect = (CryptoUtils::genHash(response) == lastVerifiedHash);
-    // If correct, update the last verified hash to the new, lower-index hash
-    if(isCorrect) LamportAuth::setLastHash(response);
-    return isCorrect;
+    return verifier.verify(response);
+}
+
+/**
+ * @brief Verifies an OTP that may skip up to window - 1 positions of the chain.
+ * @param response The received OTP (h_{i-j}).
+ * @param window The largest j to try.
+ * @param offset Receives j on success, 0 otherwise.
+ * @return True if verification is successful, false otherwise.
+ */
+bool LamportAuth::verifyOTP(const Digest& response, int window, int& offset)
+{
+    return verifier.verify(response, window, offset);
+}
+
+/**
+ * @brief Verifies a batch of OTPs, one per verifier, with multi-buffer hash passes.
+ * @param verifiers The verifiers, each holding its own last verified hash.
+ * @param responses The received OTPs; responses[i] is checked against verifiers[i].
+ * @return A vector with the verification result for each verifier.
+ */
+std::vector<bool> LamportAuth::verifyOTPBatch(const std::vector<LamportAuth*>& verifiers,
+                                              const std::vector<Digest>& responses)
+{
+    std::vector<bool> results(verifiers.size(), false);
+    if (responses.size() != verifiers.size()) return results;
+
+    std::unique_ptr<bool[]> accepted(new bool[verifiers.size()]);
+    verifyOTPBatch(verifiers.data(), responses.data(), verifiers.size(), accepted.get());
+    for (std::size_t i = 0; i < verifiers.size(); ++i) results[i] = accepted[i];
+    return results;
+}
+
+/**
+ * @brief Verifies a batch of OTPs into a caller-provided result array.
+ * Forwards to ChainVerifier::verifyBatch() a stack chunk of verifiers at a time.
+ * @param verifiers The verifiers.
+ * @param responses The received OTPs.
+ * @param count The number of verifiers and responses.
+ * @param results Receives the verification result for each verifier.
+ */
+void LamportAuth::verifyOTPBatch(LamportAuth* const* verifiers, const Digest* responses,
+                                 std::size_t count, bool* results)
+{
+    const std::size_t CHUNK = 64;
+    ChainVerifier* chunk[CHUNK];
+    for (std::size_t begin = 0; begin < count; begin += CHUNK) {
+        std::size_t n = std::min(CHUNK, count - begin);
+        for (std::size_t i = 0; i < n; ++i) chunk[i] = &verifiers[begin + i]->verifier;
+        ChainVerifier::verifyBatch(chunk, responses + begin, n, results + begin);
+    }
 }
 
 /**
  * @brief Gets the last successfully verified hash (h_i).
- * @return The last verified hash string.
+ * @return The last verified hash.
+ */
+Digest LamportAuth::getLastVerifiedHash()
+{
+    return verifier.lastVerifiedHash();
+}
+
+/**
+ * @brief Checks whether the initial hash (h_n) has been received.
+ * @return True if a verified hash is stored.
  */
-std::string LamportAuth::getLastVerifiedHash()
+bool LamportAuth::hasLastVerifiedHash() const
 {
-    return lastVerifiedHash;
+    return verifier.isEnrolled();
 }
 
 /**
  * @brief Gets the last hash in the chain (h_n).
- * @return The final hash string.
+ * @return The final hash.
  */
-std::string LamportAuth::getLastHash(){
+Digest LamportAuth::getLastHash(){
+    if (storage == ChainStorage::Checkpointed) return traverser.lastLink();
+    if (storage == ChainStorage::Mapped) return chainFile.lastLink();
     return chain.back();
 }
\ No newline at end of file
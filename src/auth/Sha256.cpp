@@ -0,0 +1,410 @@
+#include "Sha256.hpp"
+
+#include <cstring>
+
+// The multi-buffer kernels and the SHA-NI path rely on GCC/Clang vector extensions and
+// per-function target attributes, so they are only built for x86 with a GNU-compatible compiler.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA256_HAVE_X86_LANES 1
+#define SHA256_INLINE inline __attribute__((always_inline))
+// The helpers are always inlined into a target-specific kernel, so the vector ABI warning does not apply
+#pragma GCC diagnostic ignored "-Wpsabi"
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define SHA256_HAVE_X86_LANES 0
+#define SHA256_INLINE inline
+#endif
+
+namespace {
+
+    // Round constants (FIPS 180-4, section 4.2.2).
+    const std::uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    // Initial hash value (FIPS 180-4, section 5.3.3).
+    const std::uint32_t IV[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    SHA256_INLINE std::uint32_t loadBe32(const std::uint8_t* p)
+    {
+        return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | p[3];
+    }
+
+    SHA256_INLINE void storeBe32(std::uint8_t* p, std::uint32_t v)
+    {
+        p[0] = std::uint8_t(v >> 24);
+        p[1] = std::uint8_t(v >> 16);
+        p[2] = std::uint8_t(v >> 8);
+        p[3] = std::uint8_t(v);
+    }
+
+    // The round helpers are written once against a generic word type V, which is
+    // either a plain uint32_t (one lane) or a GCC vector of L uint32_t lanes.
+    template <typename V> SHA256_INLINE V rotr(const V& x, int n) { return (x >> n) | (x << (32 - n)); }
+    template <typename V> SHA256_INLINE V ch(const V& e, const V& f, const V& g) { return (e & f) ^ (~e & g); }
+    template <typename V> SHA256_INLINE V maj(const V& a, const V& b, const V& c) { return (a & b) ^ (a & c) ^ (b & c); }
+    template <typename V> SHA256_INLINE V bigSigma0(const V& x) { return rotr(x, 2) ^ rotr(x, 13) ^ rotr(x, 22); }
+    template <typename V> SHA256_INLINE V bigSigma1(const V& x) { return rotr(x, 6) ^ rotr(x, 11) ^ rotr(x, 25); }
+    template <typename V> SHA256_INLINE V smallSigma0(const V& x) { return rotr(x, 7) ^ rotr(x, 18) ^ (x >> 3); }
+    template <typename V> SHA256_INLINE V smallSigma1(const V& x) { return rotr(x, 17) ^ rotr(x, 19) ^ (x >> 10); }
+
+    /**
+     * @brief Runs the SHA-256 compression function on one block per lane.
+     * @param state The eight working state words, one lane per message.
+     * @param blocks L pointers to the 64-byte block of each lane.
+     */
+    template <typename V, std::size_t L>
+    SHA256_INLINE void compressLanes(V state[8], const std::uint8_t* const* blocks)
+    {
+        // Transpose the big-endian message words so that w[t] holds word t of every lane
+        V w[16];
+        for (int t = 0; t < 16; ++t) {
+            std::uint32_t words[L];
+            for (std::size_t i = 0; i < L; ++i) words[i] = loadBe32(blocks[i] + 4 * t);
+            std::memcpy(&w[t], words, sizeof(V));
+        }
+
+        V a = state[0], b = state[1], c = state[2], d = state[3];
+        V e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int t = 0; t < 64; ++t) {
+            // The message schedule is kept in a rolling window of 16 words
+            if (t >= 16) {
+                w[t & 15] = smallSigma1(w[(t - 2) & 15]) + w[(t - 7) & 15]
+                          + smallSigma0(w[(t - 15) & 15]) + w[t & 15];
+            }
+            V t1 = h + bigSigma1(e) + ch(e, f, g) + K[t] + w[t & 15];
+            V t2 = bigSigma0(a) + maj(a, b, c);
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+
+    /**
+     * @brief Hashes L equal-length messages, one per lane.
+     * @param messages L pointers to the messages.
+     * @param len The common message length in bytes.
+     * @param out Receives the L digests.
+     */
+    template <typename V, std::size_t L>
+    SHA256_INLINE void hashLanes(const std::uint8_t* const* messages, std::size_t len,
+                                 std::uint8_t (*out)[Sha256::DIGEST_SIZE])
+    {
+        V state[8];
+        for (int j = 0; j < 8; ++j) state[j] = V{} + IV[j];
+
+        // Every full block is read straight from the caller's buffers
+        const std::uint8_t* blocks[L];
+        std::size_t fullBlocks = len / Sha256::BLOCK_SIZE;
+        for (std::size_t b = 0; b < fullBlocks; ++b) {
+            for (std::size_t i = 0; i < L; ++i) blocks[i] = messages[i] + b * Sha256::BLOCK_SIZE;
+            compressLanes<V, L>(state, blocks);
+        }
+
+        // The remaining bytes plus padding span one or two blocks. Since every lane
+        // has the same length, the padding layout is identical across lanes.
+        std::size_t tailLen = len - fullBlocks * Sha256::BLOCK_SIZE;
+        std::size_t tailBlocks = (tailLen + 9 > Sha256::BLOCK_SIZE) ? 2 : 1;
+        std::uint64_t bitLen = std::uint64_t(len) * 8;
+        std::uint8_t tail[L][2 * Sha256::BLOCK_SIZE];
+        for (std::size_t i = 0; i < L; ++i) {
+            std::memset(tail[i], 0, sizeof(tail[i]));
+            std::memcpy(tail[i], messages[i] + fullBlocks * Sha256::BLOCK_SIZE, tailLen);
+            tail[i][tailLen] = 0x80;
+            std::uint8_t* lenField = tail[i] + tailBlocks * Sha256::BLOCK_SIZE - 8;
+            storeBe32(lenField, std::uint32_t(bitLen >> 32));
+            storeBe32(lenField + 4, std::uint32_t(bitLen));
+        }
+        for (std::size_t b = 0; b < tailBlocks; ++b) {
+            for (std::size_t i = 0; i < L; ++i) blocks[i] = tail[i] + b * Sha256::BLOCK_SIZE;
+            compressLanes<V, L>(state, blocks);
+        }
+
+        // Transpose the state back into one big-endian digest per lane
+        for (int j = 0; j < 8; ++j) {
+            std::uint32_t words[L];
+            std::memcpy(words, &state[j], sizeof(V));
+            for (std::size_t i = 0; i < L; ++i) storeBe32(out[i] + 4 * j, words[i]);
+        }
+    }
+
+    typedef void (*BlockCompressor)(std::uint32_t state[8], const std::uint8_t* blocks, std::size_t count);
+
+    /**
+     * @brief Hashes one message with a given block compression function.
+     * @param compress Compresses consecutive 64-byte blocks into the state.
+     * @param data The message bytes.
+     * @param len The message length in bytes.
+     * @param out Receives the digest.
+     */
+    SHA256_INLINE void hashSingle(BlockCompressor compress, const std::uint8_t* data, std::size_t len,
+                                  std::uint8_t out[Sha256::DIGEST_SIZE])
+    {
+        std::uint32_t state[8];
+        std::memcpy(state, IV, sizeof(state));
+
+        std::size_t fullBlocks = len / Sha256::BLOCK_SIZE;
+        compress(state, data, fullBlocks);
+
+        std::size_t tailLen = len - fullBlocks * Sha256::BLOCK_SIZE;
+        std::size_t tailBlocks = (tailLen + 9 > Sha256::BLOCK_SIZE) ? 2 : 1;
+        std::uint64_t bitLen = std::uint64_t(len) * 8;
+        std::uint8_t tail[2 * Sha256::BLOCK_SIZE] = {};
+        std::memcpy(tail, data + fullBlocks * Sha256::BLOCK_SIZE, tailLen);
+        tail[tailLen] = 0x80;
+        storeBe32(tail + tailBlocks * Sha256::BLOCK_SIZE - 8, std::uint32_t(bitLen >> 32));
+        storeBe32(tail + tailBlocks * Sha256::BLOCK_SIZE - 4, std::uint32_t(bitLen));
+        compress(state, tail, tailBlocks);
+
+        for (int j = 0; j < 8; ++j) storeBe32(out + 4 * j, state[j]);
+    }
+
+    void compressScalar(std::uint32_t state[8], const std::uint8_t* blocks, std::size_t count)
+    {
+        for (std::size_t b = 0; b < count; ++b) {
+            const std::uint8_t* block = blocks + b * Sha256::BLOCK_SIZE;
+            compressLanes<std::uint32_t, 1>(state, &block);
+        }
+    }
+
+#if SHA256_HAVE_X86_LANES
+    /**
+     * @brief Compresses blocks with the x86 SHA extensions (SHA-NI).
+     * The state is kept in the ABEF/CDGH register layout expected by SHA256RNDS2.
+     */
+    __attribute__((target("sha,sse4.1")))
+    void compressShaNi(std::uint32_t state[8], const std::uint8_t* blocks, std::size_t count)
+    {
+        const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+        // Rearrange the state from ABCD/EFGH into ABEF/CDGH
+        __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0])), 0xB1);
+        __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4])), 0x1B);
+        __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+        state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+        for (std::size_t b = 0; b < count; ++b) {
+            const std::uint8_t* block = blocks + b * Sha256::BLOCK_SIZE;
+            __m128i abefSave = state0;
+            __m128i cdghSave = state1;
+
+            // msg[i % 4] holds message words 4i..4i+3 for the group of four rounds being run
+            __m128i msg[4];
+            for (int i = 0; i < 4; ++i) {
+                msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i)), byteSwap);
+            }
+
+            for (int i = 0; i < 16; ++i) {
+                if (i >= 4) {
+                    __m128i w = _mm_sha256msg1_epu32(msg[i & 3], msg[(i + 1) & 3]);
+                    w = _mm_add_epi32(w, _mm_alignr_epi8(msg[(i + 3) & 3], msg[(i + 2) & 3], 4));
+                    msg[i & 3] = _mm_sha256msg2_epu32(w, msg[(i + 3) & 3]);
+                }
+                __m128i wk = _mm_add_epi32(msg[i & 3], _mm_loadu_si128(reinterpret_cast<const __m128i*>(&K[4 * i])));
+                state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+                state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(wk, 0x0E));
+            }
+
+            state0 = _mm_add_epi32(state0, abefSave);
+            state1 = _mm_add_epi32(state1, cdghSave);
+        }
+
+        // Rearrange ABEF/CDGH back into ABCD/EFGH
+        tmp = _mm_shuffle_epi32(state0, 0x1B);
+        state1 = _mm_shuffle_epi32(state1, 0xB1);
+        state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+        state1 = _mm_alignr_epi8(state1, tmp, 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+    }
+
+    /**
+     * @brief Checks CPUID for the SHA extensions (leaf 7, EBX bit 29) and SSE4.1.
+     * @return True if compressShaNi() can run on this CPU.
+     */
+    bool cpuHasShaNi()
+    {
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+        __builtin_cpu_init();
+        return (ebx & (1u << 29)) != 0 && __builtin_cpu_supports("sse4.1");
+    }
+#endif
+
+    /**
+     * @brief Describes the single-message backend chosen for this CPU.
+     */
+    struct SingleBackend {
+        BlockCompressor compress;
+        const char* name;
+    };
+
+    /**
+     * @brief Picks SHA-NI when the running CPU has it, the portable code otherwise.
+     * @return The selected backend. Evaluated once, on first use.
+     */
+    const SingleBackend& activeSingleBackend()
+    {
+        static const SingleBackend backend = []() -> SingleBackend {
+#if SHA256_HAVE_X86_LANES
+            if (cpuHasShaNi()) return {compressShaNi, "sha-ni"};
+#endif
+            return {compressScalar, "scalar"};
+        }();
+        return backend;
+    }
+
+    typedef void (*LaneKernel)(const std::uint8_t* const*, std::size_t, std::uint8_t (*)[Sha256::DIGEST_SIZE]);
+
+    void hashLanesScalar(const std::uint8_t* const* messages, std::size_t len,
+                         std::uint8_t (*out)[Sha256::DIGEST_SIZE])
+    {
+        hashLanes<std::uint32_t, 1>(messages, len, out);
+    }
+
+#if SHA256_HAVE_X86_LANES
+    typedef std::uint32_t u32x4 __attribute__((vector_size(16)));
+    typedef std::uint32_t u32x8 __attribute__((vector_size(32)));
+    typedef std::uint32_t u32x16 __attribute__((vector_size(64)));
+
+    __attribute__((target("sse4.1")))
+    void hashLanesSse41(const std::uint8_t* const* messages, std::size_t len,
+                        std::uint8_t (*out)[Sha256::DIGEST_SIZE])
+    {
+        hashLanes<u32x4, 4>(messages, len, out);
+    }
+
+    __attribute__((target("avx2")))
+    void hashLanesAvx2(const std::uint8_t* const* messages, std::size_t len,
+                       std::uint8_t (*out)[Sha256::DIGEST_SIZE])
+    {
+        hashLanes<u32x8, 8>(messages, len, out);
+    }
+
+    __attribute__((target("avx512f")))
+    void hashLanesAvx512(const std::uint8_t* const* messages, std::size_t len,
+                         std::uint8_t (*out)[Sha256::DIGEST_SIZE])
+    {
+        hashLanes<u32x16, 16>(messages, len, out);
+    }
+#endif
+
+    /**
+     * @brief Describes the multi-buffer kernel chosen for this CPU.
+     */
+    struct MultiBufferKernel {
+        LaneKernel fn;
+        std::size_t lanes;
+        const char* name;
+    };
+
+    /**
+     * @brief Picks the widest multi-buffer kernel the running CPU supports.
+     * @return The selected kernel. Evaluated once, on first use.
+     */
+    const MultiBufferKernel& activeKernel()
+    {
+        static const MultiBufferKernel kernel = []() -> MultiBufferKernel {
+#if SHA256_HAVE_X86_LANES
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f")) return {hashLanesAvx512, 16, "avx512"};
+            if (__builtin_cpu_supports("avx2")) return {hashLanesAvx2, 8, "avx2"};
+            if (__builtin_cpu_supports("sse4.1")) return {hashLanesSse41, 4, "sse4.1"};
+#endif
+            return {hashLanesScalar, 1, "scalar"};
+        }();
+        return kernel;
+    }
+}
+
+/**
+ * @brief Hashes a single message with the fastest backend available (SHA-NI or scalar).
+ * @param data Pointer to the message bytes.
+ * @param len The message length in bytes.
+ * @param out Receives the 32-byte digest.
+ */
+void Sha256::hash(const std::uint8_t* data, std::size_t len, std::uint8_t out[DIGEST_SIZE])
+{
+    hashSingle(activeSingleBackend().compress, data, len, out);
+}
+
+/**
+ * @brief Hashes a single message with the portable scalar implementation.
+ * @param data Pointer to the message bytes.
+ * @param len The message length in bytes.
+ * @param out Receives the 32-byte digest.
+ */
+void Sha256::hashPortable(const std::uint8_t* data, std::size_t len, std::uint8_t out[DIGEST_SIZE])
+{
+    hashSingle(compressScalar, data, len, out);
+}
+
+/**
+ * @brief Gets the name of the active single-message backend.
+ * @return A short backend name for logging.
+ */
+const char* Sha256::backend()
+{
+    return activeSingleBackend().name;
+}
+
+/**
+ * @brief Hashes many equal-length messages using the multi-buffer kernel.
+ * A final partial group is padded with copies of its last message.
+ * @param messages Array of message pointers.
+ * @param len The common message length in bytes.
+ * @param count The number of messages.
+ * @param out Receives one digest per message.
+ */
+void Sha256::hashMany(const std::uint8_t* const* messages, std::size_t len, std::size_t count,
+                      std::uint8_t (*out)[DIGEST_SIZE])
+{
+    const MultiBufferKernel& kernel = activeKernel();
+
+    std::size_t i = 0;
+    for (; i + kernel.lanes <= count; i += kernel.lanes) {
+        kernel.fn(messages + i, len, out + i);
+    }
+    if (i == count) return;
+
+    // Fill the unused lanes of the last group with a real message and discard their output
+    const std::uint8_t* group[16];
+    std::uint8_t groupOut[16][DIGEST_SIZE];
+    std::size_t remaining = count - i;
+    for (std::size_t lane = 0; lane < kernel.lanes; ++lane) {
+        group[lane] = messages[i + (lane < remaining ? lane : remaining - 1)];
+    }
+    kernel.fn(group, len, groupOut);
+    std::memcpy(out + i, groupOut, remaining * DIGEST_SIZE);
+}
+
+/**
+ * @brief Gets the lane count of the active multi-buffer kernel.
+ * @return The number of messages hashed per kernel invocation.
+ */
+std::size_t Sha256::laneCount()
+{
+    return activeKernel().lanes;
+}
+
+/**
+ * @brief Gets the name of the active multi-buffer kernel.
+ * @return A short backend name for logging.
+ */
+const char* Sha256::multiBufferBackend()
+{
+    return activeKernel().name;
+}
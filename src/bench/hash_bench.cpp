@@ -0,0 +1,109 @@
+#include "CryptoUtils.hpp"
+#include "Sha256.hpp"
+
+#include <cryptopp/sha.h>
+#include <cryptopp/hex.h>
+#include <cryptopp/filters.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * @brief Prints one benchmark result line.
+     * @param name The name of the measured operation.
+     * @param elapsed The total time taken.
+     * @param hashes The number of hashes performed.
+     */
+    void report(const std::string& name, Clock::duration elapsed, long hashes)
+    {
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count() / hashes;
+        std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << ns << " ns/hash" << std::setw(14) << (1e9 / ns) << " hashes/s" << std::endl;
+    }
+
+    /**
+     * @brief The pre-engine genHash: a Crypto++ pipeline producing uppercase hex.
+     * @param input The string to hash.
+     * @return The hex digest.
+     */
+    std::string pipelineHash(const std::string& input)
+    {
+        std::string destination;
+        CryptoPP::SHA256 hash;
+        CryptoPP::StringSource ss(input, true,
+            new CryptoPP::HashFilter(hash,
+                new CryptoPP::HexEncoder(
+                    new CryptoPP::StringSink(destination)
+                )));
+        return destination;
+    }
+}
+
+/**
+ * @brief Benchmarks the SHA-256 backends on chain-link sized messages.
+ * Usage: lamport-hash-bench [iterations]
+ */
+int main(int argc, char *argv[])
+{
+    long iterations = (argc > 1) ? std::atol(argv[1]) : 200000;
+    if (iterations <= 0) iterations = 200000;
+
+    std::cout << "SHA-256 backend: " << Sha256::backend()
+              << ", multi-buffer: " << Sha256::multiBufferBackend()
+              << " x" << Sha256::laneCount() << std::endl;
+
+    // A legacy link is 64 hex characters, a binary link 32 bytes
+    std::string hexLink(2 * Digest::SIZE, 'A');
+    Digest binaryLink;
+
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < iterations; ++i) hexLink = pipelineHash(hexLink);
+    report("crypto++ pipeline (64 B, hex out)", Clock::now() - start, iterations);
+
+    start = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        Sha256::hashPortable(binaryLink.data(), Digest::SIZE, binaryLink.data());
+    }
+    report("portable (32 B)", Clock::now() - start, iterations);
+
+    start = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        Sha256::hash(binaryLink.data(), Digest::SIZE, binaryLink.data());
+    }
+    report(std::string(Sha256::backend()) + " (32 B)", Clock::now() - start, iterations);
+
+    // Independent messages through the multi-buffer kernel
+    ChainParams binarySha256;
+    binarySha256.format = ChainFormat::BinaryV2;
+    std::vector<Digest> links(1024);
+    long rounds = iterations / static_cast<long>(links.size()) + 1;
+    start = Clock::now();
+    for (long r = 0; r < rounds; ++r) links = CryptoUtils::genNextLinkBatch(links, binarySha256);
+    report(std::string("multi-buffer ") + Sha256::multiBufferBackend() + " (32 B)",
+           Clock::now() - start, rounds * static_cast<long>(links.size()));
+
+    // Serial chain generation is bound by single-hash latency
+    int len = static_cast<int>(iterations);
+    for (HashAlgorithm algorithm : {HashAlgorithm::Sha256, HashAlgorithm::Sha512_256, HashAlgorithm::Blake2s}) {
+        for (ChainFormat format : {ChainFormat::HexV1, ChainFormat::BinaryV2}) {
+            ChainParams params;
+            params.format = format;
+            params.algorithm = algorithm;
+            start = Clock::now();
+            std::vector<Digest> chain = CryptoUtils::genHashChain("benchmark-seed", len, params);
+            report("genHashChain " + std::string(hashAlgorithmName(algorithm))
+                       + (format == ChainFormat::HexV1 ? " (format 1)" : " (format 2)"),
+                   Clock::now() - start, len);
+        }
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,475 @@
+#include "CountingAllocator.hpp"
+#include "CryptoUtils.hpp"
+#include "LamportAuth.hpp"
+#include "Sha256.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * @class Timer
+     * @brief Measures the timed part of a benchmark run, with the allocations made during it.
+     *
+     * A benchmark calls stop() before work that must not be measured, such as
+     * rebuilding a used-up chain, and start() after it.
+     */
+    class Timer {
+    public:
+        /**
+         * @brief Starts or resumes the measurement.
+         */
+        void start()
+        {
+            allocations -= allocationCount.load(std::memory_order_relaxed);
+            bytes -= allocationBytes.load(std::memory_order_relaxed);
+            begin = Clock::now();
+        }
+
+        /**
+         * @brief Pauses the measurement.
+         */
+        void stop()
+        {
+            elapsed += Clock::now() - begin;
+            allocations += allocationCount.load(std::memory_order_relaxed);
+            bytes += allocationBytes.load(std::memory_order_relaxed);
+        }
+
+        Clock::duration elapsed{0};     ///< Total measured time.
+        std::uint64_t allocations = 0;  ///< Allocations during the measured time.
+        std::uint64_t bytes = 0;        ///< Bytes allocated during the measured time.
+
+    private:
+        Clock::time_point begin;
+    };
+
+    /**
+     * @struct Benchmark
+     * @brief A named operation and the number of hashes one operation computes.
+     */
+    struct Benchmark {
+        std::string name;                             ///< Unique name, the key for baseline comparisons.
+        double hashesPerOp;                           ///< Hashes per operation; 0 when not meaningful.
+        std::function<void(Timer&, long)> run;        ///< Runs the operation a number of times; the timer is started.
+    };
+
+    /**
+     * @struct Result
+     * @brief The measurement of one benchmark.
+     */
+    struct Result {
+        std::string name;         ///< The benchmark name.
+        long iterations = 0;      ///< Operations per measured run.
+        double nsPerOp = 0;       ///< Median time per operation.
+        double hashesPerOp = 0;   ///< Hashes per operation; 0 when not meaningful.
+        double allocsPerOp = 0;   ///< Allocations per operation.
+        double bytesPerOp = 0;    ///< Bytes allocated per operation.
+    };
+
+    /**
+     * @brief Runs a benchmark once for a given number of operations.
+     * @param benchmark The benchmark.
+     * @param iterations The number of operations.
+     * @return The timer after the run.
+     */
+    Timer runOnce(const Benchmark& benchmark, long iterations)
+    {
+        Timer timer;
+        timer.start();
+        benchmark.run(timer, iterations);
+        timer.stop();
+        return timer;
+    }
+
+    /**
+     * @brief Measures a benchmark: grows the operation count until a run takes at least
+     * minTime seconds, then keeps the median of several runs of that length.
+     * @param benchmark The benchmark.
+     * @param minTime The shortest measured run, in seconds.
+     * @param repetitions The number of measured runs.
+     * @return The result.
+     */
+    Result measure(const Benchmark& benchmark, double minTime, int repetitions)
+    {
+        long iterations = 1;
+        for (;;) {
+            double seconds = std::chrono::duration<double>(runOnce(benchmark, iterations).elapsed).count();
+            if (seconds >= minTime || iterations >= (1L << 40)) break;
+            // Aim 20% past the target so the measured runs do not fall just short of it
+            double scale = seconds > 0 ? 1.2 * minTime / seconds : 10.0;
+            iterations = static_cast<long>(iterations * std::min(10.0, std::max(2.0, scale)));
+        }
+
+        std::vector<Timer> runs;
+        for (int i = 0; i < repetitions; ++i) runs.push_back(runOnce(benchmark, iterations));
+        std::sort(runs.begin(), runs.end(),
+                  [](const Timer& a, const Timer& b) { return a.elapsed < b.elapsed; });
+        const Timer& median = runs[runs.size() / 2];
+
+        Result result;
+        result.name = benchmark.name;
+        result.iterations = iterations;
+        result.nsPerOp = std::chrono::duration<double, std::nano>(median.elapsed).count() / iterations;
+        result.hashesPerOp = benchmark.hashesPerOp;
+        result.allocsPerOp = static_cast<double>(median.allocations) / iterations;
+        result.bytesPerOp = static_cast<double>(median.bytes) / iterations;
+        return result;
+    }
+
+    /**
+     * @brief Keeps a value from being optimized away.
+     * @param value The value.
+     */
+    template <typename T>
+    void keep(const T& value)
+    {
+        asm volatile("" : : "r"(&value) : "memory");
+    }
+
+    /**
+     * @brief Gets the name of a chain format for benchmark names.
+     * @param format The format.
+     * @return "hex" or "binary".
+     */
+    const char* formatName(ChainFormat format)
+    {
+        return format == ChainFormat::HexV1 ? "hex" : "binary";
+    }
+
+    /**
+     * @brief Builds the list of benchmarks.
+     * @return Every benchmark, in reporting order.
+     */
+    std::vector<Benchmark> benchmarks()
+    {
+        std::vector<Benchmark> list;
+
+        // A legacy link is hashed as 64 hex characters, a binary link as 32 bytes
+        for (std::size_t size : {std::size_t(32), std::size_t(64)}) {
+            list.push_back({"genHash/" + std::to_string(size), 1, [size](Timer&, long n) {
+                std::string input(size, 'A');
+                for (long i = 0; i < n; ++i) {
+                    Digest digest = CryptoUtils::genHash(input);
+                    input[0] = static_cast<char>(digest.data()[0]);
+                }
+                keep(input);
+            }});
+        }
+
+        for (ChainFormat format : {ChainFormat::HexV1, ChainFormat::BinaryV2}) {
+            for (int length : {1 << 10, 1 << 14, 1 << 18}) {
+                ChainParams params;
+                params.format = format;
+                list.push_back({"genHashChain/" + std::string(formatName(format)) + "/" + std::to_string(length),
+                                static_cast<double>(length), [params, length](Timer&, long n) {
+                    for (long i = 0; i < n; ++i) keep(CryptoUtils::genHashChain("benchmark-seed", length, params));
+                }});
+            }
+        }
+
+        list.push_back({"generateRandomSeed/32", 0, [](Timer&, long n) {
+            for (long i = 0; i < n; ++i) keep(CryptoUtils::generateRandomSeed(32));
+        }});
+
+        list.push_back({"convertToHex/32", 0, [](Timer&, long n) {
+            std::string input(32, '\x5a');
+            for (long i = 0; i < n; ++i) keep(CryptoUtils::convertToHex(input));
+        }});
+
+        const int CHAIN_LENGTH = 1 << 14;
+        for (ChainStorage storage : {ChainStorage::Full, ChainStorage::Checkpointed}) {
+            std::string mode = storage == ChainStorage::Full ? "full" : "checkpointed";
+            list.push_back({"initChain/" + mode + "/" + std::to_string(CHAIN_LENGTH), CHAIN_LENGTH,
+                            [storage, CHAIN_LENGTH](Timer&, long n) {
+                for (long i = 0; i < n; ++i) {
+                    LamportAuth client;
+                    client.initChain("benchmark-seed", CHAIN_LENGTH, ChainParams(), storage);
+                    keep(client);
+                }
+            }});
+
+            // Challenges walk down the chain; a used-up chain is rebuilt outside the measurement
+            list.push_back({"getOTPForChallenge/" + mode + "/" + std::to_string(CHAIN_LENGTH), 0,
+                            [storage, CHAIN_LENGTH](Timer& timer, long n) {
+                timer.stop();
+                LamportAuth client;
+                client.initChain("benchmark-seed", CHAIN_LENGTH, ChainParams(), storage);
+                int challenge = 1;
+                timer.start();
+                for (long i = 0; i < n; ++i) {
+                    if (challenge == CHAIN_LENGTH) {
+                        timer.stop();
+                        client.initChain("benchmark-seed", CHAIN_LENGTH, ChainParams(), storage);
+                        challenge = 1;
+                        timer.start();
+                    }
+                    keep(client.getOTPForChallenge(challenge++));
+                }
+            }});
+        }
+
+        // The server walks down one chain from its anchor; a used-up chain starts over
+        for (ChainFormat format : {ChainFormat::HexV1, ChainFormat::BinaryV2}) {
+            ChainParams params;
+            params.format = format;
+            list.push_back({"verifyOTP/" + std::string(formatName(format)), 1, [params, CHAIN_LENGTH](Timer& timer, long n) {
+                timer.stop();
+                std::vector<Digest> chain = CryptoUtils::genHashChain("benchmark-seed", CHAIN_LENGTH, params);
+                LamportAuth server;
+                server.setChainParams(params);
+                server.setLastHash(chain.back());
+                std::size_t next = chain.size() - 1;
+                timer.start();
+                bool valid = true;
+                for (long i = 0; i < n; ++i) {
+                    if (next == 0) {
+                        server.setLastHash(chain.back());
+                        next = chain.size() - 1;
+                    }
+                    valid &= server.verifyOTP(chain[--next]);
+                }
+                timer.stop();
+                if (!valid) std::cerr << "lamport-bench: verifyOTP rejected a valid response" << std::endl;
+                timer.start();
+            }});
+        }
+
+        // Many sessions with one pending response each, as the server batches them
+        const std::size_t SESSIONS = 64;
+        list.push_back({"verifyOTPBatch/" + std::to_string(SESSIONS), SESSIONS, [SESSIONS](Timer& timer, long n) {
+            timer.stop();
+            const int length = 1 << 10;
+            ChainParams params;
+            std::vector<std::vector<Digest>> chains;
+            std::vector<LamportAuth> servers(SESSIONS);
+            std::vector<LamportAuth*> verifiers;
+            for (std::size_t s = 0; s < SESSIONS; ++s) {
+                chains.push_back(CryptoUtils::genHashChain("benchmark-seed-" + std::to_string(s), length, params));
+                servers[s].setChainParams(params);
+                servers[s].setLastHash(chains[s].back());
+                verifiers.push_back(&servers[s]);
+            }
+            std::vector<Digest> responses(SESSIONS);
+            std::unique_ptr<bool[]> results(new bool[SESSIONS]);
+            std::size_t next = length - 1;
+            timer.start();
+            for (long i = 0; i < n; ++i) {
+                if (next == 0) {
+                    for (std::size_t s = 0; s < SESSIONS; ++s) servers[s].setLastHash(chains[s].back());
+                    next = length - 1;
+                }
+                --next;
+                for (std::size_t s = 0; s < SESSIONS; ++s) responses[s] = chains[s][next];
+                LamportAuth::verifyOTPBatch(verifiers.data(), responses.data(), SESSIONS, results.get());
+            }
+            keep(results);
+        }});
+
+        return list;
+    }
+
+    /**
+     * @brief Escapes a string for a JSON string literal.
+     * @param text The string.
+     * @return The escaped string, without quotes.
+     */
+    std::string jsonEscape(const std::string& text)
+    {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    /**
+     * @brief Writes the results as JSON, one benchmark object per line so that two runs diff line by line.
+     * @param out The stream to write to.
+     * @param results The results.
+     * @param minTime The minimum run time used.
+     * @param repetitions The number of measured runs per benchmark.
+     */
+    void writeJson(std::ostream& out, const std::vector<Result>& results, double minTime, int repetitions)
+    {
+        char date[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+        out << "{\n  \"context\": {\"date\": \"" << date << "\", \"sha256_backend\": \"" << Sha256::backend()
+            << "\", \"multi_buffer_backend\": \"" << Sha256::multiBufferBackend()
+            << "\", \"lanes\": " << Sha256::laneCount() << ", \"min_time\": " << minTime
+            << ", \"repetitions\": " << repetitions << "},\n  \"benchmarks\": [\n";
+        out << std::setprecision(6);
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            double hashesPerSecond = r.hashesPerOp > 0 ? r.hashesPerOp * 1e9 / r.nsPerOp : 0;
+            out << "    {\"name\": \"" << jsonEscape(r.name) << "\", \"iterations\": " << r.iterations
+                << ", \"ns_per_op\": " << r.nsPerOp << ", \"hashes_per_op\": " << r.hashesPerOp
+                << ", \"hashes_per_second\": " << hashesPerSecond << ", \"allocs_per_op\": " << r.allocsPerOp
+                << ", \"bytes_per_op\": " << r.bytesPerOp << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+    /**
+     * @brief Gets a number from a benchmark line written by writeJson().
+     * @param line The line.
+     * @param key The key.
+     * @param value Receives the number.
+     * @return False if the key is missing.
+     */
+    bool jsonNumber(const std::string& line, const std::string& key, double& value)
+    {
+        std::size_t at = line.find("\"" + key + "\": ");
+        if (at == std::string::npos) return false;
+        value = std::strtod(line.c_str() + at + key.size() + 4, nullptr);
+        return true;
+    }
+
+    /**
+     * @brief Reads the results of an earlier run from the JSON written by writeJson().
+     * @param path The file.
+     * @param results Receives the results by name.
+     * @return False if the file cannot be read.
+     */
+    bool readJson(const std::string& path, std::map<std::string, Result>& results)
+    {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::string line;
+        const std::string NAME = "\"name\": \"";
+        while (std::getline(in, line)) {
+            std::size_t at = line.find(NAME);
+            if (at == std::string::npos) continue;
+            std::size_t end = line.find('"', at + NAME.size());
+            Result r;
+            r.name = line.substr(at + NAME.size(), end - at - NAME.size());
+            if (!jsonNumber(line, "ns_per_op", r.nsPerOp)) continue;
+            jsonNumber(line, "allocs_per_op", r.allocsPerOp);
+            results[r.name] = r;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Prints one result line.
+     * @param r The result.
+     */
+    void report(const Result& r)
+    {
+        std::cout << std::left << std::setw(40) << r.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << r.nsPerOp << " ns/op";
+        if (r.hashesPerOp > 0) {
+            std::cout << std::setw(14) << std::setprecision(0) << (r.hashesPerOp * 1e9 / r.nsPerOp) << " hashes/s";
+        } else {
+            std::cout << std::setw(23) << "";
+        }
+        std::cout << std::setw(10) << std::setprecision(2) << r.allocsPerOp << " allocs/op" << std::endl;
+    }
+}
+
+/**
+ * @brief Benchmarks the hashing, chain and OTP primitives and optionally compares them with an earlier run.
+ * Usage: lamport-bench [--filter <text>] [--min-time <seconds>] [--repetitions <n>] [--json <file>]
+ *                      [--baseline <file>] [--threshold <percent>]
+ * With --baseline, exits with 1 if any benchmark got slower than the threshold (default 10%)
+ * or allocates more per operation.
+ */
+int main(int argc, char *argv[])
+{
+    std::string filter;
+    std::string jsonPath;
+    std::string baselinePath;
+    double minTime = 0.2;
+    int repetitions = 3;
+    double threshold = 10;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Usage: lamport-bench [--filter <text>] [--min-time <seconds>] [--repetitions <n>]"
+                         " [--json <file>] [--baseline <file>] [--threshold <percent>]" << std::endl;
+            return -1;
+        }
+        const char* value = argv[++i];
+        if (option == "--filter") filter = value;
+        else if (option == "--min-time") minTime = std::max(0.01, std::atof(value));
+        else if (option == "--repetitions") repetitions = std::max(1, std::atoi(value));
+        else if (option == "--json") jsonPath = value;
+        else if (option == "--baseline") baselinePath = value;
+        else if (option == "--threshold") threshold = std::atof(value);
+        else {
+            std::cerr << "lamport-bench: unknown option " << option << std::endl;
+            return -1;
+        }
+    }
+
+    std::map<std::string, Result> baseline;
+    if (!baselinePath.empty() && !readJson(baselinePath, baseline)) {
+        std::cerr << "lamport-bench: cannot read " << baselinePath << std::endl;
+        return -1;
+    }
+
+    std::cout << "SHA-256 backend: " << Sha256::backend()
+              << ", multi-buffer: " << Sha256::multiBufferBackend()
+              << " x" << Sha256::laneCount() << std::endl;
+
+    std::vector<Result> results;
+    for (const Benchmark& benchmark : benchmarks()) {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) continue;
+        results.push_back(measure(benchmark, minTime, repetitions));
+        report(results.back());
+    }
+
+    if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath);
+        writeJson(out, results, minTime, repetitions);
+        if (!out) {
+            std::cerr << "lamport-bench: cannot write " << jsonPath << std::endl;
+            return -1;
+        }
+    }
+
+    if (baseline.empty()) return 0;
+
+    // Time is compared against the threshold; allocations are deterministic, so any increase counts
+    int regressions = 0;
+    std::cout << "\nCompared with " << baselinePath << ":" << std::endl;
+    for (const Result& r : results) {
+        auto before = baseline.find(r.name);
+        if (before == baseline.end()) continue;
+        double change = 100.0 * (r.nsPerOp - before->second.nsPerOp) / before->second.nsPerOp;
+        bool slower = change > threshold;
+        bool allocates = r.allocsPerOp > before->second.allocsPerOp + 0.01;
+        if (slower || allocates) ++regressions;
+        std::cout << std::left << std::setw(40) << r.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << before->second.nsPerOp << " -> " << std::setw(12) << r.nsPerOp << " ns/op"
+                  << std::showpos << std::setw(9) << change << "%" << std::noshowpos
+                  << (slower ? "  SLOWER" : "") << (allocates ? "  MORE ALLOCATIONS" : "") << std::endl;
+    }
+    if (regressions > 0) {
+        std::cout << regressions << " regression(s) beyond " << threshold << "%." << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <QCoreApplication>
 #include "Client.hpp"
+#include "Sha256.hpp"
 #include <iostream>
 
 int main(int argc, char *argv[]) {
@@ -11,6 +12,8 @@ int main(int argc, char *argv[]) {
     }
 
     QString configPath = argv[1];
+    std::cout << "Client: SHA-256 backend: " << Sha256::backend()
+              << " (multi-buffer: " << Sha256::multiBufferBackend() << ")" << std::endl;
 
     Client client(configPath, &app);
 
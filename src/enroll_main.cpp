@@ -0,0 +1,151 @@
+#include "CryptoUtils.hpp"
+#include "LamportAuth.hpp"
+#include "Sha256.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    const std::size_t BLOCK = 256; ///< Identities claimed by a worker at a time.
+
+    /**
+     * @brief Gets the name an output file is written under until it is complete.
+     * @param path The output file.
+     * @return The temporary path.
+     */
+    std::string partialPath(const std::string& path)
+    {
+        return path + ".partial";
+    }
+
+    /**
+     * @brief Creates a fresh file under the output's temporary name, with the given permissions.
+     * A file already at the output path is never opened, so its permissions cannot leak into the new one.
+     * @param path The output file; replaced by commitOutput().
+     * @param mode The permission bits of the new file.
+     * @return The stream, or nullptr on failure.
+     */
+    std::FILE* openOutput(const std::string& path, mode_t mode)
+    {
+        std::string partial = partialPath(path);
+        ::unlink(partial.c_str());
+        int fd = ::open(partial.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
+        if (fd < 0) return nullptr;
+        // The umask may only narrow the mode, but a file with the exact bits is what the caller asked for
+        std::FILE* file = ::fchmod(fd, mode) == 0 ? ::fdopen(fd, "w") : nullptr;
+        if (!file) ::close(fd);
+        return file;
+    }
+
+    /**
+     * @brief Renames a written output file into place.
+     * @param path The output file.
+     * @return False if the rename failed.
+     */
+    bool commitOutput(const std::string& path)
+    {
+        return std::rename(partialPath(path).c_str(), path.c_str()) == 0;
+    }
+}
+
+/**
+ * @brief Provisions many Lamport identities at once.
+ * Usage: lamport-enroll <count> <length> <output-prefix> [chainFormat] [hashAlgorithm] [threads]
+ *
+ * Writes <output-prefix>.seeds ("<id>\t<seed>", readable by the owner only) for the
+ * devices and <output-prefix>.anchors ("<id>\t<length>\t<enrollment message>") for
+ * the server.
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < 4) {
+        std::cerr << "Usage: lamport-enroll <count> <length> <output-prefix> [chainFormat] [hashAlgorithm] [threads]"
+                  << std::endl;
+        return -1;
+    }
+
+    long long count = std::atoll(argv[1]);
+    long long len = std::atoll(argv[2]);
+    std::string prefix = argv[3];
+    if (count <= 0 || len <= 0) {
+        std::cerr << "lamport-enroll: count and length must be positive" << std::endl;
+        return -1;
+    }
+
+    ChainParams params;
+    params.format = (argc > 4 && std::atoi(argv[4]) == static_cast<int>(ChainFormat::BinaryV2))
+                        ? ChainFormat::BinaryV2 : ChainFormat::HexV1;
+    if (argc > 5 && !parseHashAlgorithm(argv[5], params.algorithm)) {
+        std::cerr << "lamport-enroll: unknown hash algorithm " << argv[5] << std::endl;
+        return -1;
+    }
+    unsigned threads = (argc > 6) ? static_cast<unsigned>(std::atoi(argv[6])) : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    std::cout << "Enrolling " << count << " identities, " << len << " links each ("
+              << hashAlgorithmName(params.algorithm) << ", format " << static_cast<int>(params.format)
+              << ") on " << threads << " threads, multi-buffer: " << Sha256::multiBufferBackend()
+              << " x" << Sha256::laneCount() << std::endl;
+
+    std::size_t total = static_cast<std::size_t>(count);
+    std::vector<std::string> seeds(total);
+    std::vector<Digest> anchors(total);
+
+    // Workers claim blocks of identities; each block's chains are advanced together
+    std::atomic<std::size_t> nextBlock(0);
+    auto worker = [&]() {
+        for (;;) {
+            std::size_t begin = nextBlock.fetch_add(BLOCK);
+            if (begin >= total) return;
+            std::size_t n = std::min(BLOCK, total - begin);
+            for (std::size_t i = 0; i < n; ++i) seeds[begin + i] = CryptoUtils::generateRandomSeed(32);
+            CryptoUtils::genChainAnchors(&seeds[begin], n, static_cast<std::uint64_t>(len), params, &anchors[begin]);
+        }
+    };
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t) pool.emplace_back(worker);
+    for (std::thread& t : pool) t.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Seeds are the devices' secrets; anchors are public and go to the server
+    std::FILE* seedFile = openOutput(prefix + ".seeds", 0600);
+    std::FILE* anchorFile = openOutput(prefix + ".anchors", 0644);
+    if (!seedFile || !anchorFile) {
+        std::cerr << "lamport-enroll: cannot write " << prefix << ".seeds / " << prefix << ".anchors" << std::endl;
+        if (seedFile) std::fclose(seedFile);
+        if (anchorFile) std::fclose(anchorFile);
+        std::remove(partialPath(prefix + ".seeds").c_str());
+        std::remove(partialPath(prefix + ".anchors").c_str());
+        return -1;
+    }
+    for (std::size_t i = 0; i < total; ++i) {
+        std::fprintf(seedFile, "%zu\t%s\n", i, seeds[i].c_str());
+        std::fprintf(anchorFile, "%zu\t%lld\t%s\n", i, len,
+                     LamportAuth::encodeEnrollment(params, anchors[i]).c_str());
+    }
+    bool ok = std::fclose(seedFile) == 0;
+    ok = (std::fclose(anchorFile) == 0) && ok;
+    ok = ok && commitOutput(prefix + ".seeds") && commitOutput(prefix + ".anchors");
+    if (!ok) {
+        std::cerr << "lamport-enroll: error while writing output files" << std::endl;
+        return -1;
+    }
+
+    std::cout << "Done in " << seconds << " s ("
+              << (static_cast<double>(count) * static_cast<double>(len) / seconds / 1e6) << " M hashes/s)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "EpollServer.hpp"
+#include "LiveConfig.hpp"
+#include "ReplicaFence.hpp"
+#include "ReplicationReceiver.hpp"
+#include "Sha256.hpp"
+
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+// Headless Qt-free server: one epoll reactor per thread, all sharing the port with SO_REUSEPORT.
+// Usage: lamport-server-epoll <config.json> [-v] [--standby]
+
+/**
+ * @brief Pins the calling thread to one CPU.
+ * @param cpu The CPU index, wrapped to the number of CPUs.
+ * @return True on success.
+ */
+static bool pinCurrentThread(unsigned cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % std::max(1u, std::thread::hardware_concurrency()), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: lamport-server-epoll <config.json> [-v] [--standby]" << std::endl;
+        return -1;
+    }
+    bool verbose = false;
+    bool standby = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-v") == 0) verbose = true;
+        if (std::strcmp(argv[i], "--standby") == 0) standby = true;
+    }
+
+    // Parsed once; the event loops pick up a reloaded file on their own (see LiveConfig)
+    LiveConfig liveConfig;
+    if (!liveConfig.load(argv[1])) return 1;
+    std::shared_ptr<const ConfigSnapshot> config = liveConfig.snapshot();
+    ServerSettings settings = config->serverSettings();
+    std::uint16_t port = config->alicePort;
+
+    // serverThreads > 1 runs one reactor per thread sharing the port; 0 means one per core
+    int threads = config->serverThreads;
+    if (threads <= 0) threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    bool pinThreads = config->pinThreads;
+
+    std::cout << "Server: SHA-256 backend: " << Sha256::backend()
+              << " (multi-buffer: " << Sha256::multiBufferBackend() << ")" << std::endl;
+
+    // A standby mirrors the primary's chains until the primary is gone, then takes over its port;
+    // either way the active server holds the fence and streams its changes to whichever standby
+    // listens on replicaSocket. An active server takes the fence before it opens its table and store,
+    // and nothing listens, let alone shares the port, before the fence is held.
+    const std::string& replicaSocket = config->replicaSocket;
+    ReplicaFence fence;
+    if (standby && replicaSocket.empty()) {
+        std::cerr << "Server: --standby needs replicaSocket in the configuration." << std::endl;
+        return 1;
+    }
+    if (!standby && !replicaSocket.empty() && !fence.acquire(replicaSocket)) {
+        std::cerr << "Server: another server is active for " << replicaSocket << "; start this one with --standby."
+                  << std::endl;
+        return 1;
+    }
+
+    // One registry for all event loops, so a reconnecting client can resume on any of them,
+    // and one admission control, so a source's rate holds whichever loop its connections land on.
+    // The table and store are flocked, so a standby given the primary's paths stops here.
+    ChainRegistry chains;
+    if (!config->verifierTable.empty()
+        && !chains.map(config->verifierTable, static_cast<std::uint32_t>(config->verifierTableCapacity))) {
+        if (standby) std::cerr << "Server: a standby needs its own verifierTable and chainStoreDir." << std::endl;
+        return 1;
+    }
+    if (!config->chainStoreDir.empty()
+        && !chains.persist(config->chainStoreDir, static_cast<std::uint64_t>(config->snapshotEvery))) {
+        if (standby) std::cerr << "Server: a standby needs its own verifierTable and chainStoreDir." << std::endl;
+        return 1;
+    }
+
+    if (standby) {
+        ReplicationReceiver receiver;
+        if (!receiver.listen(replicaSocket)) return 1;
+        std::cout << "Server: standing by for the primary on " << replicaSocket << std::endl;
+        if (!receiver.follow(chains, config->standbyTimeout, fence)) return 1;
+        receiver.close();
+        std::cout << "Server: primary lost; taking over with " << chains.size() << " chain(s)." << std::endl;
+    }
+    if (!replicaSocket.empty()) chains.replicate(replicaSocket);
+
+    AdmissionControl admission(settings.admission);
+    std::vector<std::unique_ptr<EpollServer>> servers;
+    for (int i = 0; i < threads; ++i) {
+        servers.emplace_back(new EpollServer(settings, verbose, &chains, &admission, &liveConfig));
+        if (!servers.back()->listen(config->aliceIP, port, threads > 1)) return 1;
+    }
+
+    // Signals are handled by the main thread alone: block them before the reactors inherit the mask
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    liveConfig.watch();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        EpollServer* server = servers[i].get();
+        workers.emplace_back([server, i, pinThreads]() {
+            if (pinThreads && !pinCurrentThread(static_cast<unsigned>(i))) {
+                std::cerr << "Server: could not pin event loop " << i << " to a CPU" << std::endl;
+            }
+            server->run();
+        });
+    }
+    std::cout << "Server: " << threads << " event loop(s) on port " << port
+              << (pinThreads ? " (pinned)" : "") << std::endl;
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    std::cout << "Server: Shutting down." << std::endl;
+    for (auto& server : servers) server->stop();
+    for (std::thread& worker : workers) worker.join();
+
+    AdmissionControl::Stats stats = admission.stats();
+    if (stats.connectionsRefused || stats.framesLimited || stats.verifiesShed) {
+        std::cout << "Server: Refused " << stats.connectionsRefused << " connection(s), rate-limited "
+                  << stats.framesLimited << " frame(s), shed " << stats.verifiesShed << " verification(s)."
+                  << std::endl;
+    }
+    return 0;
+}
\ No newline at end of file
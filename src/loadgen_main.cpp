@@ -0,0 +1,194 @@
+#include "ConfigSnapshot.hpp"
+#include "JsonConfig.hpp"
+#include "LoadGenerator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+
+namespace {
+
+    /**
+     * @brief Prints one latency histogram as a table row, in milliseconds.
+     * @param name The row label.
+     * @param histogram The histogram, in microseconds.
+     */
+    void printLatency(const char* name, const LatencyHistogram& histogram)
+    {
+        auto ms = [](std::uint64_t micros) { return static_cast<double>(micros) / 1000.0; };
+        std::cout << "  " << std::left << std::setw(9) << name << std::right << std::setw(12) << histogram.count()
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(11) << ms(histogram.percentile(50))
+                  << std::setw(11) << ms(histogram.percentile(99))
+                  << std::setw(11) << ms(histogram.percentile(99.9))
+                  << std::setw(11) << ms(histogram.max())
+                  << std::setw(11) << histogram.mean() / 1000.0 << std::endl;
+    }
+
+    /**
+     * @brief Sums a counter over every generator.
+     * @param generators The generators.
+     * @param counter The counter to sum.
+     * @return The total.
+     */
+    std::uint64_t total(const std::vector<std::unique_ptr<LoadGenerator>>& generators,
+                        std::atomic<std::uint64_t> LoadGenerator::Counters::*counter)
+    {
+        std::uint64_t sum = 0;
+        for (const auto& generator : generators) sum += (generator->counters().*counter).load(std::memory_order_relaxed);
+        return sum;
+    }
+}
+
+/**
+ * @brief Simulates many clients against a server and reports throughput and latencies.
+ * Usage: lamport-loadgen <config.json> <sessions> [--threads <n>] [--rounds <n>] [--connect-rate <per second>]
+ *                        [--round-rate <per second>] [--duration <seconds>] [--report <seconds>]
+ *
+ * Connects to aliceIP/alicePort with the configured chainFormat and hashAlgorithm.
+ * Stops after --duration seconds (0: on SIGINT/SIGTERM) and prints the totals.
+ */
+int main(int argc, char *argv[])
+{
+    const char* USAGE = "Usage: lamport-loadgen <config.json> <sessions> [--threads <n>] [--rounds <n>]"
+                        " [--connect-rate <per second>] [--round-rate <per second>] [--duration <seconds>]"
+                        " [--report <seconds>]";
+    if (argc < 3) {
+        std::cerr << USAGE << std::endl;
+        return -1;
+    }
+    long long sessions = std::atoll(argv[2]);
+    if (sessions <= 0) {
+        std::cerr << "lamport-loadgen: sessions must be positive" << std::endl;
+        return -1;
+    }
+
+    unsigned threads = std::thread::hardware_concurrency();
+    LoadGenerator::Options options;
+    int duration = 0;
+    int reportInterval = 5;
+    for (int i = 3; i < argc; ++i) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << USAGE << std::endl;
+            return -1;
+        }
+        const char* value = argv[++i];
+        if (option == "--threads") threads = static_cast<unsigned>(std::max(1, std::atoi(value)));
+        else if (option == "--rounds") options.rounds = std::max(1, std::atoi(value));
+        else if (option == "--connect-rate") options.connectRate = std::max(0.0, std::atof(value));
+        else if (option == "--round-rate") options.roundRate = std::max(0.0, std::atof(value));
+        else if (option == "--duration") duration = std::max(0, std::atoi(value));
+        else if (option == "--report") reportInterval = std::max(1, std::atoi(value));
+        else {
+            std::cerr << "lamport-loadgen: unknown option " << option << std::endl;
+            return -1;
+        }
+    }
+    if (threads == 0) threads = 1;
+    threads = static_cast<unsigned>(std::min<long long>(threads, sessions));
+
+    JsonConfig json;
+    if (!json.load(argv[1])) return 1;
+    ConfigSnapshot config = ConfigSnapshot::from(json);
+    options.params.format = config.chainFormat == static_cast<int>(ChainFormat::BinaryV2)
+                                ? ChainFormat::BinaryV2 : ChainFormat::HexV1;
+    if (!parseHashAlgorithm(config.hashAlgorithm, options.params.algorithm)) {
+        std::cerr << "lamport-loadgen: unknown hash algorithm " << config.hashAlgorithm << std::endl;
+        return 1;
+    }
+    if (!LoadGenerator::resolve(config.aliceIP, config.alicePort, options)) {
+        std::cerr << "lamport-loadgen: invalid server address " << config.aliceIP << ":" << config.alicePort << std::endl;
+        return 1;
+    }
+
+    // Sessions and the connection rate are split evenly over the event loops
+    std::vector<std::unique_ptr<LoadGenerator>> generators;
+    LoadGenerator::Options share = options;
+    share.connectRate = options.connectRate / threads;
+    for (unsigned t = 0; t < threads; ++t) {
+        std::size_t count = static_cast<std::size_t>(sessions / threads + (t < sessions % threads ? 1 : 0));
+        generators.push_back(std::make_unique<LoadGenerator>(share, count));
+    }
+
+    // Signals are handled by the main thread alone: block them before the workers inherit the mask
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    std::cout << "LoadGen: " << sessions << " sessions of " << options.rounds << " rounds against "
+              << config.aliceIP << ":" << config.alicePort << " (" << hashAlgorithmName(options.params.algorithm)
+              << ", format " << static_cast<int>(options.params.format) << ") on " << threads << " threads" << std::endl;
+
+    std::vector<std::thread> workers;
+    for (auto& generator : generators) workers.emplace_back([&generator]() { generator->run(); });
+
+    // Throughput is printed every reportInterval seconds until the duration is up or a signal arrives
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    Clock::time_point last = start;
+    std::uint64_t lastRounds = 0;
+    std::uint64_t lastEnrolled = 0;
+    for (;;) {
+        int wait = reportInterval;
+        if (duration > 0) {
+            double left = duration - std::chrono::duration<double>(Clock::now() - start).count();
+            if (left <= 0) break;
+            wait = std::min(wait, static_cast<int>(std::ceil(left)));
+        }
+        timespec timeout = {wait, 0};
+        if (sigtimedwait(&signals, nullptr, &timeout) > 0) break;
+
+        Clock::time_point time = Clock::now();
+        double seconds = std::chrono::duration<double>(time - last).count();
+        std::uint64_t rounds = total(generators, &LoadGenerator::Counters::rounds);
+        std::uint64_t enrolled = total(generators, &LoadGenerator::Counters::enrolled);
+        std::cout << "LoadGen: " << std::fixed << std::setprecision(0)
+                  << std::chrono::duration<double>(time - start).count() << " s: "
+                  << total(generators, &LoadGenerator::Counters::active) << " connected, "
+                  << (rounds - lastRounds) / seconds << " rounds/s, "
+                  << (enrolled - lastEnrolled) / seconds << " enrollments/s, "
+                  << total(generators, &LoadGenerator::Counters::failures) << " failures" << std::endl;
+        last = time;
+        lastRounds = rounds;
+        lastEnrolled = enrolled;
+    }
+
+    for (auto& generator : generators) generator->stop();
+    for (std::thread& worker : workers) worker.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    LoadGenerator::Latencies latencies;
+    for (const auto& generator : generators) latencies.merge(generator->latencies());
+    std::uint64_t rounds = total(generators, &LoadGenerator::Counters::rounds);
+    std::uint64_t enrolled = total(generators, &LoadGenerator::Counters::enrolled);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "LoadGen: " << elapsed << " s, " << total(generators, &LoadGenerator::Counters::connects)
+              << " connections, " << enrolled << " enrollments, " << rounds << " rounds, "
+              << total(generators, &LoadGenerator::Counters::completed) << " chains completed, "
+              << total(generators, &LoadGenerator::Counters::failures) << " failures" << std::endl;
+    std::cout << "LoadGen: " << rounds / elapsed << " rounds/s, " << enrolled / elapsed << " enrollments/s" << std::endl;
+    std::cout << "  " << std::left << std::setw(9) << "latency" << std::right << std::setw(12) << "count"
+              << std::setw(11) << "p50 ms" << std::setw(11) << "p99 ms" << std::setw(11) << "p99.9 ms"
+              << std::setw(11) << "max ms" << std::setw(11) << "mean ms" << std::endl;
+    printLatency("connect", latencies.connect);
+    printLatency("enroll", latencies.enroll);
+    printLatency("verify", latencies.verify);
+    printLatency("round", latencies.round);
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include "AdmissionControl.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include <netinet/in.h>
+
+namespace {
+    const std::uint32_t CLOCK_SKEW = 60000; ///< How far, in ms, a bucket's stamp may be ahead of a thread's clock reading.
+
+    /**
+     * @brief Scrambles a key so that neighbouring keys land in unrelated buckets (the splitmix64 finaliser).
+     * @param key The key.
+     * @return The scrambled key.
+     */
+    std::uint64_t mix(std::uint64_t key)
+    {
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return key;
+    }
+}
+
+/**
+ * @brief Constructs an AdmissionControl, allocating the tables of enabled limits.
+ * @param settings The limits.
+ */
+AdmissionControl::AdmissionControl(const AdmissionSettings& settings)
+    : m_seed((std::uint64_t(std::random_device()()) << 32) | std::random_device()()),
+      m_epoch(std::chrono::steady_clock::now())
+{
+    configure(m_source, settings.sourceRate, settings.sourceBurst, true);
+    configure(m_identity, settings.identityRate, settings.identityBurst, false);
+    m_verifyBudget = std::max(0, settings.verifyBudget);
+}
+
+/**
+ * @brief Enables a limit with a full bucket for every key.
+ * @param limit The limit.
+ * @param rate Tokens per second.
+ * @param burst Tokens.
+ * @param table Whether the limit keeps its own bucket states.
+ */
+void AdmissionControl::configure(Limit& limit, int rate, int burst, bool table)
+{
+    if (rate <= 0) return;
+    // The deficit is kept in 32 bits of 1/1000 tokens
+    const int MAX_TOKENS = 4000000;
+    limit.rate = static_cast<std::uint32_t>(std::min(rate, MAX_TOKENS));
+    // Without an explicit burst, a bucket holds one second's worth of tokens
+    limit.capacity = static_cast<std::uint32_t>(std::min(burst > 0 ? burst : rate, MAX_TOKENS)) * 1000;
+    if (!table) return;
+    limit.states.reset(new std::atomic<std::uint64_t>[BUCKETS]);
+    for (std::size_t i = 0; i < BUCKETS; ++i) limit.states[i].store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Hashes a source address into a key.
+ * @param address The address bytes.
+ * @param len The number of bytes.
+ * @return The key.
+ */
+std::uint64_t AdmissionControl::sourceKey(const std::uint8_t* address, std::size_t len)
+{
+    // FNV-1a
+    std::uint64_t key = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < len; ++i) {
+        key ^= address[i];
+        key *= 0x100000001b3ULL;
+    }
+    return key ? key : 1;
+}
+
+/**
+ * @brief Hashes a peer's address as 16 bytes, so that an IPv4 peer has the same key over IPv4 and IPv6.
+ * @param peer The peer address.
+ * @return The key.
+ */
+std::uint64_t AdmissionControl::sourceKey(const sockaddr_storage& peer)
+{
+    std::uint8_t address[16] = {};
+    if (peer.ss_family == AF_INET6) {
+        std::memcpy(address, &reinterpret_cast<const sockaddr_in6&>(peer).sin6_addr, sizeof(address));
+    } else if (peer.ss_family == AF_INET) {
+        address[10] = 0xff;
+        address[11] = 0xff;
+        std::memcpy(address + 12, &reinterpret_cast<const sockaddr_in&>(peer).sin_addr, 4);
+    }
+    return sourceKey(address, sizeof(address));
+}
+
+/**
+ * @brief Charges a connection to its source's bucket.
+ * @param source The source key.
+ * @return True if admitted.
+ */
+bool AdmissionControl::admitConnection(std::uint64_t source)
+{
+    if (!m_source.states || source == 0) return true;
+    if (take(m_source, source, now())) return true;
+    m_connectionsRefused.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+/**
+ * @brief Charges a frame to its source's bucket.
+ * @param source The source key.
+ * @return True if admitted.
+ */
+bool AdmissionControl::admitFrame(std::uint64_t source)
+{
+    if (!m_source.states || source == 0) return true;
+    if (take(m_source, source, now())) return true;
+    m_framesLimited.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+/**
+ * @brief Checks whether the per-chain limit is enabled.
+ * @return True if it is.
+ */
+bool AdmissionControl::limitsChains() const
+{
+    return m_identity.rate > 0;
+}
+
+/**
+ * @brief Charges a frame to a chain's bucket, which its owner guards.
+ * @param bucket The bucket state.
+ * @return True if admitted.
+ */
+bool AdmissionControl::admitChainFrame(std::uint64_t& bucket)
+{
+    if (m_identity.rate == 0) return true;
+    std::uint64_t next;
+    if (charge(m_identity, bucket, now(), next)) {
+        bucket = next;
+        return true;
+    }
+    m_framesLimited.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+/**
+ * @brief Reserves hashes from the global budget. A request larger than the whole budget
+ * is let through when nothing else is in flight, so it cannot be starved forever.
+ * @param hashes The number of hashes.
+ * @return True if reserved.
+ */
+bool AdmissionControl::acquireVerify(std::uint32_t hashes)
+{
+    if (m_verifyBudget == 0) return true;
+    std::int64_t inFlight = m_verifyInFlight.load(std::memory_order_relaxed);
+    do {
+        if (inFlight > 0 && inFlight + hashes > m_verifyBudget) {
+            m_verifiesShed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!m_verifyInFlight.compare_exchange_weak(inFlight, inFlight + hashes, std::memory_order_acquire,
+                                                     std::memory_order_relaxed));
+    return true;
+}
+
+/**
+ * @brief Returns reserved hashes to the global budget.
+ * @param hashes The number of hashes.
+ */
+void AdmissionControl::releaseVerify(std::uint32_t hashes)
+{
+    if (m_verifyBudget == 0) return;
+    m_verifyInFlight.fetch_sub(hashes, std::memory_order_release);
+}
+
+/**
+ * @brief Gets the rejection counters.
+ * @return The counters.
+ */
+AdmissionControl::Stats AdmissionControl::stats() const
+{
+    Stats stats;
+    stats.connectionsRefused = m_connectionsRefused.load(std::memory_order_relaxed);
+    stats.framesLimited = m_framesLimited.load(std::memory_order_relaxed);
+    stats.verifiesShed = m_verifiesShed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+/**
+ * @brief Refills a bucket state for the elapsed time and takes one token from it.
+ * @param limit The limit.
+ * @param state The state.
+ * @param now The current time in ms.
+ * @param next Receives the charged state.
+ * @return True if a token was available.
+ */
+bool AdmissionControl::charge(const Limit& limit, std::uint64_t state, std::uint32_t now, std::uint64_t& next)
+{
+    // Unsigned differences stay correct when the 32-bit clock wraps. Another thread may have
+    // stamped the bucket just after this thread read the clock; that counts as no time elapsed
+    std::uint32_t stamp = static_cast<std::uint32_t>(state);
+    std::uint32_t elapsed = now - stamp;
+    if (elapsed > UINT32_MAX - CLOCK_SKEW) elapsed = 0;
+    std::uint64_t deficit = state >> 32;
+    std::uint64_t refill = std::uint64_t(elapsed) * limit.rate;
+    deficit = (deficit > refill ? deficit - refill : 0) + 1000;
+    if (deficit > limit.capacity) return false;
+    next = (deficit << 32) | (elapsed ? now : stamp);
+    return true;
+}
+
+/**
+ * @brief Takes a token from a bucket with one compare-and-swap, retried only if another
+ * thread charged the same bucket in between.
+ * @param limit The limit.
+ * @param key The key.
+ * @param now The current time in ms.
+ * @return True if a token was taken.
+ */
+bool AdmissionControl::take(Limit& limit, std::uint64_t key, std::uint32_t now) const
+{
+    std::atomic<std::uint64_t>& bucket = limit.states[mix(key ^ m_seed) & (BUCKETS - 1)];
+    std::uint64_t state = bucket.load(std::memory_order_relaxed);
+    for (;;) {
+        std::uint64_t next;
+        if (!charge(limit, state, now, next)) return false;
+        if (bucket.compare_exchange_weak(state, next, std::memory_order_relaxed)) return true;
+    }
+}
+
+/**
+ * @brief Gets the time since construction.
+ * @return Milliseconds, modulo 2^32.
+ */
+std::uint32_t AdmissionControl::now() const
+{
+    return static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_epoch).count());
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "ChainGenerator.hpp"
+#include <QMetaObject>
+
+/**
+ * @brief Constructs an idle ChainGenerator.
+ * @param parent The parent QObject.
+ */
+ChainGenerator::ChainGenerator(QObject* parent)
+    : QObject(parent)
+{
+}
+
+/**
+ * @brief Cancels the generation in progress and joins the worker thread.
+ */
+ChainGenerator::~ChainGenerator()
+{
+    cancel();
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+/**
+ * @brief Starts a generation on a new worker thread.
+ * @param request The chain to build.
+ * @return False if already running.
+ */
+bool ChainGenerator::start(const Request& request)
+{
+    if (m_running) return false;
+    if (m_thread) {
+        // The previous worker has already delivered its result and is about to exit
+        m_thread->wait();
+        delete m_thread;
+    }
+    m_request = request;
+    m_cancel = false;
+    m_running = true;
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+    return true;
+}
+
+/**
+ * @brief Asks the worker to stop at its next progress report.
+ */
+void ChainGenerator::cancel()
+{
+    m_cancel = true;
+}
+
+/**
+ * @brief Checks whether a generation is running.
+ * @return True until finished() is emitted.
+ */
+bool ChainGenerator::isRunning() const
+{
+    return m_running;
+}
+
+/**
+ * @brief Moves the generated chain out of the generator.
+ * @return The chain.
+ */
+LamportAuth ChainGenerator::takeResult()
+{
+    return std::move(m_result);
+}
+
+/**
+ * @brief Checks whether the chain was written to the requested file.
+ * @return True if the result maps the chain file.
+ */
+bool ChainGenerator::wroteChainFile() const
+{
+    return m_wroteChainFile;
+}
+
+/**
+ * @brief Builds the chain on the worker thread, streaming it to the chain file if one was
+ * requested, and posts the outcome back to the generator's thread.
+ */
+void ChainGenerator::run()
+{
+    // Polled between chunks of links, so a cancel takes effect within one CHAIN_PROGRESS_INTERVAL
+    ChainProgress report = [this](std::uint64_t done, std::uint64_t total) {
+        if (m_cancel) return false;
+        emit progress(done, total);
+        return true;
+    };
+
+    const Request& request = m_request;
+    bool ok = false;
+    m_wroteChainFile = false;
+    if (!request.chainFile.empty()) {
+        m_wroteChainFile = ChainFile::generate(request.chainFile, request.seed,
+                                               static_cast<std::uint64_t>(request.length), request.params, report)
+                           && m_result.openChainFile(request.chainFile);
+        ok = m_wroteChainFile;
+    }
+    // A chain file that cannot be written falls back to an in-memory chain
+    if (!ok && !m_cancel) {
+        ok = m_result.initChain(request.seed, request.length, request.params, request.storage, report);
+    }
+
+    QMetaObject::invokeMethod(this, [this, ok]() { onWorkerDone(ok); }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Ends the generation and reports it.
+ * @param ok True if the chain is complete.
+ */
+void ChainGenerator::onWorkerDone(bool ok)
+{
+    m_running = false;
+    emit finished(ok && !m_cancel);
+}
\ No newline at end of file
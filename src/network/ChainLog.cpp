@@ -0,0 +1,168 @@
+#include "ChainLog.hpp"
+
+#include <cstring>
+
+namespace {
+
+    void storeLe(std::uint8_t* p, std::uint64_t v, std::size_t bytes)
+    {
+        for (std::size_t i = 0; i < bytes; ++i) p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+    }
+
+    std::uint64_t loadLe(const std::uint8_t* p, std::size_t bytes)
+    {
+        std::uint64_t v = 0;
+        for (std::size_t i = 0; i < bytes; ++i) v |= std::uint64_t(p[i]) << (8 * i);
+        return v;
+    }
+
+    /**
+     * @brief Appends the CRC of a record's body.
+     * @param out The record.
+     * @param size The size of the record including its CRC.
+     * @return The size.
+     */
+    std::size_t seal(std::uint8_t* out, std::size_t size)
+    {
+        storeLe(out + size - ChainLog::CRC_SIZE, ChainLog::crc32(out, size - ChainLog::CRC_SIZE), ChainLog::CRC_SIZE);
+        return size;
+    }
+}
+
+namespace ChainLog {
+
+    /**
+     * @brief Writes an Enroll record.
+     * @param out The output buffer.
+     * @param anchor The anchor.
+     * @param verifier The verifier.
+     * @return The record size.
+     */
+    std::size_t encodeEnroll(std::uint8_t* out, const Digest& anchor, const ChainVerifier& verifier)
+    {
+        out[0] = static_cast<std::uint8_t>(RecordType::Enroll);
+        std::memcpy(out + 1, anchor.data(), Digest::SIZE);
+        out[1 + Digest::SIZE] = static_cast<std::uint8_t>(verifier.chainParams().format);
+        out[2 + Digest::SIZE] = static_cast<std::uint8_t>(verifier.chainParams().algorithm);
+        return seal(out, ENROLL_RECORD_SIZE);
+    }
+
+    /**
+     * @brief Writes an Advance record.
+     * @param out The output buffer.
+     * @param anchor The anchor.
+     * @param verifier The verifier.
+     * @param verifiedIteration The last verified challenge number.
+     * @return The record size.
+     */
+    std::size_t encodeAdvance(std::uint8_t* out, const Digest& anchor, const ChainVerifier& verifier,
+                              std::int32_t verifiedIteration)
+    {
+        out[0] = static_cast<std::uint8_t>(RecordType::Advance);
+        std::memcpy(out + 1, anchor.data(), Digest::SIZE);
+        std::memcpy(out + 1 + Digest::SIZE, verifier.lastVerifiedHash().data(), Digest::SIZE);
+        storeLe(out + 1 + 2 * Digest::SIZE, static_cast<std::uint32_t>(verifiedIteration), 4);
+        return seal(out, ADVANCE_RECORD_SIZE);
+    }
+
+    /**
+     * @brief Writes a record made of a type and an anchor.
+     * @param out The output buffer.
+     * @param type The record type.
+     * @param anchor The anchor.
+     * @return The record size.
+     */
+    std::size_t encodeMarker(std::uint8_t* out, RecordType type, const Digest& anchor)
+    {
+        out[0] = static_cast<std::uint8_t>(type);
+        std::memcpy(out + 1, anchor.data(), Digest::SIZE);
+        return seal(out, MARKER_RECORD_SIZE);
+    }
+
+    /**
+     * @brief Maps a type byte to its record size.
+     * @param type The type byte.
+     * @return The size, or 0.
+     */
+    std::size_t recordSize(std::uint8_t type)
+    {
+        switch (type) {
+            case static_cast<std::uint8_t>(RecordType::Enroll): return ENROLL_RECORD_SIZE;
+            case static_cast<std::uint8_t>(RecordType::Advance): return ADVANCE_RECORD_SIZE;
+            case static_cast<std::uint8_t>(RecordType::Remove):
+            case static_cast<std::uint8_t>(RecordType::Exhaust):
+            case static_cast<std::uint8_t>(RecordType::SyncBegin):
+            case static_cast<std::uint8_t>(RecordType::SyncEnd):
+            case static_cast<std::uint8_t>(RecordType::Heartbeat): return MARKER_RECORD_SIZE;
+            default: return 0;
+        }
+    }
+
+    /**
+     * @brief Checks the CRC of a record and decodes it.
+     * @param data The record.
+     * @param record Receives the fields.
+     * @return True if the record is intact and well-formed.
+     */
+    bool decode(const std::uint8_t* data, Record& record)
+    {
+        std::size_t size = recordSize(data[0]);
+        if (size == 0 || crc32(data, size - CRC_SIZE) != loadLe(data + size - CRC_SIZE, CRC_SIZE)) return false;
+        record.type = static_cast<RecordType>(data[0]);
+        std::memcpy(record.anchor.data(), data + 1, Digest::SIZE);
+        if (record.type == RecordType::Enroll) {
+            return decodeParams(data[1 + Digest::SIZE], data[2 + Digest::SIZE], record.params);
+        }
+        if (record.type == RecordType::Advance) {
+            std::memcpy(record.link.data(), data + 1 + Digest::SIZE, Digest::SIZE);
+            record.verifiedIteration = static_cast<std::int32_t>(loadLe(data + 1 + 2 * Digest::SIZE, 4));
+        }
+        return true;
+    }
+
+    /**
+     * @brief Computes a CRC-32 with a lazily built table.
+     * @param data The bytes.
+     * @param size The number of bytes.
+     * @param crc The running CRC.
+     * @return The CRC.
+     */
+    std::uint32_t crc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc)
+    {
+        static const auto table = []() {
+            struct Table { std::uint32_t values[256]; } t;
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                std::uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t.values[i] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (std::size_t i = 0; i < size; ++i) crc = table.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    /**
+     * @brief Decodes a stored format and algorithm.
+     * @param format The format byte.
+     * @param algorithm The algorithm byte.
+     * @param params Receives the parameters.
+     * @return True if both are known.
+     */
+    bool decodeParams(std::uint8_t format, std::uint8_t algorithm, ChainParams& params)
+    {
+        switch (format) {
+            case static_cast<std::uint8_t>(ChainFormat::HexV1): params.format = ChainFormat::HexV1; break;
+            case static_cast<std::uint8_t>(ChainFormat::BinaryV2): params.format = ChainFormat::BinaryV2; break;
+            default: return false;
+        }
+        switch (algorithm) {
+            case static_cast<std::uint8_t>(HashAlgorithm::Sha256): params.algorithm = HashAlgorithm::Sha256; break;
+            case static_cast<std::uint8_t>(HashAlgorithm::Sha512_256): params.algorithm = HashAlgorithm::Sha512_256; break;
+            case static_cast<std::uint8_t>(HashAlgorithm::Blake2s): params.algorithm = HashAlgorithm::Blake2s; break;
+            default: return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,453 @@
+#include "ChainRegistry.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    const char* STORE_TABLE_NAME = "chains.table";      ///< The table kept in a store directory without a mapped one.
+    const std::uint32_t STORE_TABLE_CAPACITY = 65536;   ///< Its initial capacity.
+}
+
+/**
+ * @brief Maps a table file as the registry's records.
+ * @param path The table file.
+ * @param capacity The capacity of a new file.
+ * @return True on success.
+ */
+bool ChainRegistry::map(const std::string& path, std::uint32_t capacity)
+{
+    std::unique_lock<std::shared_mutex> guard(layout);
+    attachments.clear();
+    if (!table.open(path, capacity)) return false;
+    coverTable();
+    return true;
+}
+
+/**
+ * @brief Opens the store on top of the table.
+ * @param directory The store directory.
+ * @param snapshotEvery Records between checkpoints.
+ * @return True on success.
+ */
+bool ChainRegistry::persist(const std::string& directory, std::uint64_t snapshotEvery)
+{
+    std::uint64_t firstSegment;
+    {
+        std::unique_lock<std::shared_mutex> guard(layout);
+        if (!table.isFile()) {
+            if (::mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) {
+                std::cerr << "ChainStore: cannot create " << directory << ": " << std::strerror(errno) << std::endl;
+                return false;
+            }
+            attachments.clear();
+            if (!table.open(directory + "/" + STORE_TABLE_NAME, STORE_TABLE_CAPACITY)) return false;
+            coverTable();
+        }
+        firstSegment = table.logSegment();
+    }
+    // Not under the layout lock: the store checkpoints the table through checkpoint(), which takes it
+    return store.open(directory, snapshotEvery, firstSegment,
+                      [this](const ChainLog::Record& record) { replay(record); },
+                      [this](std::uint64_t segment) { return checkpoint(segment); });
+}
+
+/**
+ * @brief Starts streaming changes to a standby.
+ * @param socketPath The standby's socket.
+ */
+void ChainRegistry::replicate(const std::string& socketPath)
+{
+    {
+        std::unique_lock<std::shared_mutex> guard(layout);
+        replicating = true;
+    }
+    replica.start(socketPath, [this]() { resyncReplica(); });
+}
+
+/**
+ * @brief Applies a replicated change.
+ * @param record The record.
+ */
+void ChainRegistry::apply(const ChainLog::Record& record)
+{
+    std::unique_lock<std::shared_mutex> guard(layout);
+    std::uint32_t index = table.find(record.anchor);
+    ChainVerifier verifier;
+    if (record.type == ChainLog::RecordType::Enroll) {
+        if (index == NONE) index = table.insert(record.anchor);
+        if (index == NONE) return;
+        coverTable();
+        verifier.enroll(record.params, record.anchor);
+        storeRecord(index, verifier, 0);
+        if (store.isOpen()) store.logEnroll(record.anchor, verifier);
+    } else if (record.type == ChainLog::RecordType::Advance) {
+        if (index == NONE) return;
+        ChainParams params;
+        params.format = static_cast<ChainFormat>(table.record(index).format);
+        params.algorithm = static_cast<HashAlgorithm>(table.record(index).algorithm);
+        verifier.enroll(params, record.link);
+        storeRecord(index, verifier, record.verifiedIteration);
+        if (store.isOpen()) store.logAdvance(record.anchor, verifier, record.verifiedIteration);
+    } else if (record.type == ChainLog::RecordType::Exhaust) {
+        if (index == NONE) return;
+        table.record(index).flags |= VerifierTable::EXHAUSTED;
+        attachments[index] = Attachment();
+        if (store.isOpen()) store.logExhaust(record.anchor);
+    } else if (record.type == ChainLog::RecordType::Remove) {
+        if (index == NONE) return;
+        if (store.isOpen()) store.logRemove(record.anchor);
+        table.remove(index);
+        attachments[index] = Attachment();
+    }
+}
+
+/**
+ * @brief Replaces every chain, logging the replacement to the store.
+ * @param replacement The new chains.
+ */
+void ChainRegistry::replaceAll(const std::vector<ChainStore::Entry>& replacement)
+{
+    std::unique_lock<std::shared_mutex> guard(layout);
+    if (store.isOpen()) {
+        for (std::uint32_t number = 0; number < table.end(); ++number) {
+            if (table.record(number).flags & VerifierTable::LIVE) store.logRemove(table.record(number).anchor);
+        }
+    }
+    table.clear();
+    attachments.clear();
+    for (const ChainStore::Entry& entry : replacement) {
+        insertEntry(entry);
+        if (store.isOpen()) {
+            store.logEnroll(entry.anchor, entry.verifier);
+            store.logAdvance(entry.anchor, entry.verifier, entry.verifiedIteration);
+            if (entry.exhausted) store.logExhaust(entry.anchor);
+        }
+    }
+    coverTable();
+}
+
+/**
+ * @brief Registers a new chain.
+ * @param anchor The anchor.
+ * @param verifier The enrolled verifier.
+ * @param owner The enrolling session.
+ * @return The record index, or NONE if the anchor is known.
+ */
+std::uint32_t ChainRegistry::enroll(const Digest& anchor, const ChainVerifier& verifier, SessionId owner)
+{
+    std::unique_lock<std::shared_mutex> guard(layout);
+    std::uint32_t index = table.insert(anchor);
+    if (index == NONE) return NONE;
+    storeRecord(index, verifier, 0);
+    coverTable();
+    // A reused record number starts with a full bucket
+    attachments[index] = Attachment();
+    attachments[index].owner = owner;
+    attachments[index].attached = true;
+    if (store.isOpen()) store.logEnroll(anchor, verifier);
+    if (replicating) replica.logEnroll(anchor, verifier);
+    return index;
+}
+
+/**
+ * @brief Attaches an unattached chain to a session.
+ * @param anchor The anchor.
+ * @param owner The resuming session.
+ * @return The record index, or NONE.
+ */
+std::uint32_t ChainRegistry::attach(const Digest& anchor, SessionId owner)
+{
+    std::shared_lock<std::shared_mutex> shared(layout);
+    std::uint32_t index = table.find(anchor);
+    if (index == NONE) return NONE;
+    std::lock_guard<std::mutex> guard(stripeOf(index));
+    if (table.record(index).flags & VerifierTable::EXHAUSTED) return NONE;
+    Attachment& entry = attachments[index];
+    if (entry.attached) return NONE;
+    entry.owner = owner;
+    entry.attached = true;
+    return index;
+}
+
+/**
+ * @brief Detaches a chain from its session.
+ * @param index The record index.
+ */
+void ChainRegistry::detach(std::uint32_t index)
+{
+    if (index == NONE) return;
+    std::shared_lock<std::shared_mutex> shared(layout);
+    std::lock_guard<std::mutex> guard(stripeOf(index));
+    attachments[index].attached = false;
+}
+
+/**
+ * @brief Turns a used-up chain into a tombstone that refuses its anchor.
+ * @param index The record index.
+ */
+void ChainRegistry::exhaust(std::uint32_t index)
+{
+    if (index == NONE) return;
+    std::shared_lock<std::shared_mutex> shared(layout);
+    std::lock_guard<std::mutex> guard(stripeOf(index));
+    table.record(index).flags |= VerifierTable::EXHAUSTED;
+    attachments[index] = Attachment();
+    if (store.isOpen()) store.logExhaust(table.record(index).anchor);
+    if (replicating) replica.logExhaust(table.record(index).anchor);
+}
+
+/**
+ * @brief Forgets a chain and recycles its record.
+ * @param index The record index.
+ */
+void ChainRegistry::remove(std::uint32_t index)
+{
+    if (index == NONE) return;
+    std::unique_lock<std::shared_mutex> guard(layout);
+    if (store.isOpen()) store.logRemove(table.record(index).anchor);
+    if (replicating) replica.logRemove(table.record(index).anchor);
+    table.remove(index);
+    attachments[index] = Attachment();
+}
+
+/**
+ * @brief Charges a frame to the bucket kept beside a chain's record.
+ * @param index The record index.
+ * @param admission The limits.
+ * @return True if admitted.
+ */
+bool ChainRegistry::admitFrame(std::uint32_t index, AdmissionControl& admission)
+{
+    if (index == NONE || !admission.limitsChains()) return true;
+    std::shared_lock<std::shared_mutex> shared(layout);
+    std::lock_guard<std::mutex> guard(stripeOf(index));
+    return admission.admitChainFrame(attachments[index].bucket);
+}
+
+/**
+ * @brief Copies a record.
+ * @param index The record index.
+ * @return The record.
+ */
+ChainRecord ChainRegistry::load(std::uint32_t index) const
+{
+    std::shared_lock<std::shared_mutex> shared(layout);
+    std::lock_guard<std::mutex> guard(stripeOf(index));
+    const VerifierTable::Record& stored = table.record(index);
+    ChainParams params;
+    params.format = static_cast<ChainFormat>(stored.format);
+    params.algorithm = static_cast<HashAlgorithm>(stored.algorithm);
+    ChainRecord entry;
+    entry.verifier.enroll(params, stored.link);
+    entry.verifiedIteration = static_cast<std::int32_t>(stored.counter);
+    entry.owner = attachments[index].owner;
+    entry.attached = attachments[index].attached;
+    return entry;
+}
+
+/**
+ * @brief Stores the verifier state and counter of a chain.
+ * @param index The record index.
+ * @param verifier The verifier.
+ * @param verifiedIteration The last verified challenge number.
+ * @return The log position of the advance, or 0.
+ */
+std::uint64_t ChainRegistry::save(std::uint32_t index, const ChainVerifier& verifier, std::int32_t verifiedIteration)
+{
+    std::shared_lock<std::shared_mutex> shared(layout);
+    std::lock_guard<std::mutex> guard(stripeOf(index));
+    storeRecord(index, verifier, verifiedIteration);
+    // Only appended to a buffer here; the store's flusher thread writes and syncs it
+    std::uint64_t position = 0;
+    if (store.isOpen()) position = store.logAdvance(table.record(index).anchor, verifier, verifiedIteration);
+    if (replicating) replica.logAdvance(table.record(index).anchor, verifier, verifiedIteration);
+    return position;
+}
+
+/**
+ * @brief Gets the end of the store's log.
+ * @return The log position, or 0.
+ */
+std::uint64_t ChainRegistry::logPosition() const
+{
+    return store.appendedPosition();
+}
+
+/**
+ * @brief Gets how far the store's log is synced.
+ * @return The log position.
+ */
+std::uint64_t ChainRegistry::durablePosition() const
+{
+    return store.durablePosition();
+}
+
+/**
+ * @brief Registers a listener with the store.
+ * @param owner The listener's owner.
+ * @param listener The function.
+ */
+void ChainRegistry::watchDurable(const void* owner, std::function<void()> listener)
+{
+    store.watchDurable(owner, std::move(listener));
+}
+
+/**
+ * @brief Removes an owner's listeners from the store.
+ * @param owner The listener's owner.
+ */
+void ChainRegistry::unwatchDurable(const void* owner)
+{
+    store.unwatchDurable(owner);
+}
+
+/**
+ * @brief Gets the number of known chains.
+ * @return The chain count.
+ */
+std::size_t ChainRegistry::size() const
+{
+    std::shared_lock<std::shared_mutex> shared(layout);
+    return table.size();
+}
+
+/**
+ * @brief Replays a logged change onto the table, never moving a chain backwards.
+ * @param record The record.
+ */
+void ChainRegistry::replay(const ChainLog::Record& record)
+{
+    std::unique_lock<std::shared_mutex> guard(layout);
+    std::uint32_t index = table.find(record.anchor);
+    if (record.type == ChainLog::RecordType::Enroll) {
+        if (index != NONE) return;
+        index = table.insert(record.anchor);
+        if (index == NONE) return;
+        coverTable();
+        ChainVerifier verifier;
+        verifier.enroll(record.params, record.anchor);
+        storeRecord(index, verifier, 0);
+    } else if (record.type == ChainLog::RecordType::Advance) {
+        VerifierTable::Record* stored = index == NONE ? nullptr : &table.record(index);
+        if (!stored || stored->counter >= static_cast<std::uint64_t>(record.verifiedIteration)) return;
+        stored->link = record.link;
+        stored->counter = static_cast<std::uint64_t>(record.verifiedIteration);
+    } else if (record.type == ChainLog::RecordType::Exhaust) {
+        if (index != NONE) table.record(index).flags |= VerifierTable::EXHAUSTED;
+    } else if (record.type == ChainLog::RecordType::Remove) {
+        if (index == NONE) return;
+        table.remove(index);
+        attachments[index] = Attachment();
+    }
+}
+
+/**
+ * @brief Syncs the table through a second descriptor, then marks and syncs the checkpoint.
+ * @param segment The first segment the table still needs.
+ * @return True on success.
+ */
+bool ChainRegistry::checkpoint(std::uint64_t segment)
+{
+    // Changes are logged under their chain's locks, which this waits out: those logged before the segment are in the pages
+    int fd;
+    {
+        std::unique_lock<std::shared_mutex> guard(layout);
+        fd = table.duplicateFile();
+    }
+    if (fd < 0) return false;
+    // Synced outside the layout lock, so the event loops go on verifying meanwhile
+    bool ok = ::fdatasync(fd) == 0;
+    if (ok) {
+        std::unique_lock<std::shared_mutex> guard(layout);
+        // A table that grew meanwhile is a new file, synced only as of its growth: it keeps its older mark
+        ok = table.mapsFile(fd);
+        if (ok) table.setLogSegment(segment);
+    }
+    ok = ok && ::fdatasync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+/**
+ * @brief Copies the live records into store entries.
+ * @return The chains.
+ */
+std::vector<ChainStore::Entry> ChainRegistry::entries() const
+{
+    std::vector<ChainStore::Entry> live;
+    live.reserve(table.size());
+    for (std::uint32_t number = 0; number < table.end(); ++number) {
+        const VerifierTable::Record& stored = table.record(number);
+        if (!(stored.flags & VerifierTable::LIVE)) continue;
+        ChainStore::Entry entry;
+        ChainParams params;
+        params.format = static_cast<ChainFormat>(stored.format);
+        params.algorithm = static_cast<HashAlgorithm>(stored.algorithm);
+        entry.anchor = stored.anchor;
+        entry.verifier.enroll(params, stored.link);
+        entry.verifiedIteration = static_cast<std::int32_t>(stored.counter);
+        entry.exhausted = (stored.flags & VerifierTable::EXHAUSTED) != 0;
+        live.push_back(entry);
+    }
+    return live;
+}
+
+/**
+ * @brief Sends the full state to a standby; runs on the sender thread.
+ */
+void ChainRegistry::resyncReplica()
+{
+    std::unique_lock<std::shared_mutex> guard(layout);
+    replica.resend(entries());
+}
+
+/**
+ * @brief Picks a record's stripe by its number.
+ * @param number The record number.
+ * @return The stripe's lock.
+ */
+std::mutex& ChainRegistry::stripeOf(std::uint32_t number) const
+{
+    return stripes[number % STRIPES].lock;
+}
+
+/**
+ * @brief Extends the attachments up to the table's high-water mark; new entries are detached.
+ */
+void ChainRegistry::coverTable()
+{
+    if (attachments.size() < table.end()) attachments.resize(table.end());
+}
+
+/**
+ * @brief Copies a verifier's link and parameters, and a counter, into a table record.
+ * @param number The record number.
+ * @param verifier The verifier.
+ * @param verifiedIteration The last verified challenge number.
+ */
+void ChainRegistry::storeRecord(std::uint32_t number, const ChainVerifier& verifier, std::int32_t verifiedIteration)
+{
+    VerifierTable::Record& stored = table.record(number);
+    stored.link = verifier.lastVerifiedHash();
+    stored.counter = static_cast<std::uint64_t>(verifiedIteration);
+    stored.format = static_cast<std::uint8_t>(verifier.chainParams().format);
+    stored.algorithm = static_cast<std::uint8_t>(verifier.chainParams().algorithm);
+}
+
+/**
+ * @brief Inserts a stored chain with its link, counter and exhaustion; a duplicate anchor is skipped.
+ * @param entry The chain.
+ */
+void ChainRegistry::insertEntry(const ChainStore::Entry& entry)
+{
+    std::uint32_t number = table.insert(entry.anchor);
+    if (number == NONE) return;
+    storeRecord(number, entry.verifier, entry.verifiedIteration);
+    if (entry.exhausted) table.record(number).flags |= VerifierTable::EXHAUSTED;
+}
\ No newline at end of file
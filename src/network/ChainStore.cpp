@@ -0,0 +1,533 @@
+#include "ChainStore.hpp"
+#include "ChainLog.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    const char WAL_MAGIC[8] = {'L', 'M', 'P', 'W', 'A', 'L', '\0', '\0'};
+    const char SNAP_MAGIC[8] = {'L', 'M', 'P', 'S', 'N', 'A', 'P', '\0'};
+    const std::uint32_t VERSION = 1;
+    const std::uint32_t SNAP_VERSION = 2;     ///< Version 2 added the flags byte; both are still read.
+    const std::size_t WAL_HEADER_SIZE = 16;   ///< Magic, version, reserved.
+    const std::size_t SNAP_HEADER_SIZE = 32;  ///< Magic, version, reserved, seq, count.
+    const std::size_t SNAP_ENTRY_SIZE = 71;   ///< Anchor, link, counter, format, algorithm, flags.
+    const std::size_t SNAP_V1_ENTRY_SIZE = 70; ///< The same without flags.
+    const std::uint8_t SNAP_EXHAUSTED = 1;    ///< Entry flag: the chain is used up.
+    const std::size_t CRC_SIZE = ChainLog::CRC_SIZE;
+    const char* SNAPSHOT_NAME = "chains.snap";
+    const std::chrono::microseconds SYNC_INTERVAL(1000); ///< The least time between two syncs.
+
+    void storeLe(std::uint8_t* p, std::uint64_t v, std::size_t bytes)
+    {
+        for (std::size_t i = 0; i < bytes; ++i) p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+    }
+
+    std::uint64_t loadLe(const std::uint8_t* p, std::size_t bytes)
+    {
+        std::uint64_t v = 0;
+        for (std::size_t i = 0; i < bytes; ++i) v |= std::uint64_t(p[i]) << (8 * i);
+        return v;
+    }
+
+    /**
+     * @brief Writes a whole buffer, retrying on short writes and EINTR.
+     * @return True if every byte was written.
+     */
+    bool writeAll(int fd, const void* data, std::size_t size)
+    {
+        const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+        while (size > 0) {
+            ssize_t written = ::write(fd, p, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Reads a whole file into memory.
+     * @param path The file.
+     * @param contents Receives the bytes.
+     * @return False if the file does not exist or cannot be read.
+     */
+    bool readFile(const std::string& path, std::vector<std::uint8_t>& contents)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat info;
+        bool ok = ::fstat(fd, &info) == 0;
+        if (ok) {
+            contents.resize(static_cast<std::size_t>(info.st_size));
+            std::size_t done = 0;
+            while (ok && done < contents.size()) {
+                ssize_t got = ::read(fd, contents.data() + done, contents.size() - done);
+                if (got < 0 && errno == EINTR) continue;
+                ok = got > 0;
+                if (ok) done += static_cast<std::size_t>(got);
+            }
+        }
+        ::close(fd);
+        return ok;
+    }
+
+    /**
+     * @brief Syncs a directory, so that files created or renamed in it survive a crash.
+     */
+    void syncDirectory(const std::string& directory)
+    {
+        int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) return;
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+/**
+ * @brief Closes the store.
+ */
+ChainStore::~ChainStore()
+{
+    close();
+}
+
+/**
+ * @brief Opens a store: replays its log onto the table, checkpoints it and starts the flusher.
+ * @param directory The directory.
+ * @param snapshotEvery Records between checkpoints.
+ * @param firstSegment The first segment to replay.
+ * @param replay Receives the records.
+ * @param checkpoint Syncs the table.
+ * @return True on success.
+ */
+bool ChainStore::open(const std::string& directory, std::uint64_t snapshotEvery, std::uint64_t firstSegment,
+                      const Replay& replay, Checkpoint checkpoint)
+{
+    close();
+    m_directory = directory;
+    m_snapshotEvery = snapshotEvery > 0 ? snapshotEvery : 1;
+    m_checkpoint = std::move(checkpoint);
+    if (::mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) {
+        std::cerr << "ChainStore: cannot create " << directory << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // Held until close(): another process recovering from the same directory would delete the segments
+    // this one is appending to
+    m_directoryLock = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (m_directoryLock < 0 || ::flock(m_directoryLock, LOCK_EX | LOCK_NB) != 0) {
+        if (errno == EWOULDBLOCK)
+            std::cerr << "ChainStore: " << directory << " is in use by another process." << std::endl;
+        else
+            std::cerr << "ChainStore: cannot open " << directory << ": " << std::strerror(errno) << std::endl;
+        releaseDirectory();
+        return false;
+    }
+
+    if (!recover(firstSegment, replay)) return false;
+    // Segments are numbered from 1, so a table marked 0 has never been checkpointed
+    if (m_segment == 0) m_segment = 1;
+
+    // The replayed state is checkpointed at a fresh segment, so a torn tail is never appended to
+    if (!openSegment() || !m_checkpoint(m_segment)) {
+        std::cerr << "ChainStore: cannot write to " << directory << ": " << std::strerror(errno) << std::endl;
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    removeSegmentsBefore(m_segment);
+    std::remove((m_directory + "/" + SNAPSHOT_NAME).c_str());
+
+    m_pending.clear();
+    m_appended = 0;
+    m_durable = 0;
+    m_stopping = false;
+    m_failed = false;
+    m_recordsSinceSnapshot = 0;
+    m_flusher = std::thread([this]() { run(); });
+    return true;
+}
+
+/**
+ * @brief Flushes pending records and joins the flusher thread.
+ */
+void ChainStore::close()
+{
+    if (m_flusher.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_flusher.join();
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    releaseDirectory();
+}
+
+/**
+ * @brief Drops the lock on the directory, which a failed open() may still hold.
+ */
+void ChainStore::releaseDirectory()
+{
+    if (m_directoryLock >= 0) ::close(m_directoryLock);
+    m_directoryLock = -1;
+}
+
+/**
+ * @brief Checks whether the store is open.
+ * @return True while the flusher runs.
+ */
+bool ChainStore::isOpen() const
+{
+    return m_flusher.joinable();
+}
+
+/**
+ * @brief Logs an enrollment.
+ * @param anchor The anchor.
+ * @param verifier The verifier.
+ */
+void ChainStore::logEnroll(const Digest& anchor, const ChainVerifier& verifier)
+{
+    std::uint8_t record[ChainLog::MAX_RECORD_SIZE];
+    append(record, ChainLog::encodeEnroll(record, anchor, verifier));
+}
+
+/**
+ * @brief Logs an advance.
+ * @param anchor The anchor.
+ * @param verifier The verifier.
+ * @param verifiedIteration The last verified challenge number.
+ * @return The log position the record ends at.
+ */
+std::uint64_t ChainStore::logAdvance(const Digest& anchor, const ChainVerifier& verifier, std::int32_t verifiedIteration)
+{
+    std::uint8_t record[ChainLog::MAX_RECORD_SIZE];
+    return append(record, ChainLog::encodeAdvance(record, anchor, verifier, verifiedIteration));
+}
+
+/**
+ * @brief Logs an exhausted chain.
+ * @param anchor The anchor.
+ */
+void ChainStore::logExhaust(const Digest& anchor)
+{
+    std::uint8_t record[ChainLog::MAX_RECORD_SIZE];
+    append(record, ChainLog::encodeMarker(record, ChainLog::RecordType::Exhaust, anchor));
+}
+
+/**
+ * @brief Logs a removal.
+ * @param anchor The anchor.
+ */
+void ChainStore::logRemove(const Digest& anchor)
+{
+    std::uint8_t record[ChainLog::MAX_RECORD_SIZE];
+    append(record, ChainLog::encodeMarker(record, ChainLog::RecordType::Remove, anchor));
+}
+
+/**
+ * @brief Queues a record for the flusher.
+ * @param record The encoded record.
+ * @param size The size of the record.
+ * @return The log position after the record; 0 once the store has failed.
+ */
+std::uint64_t ChainStore::append(const std::uint8_t* record, std::size_t size)
+{
+    bool wasEmpty;
+    std::uint64_t position;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (m_failed) return 0;
+        wasEmpty = m_pending.empty();
+        m_pending.insert(m_pending.end(), record, record + size);
+        m_appended += size;
+        position = m_appended;
+    }
+    // The flusher drains the whole buffer each time, so it only needs waking for the first record
+    if (wasEmpty) m_wake.notify_one();
+    m_recordsSinceSnapshot.fetch_add(1, std::memory_order_relaxed);
+    return position;
+}
+
+/**
+ * @brief Gets the end of the log appended so far.
+ * @return The log position.
+ */
+std::uint64_t ChainStore::appendedPosition() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_appended;
+}
+
+/**
+ * @brief Gets how far the log is synced, without locking.
+ * @return The log position; UINT64_MAX once the store has failed.
+ */
+std::uint64_t ChainStore::durablePosition() const
+{
+    return m_durable.load();
+}
+
+/**
+ * @brief Registers a function to call whenever a batch has been synced.
+ * @param owner Identifies the listener for unwatchDurable().
+ * @param listener The function.
+ */
+void ChainStore::watchDurable(const void* owner, std::function<void()> listener)
+{
+    std::lock_guard<std::mutex> guard(m_listenerLock);
+    m_listeners.emplace_back(owner, std::move(listener));
+}
+
+/**
+ * @brief Removes a listener; it is not called any more once this returns.
+ * @param owner The owner given to watchDurable().
+ */
+void ChainStore::unwatchDurable(const void* owner)
+{
+    std::lock_guard<std::mutex> guard(m_listenerLock);
+    m_listeners.erase(std::remove_if(m_listeners.begin(), m_listeners.end(),
+                                     [owner](const Listener& listener) { return listener.first == owner; }),
+                      m_listeners.end());
+}
+
+/**
+ * @brief Waits for the flusher to sync everything appended before the call.
+ * @return True unless the store has failed.
+ */
+bool ChainStore::sync()
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+    std::uint64_t target = m_appended;
+    m_synced.wait(guard, [&]() { return m_durable.load() >= target || m_failed || !m_flusher.joinable(); });
+    return !m_failed;
+}
+
+/**
+ * @brief Writes pending records in batches, one fdatasync() per batch, until the store is closed.
+ */
+void ChainStore::run()
+{
+    // The two buffers trade places each batch, so once both have grown appending no longer allocates
+    std::vector<std::uint8_t> batch;
+    std::chrono::steady_clock::time_point lastSync;
+    std::unique_lock<std::mutex> guard(m_lock);
+    for (;;) {
+        m_wake.wait(guard, [&]() { return m_stopping || !m_pending.empty(); });
+        // Each sync costs the kernel a journal commit, CPU time the event loops would otherwise get,
+        // so a sync right after another waits for more records to share it
+        m_wake.wait_until(guard, lastSync + SYNC_INTERVAL, [&]() { return m_stopping; });
+        lastSync = std::chrono::steady_clock::now();
+        batch.clear();
+        batch.swap(m_pending);
+        std::uint64_t target = m_appended;
+        bool stopping = m_stopping;
+        bool ok = !m_failed;
+        guard.unlock();
+
+        if (ok && !batch.empty()) {
+            ok = writeAll(m_fd, batch.data(), batch.size()) && ::fdatasync(m_fd) == 0;
+        }
+        // Every record of the old segment is synced; records appended meanwhile go to the new one
+        if (ok && !stopping && m_recordsSinceSnapshot.load(std::memory_order_relaxed) >= m_snapshotEvery) {
+            m_recordsSinceSnapshot = 0;
+            ok = rotate();
+        }
+
+        guard.lock();
+        if (!ok && !m_failed) {
+            m_failed = true;
+            m_pending.clear();
+            std::cerr << "ChainStore: write to " << m_directory << " failed: " << std::strerror(errno)
+                      << "; chains are no longer persisted." << std::endl;
+        }
+        // A failed store holds nothing back any more: its records are dropped anyway
+        // Sequentially consistent, like the listeners' own flags, so that a loop holding challenges back
+        // either sees this sync or is woken by a listener
+        m_durable.store(m_failed ? UINT64_MAX : target);
+        m_synced.notify_all();
+        if (!batch.empty()) {
+            guard.unlock();
+            {
+                std::lock_guard<std::mutex> listening(m_listenerLock);
+                for (const Listener& listener : m_listeners) listener.second();
+            }
+            guard.lock();
+        }
+        if (stopping && m_pending.empty()) break;
+    }
+}
+
+/**
+ * @brief Closes the current segment, starts the next one and checkpoints the table at it.
+ * @return True unless the new segment cannot be created.
+ */
+bool ChainStore::rotate()
+{
+    ::close(m_fd);
+    m_fd = -1;
+    ++m_segment;
+    if (!openSegment()) return false;
+    if (m_checkpoint(m_segment)) {
+        removeSegmentsBefore(m_segment);
+    } else {
+        // The table still needs the old segments; the next checkpoint removes them
+        std::cerr << "ChainStore: the table was not checkpointed; its log is kept until the next checkpoint." << std::endl;
+    }
+    return true;
+}
+
+/**
+ * @brief Replays the log segments from the table's on; a store that predates the table starts from its snapshot.
+ * A torn or corrupt record ends the replay of its segment, which is where a crash cut it off.
+ * @param firstSegment The first segment to replay.
+ * @param replay Receives the records.
+ * @return False if the snapshot is unreadable or the log does not reach back to the first segment.
+ */
+bool ChainStore::recover(std::uint64_t firstSegment, const Replay& replay)
+{
+    std::uint64_t seq = firstSegment;
+    if (firstSegment == 0 && !replayOldSnapshot(replay, seq)) return false;
+
+    // Segments are only deleted once a checkpoint covers them, so a gap means another table
+    std::uint64_t oldest = removeSegmentsBefore(0);
+    if (oldest != UINT64_MAX && oldest > seq) {
+        std::cerr << "ChainStore: " << m_directory << " starts at segment " << oldest << " but the table needs "
+                  << seq << " on; it belongs to another table." << std::endl;
+        return false;
+    }
+
+    std::vector<std::uint8_t> data;
+    std::uint64_t replayed = 0;
+    for (m_segment = seq; readFile(segmentPath(m_segment), data); ++m_segment) {
+        if (data.size() < WAL_HEADER_SIZE || std::memcmp(data.data(), WAL_MAGIC, 8) != 0
+            || loadLe(data.data() + 8, 4) != VERSION) {
+            continue;
+        }
+        std::size_t offset = WAL_HEADER_SIZE;
+        while (offset < data.size()) {
+            const std::uint8_t* p = data.data() + offset;
+            std::size_t size = ChainLog::recordSize(p[0]);
+            ChainLog::Record record;
+            if (size == 0 || offset + size > data.size() || !ChainLog::decode(p, record)) break;
+            replay(record);
+            offset += size;
+            ++replayed;
+        }
+    }
+    if (replayed > 0) std::cout << "ChainStore: replayed " << replayed << " log record(s)." << std::endl;
+    return true;
+}
+
+/**
+ * @brief Turns each chain of an old snapshot into the records that would have logged it.
+ * @param replay Receives the records.
+ * @param seq Receives the snapshot's segment.
+ * @return False if the snapshot exists but is corrupt.
+ */
+bool ChainStore::replayOldSnapshot(const Replay& replay, std::uint64_t& seq)
+{
+    std::vector<std::uint8_t> data;
+    std::string snapshotPath = m_directory + "/" + SNAPSHOT_NAME;
+    if (!readFile(snapshotPath, data)) return true;
+    std::uint64_t version = data.size() >= SNAP_HEADER_SIZE ? loadLe(data.data() + 8, 4) : 0;
+    std::size_t entrySize = version == 1 ? SNAP_V1_ENTRY_SIZE : SNAP_ENTRY_SIZE;
+    bool ok = data.size() >= SNAP_HEADER_SIZE + CRC_SIZE && std::memcmp(data.data(), SNAP_MAGIC, 8) == 0
+              && (version == 1 || version == SNAP_VERSION);
+    std::uint64_t count = ok ? loadLe(data.data() + 24, 8) : 0;
+    ok = ok && data.size() == SNAP_HEADER_SIZE + count * entrySize + CRC_SIZE
+         && ChainLog::crc32(data.data(), data.size() - CRC_SIZE) == loadLe(data.data() + data.size() - CRC_SIZE, CRC_SIZE);
+    if (!ok) {
+        // The snapshot was renamed into place only once complete, so this is damage, not a crash
+        std::cerr << "ChainStore: " << snapshotPath << " is corrupt." << std::endl;
+        return false;
+    }
+    seq = loadLe(data.data() + 16, 8);
+    const std::uint8_t* p = data.data() + SNAP_HEADER_SIZE;
+    for (std::uint64_t i = 0; i < count; ++i, p += entrySize) {
+        ChainLog::Record record;
+        if (!ChainLog::decodeParams(p[68], p[69], record.params)) continue;
+        std::memcpy(record.anchor.data(), p, Digest::SIZE);
+        record.type = ChainLog::RecordType::Enroll;
+        replay(record);
+        std::memcpy(record.link.data(), p + Digest::SIZE, Digest::SIZE);
+        record.verifiedIteration = static_cast<std::int32_t>(loadLe(p + 2 * Digest::SIZE, 4));
+        record.type = ChainLog::RecordType::Advance;
+        replay(record);
+        if (entrySize == SNAP_ENTRY_SIZE && (p[70] & SNAP_EXHAUSTED)) {
+            record.type = ChainLog::RecordType::Exhaust;
+            replay(record);
+        }
+    }
+    std::cout << "ChainStore: moved " << count << " chain(s) from " << snapshotPath << " into the table." << std::endl;
+    return true;
+}
+
+/**
+ * @brief Creates the current segment with its header.
+ * @return True on success.
+ */
+bool ChainStore::openSegment()
+{
+    m_fd = ::open(segmentPath(m_segment).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+    if (m_fd < 0) return false;
+    std::uint8_t header[WAL_HEADER_SIZE] = {};
+    std::memcpy(header, WAL_MAGIC, sizeof(WAL_MAGIC));
+    storeLe(header + 8, VERSION, 4);
+    bool ok = writeAll(m_fd, header, sizeof(header)) && ::fdatasync(m_fd) == 0;
+    syncDirectory(m_directory);
+    return ok;
+}
+
+/**
+ * @brief Deletes the segments a checkpoint has made obsolete.
+ * @param seq The first segment to keep; 0 only looks.
+ * @return The lowest segment found.
+ */
+std::uint64_t ChainStore::removeSegmentsBefore(std::uint64_t seq)
+{
+    std::uint64_t lowest = UINT64_MAX;
+    DIR* dir = ::opendir(m_directory.c_str());
+    if (!dir) return lowest;
+    while (dirent* item = ::readdir(dir)) {
+        unsigned long long found = 0;
+        char suffix[5] = {};
+        if (std::sscanf(item->d_name, "chains-%16llx.%4s", &found, suffix) == 2 && std::strcmp(suffix, "wal") == 0) {
+            lowest = std::min<std::uint64_t>(lowest, found);
+            if (found < seq) std::remove((m_directory + "/" + item->d_name).c_str());
+        }
+    }
+    ::closedir(dir);
+    return lowest;
+}
+
+/**
+ * @brief Builds the path of a segment from its sequence number.
+ * @param seq The sequence number.
+ * @return The path.
+ */
+std::string ChainStore::segmentPath(std::uint64_t seq) const
+{
+    char name[40];
+    std::snprintf(name, sizeof(name), "chains-%016" PRIx64 ".wal", seq);
+    return m_directory + "/" + name;
+}
\ No newline at end of file
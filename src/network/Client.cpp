@@ -1,5 +1,11 @@
 #include "Client.hpp"
-#include <QDataStream>
+#include "Sha256.hpp"
+#include <QJsonDocument>
+#include <QFile>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTimer>
+#include <cstdio>
 
 /**
  * @brief Constructs a Client object.
@@ -15,6 +21,10 @@ Client::Client(const QString& filePath, QObject* parent)
     connect(m_socket, &QTcpSocket::connected, this, &Client::onConnected);
     connect(m_socket, &QTcpSocket::disconnected, this, &Client::onDisconnected);
     connect(m_socket, &QTcpSocket::readyRead, this, &Client::onReadyRead);
+    // Chains are built off the event loop; their progress and result come back as signals
+    m_generator = new ChainGenerator(this);
+    connect(m_generator, &ChainGenerator::progress, this, &Client::onChainProgress);
+    connect(m_generator, &ChainGenerator::finished, this, &Client::onChainGenerated);
     // Attempt to connect to the server
     startClient();
 }
@@ -36,8 +46,11 @@ bool Client::isConnected() const {
 
 /**
  * @brief Initiates a connection to the server using settings from the config file.
+ * A chain that is not ready yet is restored or generated in the background meanwhile.
  */
 void Client::startClient() {
+    m_stopping = false;
+    if (!m_chainReady && !m_generator->isRunning() && !restoreState()) createChain();
     QHostAddress aliceIP(m_config.getAliceIP());
     quint16 alicePort = m_config.getAlicePort();
     emit newLogMessage("Client: Connecting to " + aliceIP.toString() + ":" + QString::number(alicePort));
@@ -48,6 +61,8 @@ void Client::startClient() {
  * @brief Disconnects the client from the server.
  */
 void Client::stopClient() {
+    m_stopping = true; // A deliberate disconnect is not followed by a reconnect
+    m_generator->cancel();
     if (isConnected()) {
         m_socket->disconnectFromHost();
     }
@@ -55,73 +70,349 @@ void Client::stopClient() {
 
 /**
  * @brief Slot called upon successful connection to the server.
- * Generates the hash chain and sends the final hash (h_n) to the server.
+ * Resumes or enrolls the chain if it is ready; otherwise the handshake follows
+ * as soon as the background generation has produced h_n.
  */
 void Client::onConnected() {
     emit connected();
     emit newLogMessage("Client: Connection successful.");
-    // Generate the Lamport hash chain
+    m_parser = Protocol::FrameParser(); // A new stream starts with a new frame
+
+    if (m_chainReady) {
+        sendHandshake();
+    } else {
+        emit newLogMessage("Client: Waiting for the hash chain; h_n will be sent as soon as it is ready.");
+    }
+}
+
+/**
+ * @brief Starts a new chain from a fresh random seed. A matching pre-generated chain file is
+ * mapped at once; otherwise the chain is built by the generator, streamed to chainFile if set.
+ */
+void Client::createChain() {
     int len = m_config.getNumberOfIterations();
     std::string seed = CryptoUtils::generateRandomSeed(32);
-    m_auth.initChain(seed, len);
-    emit newLogMessage("Client: Seed (hex): " + QString::fromStdString(CryptoUtils::convertToHex(seed)));
-    
+    ChainParams params = configuredChainParams();
+    QString chainFilePath = m_config.getChainFile();
+    bool keepChainFile = !m_config.getClientStateFile().isEmpty();
+    m_chainReady = false;
+    m_enrolled = false;
+    m_restoring = false;
+    m_seed.clear();
+
+    // A chain file kept for resuming belongs to the enrolled chain, so it is never reused for a new one
+    if (!chainFilePath.isEmpty() && len > 0 && !keepChainFile
+        && m_auth.openChainFile(chainFilePath.toStdString())
+        && m_auth.getChainParams().format == params.format
+        && m_auth.getChainParams().algorithm == params.algorithm
+        && m_auth.getChainLength() >= static_cast<std::uint64_t>(len)) {
+        emit newLogMessage("Client: Using pre-generated chain file " + chainFilePath);
+        // The mapping stays valid after unlinking; removing the file means its anchor is never enrolled twice
+        std::remove(chainFilePath.toStdString().c_str());
+        m_anchor = m_auth.getLastHash();
+        m_lastChallenge = 0;
+        finishChain();
+        return;
+    }
+
+    emit newLogMessage("Client: Generating hash chain in the background (SHA-256 backend: "
+                       + QString(Sha256::backend()) + ")...");
+    ChainGenerator::Request request;
+    request.seed = seed;
+    request.length = len;
+    request.params = params;
+    // Long chains can be kept as O(log n) checkpoints instead of n links
+    request.storage = m_config.getChainStorage() == "checkpointed" ? ChainStorage::Checkpointed : ChainStorage::Full;
+    if (len > 0) request.chainFile = chainFilePath.toStdString();
+    m_seed = QString::fromStdString(seed);
+    m_progressStep = 0;
+    m_generator->start(request);
+}
+
+/**
+ * @brief Logs every further 10% of the chain generation.
+ * @param done The links computed so far.
+ * @param total The chain length.
+ */
+void Client::onChainProgress(quint64 done, quint64 total) {
+    if (total == 0) return;
+    int step = static_cast<int>(done * 10 / total);
+    if (step <= m_progressStep) return;
+    m_progressStep = step;
+    emit newLogMessage("Client: Hash chain " + QString::number(step * 10) + "% generated.");
+}
+
+/**
+ * @brief Takes over a chain from the generator: a new chain is ready to be enrolled,
+ * a rebuilt one is checked against the saved anchor and resumed.
+ * @param ok False if the generation was cancelled.
+ */
+void Client::onChainGenerated(bool ok) {
+    if (!ok) {
+        emit newLogMessage("Client: Hash chain generation cancelled.");
+        m_restoring = false;
+        // Nothing else will report the end of a client stopped before it ever connected
+        if (m_stopping && !isConnected()) emit disconnected();
+        return;
+    }
+    m_auth = m_generator->takeResult();
+
+    if (m_restoring) {
+        m_restoring = false;
+        if (!(m_auth.getLastHash() == m_anchor)) {
+            emit newLogMessage("Client: State file " + m_config.getClientStateFile()
+                               + " does not match its seed; generating a new chain.");
+            createChain();
+            return;
+        }
+        m_lastChallenge = m_restoredChallenge;
+        m_enrolled = true;
+        finishChain();
+        return;
+    }
+
+    QString chainFilePath = m_config.getChainFile();
+    if (!chainFilePath.isEmpty() && m_config.getNumberOfIterations() > 0) {
+        if (!m_generator->wroteChainFile()) {
+            emit newLogMessage("Client: Could not write chain file " + chainFilePath + ", kept the chain in memory.");
+        } else {
+            emit newLogMessage("Client: Wrote chain file " + chainFilePath);
+            // Unless kept for resuming, the file is removed like a pre-generated one
+            if (m_config.getClientStateFile().isEmpty()) std::remove(chainFilePath.toStdString().c_str());
+        }
+    }
+    emit newLogMessage("Client: Seed (hex): " + QString::fromStdString(CryptoUtils::convertToHex(m_seed.toStdString())));
+    m_anchor = m_auth.getLastHash();
+    m_lastChallenge = 0;
+    finishChain();
+}
+
+/**
+ * @brief Marks the chain ready, saves the state and, if connected, sends the handshake.
+ */
+void Client::finishChain() {
+    m_chainReady = true;
+    saveState();
+    if (isConnected()) sendHandshake();
+}
+
+/**
+ * @brief Resumes a chain the server has seen, or enrolls a new one.
+ */
+void Client::sendHandshake() {
+    if (m_enrolled) {
+        // One round trip instead of rebuilding and re-enrolling the chain
+        emit newLogMessage("Client: Resuming chain after challenge #" + QString::number(m_lastChallenge) + "...");
+        std::uint8_t frame[Protocol::RESUME_FRAME_SIZE];
+        std::size_t size = Protocol::encodeResume(frame, m_anchor);
+        m_socket->write(reinterpret_cast<const char*>(frame), static_cast<qint64>(size));
+        m_socket->flush();
+        m_resuming = true;
+        return;
+    }
+    sendEnrollment();
+    m_enrolled = true;
+}
+
+/**
+ * @brief Sends the anchor h_n with its chain parameters to the server.
+ */
+void Client::sendEnrollment() {
     // Send the last hash of the chain (h_n) to the server for setup
     emit newLogMessage("Client: Sending final hash h_n to server...");
-    std::string hn = m_auth.getLastHash();
-    m_socket->write(QByteArray::fromStdString(hn));
+    // The anchor is sent together with the chain format and hash function it was built with
+    std::uint8_t frame[Protocol::ENROLL_FRAME_SIZE];
+    std::size_t size = Protocol::encodeEnroll(frame, m_auth.getChainParams(), m_anchor);
+    m_socket->write(reinterpret_cast<const char*>(frame), static_cast<qint64>(size));
     m_socket->flush();
 }
 
+/**
+ * @brief Gets the chain format and hash function selected in the configuration.
+ * @return The chain parameters.
+ */
+ChainParams Client::configuredChainParams() {
+    ChainParams params;
+    params.format = m_config.getChainFormat() == static_cast<int>(ChainFormat::BinaryV2)
+                        ? ChainFormat::BinaryV2 : ChainFormat::HexV1;
+    if (!parseHashAlgorithm(m_config.getHashAlgorithm().toStdString(), params.algorithm)) {
+        emit newLogMessage("Client: Unknown hash algorithm " + m_config.getHashAlgorithm() + ", using SHA-256.");
+    }
+    return params;
+}
+
+/**
+ * @brief Writes the chain's seed, parameters, anchor and position to the state file, readable by the owner only.
+ */
+void Client::saveState() {
+    QString path = m_config.getClientStateFile();
+    if (path.isEmpty() || !m_chainReady) return;
+
+    QJsonObject state;
+    state["seed"] = m_seed;
+    state["chainFormat"] = static_cast<int>(m_auth.getChainParams().format);
+    state["hashAlgorithm"] = QString(hashAlgorithmName(m_auth.getChainParams().algorithm));
+    state["numberOfIterations"] = m_config.getNumberOfIterations();
+    state["anchor"] = QString::fromStdString(m_anchor.toHex());
+    state["lastChallenge"] = m_lastChallenge;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)
+        || !file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner)
+        || file.write(QJsonDocument(state).toJson()) < 0
+        || !file.commit()) {
+        emit newLogMessage("Client: Could not save state to " + path);
+    }
+}
+
+/**
+ * @brief Restores the chain saved in the state file: maps the kept chain file if it
+ * holds the saved anchor, otherwise rebuilds the chain from the saved seed in the background.
+ * @return True if the chain was restored or its rebuild has started.
+ */
+bool Client::restoreState() {
+    QString path = m_config.getClientStateFile();
+    if (path.isEmpty()) return false;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QJsonObject state = QJsonDocument::fromJson(file.readAll()).object();
+
+    ChainParams params;
+    params.format = state.value("chainFormat").toInt() == static_cast<int>(ChainFormat::BinaryV2)
+                        ? ChainFormat::BinaryV2 : ChainFormat::HexV1;
+    Digest anchor;
+    int len = state.value("numberOfIterations").toInt();
+    if (!parseHashAlgorithm(state.value("hashAlgorithm").toString().toStdString(), params.algorithm)
+        || !Digest::fromHex(state.value("anchor").toString().toStdString(), anchor)
+        || len != m_config.getNumberOfIterations()) {
+        emit newLogMessage("Client: Ignoring state file " + path + " (unreadable or for a different chain length).");
+        return false;
+    }
+
+    QString chainFilePath = m_config.getChainFile();
+    bool restored = !chainFilePath.isEmpty()
+                    && m_auth.openChainFile(chainFilePath.toStdString())
+                    && m_auth.getChainParams().format == params.format
+                    && m_auth.getChainParams().algorithm == params.algorithm
+                    && m_auth.getLastHash() == anchor;
+    m_seed = state.value("seed").toString();
+    m_anchor = anchor;
+    if (restored) {
+        emit newLogMessage("Client: Restored chain from " + chainFilePath);
+        m_lastChallenge = state.value("lastChallenge").toInt();
+        m_enrolled = true;
+        finishChain();
+        return true;
+    }
+
+    // A chain mapped from a pre-generated file has no known seed and cannot be rebuilt
+    if (m_seed.isEmpty()) return false;
+    emit newLogMessage("Client: Rebuilding chain from the seed in " + path + " in the background...");
+    ChainGenerator::Request request;
+    request.seed = m_seed.toStdString();
+    request.length = len;
+    request.params = params;
+    request.storage = m_config.getChainStorage() == "checkpointed" ? ChainStorage::Checkpointed : ChainStorage::Full;
+    m_restoredChallenge = state.value("lastChallenge").toInt();
+    m_restoring = true;
+    m_progressStep = 0;
+    m_generator->start(request);
+    return true;
+}
+
 /**
  * @brief Slot called when disconnected from the server.
+ * Saves the chain position and, unless stopped on purpose, reconnects after reconnectDelay.
  */
 void Client::onDisconnected() {
     emit newLogMessage("Client: Disconnected from server.");
+    saveState();
+    int delay = m_config.getReconnectDelay();
+    if (!m_stopping && delay > 0) {
+        emit newLogMessage("Client: Reconnecting in " + QString::number(delay) + " s...");
+        QTimer::singleShot(delay * 1000, this, &Client::startClient);
+        return;
+    }
     emit disconnected();
 }
 
 /**
- * @brief Slot called when data is received from the server (a challenge).
- * Responds with the appropriate one-time password (OTP).
+ * @brief Slot called when data is received from the server.
+ * Feeds everything available to the frame parser and answers every challenge it yields;
+ * the responses are queued on the socket and sent with one flush.
  */
 void Client::onReadyRead() {
-    QByteArray content = m_socket->readAll();
-    // Deserialize the challenge number from the byte array
-    int challengeNumber = getNumberFromQByteArray(content);
-    if (challengeNumber <= 0) return; // Ignore invalid challenges
-    
-    emit newLogMessage("Client: Received challenge #" + QString::number(challengeNumber));
-    
-    // Get the correct OTP from the LamportAuth logic
-    std::string response = m_auth.getOTPForChallenge(challengeNumber);
-    emit newLogMessage("Client: Sending response h_" + QString::number(m_config.getNumberOfIterations() - challengeNumber));
-    
-    // Send the OTP back to the server
-    m_socket->write(QByteArray::fromStdString(response));
+    int answered = 0;
+    int first = 0;
+    int last = 0;
+    qint64 size;
+    while ((size = m_socket->read(reinterpret_cast<char*>(m_readBuffer), sizeof(m_readBuffer))) > 0) {
+        bool ok = m_parser.feed(m_readBuffer, static_cast<std::size_t>(size), [&](const Protocol::Frame& frame) {
+            int challengeNumber = 0;
+            if (!handleFrame(frame, challengeNumber)) return false;
+            if (challengeNumber > 0) {
+                if (answered++ == 0) first = challengeNumber;
+                last = challengeNumber;
+            }
+            return true;
+        });
+        if (!ok) {
+            emit newLogMessage("Client: Protocol error. Disconnecting.");
+            m_socket->disconnectFromHost();
+            return;
+        }
+    }
+    if (answered == 0) return;
     m_socket->flush();
-}
 
-/**
- * @brief Deserializes a QByteArray into a 32-bit integer.
- * @param input The QByteArray received from the network.
- * @return The deserialized integer.
- */
-int Client::getNumberFromQByteArray(const QByteArray& input) {
-    QDataStream ss(input);
-    qint32 number;
-    ss >> number;
-    return number;
+    if (answered == 1) {
+        emit newLogMessage("Client: Received challenge #" + QString::number(first));
+        emit newLogMessage("Client: Sending response h_" + QString::number(m_config.getNumberOfIterations() - first));
+    } else {
+        emit newLogMessage("Client: Answered " + QString::number(answered) + " challenges, #" + QString::number(first)
+                           + " to #" + QString::number(last));
+    }
 }
 
 /**
- * @brief Serializes a 32-bit integer into a QByteArray for network transmission.
- * @param source The integer to serialize.
- * @return The resulting QByteArray.
+ * @brief Handles one frame from the server: the answer to a resume request,
+ * or a challenge, which is answered with its OTP.
+ * @param frame The frame.
+ * @param challengeNumber Receives the challenge answered, or 0 if it was ignored.
+ * @return False if the frame is malformed or unexpected.
  */
-QByteArray Client::IntToArray(qint32 source) {
-    QByteArray temp;
-    QDataStream data(&temp, QIODevice::ReadWrite);
-    data << source;
-    return temp;
+bool Client::handleFrame(const Protocol::Frame& frame, int& challengeNumber) {
+    challengeNumber = 0;
+    if (m_resuming) {
+        bool accepted = false;
+        std::uint64_t counter = 0;
+        if (!Protocol::decodeResumeAck(frame, accepted, counter)) return false;
+        m_resuming = false;
+        if (!accepted) {
+            // The server no longer knows the chain (or it is in use): start over with a new one
+            emit newLogMessage("Client: Server refused to resume the chain; enrolling a new one.");
+            createChain(); // Enroll follows once the new chain is ready
+            return true;
+        }
+        if (counter > static_cast<std::uint64_t>(m_lastChallenge)) {
+            emit newLogMessage("Client: Warning - server has verified up to challenge #" + QString::number(counter)
+                               + ", beyond the last saved answer #" + QString::number(m_lastChallenge) + ".");
+            m_lastChallenge = static_cast<int>(counter);
+        }
+        emit newLogMessage("Client: Resumed after challenge #" + QString::number(counter) + ".");
+        return true;
+    }
+
+    std::uint64_t counter = 0;
+    if (!Protocol::decodeChallenge(frame, counter)) return false;
+    // Ignore challenges outside the chain
+    if (counter == 0 || counter >= static_cast<std::uint64_t>(m_config.getNumberOfIterations())) return true;
+    challengeNumber = static_cast<int>(counter);
+    if (challengeNumber > m_lastChallenge) m_lastChallenge = challengeNumber;
+
+    // Get the correct OTP from the LamportAuth logic and queue it on the socket
+    std::uint8_t response[Protocol::RESPONSE_FRAME_SIZE];
+    std::size_t size = Protocol::encodeResponse(response, counter, m_auth.getOTPForChallenge(challengeNumber));
+    m_socket->write(reinterpret_cast<const char*>(response), static_cast<qint64>(size));
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,357 @@
+#include "EpollServer.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @brief Constructs an EpollServer with its epoll instance and wake-up eventfd, and has a shared
+ * registry's store wake it after each sync, so that held challenges go out.
+ * @param settings The protocol settings.
+ * @param verbose Whether to print log messages.
+ * @param chains The shared chain registry, or nullptr.
+ * @param admission The shared admission control, or nullptr.
+ * @param config The live configuration, or nullptr.
+ */
+EpollServer::EpollServer(const ServerSettings& settings, bool verbose, ChainRegistry* chains,
+                         AdmissionControl* admission, const LiveConfig* config)
+    : m_core(settings, *this, chains, admission, config), m_verbose(verbose), m_chains(chains)
+{
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    m_wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = m_wake;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &event);
+    if (m_chains) {
+        m_chains->watchDurable(this, [this]() {
+            if (m_core.holdsChallenges()) wake();
+        });
+    }
+}
+
+/**
+ * @brief Closes every connection, the listener and the epoll instance.
+ */
+EpollServer::~EpollServer()
+{
+    // Before the eventfd goes: the store's flusher may be about to write to it
+    if (m_chains) m_chains->unwatchDurable(this);
+    for (auto& connection : m_connections) {
+        if (connection) ::close(connection->fd);
+    }
+    if (m_listener >= 0) ::close(m_listener);
+    if (m_wake >= 0) ::close(m_wake);
+    if (m_epoll >= 0) ::close(m_epoll);
+}
+
+/**
+ * @brief Binds and listens on an address.
+ * @param address The numeric address.
+ * @param port The port.
+ * @param reusePort Whether to set SO_REUSEPORT.
+ * @return True on success.
+ */
+bool EpollServer::listen(const std::string& address, std::uint16_t port, bool reusePort)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+    addrinfo* result = nullptr;
+    std::string service = std::to_string(port);
+    if (::getaddrinfo(address.c_str(), service.c_str(), &hints, &result) != 0) {
+        std::cerr << "Server: Error - Invalid listen address " << address << std::endl;
+        return false;
+    }
+
+    int fd = ::socket(result->ai_family, result->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, result->ai_protocol);
+    int one = 1;
+    bool ok = fd >= 0
+              && ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0
+              && (!reusePort || ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) == 0)
+              && ::bind(fd, result->ai_addr, result->ai_addrlen) == 0
+              && ::listen(fd, SOMAXCONN) == 0;
+    ::freeaddrinfo(result);
+    if (!ok) {
+        std::cerr << "Server: Error - Could not start listening on port " << port << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event);
+    m_listener = fd;
+    log("Server: Started, listening on port " + std::to_string(port));
+    return true;
+}
+
+/**
+ * @brief Runs the event loop: waits for socket events or the next due challenge.
+ */
+void EpollServer::run()
+{
+    // Without a UI to press Start, every client is challenged as soon as it has enrolled
+    m_core.startAuthentication();
+    m_running = true;
+
+    const int MAX_EVENTS = 256;
+    epoll_event events[MAX_EVENTS];
+    while (m_running) {
+        int timeout = static_cast<int>(m_core.msUntilNextTimer());
+        int n = ::epoll_wait(m_epoll, events, MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) {
+            std::cerr << "Server: epoll_wait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == m_listener) {
+                acceptAll();
+            } else if (fd == m_wake) {
+                std::uint64_t count;
+                while (::read(m_wake, &count, sizeof(count)) > 0) {}
+            } else if (static_cast<std::size_t>(fd) < m_connections.size() && m_connections[fd]) {
+                Connection* connection = m_connections[fd].get();
+                if (events[i].events & EPOLLOUT) flushPending(connection);
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) readFrom(connection);
+            }
+            closeBroken();
+        }
+
+        m_core.processTimers();
+        closeBroken();
+    }
+    m_core.stopAuthentication();
+}
+
+/**
+ * @brief Wakes the event loop and makes it return.
+ */
+void EpollServer::stop()
+{
+    m_running = false;
+    wake();
+}
+
+/**
+ * @brief Makes epoll_wait() return, so that the loop processes the core's timers.
+ */
+void EpollServer::wake()
+{
+    std::uint64_t one = 1;
+    ssize_t written = ::write(m_wake, &one, sizeof(one));
+    (void)written;
+}
+
+/**
+ * @brief Gets the number of connected clients.
+ * @return The number of open sessions.
+ */
+std::size_t EpollServer::sessionCount() const
+{
+    return m_core.sessionCount();
+}
+
+/**
+ * @brief Accepts pending connections until the backlog is empty.
+ */
+void EpollServer::acceptAll()
+{
+    for (;;) {
+        sockaddr_storage peer = {};
+        socklen_t peerLen = sizeof(peer);
+        int fd = ::accept4(m_listener, reinterpret_cast<sockaddr*>(&peer), &peerLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN, or an error the next event will report again
+
+        // A source over its rate is turned away before anything is allocated for it
+        std::uint64_t source = AdmissionControl::sourceKey(peer);
+        if (!m_core.admitConnection(source)) {
+            ::close(fd);
+            continue;
+        }
+
+        // Challenges and responses are small and latency bound
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            ::close(fd);
+            continue;
+        }
+
+        if (static_cast<std::size_t>(fd) >= m_connections.size()) m_connections.resize(fd + 1);
+        m_connections[fd].reset(new Connection());
+        Connection* connection = m_connections[fd].get();
+        connection->fd = fd;
+        connection->session = m_core.openSession(connection, source);
+
+        if (m_verbose) {
+            char host[NI_MAXHOST] = "?";
+            ::getnameinfo(reinterpret_cast<sockaddr*>(&peer), peerLen, host, sizeof(host), nullptr, 0, NI_NUMERICHOST);
+            log(ServerCore::sessionLabel(connection->session) + "New connection from: " + host);
+        }
+    }
+}
+
+/**
+ * @brief Reads a connection until the socket is drained, passing every read to the core.
+ * @param connection The connection.
+ */
+void EpollServer::readFrom(Connection* connection)
+{
+    for (;;) {
+        ssize_t size = ::recv(connection->fd, m_readBuffer, sizeof(m_readBuffer), 0);
+        if (size > 0) {
+            if (!m_core.receive(connection->session, m_readBuffer, static_cast<std::size_t>(size))) {
+                closeConnection(connection);
+                return;
+            }
+            if (connection->broken) return;
+            continue;
+        }
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (size < 0 && errno == EINTR) continue;
+        log(ServerCore::sessionLabel(connection->session) + "Client has disconnected.");
+        closeConnection(connection);
+        return;
+    }
+}
+
+/**
+ * @brief Sends frames from the core; whatever the kernel does not accept is kept until the socket is writable.
+ * @param connection The Connection.
+ * @param data The bytes.
+ * @param len The number of bytes.
+ */
+void EpollServer::send(void* connection, const std::uint8_t* data, std::size_t len)
+{
+    Connection* target = static_cast<Connection*>(connection);
+    if (target->broken) return;
+    if (!target->pending.empty()) {
+        target->pending.insert(target->pending.end(), data, data + len);
+        return;
+    }
+
+    ssize_t written = ::send(target->fd, data, len, MSG_NOSIGNAL);
+    if (written < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            target->broken = true;
+            m_broken.push_back(target->fd);
+            return;
+        }
+        written = 0;
+    }
+    if (static_cast<std::size_t>(written) < len) {
+        target->pending.assign(data + written, data + len);
+        watchWritable(target, true);
+    }
+}
+
+/**
+ * @brief Writes pending bytes once the socket is writable again.
+ * @param connection The connection.
+ */
+void EpollServer::flushPending(Connection* connection)
+{
+    while (!connection->pending.empty()) {
+        ssize_t written = ::send(connection->fd, connection->pending.data(), connection->pending.size(), MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            if (errno == EINTR) continue;
+            connection->broken = true;
+            m_broken.push_back(connection->fd);
+            return;
+        }
+        connection->pending.erase(connection->pending.begin(), connection->pending.begin() + written);
+    }
+    watchWritable(connection, false);
+}
+
+/**
+ * @brief Switches a connection between read-only and read/write readiness.
+ * @param connection The connection.
+ * @param enable Whether to watch for writability.
+ */
+void EpollServer::watchWritable(Connection* connection, bool enable)
+{
+    epoll_event event = {};
+    event.events = enable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.fd = connection->fd;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+/**
+ * @brief Closes a connection: removes it from epoll, closes the socket and the session.
+ * @param connection The connection; invalid afterwards.
+ */
+void EpollServer::closeConnection(Connection* connection)
+{
+    int fd = connection->fd;
+    m_core.closeSession(connection->session);
+    ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    m_connections[fd].reset();
+}
+
+/**
+ * @brief Closes the connections whose write failed.
+ */
+void EpollServer::closeBroken()
+{
+    for (int fd : m_broken) {
+        if (static_cast<std::size_t>(fd) >= m_connections.size() || !m_connections[fd]) continue;
+        log(ServerCore::sessionLabel(m_connections[fd]->session) + "Client has disconnected.");
+        closeConnection(m_connections[fd].get());
+    }
+    m_broken.clear();
+}
+
+/**
+ * @brief Closes a connection the core has timed out, after the current event like a failed write.
+ * @param connection The Connection.
+ */
+void EpollServer::drop(void* connection)
+{
+    Connection* target = static_cast<Connection*>(connection);
+    if (target->broken) return;
+    target->broken = true;
+    m_broken.push_back(target->fd);
+}
+
+/**
+ * @brief Prints a log message of the core when running verbosely.
+ * One fwrite per line keeps the lines of several reactor threads whole.
+ * @param message The message.
+ */
+void EpollServer::log(const std::string& message)
+{
+    if (!m_verbose) return;
+    std::string line = message + '\n';
+    std::fwrite(line.data(), 1, line.size(), stdout);
+}
+
+/**
+ * @brief Tells the core whether its per-round messages would be printed.
+ * @return True when running verbosely.
+ */
+bool EpollServer::verbose() const
+{
+    return m_verbose;
+}
\ No newline at end of file
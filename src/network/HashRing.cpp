@@ -0,0 +1,123 @@
+#include "HashRing.hpp"
+#include "Sha256.hpp"
+
+#include <algorithm>
+
+namespace {
+
+    /**
+     * @brief Reads the first 8 bytes of a digest as a big-endian ring position.
+     * @param digest The digest.
+     * @return The position.
+     */
+    std::uint64_t positionOf(const std::uint8_t* digest)
+    {
+        std::uint64_t position = 0;
+        for (int i = 0; i < 8; ++i) position = (position << 8) | digest[i];
+        return position;
+    }
+}
+
+/**
+ * @brief Adds a shard and places its points.
+ * @param name The shard name.
+ * @return False if already present.
+ */
+bool HashRing::addShard(const std::string& name)
+{
+    if (std::find(shards.begin(), shards.end(), name) != shards.end()) return false;
+    shards.push_back(name);
+    rebuild();
+    return true;
+}
+
+/**
+ * @brief Removes a shard and its points.
+ * @param name The shard name.
+ * @return False if absent.
+ */
+bool HashRing::removeShard(const std::string& name)
+{
+    auto it = std::find(shards.begin(), shards.end(), name);
+    if (it == shards.end()) return false;
+    shards.erase(it);
+    rebuild();
+    return true;
+}
+
+/**
+ * @brief Gets the number of shards.
+ * @return The shard count.
+ */
+std::size_t HashRing::shardCount() const
+{
+    return shards.size();
+}
+
+/**
+ * @brief Gets the name of a shard.
+ * @param shard The shard index.
+ * @return The name.
+ */
+const std::string& HashRing::shardName(std::size_t shard) const
+{
+    return shards[shard];
+}
+
+/**
+ * @brief Finds the first point at or after the anchor's position, wrapping around the ring.
+ * @param anchor The anchor.
+ * @return The owning shard, or NONE.
+ */
+std::size_t HashRing::shardFor(const Digest& anchor) const
+{
+    if (points.empty()) return NONE;
+    // Anchors are chosen by clients; hashing them again spreads even crafted ones over the ring
+    std::uint8_t digest[Sha256::DIGEST_SIZE];
+    Sha256::hash(anchor.data(), Digest::SIZE, digest);
+    std::uint64_t position = positionOf(digest);
+    auto it = std::lower_bound(points.begin(), points.end(), position,
+                               [](const Point& point, std::uint64_t value) { return point.position < value; });
+    if (it == points.end()) it = points.begin();
+    return it->shard;
+}
+
+/**
+ * @brief Sums the arcs that end at each shard's points.
+ * @return The fraction of the ring per shard.
+ */
+std::vector<double> HashRing::shares() const
+{
+    std::vector<double> result(shards.size(), 0.0);
+    if (points.empty()) return result;
+    const double ring = 18446744073709551616.0; // 2^64
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        // The arc from the previous point (exclusive) up to this one; unsigned wrap handles the first point
+        std::uint64_t previous = points[i == 0 ? points.size() - 1 : i - 1].position;
+        std::uint64_t arc = points[i].position - previous;
+        result[points[i].shard] += (points.size() == 1 ? ring : static_cast<double>(arc)) / ring;
+    }
+    return result;
+}
+
+/**
+ * @brief Places VIRTUAL_NODES points per shard at SHA-256("<name>#<i>") and sorts them.
+ */
+void HashRing::rebuild()
+{
+    points.clear();
+    points.reserve(shards.size() * VIRTUAL_NODES);
+    std::uint8_t digest[Sha256::DIGEST_SIZE];
+    for (std::size_t shard = 0; shard < shards.size(); ++shard) {
+        for (unsigned i = 0; i < VIRTUAL_NODES; ++i) {
+            std::string key = shards[shard] + "#" + std::to_string(i);
+            Sha256::hash(reinterpret_cast<const std::uint8_t*>(key.data()), key.size(), digest);
+            points.push_back(Point{positionOf(digest), static_cast<std::uint32_t>(shard)});
+        }
+    }
+    // Ties are broken by name, not by index, so that the owners do not depend on the order of the shard list
+    std::sort(points.begin(), points.end(), [this](const Point& a, const Point& b) {
+        if (a.position != b.position) return a.position < b.position;
+        return shards[a.shard] < shards[b.shard];
+    });
+}
@@ -0,0 +1,473 @@
+#include "LoadGenerator.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+    const std::uint64_t WAKE = UINT64_MAX;           ///< epoll key of the wake-up eventfd.
+    const std::int64_t RETRY_DELAY = 1000000;        ///< Microseconds before a failed session reconnects.
+    const std::size_t RESPONSE_CHUNK = 64;           ///< Responses encoded per write.
+    const int CONNECT_BATCH = 8;                     ///< Connects (and chains built) per loop iteration, between socket events.
+}
+
+/**
+ * @brief Adds another set of histograms to this one.
+ * @param other The histograms to add.
+ */
+void LoadGenerator::Latencies::merge(const Latencies& other)
+{
+    connect.merge(other.connect);
+    enroll.merge(other.enroll);
+    verify.merge(other.verify);
+    round.merge(other.round);
+}
+
+/**
+ * @brief Constructs a LoadGenerator with its epoll instance and wake-up eventfd, and queues every session.
+ * @param options What the sessions do.
+ * @param sessions The number of sessions.
+ */
+LoadGenerator::LoadGenerator(const Options& options, std::size_t sessions)
+    : m_options(options)
+{
+    m_options.rounds = std::max(1, m_options.rounds);
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    m_wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &event);
+
+    for (std::size_t i = 0; i < sessions; ++i) {
+        m_sessions.push_back(std::make_unique<Session>());
+        m_connectQueue.push(i);
+    }
+}
+
+/**
+ * @brief Closes every session, the eventfd and the epoll instance.
+ */
+LoadGenerator::~LoadGenerator()
+{
+    for (auto& session : m_sessions) {
+        if (session->socket >= 0) ::close(session->socket);
+    }
+    if (m_wake >= 0) ::close(m_wake);
+    if (m_epoll >= 0) ::close(m_epoll);
+}
+
+/**
+ * @brief Resolves a numeric host and port.
+ * @param host The address.
+ * @param port The port.
+ * @param options Receives the address.
+ * @return True on success.
+ */
+bool LoadGenerator::resolve(const std::string& host, std::uint16_t port, Options& options)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    addrinfo* result = nullptr;
+    if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) return false;
+    std::memcpy(&options.server, result->ai_addr, result->ai_addrlen);
+    options.serverLength = result->ai_addrlen;
+    ::freeaddrinfo(result);
+    return true;
+}
+
+/**
+ * @brief Gets the steady clock in microseconds.
+ * @return The time.
+ */
+std::int64_t LoadGenerator::now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Runs the reactor: paced connects, timers, then socket events.
+ */
+void LoadGenerator::run()
+{
+    m_nextConnect = now();
+    epoll_event events[256];
+
+    while (m_running.load(std::memory_order_acquire)) {
+        std::int64_t time = now();
+        while (!m_timers.empty() && m_timers.top().due <= time) {
+            Timer timer = m_timers.top();
+            m_timers.pop();
+            if (timer.kind == TimerKind::Reconnect) {
+                m_connectQueue.push(timer.session);
+            } else {
+                m_sessions[timer.session]->responseTimer = false;
+                respond(timer.session, time);
+            }
+        }
+        connectQueued(time);
+
+        // Sleep until the next timer or paced connect, rounded up to the next millisecond
+        std::int64_t wait = m_timers.empty() ? -1 : m_timers.top().due - time;
+        if (!m_connectQueue.empty()) {
+            std::int64_t connectWait = m_options.connectRate > 0 ? m_nextConnect - time : 0;
+            wait = wait < 0 ? connectWait : std::min(wait, connectWait);
+        }
+        int timeout = wait < 0 ? -1 : static_cast<int>((std::max<std::int64_t>(wait, 0) + 999) / 1000);
+
+        int count = ::epoll_wait(m_epoll, events, 256, timeout);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "LoadGen: Error - epoll_wait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.u64 == WAKE) continue;
+            std::size_t index = static_cast<std::size_t>(events[i].data.u64);
+            Session& session = *m_sessions[index];
+            // A session closed earlier in this batch has no socket left
+            if (session.socket < 0) continue;
+            if (session.phase == Phase::Connecting) {
+                connected(index);
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) readable(index);
+            if (session.socket >= 0 && (events[i].events & EPOLLOUT)) flush(index);
+        }
+    }
+}
+
+/**
+ * @brief Makes run() return.
+ */
+void LoadGenerator::stop()
+{
+    m_running.store(false, std::memory_order_release);
+    std::uint64_t one = 1;
+    ssize_t written = ::write(m_wake, &one, sizeof(one));
+    (void)written;
+}
+
+/**
+ * @brief Copies the histograms.
+ * @return The copy.
+ */
+LoadGenerator::Latencies LoadGenerator::latencies() const
+{
+    std::lock_guard<std::mutex> lock(m_latencyLock);
+    return m_latencies;
+}
+
+/**
+ * @brief Records a latency.
+ * @param histogram The histogram.
+ * @param micros The latency.
+ */
+void LoadGenerator::record(LatencyHistogram& histogram, std::int64_t micros)
+{
+    std::lock_guard<std::mutex> lock(m_latencyLock);
+    histogram.record(static_cast<std::uint64_t>(std::max<std::int64_t>(micros, 0)));
+}
+
+/**
+ * @brief Opens queued connections at the connection rate, a batch at a time so that
+ * connects already under way are completed and timed without waiting for the whole queue.
+ * @param time The current time.
+ */
+void LoadGenerator::connectQueued(std::int64_t time)
+{
+    for (int opened = 0; opened < CONNECT_BATCH && !m_connectQueue.empty(); ++opened) {
+        if (m_options.connectRate > 0) {
+            if (time < m_nextConnect) return;
+            // A late wake-up may catch up on one millisecond of connects, not on a whole idle stretch
+            m_nextConnect = std::max(m_nextConnect, time - 1000)
+                            + static_cast<std::int64_t>(1e6 / m_options.connectRate);
+        }
+        std::size_t index = m_connectQueue.front();
+        m_connectQueue.pop();
+        connect(index);
+    }
+}
+
+/**
+ * @brief Builds a fresh chain and starts a non-blocking connect.
+ * @param index The session.
+ */
+void LoadGenerator::connect(std::size_t index)
+{
+    Session& session = *m_sessions[index];
+    // A new random seed per connection: the server never lets an anchor enroll twice
+    session.chain.initChain(CryptoUtils::generateRandomSeed(16), m_options.rounds + 1, m_options.params);
+    session.parser = Protocol::FrameParser();
+    session.queued.clear();
+    session.output.clear();
+    session.lastChallenge = 0;
+    session.lastResponse = 0;
+    session.nextResponse = 0;
+    session.finished = false;
+
+    int fd = ::socket(m_options.server.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        m_counters.failures.fetch_add(1, std::memory_order_relaxed);
+        m_timers.push(Timer{now() + RETRY_DELAY, index, TimerKind::Reconnect});
+        return;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    m_counters.connects.fetch_add(1, std::memory_order_relaxed);
+    session.phaseStart = now();
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&m_options.server), m_options.serverLength) < 0
+        && errno != EINPROGRESS) {
+        ::close(fd);
+        m_counters.failures.fetch_add(1, std::memory_order_relaxed);
+        m_timers.push(Timer{now() + RETRY_DELAY, index, TimerKind::Reconnect});
+        return;
+    }
+    session.socket = fd;
+    session.phase = Phase::Connecting;
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.u64 = index;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event);
+}
+
+/**
+ * @brief Checks the outcome of a connect and enrolls the session's chain.
+ * @param index The session.
+ */
+void LoadGenerator::connected(std::size_t index)
+{
+    Session& session = *m_sessions[index];
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (::getsockopt(session.socket, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+        disconnect(index, true);
+        return;
+    }
+    std::int64_t time = now();
+    record(m_latencies.connect, time - session.phaseStart);
+    m_counters.active.fetch_add(1, std::memory_order_relaxed);
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = index;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, session.socket, &event);
+
+    session.phase = Phase::Enrolling;
+    session.phaseStart = time;
+    std::uint8_t frame[Protocol::ENROLL_FRAME_SIZE];
+    std::size_t size = Protocol::encodeEnroll(frame, m_options.params, session.chain.getLastHash());
+    send(index, frame, size);
+}
+
+/**
+ * @brief Drains the socket, then answers the challenges that arrived.
+ * @param index The session.
+ */
+void LoadGenerator::readable(std::size_t index)
+{
+    Session& session = *m_sessions[index];
+    for (;;) {
+        ssize_t n = ::read(session.socket, m_readBuffer, sizeof(m_readBuffer));
+        if (n > 0) {
+            // Every frame of one read arrived at the same time
+            std::int64_t time = now();
+            if (!session.parser.feed(m_readBuffer, static_cast<std::size_t>(n),
+                                     [&](const Protocol::Frame& frame) { return handleFrame(index, frame, time); })) {
+                disconnect(index, true);
+                return;
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        // End of stream: expected once the last response is out, a failure before
+        disconnect(index, !session.finished);
+        return;
+    }
+    if (!session.responseTimer) respond(index, now());
+}
+
+/**
+ * @brief Queues a challenge and records the latencies its arrival ends.
+ * @param index The session.
+ * @param frame The frame.
+ * @param time When it was read.
+ * @return False if the frame is not a challenge.
+ */
+bool LoadGenerator::handleFrame(std::size_t index, const Protocol::Frame& frame, std::int64_t time)
+{
+    Session& session = *m_sessions[index];
+    std::uint64_t counter = 0;
+    if (!Protocol::decodeChallenge(frame, counter)) return false;
+
+    if (session.phase == Phase::Enrolling) {
+        record(m_latencies.enroll, time - session.phaseStart);
+        m_counters.enrolled.fetch_add(1, std::memory_order_relaxed);
+        session.phase = Phase::Running;
+    }
+    if (session.lastResponse != 0) {
+        record(m_latencies.verify, time - session.lastResponse);
+        session.lastResponse = 0;
+    }
+    // Challenges that share a read are one round
+    if (session.lastChallenge != time) {
+        if (session.lastChallenge != 0) record(m_latencies.round, time - session.lastChallenge);
+        session.lastChallenge = time;
+    }
+    // A pipelining server may run past the chain; those challenges are left unanswered
+    if (counter >= 1 && counter <= static_cast<std::uint64_t>(m_options.rounds) && !session.finished) {
+        session.queued.push_back(counter);
+    }
+    return true;
+}
+
+/**
+ * @brief Answers queued challenges in one write: all of them, or one per interval under roundRate.
+ * @param index The session.
+ * @param time The current time.
+ */
+void LoadGenerator::respond(std::size_t index, std::int64_t time)
+{
+    Session& session = *m_sessions[index];
+    if (session.socket < 0 || session.phase != Phase::Running || session.queued.empty()) return;
+
+    std::int64_t interval = m_options.roundRate > 0 ? static_cast<std::int64_t>(1e6 / m_options.roundRate) : 0;
+    std::uint8_t frames[RESPONSE_CHUNK * Protocol::RESPONSE_FRAME_SIZE];
+    std::size_t answered = 0;
+    while (answered < session.queued.size() && !session.finished) {
+        std::size_t size = 0;
+        for (std::size_t k = 0; k < RESPONSE_CHUNK && answered < session.queued.size(); ++k) {
+            if (interval > 0) {
+                if (time < session.nextResponse) break;
+                session.nextResponse = std::max(session.nextResponse, time - interval) + interval;
+            }
+            std::uint64_t counter = session.queued[answered++];
+            Digest otp = session.chain.getOTPForChallenge(static_cast<int>(counter));
+            size += Protocol::encodeResponse(frames + size, counter, otp);
+            if (counter == static_cast<std::uint64_t>(m_options.rounds)) {
+                session.finished = true;
+                break;
+            }
+        }
+        if (size == 0) break;
+        m_counters.rounds.fetch_add(size / Protocol::RESPONSE_FRAME_SIZE, std::memory_order_relaxed);
+        session.lastResponse = time;
+        if (!send(index, frames, size)) return;
+    }
+    session.queued.erase(session.queued.begin(), session.queued.begin() + static_cast<std::ptrdiff_t>(answered));
+
+    if (session.finished) {
+        m_counters.completed.fetch_add(1, std::memory_order_relaxed);
+        session.queued.clear();
+        // The server closes the session on our end of stream, which then ends the connection cleanly
+        if (session.output.empty()) ::shutdown(session.socket, SHUT_WR);
+    } else if (!session.queued.empty() && interval > 0 && !session.responseTimer) {
+        session.responseTimer = true;
+        m_timers.push(Timer{session.nextResponse, index, TimerKind::Respond});
+    }
+}
+
+/**
+ * @brief Writes bytes, or queues them behind earlier ones.
+ * @param index The session.
+ * @param data The bytes.
+ * @param size The number of bytes.
+ * @return True unless the connection was closed.
+ */
+bool LoadGenerator::send(std::size_t index, const std::uint8_t* data, std::size_t size)
+{
+    Session& session = *m_sessions[index];
+    if (!session.output.empty()) {
+        session.output.insert(session.output.end(), data, data + size);
+        return true;
+    }
+    while (size > 0) {
+        ssize_t n = ::send(session.socket, data, size, MSG_NOSIGNAL);
+        if (n > 0) {
+            data += n;
+            size -= static_cast<std::size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            session.output.assign(data, data + size);
+            epoll_event event = {};
+            event.events = EPOLLIN | EPOLLOUT;
+            event.data.u64 = index;
+            ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, session.socket, &event);
+            return true;
+        }
+        disconnect(index, true);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes pending output and stops watching for writability once it is out.
+ * @param index The session.
+ * @return True unless the connection was closed.
+ */
+bool LoadGenerator::flush(std::size_t index)
+{
+    Session& session = *m_sessions[index];
+    std::size_t sent = 0;
+    while (sent < session.output.size()) {
+        ssize_t n = ::send(session.socket, session.output.data() + sent, session.output.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += static_cast<std::size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        disconnect(index, true);
+        return false;
+    }
+    session.output.erase(session.output.begin(), session.output.begin() + static_cast<std::ptrdiff_t>(sent));
+    if (!session.output.empty()) return true;
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = index;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, session.socket, &event);
+    if (session.finished) ::shutdown(session.socket, SHUT_WR);
+    return true;
+}
+
+/**
+ * @brief Closes a session's connection and queues or schedules the next one.
+ * @param index The session.
+ * @param failed Whether the connection ended early.
+ */
+void LoadGenerator::disconnect(std::size_t index, bool failed)
+{
+    Session& session = *m_sessions[index];
+    ::close(session.socket);
+    session.socket = -1;
+    if (session.phase == Phase::Enrolling || session.phase == Phase::Running) {
+        m_counters.active.fetch_sub(1, std::memory_order_relaxed);
+    }
+    session.phase = Phase::Idle;
+    session.queued.clear();
+    session.output.clear();
+    if (failed) {
+        m_counters.failures.fetch_add(1, std::memory_order_relaxed);
+        m_timers.push(Timer{now() + RETRY_DELAY, index, TimerKind::Reconnect});
+    } else {
+        m_connectQueue.push(index);
+    }
+}
@@ -0,0 +1,197 @@
+#include "Protocol.hpp"
+
+namespace Protocol {
+
+    /**
+     * @brief Writes a frame header.
+     * @param out The frame buffer.
+     * @param type The message type.
+     * @param length The payload length.
+     */
+    static void writeHeader(std::uint8_t* out, MessageType type, std::size_t length)
+    {
+        out[0] = VERSION;
+        out[1] = static_cast<std::uint8_t>(type);
+        out[2] = static_cast<std::uint8_t>(length >> 8);
+        out[3] = static_cast<std::uint8_t>(length);
+    }
+
+    /**
+     * @brief Writes a 64-bit integer as 8 big-endian bytes.
+     */
+    static void writeU64(std::uint8_t* out, std::uint64_t value)
+    {
+        for (int i = 7; i >= 0; --i) {
+            out[i] = static_cast<std::uint8_t>(value);
+            value >>= 8;
+        }
+    }
+
+    /**
+     * @brief Reads a 64-bit integer from 8 big-endian bytes.
+     */
+    static std::uint64_t readU64(const std::uint8_t* in)
+    {
+        std::uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) value = (value << 8) | in[i];
+        return value;
+    }
+
+    /**
+     * @brief Writes an Enroll frame.
+     * @param out The frame buffer.
+     * @param chainParams The chain parameters.
+     * @param anchor The anchor h_n.
+     * @return The frame size.
+     */
+    std::size_t encodeEnroll(std::uint8_t* out, const ChainParams& chainParams, const Digest& anchor)
+    {
+        writeHeader(out, MessageType::Enroll, ENROLL_FRAME_SIZE - HEADER_SIZE);
+        out[HEADER_SIZE] = static_cast<std::uint8_t>(chainParams.format);
+        out[HEADER_SIZE + 1] = static_cast<std::uint8_t>(chainParams.algorithm);
+        std::memcpy(out + HEADER_SIZE + 2, anchor.data(), Digest::SIZE);
+        return ENROLL_FRAME_SIZE;
+    }
+
+    /**
+     * @brief Writes a Challenge frame.
+     * @param out The frame buffer.
+     * @param counter The challenge counter.
+     * @return The frame size.
+     */
+    std::size_t encodeChallenge(std::uint8_t* out, std::uint64_t counter)
+    {
+        writeHeader(out, MessageType::Challenge, CHALLENGE_FRAME_SIZE - HEADER_SIZE);
+        writeU64(out + HEADER_SIZE, counter);
+        return CHALLENGE_FRAME_SIZE;
+    }
+
+    /**
+     * @brief Writes a Response frame.
+     * @param out The frame buffer.
+     * @param counter The challenge counter being answered.
+     * @param otp The OTP.
+     * @return The frame size.
+     */
+    std::size_t encodeResponse(std::uint8_t* out, std::uint64_t counter, const Digest& otp)
+    {
+        writeHeader(out, MessageType::Response, RESPONSE_FRAME_SIZE - HEADER_SIZE);
+        writeU64(out + HEADER_SIZE, counter);
+        std::memcpy(out + HEADER_SIZE + 8, otp.data(), Digest::SIZE);
+        return RESPONSE_FRAME_SIZE;
+    }
+
+    /**
+     * @brief Writes a Resume frame.
+     * @param out The frame buffer.
+     * @param anchor The anchor of the chain.
+     * @return The frame size.
+     */
+    std::size_t encodeResume(std::uint8_t* out, const Digest& anchor)
+    {
+        writeHeader(out, MessageType::Resume, RESUME_FRAME_SIZE - HEADER_SIZE);
+        std::memcpy(out + HEADER_SIZE, anchor.data(), Digest::SIZE);
+        return RESUME_FRAME_SIZE;
+    }
+
+    /**
+     * @brief Writes a ResumeAck frame.
+     * @param out The frame buffer.
+     * @param accepted Whether the chain was resumed.
+     * @param counter The last verified counter.
+     * @return The frame size.
+     */
+    std::size_t encodeResumeAck(std::uint8_t* out, bool accepted, std::uint64_t counter)
+    {
+        writeHeader(out, MessageType::ResumeAck, RESUME_ACK_FRAME_SIZE - HEADER_SIZE);
+        out[HEADER_SIZE] = accepted ? 1 : 0;
+        writeU64(out + HEADER_SIZE + 1, counter);
+        return RESUME_ACK_FRAME_SIZE;
+    }
+
+    /**
+     * @brief Decodes an Enroll frame, rejecting unknown chain formats and hash algorithms.
+     * @param frame The frame.
+     * @param chainParams Receives the chain parameters.
+     * @param anchor Receives the anchor.
+     * @return True on success.
+     */
+    bool decodeEnroll(const Frame& frame, ChainParams& chainParams, Digest& anchor)
+    {
+        if (frame.type != MessageType::Enroll || frame.length != ENROLL_FRAME_SIZE - HEADER_SIZE) return false;
+
+        ChainParams decoded;
+        switch (frame.payload[0]) {
+            case static_cast<std::uint8_t>(ChainFormat::HexV1): decoded.format = ChainFormat::HexV1; break;
+            case static_cast<std::uint8_t>(ChainFormat::BinaryV2): decoded.format = ChainFormat::BinaryV2; break;
+            default: return false;
+        }
+        switch (frame.payload[1]) {
+            case static_cast<std::uint8_t>(HashAlgorithm::Sha256): decoded.algorithm = HashAlgorithm::Sha256; break;
+            case static_cast<std::uint8_t>(HashAlgorithm::Sha512_256): decoded.algorithm = HashAlgorithm::Sha512_256; break;
+            case static_cast<std::uint8_t>(HashAlgorithm::Blake2s): decoded.algorithm = HashAlgorithm::Blake2s; break;
+            default: return false;
+        }
+
+        std::memcpy(anchor.data(), frame.payload + 2, Digest::SIZE);
+        chainParams = decoded;
+        return true;
+    }
+
+    /**
+     * @brief Decodes a Challenge frame.
+     * @param frame The frame.
+     * @param counter Receives the challenge counter.
+     * @return True on success.
+     */
+    bool decodeChallenge(const Frame& frame, std::uint64_t& counter)
+    {
+        if (frame.type != MessageType::Challenge || frame.length != CHALLENGE_FRAME_SIZE - HEADER_SIZE) return false;
+        counter = readU64(frame.payload);
+        return true;
+    }
+
+    /**
+     * @brief Decodes a Response frame.
+     * @param frame The frame.
+     * @param counter Receives the challenge counter.
+     * @param otp Receives the OTP.
+     * @return True on success.
+     */
+    bool decodeResponse(const Frame& frame, std::uint64_t& counter, Digest& otp)
+    {
+        if (frame.type != MessageType::Response || frame.length != RESPONSE_FRAME_SIZE - HEADER_SIZE) return false;
+        counter = readU64(frame.payload);
+        std::memcpy(otp.data(), frame.payload + 8, Digest::SIZE);
+        return true;
+    }
+
+    /**
+     * @brief Decodes a Resume frame.
+     * @param frame The frame.
+     * @param anchor Receives the anchor.
+     * @return True on success.
+     */
+    bool decodeResume(const Frame& frame, Digest& anchor)
+    {
+        if (frame.type != MessageType::Resume || frame.length != RESUME_FRAME_SIZE - HEADER_SIZE) return false;
+        std::memcpy(anchor.data(), frame.payload, Digest::SIZE);
+        return true;
+    }
+
+    /**
+     * @brief Decodes a ResumeAck frame.
+     * @param frame The frame.
+     * @param accepted Receives whether the chain was resumed.
+     * @param counter Receives the last verified counter.
+     * @return True on success.
+     */
+    bool decodeResumeAck(const Frame& frame, bool& accepted, std::uint64_t& counter)
+    {
+        if (frame.type != MessageType::ResumeAck || frame.length != RESUME_ACK_FRAME_SIZE - HEADER_SIZE) return false;
+        if (frame.payload[0] > 1) return false;
+        accepted = frame.payload[0] == 1;
+        counter = readU64(frame.payload + 1);
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "ReplicaFence.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+/**
+ * @brief Closes the lock file, which releases the lock.
+ */
+ReplicaFence::~ReplicaFence()
+{
+    if (m_fd >= 0) ::close(m_fd);
+}
+
+/**
+ * @brief Opens the lock file on first use and tries to lock it.
+ * @param socketPath The replica socket.
+ * @return True if the lock is held.
+ */
+bool ReplicaFence::acquire(const std::string& socketPath)
+{
+    if (m_held) return true;
+    if (m_fd < 0) {
+        std::string lockPath = socketPath + ".lock";
+        // Close-on-exec, so that no child process keeps the lock after this one exits
+        m_fd = ::open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (m_fd < 0) {
+            std::cerr << "Server: cannot open " << lockPath << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    m_held = ::flock(m_fd, LOCK_EX | LOCK_NB) == 0;
+    return m_held;
+}
+
+/**
+ * @brief Checks whether the lock is held.
+ * @return True if held.
+ */
+bool ReplicaFence::isHeld() const
+{
+    return m_held;
+}
@@ -0,0 +1,186 @@
+#include "ReplicationReceiver.hpp"
+#include "ChainLog.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief Closes the receiver.
+ */
+ReplicationReceiver::~ReplicationReceiver()
+{
+    close();
+}
+
+/**
+ * @brief Binds and listens on a Unix socket.
+ * @param socketPath The socket path.
+ * @return True on success.
+ */
+bool ReplicationReceiver::listen(const std::string& socketPath)
+{
+    close();
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Standby: invalid socket path " << socketPath << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+
+    m_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0) return false;
+    // A socket file left by a previous run would make bind() fail
+    ::unlink(socketPath.c_str());
+    if (::bind(m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(m_fd, 1) != 0) {
+        std::cerr << "Standby: cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    m_socketPath = socketPath;
+    return true;
+}
+
+/**
+ * @brief Follows primaries until a synchronised one is lost and its fence released.
+ * @param chains The registry.
+ * @param timeoutSeconds The longest silence tolerated.
+ * @param fence The active server's lock.
+ * @return True once the fence is held.
+ */
+bool ReplicationReceiver::follow(ChainRegistry& chains, int timeoutSeconds, ReplicaFence& fence)
+{
+    bool synced = false;
+    while (m_fd >= 0) {
+        // Once synchronised, a primary that exits without reconnecting is noticed by its released fence
+        if (synced) {
+            pollfd listener = {m_fd, POLLIN, 0};
+            int ready = ::poll(&listener, 1, std::max(1, timeoutSeconds) * 1000);
+            if (ready < 0 && errno != EINTR) {
+                std::cerr << "Standby: poll failed: " << std::strerror(errno) << std::endl;
+                return false;
+            }
+            if (ready <= 0) {
+                if (fence.acquire(m_socketPath)) return true;
+                continue;
+            }
+        }
+        int fd = ::accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "Standby: accept failed: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        timeval timeout;
+        timeout.tv_sec = timeoutSeconds;
+        timeout.tv_usec = 0;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        std::cout << "Standby: primary connected." << std::endl;
+
+        bool lost = receive(fd, chains, synced);
+        ::close(fd);
+        if (lost && synced) {
+            if (fence.acquire(m_socketPath)) return true;
+            // Only the link was lost, say to a send timeout: a second active server would diverge
+            std::cerr << "Standby: primary disconnected but still holds " << m_socketPath
+                      << ".lock; waiting for it to reconnect or exit." << std::endl;
+            continue;
+        }
+        // A corrupt stream, or a primary lost before it sent its state: wait for it to reconnect
+        std::cerr << "Standby: primary disconnected " << (lost ? "before synchronising" : "after a corrupt record")
+                  << "; waiting for it to reconnect." << std::endl;
+    }
+    return false;
+}
+
+/**
+ * @brief Closes the listening socket and removes its file.
+ */
+void ReplicationReceiver::close()
+{
+    if (m_fd < 0) return;
+    ::close(m_fd);
+    m_fd = -1;
+    ::unlink(m_socketPath.c_str());
+    m_socketPath.clear();
+}
+
+/**
+ * @brief Reads records from one primary and applies them.
+ * @param fd The connection.
+ * @param chains The registry.
+ * @param synced Set when a full state has been applied.
+ * @return True if the connection closed or timed out, false if a record was corrupt.
+ */
+bool ReplicationReceiver::receive(int fd, ChainRegistry& chains, bool& synced)
+{
+    std::uint8_t buffer[65536];
+    std::size_t held = 0;
+    std::vector<ChainStore::Entry> state;
+    bool inSync = false;
+
+    for (;;) {
+        ssize_t got = ::recv(fd, buffer + held, sizeof(buffer) - held, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return true;
+        held += static_cast<std::size_t>(got);
+
+        std::size_t offset = 0;
+        while (offset < held) {
+            std::size_t size = ChainLog::recordSize(buffer[offset]);
+            if (size == 0) return false;
+            if (held - offset < size) break;
+            ChainLog::Record record;
+            if (!ChainLog::decode(buffer + offset, record)) return false;
+            offset += size;
+
+            switch (record.type) {
+                case ChainLog::RecordType::SyncBegin:
+                    state.clear();
+                    inSync = true;
+                    break;
+                case ChainLog::RecordType::SyncEnd:
+                    if (!inSync) return false;
+                    chains.replaceAll(state);
+                    std::cout << "Standby: synchronised " << state.size() << " chain(s) with the primary." << std::endl;
+                    synced = true;
+                    inSync = false;
+                    std::vector<ChainStore::Entry>().swap(state);
+                    break;
+                case ChainLog::RecordType::Heartbeat:
+                    break;
+                default:
+                    if (!inSync) {
+                        chains.apply(record);
+                    } else if (record.type == ChainLog::RecordType::Enroll) {
+                        // The state comes as an Enroll record followed by the chain's Advance and Exhaust records
+                        state.emplace_back();
+                        state.back().anchor = record.anchor;
+                        state.back().verifier.enroll(record.params, record.anchor);
+                    } else if (record.type == ChainLog::RecordType::Advance && !state.empty()
+                               && state.back().anchor == record.anchor) {
+                        state.back().verifier.enroll(state.back().verifier.chainParams(), record.link);
+                        state.back().verifiedIteration = record.verifiedIteration;
+                    } else if (record.type == ChainLog::RecordType::Exhaust && !state.empty()
+                               && state.back().anchor == record.anchor) {
+                        state.back().exhausted = true;
+                    }
+                    break;
+            }
+        }
+        std::memmove(buffer, buffer + offset, held - offset);
+        held -= offset;
+    }
+}
@@ -0,0 +1,278 @@
+#include "ReplicationSender.hpp"
+#include "ChainLog.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+    const std::chrono::seconds RECONNECT_DELAY(1);   ///< Wait between connection attempts.
+    const std::chrono::seconds HEARTBEAT_INTERVAL(1); ///< Longest silence towards a connected standby.
+    const int SEND_TIMEOUT_SECONDS = 5;              ///< A standby that accepts nothing for this long is dropped.
+    const std::size_t MAX_PENDING = 64u << 20;       ///< Queued bytes beyond which the standby is resynced instead.
+
+    /**
+     * @brief Sends a whole buffer, retrying on short writes and EINTR.
+     * @return True if every byte was sent.
+     */
+    bool sendAll(int fd, const std::uint8_t* data, std::size_t size)
+    {
+        while (size > 0) {
+            ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += sent;
+            size -= static_cast<std::size_t>(sent);
+        }
+        return true;
+    }
+}
+
+/**
+ * @brief Stops the sender.
+ */
+ReplicationSender::~ReplicationSender()
+{
+    stop();
+}
+
+/**
+ * @brief Starts the sender thread.
+ * @param socketPath The standby's socket.
+ * @param resync The full-state callback.
+ */
+void ReplicationSender::start(const std::string& socketPath, std::function<void()> resync)
+{
+    stop();
+    m_socketPath = socketPath;
+    m_resync = std::move(resync);
+    m_pending.clear();
+    m_connected = false;
+    m_resyncNeeded = false;
+    m_stopping = false;
+    m_sender = std::thread([this]() { run(); });
+}
+
+/**
+ * @brief Sends the remaining records and joins the sender thread.
+ */
+void ReplicationSender::stop()
+{
+    if (!m_sender.joinable()) return;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_sender.join();
+}
+
+/**
+ * @brief Checks whether a standby is connected.
+ * @return True if connected.
+ */
+bool ReplicationSender::isConnected() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_connected;
+}
+
+/**
+ * @brief Queues an enrollment.
+ * @param anchor The anchor.
+ * @param verifier The verifier.
+ */
+void ReplicationSender::logEnroll(const Digest& anchor, const ChainVerifier& verifier)
+{
+    std::uint8_t record[ChainLog::MAX_RECORD_SIZE];
+    append(record, ChainLog::encodeEnroll(record, anchor, verifier));
+}
+
+/**
+ * @brief Queues an advance.
+ * @param anchor The anchor.
+ * @param verifier The verifier.
+ * @param verifiedIteration The last verified challenge number.
+ */
+void ReplicationSender::logAdvance(const Digest& anchor, const ChainVerifier& verifier, std::int32_t verifiedIteration)
+{
+    std::uint8_t record[ChainLog::MAX_RECORD_SIZE];
+    append(record, ChainLog::encodeAdvance(record, anchor, verifier, verifiedIteration));
+}
+
+/**
+ * @brief Queues an exhausted chain.
+ * @param anchor The anchor.
+ */
+void ReplicationSender::logExhaust(const Digest& anchor)
+{
+    std::uint8_t record[ChainLog::MAX_RECORD_SIZE];
+    append(record, ChainLog::encodeMarker(record, ChainLog::RecordType::Exhaust, anchor));
+}
+
+/**
+ * @brief Queues a removal.
+ * @param anchor The anchor.
+ */
+void ReplicationSender::logRemove(const Digest& anchor)
+{
+    std::uint8_t record[ChainLog::MAX_RECORD_SIZE];
+    append(record, ChainLog::encodeMarker(record, ChainLog::RecordType::Remove, anchor));
+}
+
+/**
+ * @brief Replaces the queue with SyncBegin, an Enroll and an Advance record per chain (and an Exhaust
+ * record for a used-up one), and SyncEnd.
+ * @param entries Every chain.
+ */
+void ReplicationSender::resend(const std::vector<ChainStore::Entry>& entries)
+{
+    std::vector<std::uint8_t> state;
+    state.reserve((entries.size() + 1) * (ChainLog::ENROLL_RECORD_SIZE + ChainLog::ADVANCE_RECORD_SIZE));
+    std::uint8_t record[ChainLog::MAX_RECORD_SIZE];
+    std::size_t size = ChainLog::encodeMarker(record, ChainLog::RecordType::SyncBegin);
+    state.insert(state.end(), record, record + size);
+    for (const ChainStore::Entry& entry : entries) {
+        size = ChainLog::encodeEnroll(record, entry.anchor, entry.verifier);
+        state.insert(state.end(), record, record + size);
+        size = ChainLog::encodeAdvance(record, entry.anchor, entry.verifier, entry.verifiedIteration);
+        state.insert(state.end(), record, record + size);
+        if (entry.exhausted) {
+            size = ChainLog::encodeMarker(record, ChainLog::RecordType::Exhaust, entry.anchor);
+            state.insert(state.end(), record, record + size);
+        }
+    }
+    size = ChainLog::encodeMarker(record, ChainLog::RecordType::SyncEnd);
+    state.insert(state.end(), record, record + size);
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (!m_connected) return;
+        // Whatever was queued is part of the state now
+        m_pending.swap(state);
+    }
+    m_wake.notify_one();
+}
+
+/**
+ * @brief Queues a record for the sender thread; dropped while no standby is connected.
+ * @param record The record.
+ * @param size Its size.
+ */
+void ReplicationSender::append(const std::uint8_t* record, std::size_t size)
+{
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (!m_connected || m_resyncNeeded) return;
+        if (m_pending.size() + size > MAX_PENDING) {
+            // The standby is too far behind to catch up record by record; it gets the full state again
+            m_pending.clear();
+            m_resyncNeeded = true;
+            wasEmpty = true;
+        } else {
+            wasEmpty = m_pending.empty();
+            m_pending.insert(m_pending.end(), record, record + size);
+        }
+    }
+    // The sender drains the whole buffer each time, so it only needs waking for the first record
+    if (wasEmpty) m_wake.notify_one();
+}
+
+/**
+ * @brief Opens a connection to the standby's Unix socket.
+ * @return The socket, or -1.
+ */
+int ReplicationSender::connectToStandby() const
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (m_socketPath.size() >= sizeof(address.sun_path)) return -1;
+    std::memcpy(address.sun_path, m_socketPath.c_str(), m_socketPath.size());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    // A standby that stops reading must not stall the sender forever
+    timeval timeout;
+    timeout.tv_sec = SEND_TIMEOUT_SECONDS;
+    timeout.tv_usec = 0;
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+/**
+ * @brief Connects to the standby, sends it the full state, then streams batches and heartbeats.
+ */
+void ReplicationSender::run()
+{
+    int fd = -1;
+    std::vector<std::uint8_t> batch;
+    std::unique_lock<std::mutex> guard(m_lock);
+    while (!m_stopping) {
+        if (fd < 0) {
+            guard.unlock();
+            fd = connectToStandby();
+            guard.lock();
+            if (fd < 0) {
+                m_wake.wait_for(guard, RECONNECT_DELAY, [&]() { return m_stopping; });
+                continue;
+            }
+            std::cout << "Replication: streaming to the standby on " << m_socketPath << "." << std::endl;
+            m_connected = true;
+            m_resyncNeeded = true;
+        }
+        if (m_resyncNeeded) {
+            m_resyncNeeded = false;
+            guard.unlock();
+            m_resync();
+            guard.lock();
+        }
+
+        m_wake.wait_for(guard, HEARTBEAT_INTERVAL,
+                        [&]() { return m_stopping || m_resyncNeeded || !m_pending.empty(); });
+        if (m_resyncNeeded) continue;
+        batch.clear();
+        batch.swap(m_pending);
+        if (batch.empty()) {
+            std::uint8_t record[ChainLog::MAX_RECORD_SIZE];
+            std::size_t size = ChainLog::encodeMarker(record, ChainLog::RecordType::Heartbeat);
+            batch.insert(batch.end(), record, record + size);
+        }
+        guard.unlock();
+        bool ok = sendAll(fd, batch.data(), batch.size());
+        guard.lock();
+        if (!ok) {
+            std::cerr << "Replication: lost the standby: " << std::strerror(errno) << std::endl;
+            ::close(fd);
+            fd = -1;
+            m_connected = false;
+            m_resyncNeeded = false;
+            m_pending.clear();
+        }
+    }
+
+    // Hand the standby everything verified before the stop
+    if (fd >= 0) {
+        batch.clear();
+        batch.swap(m_pending);
+        m_connected = false;
+        guard.unlock();
+        sendAll(fd, batch.data(), batch.size());
+        ::close(fd);
+    }
+}
@@ -0,0 +1,526 @@
+#include "Router.hpp"
+#include "Protocol.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/**
+ * @brief Constructs a Router with its epoll instance and wake-up eventfd.
+ * @param verbose Whether to print routed connections.
+ * @param firstFrameTimeout Seconds allowed for a first frame.
+ * @param admission The per-source limits.
+ */
+Router::Router(bool verbose, int firstFrameTimeout, const AdmissionSettings& admission)
+    : m_verbose(verbose), m_firstFrameTimeout(std::max(0, firstFrameTimeout)), m_admission(admission),
+      m_epoch(std::chrono::steady_clock::now())
+{
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    m_wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = m_wake;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &event);
+}
+
+/**
+ * @brief Closes every link, the listener and the epoll instance.
+ */
+Router::~Router()
+{
+    for (auto& link : m_links) {
+        if (!link) continue;
+        ::close(link->client);
+        if (link->shard >= 0) ::close(link->shard);
+    }
+    if (m_listener >= 0) ::close(m_listener);
+    if (m_wake >= 0) ::close(m_wake);
+    if (m_epoll >= 0) ::close(m_epoll);
+}
+
+/**
+ * @brief Resolves a shard address and adds it to the ring.
+ * @param address The "host:port" or "[host]:port".
+ * @return True on success.
+ */
+bool Router::addShard(const std::string& address)
+{
+    std::size_t colon = address.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == address.size()) {
+        std::cerr << "Router: Error - Invalid shard address " << address << std::endl;
+        return false;
+    }
+    std::string host = address.substr(0, colon);
+    std::string service = address.substr(colon + 1);
+    if (host.size() > 2 && host.front() == '[' && host.back() == ']') host = host.substr(1, host.size() - 2);
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    addrinfo* result = nullptr;
+    if (::getaddrinfo(host.c_str(), service.c_str(), &hints, &result) != 0) {
+        std::cerr << "Router: Error - Invalid shard address " << address << std::endl;
+        return false;
+    }
+    if (!m_ring.addShard(address)) {
+        ::freeaddrinfo(result);
+        std::cerr << "Router: Error - Shard " << address << " is listed twice" << std::endl;
+        return false;
+    }
+
+    Shard shard;
+    std::memcpy(&shard.address, result->ai_addr, result->ai_addrlen);
+    shard.addressLength = result->ai_addrlen;
+    shard.load.name = address;
+    ::freeaddrinfo(result);
+    m_shards.push_back(shard);
+
+    std::vector<double> shares = m_ring.shares();
+    for (std::size_t i = 0; i < m_shards.size(); ++i) m_shards[i].load.share = shares[i];
+    return true;
+}
+
+/**
+ * @brief Binds and listens on an address.
+ * @param address The numeric address.
+ * @param port The port.
+ * @return True on success.
+ */
+bool Router::listen(const std::string& address, std::uint16_t port)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+    addrinfo* result = nullptr;
+    std::string service = std::to_string(port);
+    if (::getaddrinfo(address.c_str(), service.c_str(), &hints, &result) != 0) {
+        std::cerr << "Router: Error - Invalid listen address " << address << std::endl;
+        return false;
+    }
+
+    int fd = ::socket(result->ai_family, result->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, result->ai_protocol);
+    int one = 1;
+    bool ok = fd >= 0
+              && ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0
+              && ::bind(fd, result->ai_addr, result->ai_addrlen) == 0
+              && ::listen(fd, SOMAXCONN) == 0;
+    ::freeaddrinfo(result);
+    if (!ok) {
+        std::cerr << "Router: Error - Could not start listening on port " << port << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event);
+    m_listener = fd;
+    return true;
+}
+
+/**
+ * @brief Runs the event loop: accepts clients, routes their first frame and relays their traffic.
+ */
+void Router::run()
+{
+    m_running = true;
+
+    const int MAX_EVENTS = 256;
+    epoll_event events[MAX_EVENTS];
+    while (m_running) {
+        int n = ::epoll_wait(m_epoll, events, MAX_EVENTS, static_cast<int>(m_deadlines.msUntilNext(now())));
+        if (n < 0 && errno != EINTR) {
+            std::cerr << "Router: epoll_wait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            std::uint32_t ready = events[i].events;
+            if (fd == m_listener) {
+                acceptAll();
+                continue;
+            }
+            if (fd == m_wake) {
+                std::uint64_t count;
+                while (::read(m_wake, &count, sizeof(count)) > 0) {}
+                continue;
+            }
+            if (static_cast<std::size_t>(fd) >= m_owners.size() || m_owners[fd] < 0) continue;
+            Link* link = m_links[m_owners[fd]].get();
+
+            if (fd == link->client) {
+                if ((ready & EPOLLOUT) && !flush(link, true)) continue;
+                if (ready & (EPOLLHUP | EPOLLERR)) {
+                    closeLink(link);
+                } else if (ready & EPOLLIN) {
+                    if (link->shard < 0) readFirstFrame(link);
+                    else if (link->connected && link->toShard.empty()) relay(link, true);
+                }
+            } else if (!link->connected) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+                if (error != 0) {
+                    {
+                        std::lock_guard<std::mutex> guard(m_loadLock);
+                        ++m_shards[link->shardIndex].load.unreachable;
+                    }
+                    std::cerr << "Router: shard " << m_shards[link->shardIndex].load.name
+                              << " is unreachable: " << std::strerror(error) << std::endl;
+                    closeLink(link);
+                    continue;
+                }
+                link->connected = true;
+                flush(link, false);
+            } else {
+                if ((ready & EPOLLOUT) && !flush(link, false)) continue;
+                if (ready & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    if (link->toClient.empty()) relay(link, false);
+                    else if (ready & (EPOLLHUP | EPOLLERR)) closeLink(link);
+                }
+            }
+        }
+        expireDeadlines();
+    }
+}
+
+/**
+ * @brief Wakes the event loop and makes it return.
+ */
+void Router::stop()
+{
+    m_running = false;
+    std::uint64_t one = 1;
+    ssize_t written = ::write(m_wake, &one, sizeof(one));
+    (void)written;
+}
+
+/**
+ * @brief Copies the shards' counters.
+ * @return The load per shard.
+ */
+std::vector<Router::ShardLoad> Router::load() const
+{
+    std::lock_guard<std::mutex> guard(m_loadLock);
+    std::vector<ShardLoad> result;
+    result.reserve(m_shards.size());
+    for (const Shard& shard : m_shards) result.push_back(shard.load);
+    return result;
+}
+
+/**
+ * @brief Prints one line per shard.
+ * @param out The stream.
+ */
+void Router::report(std::ostream& out) const
+{
+    std::vector<ShardLoad> shards = load();
+    out << "Router: " << std::left << std::setw(24) << "shard" << std::right << std::setw(8) << "share"
+        << std::setw(9) << "active" << std::setw(11) << "routed" << std::setw(13) << "unreachable"
+        << std::setw(14) << "bytes in" << std::setw(14) << "bytes out" << "\n";
+    for (const ShardLoad& shard : shards) {
+        out << "Router: " << std::left << std::setw(24) << shard.name << std::right
+            << std::setw(7) << std::fixed << std::setprecision(1) << shard.share * 100 << "%"
+            << std::setw(9) << shard.active << std::setw(11) << shard.routed << std::setw(13) << shard.unreachable
+            << std::setw(14) << shard.bytesIn << std::setw(14) << shard.bytesOut << "\n";
+    }
+    out << std::flush;
+}
+
+/**
+ * @brief Gets the time on the steady clock.
+ * @return Milliseconds since construction.
+ */
+std::int64_t Router::now() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+}
+
+/**
+ * @brief Closes the clients whose first-frame deadline has passed; routed clients have none.
+ */
+void Router::expireDeadlines()
+{
+    m_deadlines.advance(now(), [this](std::uint64_t client, std::uint8_t) {
+        Link* link = m_links[client].get();
+        link->deadline = TimerWheel::NONE;
+        if (m_verbose) std::cout << "Router: client sent no first frame in time; dropped" << std::endl;
+        closeLink(link);
+    });
+}
+
+/**
+ * @brief Accepts pending connections until the backlog is empty.
+ */
+void Router::acceptAll()
+{
+    for (;;) {
+        sockaddr_storage peer = {};
+        socklen_t peerLen = sizeof(peer);
+        int fd = ::accept4(m_listener, reinterpret_cast<sockaddr*>(&peer), &peerLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN, or an error the next event will report again
+
+        // A source over its rate is turned away before anything is allocated for it
+        if (!m_admission.admitConnection(AdmissionControl::sourceKey(peer))) {
+            ::close(fd);
+            continue;
+        }
+
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            ::close(fd);
+            continue;
+        }
+
+        if (static_cast<std::size_t>(fd) >= m_links.size()) m_links.resize(fd + 1);
+        if (static_cast<std::size_t>(fd) >= m_owners.size()) m_owners.resize(fd + 1, -1);
+        m_links[fd].reset(new Link());
+        m_links[fd]->client = fd;
+        m_owners[fd] = fd;
+        if (m_firstFrameTimeout > 0) {
+            m_links[fd]->deadline = m_deadlines.schedule(now() + std::int64_t(m_firstFrameTimeout) * 1000,
+                                                         static_cast<std::uint64_t>(fd), 0);
+        }
+    }
+}
+
+/**
+ * @brief Buffers the client's bytes until its first frame is complete, then routes it by its anchor.
+ * @param link The link.
+ * @return False if the link was closed.
+ */
+bool Router::readFirstFrame(Link* link)
+{
+    for (;;) {
+        ssize_t size = ::recv(link->client, m_readBuffer, sizeof(m_readBuffer), 0);
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (size < 0 && errno == EINTR) continue;
+        if (size <= 0) {
+            closeLink(link);
+            return false;
+        }
+        link->toShard.insert(link->toShard.end(), m_readBuffer, m_readBuffer + size);
+        if (link->toShard.size() < Protocol::HEADER_SIZE) continue;
+
+        const std::uint8_t* header = link->toShard.data();
+        std::size_t frameSize = Protocol::HEADER_SIZE + ((std::size_t(header[2]) << 8) | header[3]);
+        if (header[0] != Protocol::VERSION || frameSize > Protocol::MAX_FRAME_SIZE) {
+            closeLink(link);
+            return false;
+        }
+        if (link->toShard.size() < frameSize) continue;
+
+        // Only the identity is needed; the shard checks everything else
+        Protocol::Frame frame{static_cast<Protocol::MessageType>(header[1]), header + Protocol::HEADER_SIZE,
+                              frameSize - Protocol::HEADER_SIZE};
+        Digest anchor;
+        ChainParams chainParams;
+        bool identified = (frame.type == Protocol::MessageType::Enroll && Protocol::decodeEnroll(frame, chainParams, anchor))
+                          || (frame.type == Protocol::MessageType::Resume && Protocol::decodeResume(frame, anchor));
+        if (!identified) {
+            closeLink(link);
+            return false;
+        }
+        return route(link, anchor);
+    }
+}
+
+/**
+ * @brief Opens a non-blocking connection to the shard that owns an identity.
+ * @param link The link.
+ * @param anchor The anchor.
+ * @return True unless the link was closed.
+ */
+bool Router::route(Link* link, const Digest& anchor)
+{
+    std::size_t index = m_ring.shardFor(anchor);
+    if (index == HashRing::NONE) {
+        closeLink(link);
+        return false;
+    }
+    Shard& shard = m_shards[index];
+    m_deadlines.cancel(link->deadline);
+    link->deadline = TimerWheel::NONE;
+    int fd = ::socket(shard.address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        closeLink(link);
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    bool connected = ::connect(fd, reinterpret_cast<const sockaddr*>(&shard.address), shard.addressLength) == 0;
+    if (!connected && errno != EINPROGRESS) {
+        ::close(fd);
+        {
+            std::lock_guard<std::mutex> guard(m_loadLock);
+            ++shard.load.unreachable;
+        }
+        std::cerr << "Router: shard " << shard.load.name << " is unreachable: " << std::strerror(errno) << std::endl;
+        closeLink(link);
+        return false;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLOUT;
+    event.data.fd = fd;
+    if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+        ::close(fd);
+        closeLink(link);
+        return false;
+    }
+    if (static_cast<std::size_t>(fd) >= m_owners.size()) m_owners.resize(fd + 1, -1);
+    m_owners[fd] = link->client;
+    link->shard = fd;
+    link->shardIndex = index;
+    {
+        std::lock_guard<std::mutex> guard(m_loadLock);
+        ++shard.load.active;
+        ++shard.load.routed;
+        shard.load.bytesIn += link->toShard.size();
+    }
+    if (m_verbose) {
+        std::cout << "Router: identity " << anchor.toHex().substr(0, 16) << "... -> " << shard.load.name << std::endl;
+    }
+
+    // The client is not read again until the first frame has reached the shard
+    watch(link);
+    if (connected) {
+        link->connected = true;
+        return flush(link, false);
+    }
+    return true;
+}
+
+/**
+ * @brief Reads one side until it is drained and writes the bytes to the other; what is not accepted is kept.
+ * @param link The link.
+ * @param fromClient The direction.
+ * @return True unless the link was closed.
+ */
+bool Router::relay(Link* link, bool fromClient)
+{
+    int source = fromClient ? link->client : link->shard;
+    int target = fromClient ? link->shard : link->client;
+    std::vector<std::uint8_t>& pending = fromClient ? link->toShard : link->toClient;
+
+    for (;;) {
+        ssize_t size = ::recv(source, m_readBuffer, sizeof(m_readBuffer), 0);
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (size < 0 && errno == EINTR) continue;
+        if (size <= 0) {
+            // Hand over what the closing side sent last, as far as the other side takes it now
+            flush(link, !fromClient);
+            if (m_owners[source] >= 0) closeLink(link);
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> guard(m_loadLock);
+            ShardLoad& load = m_shards[link->shardIndex].load;
+            (fromClient ? load.bytesIn : load.bytesOut) += static_cast<std::uint64_t>(size);
+        }
+
+        ssize_t written = ::send(target, m_readBuffer, static_cast<std::size_t>(size), MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                closeLink(link);
+                return false;
+            }
+            written = 0;
+        }
+        if (written < size) {
+            // The target is full: keep the rest and stop reading the source until it has drained
+            pending.assign(m_readBuffer + written, m_readBuffer + size);
+            watch(link);
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Writes the bytes pending towards one side and resumes reading the other once they are gone.
+ * @param link The link.
+ * @param toClient The direction.
+ * @return True unless the link was closed.
+ */
+bool Router::flush(Link* link, bool toClient)
+{
+    int target = toClient ? link->client : link->shard;
+    std::vector<std::uint8_t>& pending = toClient ? link->toClient : link->toShard;
+    while (!pending.empty()) {
+        ssize_t written = ::send(target, pending.data(), pending.size(), MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            closeLink(link);
+            return false;
+        }
+        pending.erase(pending.begin(), pending.begin() + written);
+    }
+    watch(link);
+    return true;
+}
+
+/**
+ * @brief Watches each socket for reading while nothing is pending towards the other side, and for
+ * writing while something is pending towards it.
+ * @param link The link.
+ */
+void Router::watch(Link* link)
+{
+    epoll_event event = {};
+    event.data.fd = link->client;
+    bool readClient = link->shard < 0 || (link->connected && link->toShard.empty());
+    event.events = (readClient ? std::uint32_t(EPOLLIN) : 0u) | (link->toClient.empty() ? 0u : std::uint32_t(EPOLLOUT));
+    ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, link->client, &event);
+    if (link->shard < 0) return;
+
+    event.data.fd = link->shard;
+    if (!link->connected) {
+        event.events = EPOLLOUT;
+    } else {
+        event.events = (link->toClient.empty() ? std::uint32_t(EPOLLIN) : 0u)
+                       | (link->toShard.empty() ? 0u : std::uint32_t(EPOLLOUT));
+    }
+    ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, link->shard, &event);
+}
+
+/**
+ * @brief Removes both sockets of a link from epoll and closes them.
+ * @param link The link.
+ */
+void Router::closeLink(Link* link)
+{
+    int client = link->client;
+    m_deadlines.cancel(link->deadline);
+    if (link->shard >= 0) {
+        {
+            std::lock_guard<std::mutex> guard(m_loadLock);
+            --m_shards[link->shardIndex].load.active;
+        }
+        ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, link->shard, nullptr);
+        ::close(link->shard);
+        m_owners[link->shard] = -1;
+    }
+    ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, client, nullptr);
+    ::close(client);
+    m_owners[client] = -1;
+    m_links[client].reset();
+}
@@ -1,14 +1,38 @@
 #include "Server.hpp"
-#include <QDataStream>
+#include "LiveConfig.hpp"
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 /**
  * @brief Constructs a Server object.
  * @param filePath Path to the configuration file.
  * @param parent The parent QObject.
+ * @param reusePort Whether to share the port with other servers via SO_REUSEPORT.
+ * @param chains The shared chain registry, or nullptr.
+ * @param admission The shared admission control, or nullptr.
+ * @param liveConfig The watched configuration, or nullptr.
  */
-Server::Server(const QString& filePath, QObject *parent)
-    : QTcpServer(parent), m_config(filePath)
+Server::Server(const QString& filePath, QObject *parent, bool reusePort, ChainRegistry* chains,
+               AdmissionControl* admission, const LiveConfig* liveConfig)
+    : QTcpServer(parent), m_config(filePath), m_reusePort(reusePort),
+      m_core(liveConfig ? liveConfig->snapshot()->serverSettings() : settingsFrom(m_config), *this, chains,
+             admission, liveConfig),
+      m_chains(chains)
 {
+    // One single-shot timer is the tick source for all session timers in the core's timing wheel
+    m_tickTimer.setSingleShot(true);
+    m_tickTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_tickTimer, &QTimer::timeout, this, &Server::processTimers);
+    // After each sync of the store, the challenges the core held for it go out on this thread
+    if (m_chains) {
+        m_chains->watchDurable(this, [this]() {
+            if (m_core.holdsChallenges()) {
+                QMetaObject::invokeMethod(this, [this]() { processTimers(); }, Qt::QueuedConnection);
+            }
+        });
+    }
     startServer();
 }
 
@@ -16,6 +40,7 @@ Server::Server(const QString& filePath, QObject *parent)
  * @brief Destructor for the Server. Ensures the server is stopped cleanly.
  */
 Server::~Server(){
+    if (m_chains) m_chains->unwatchDurable(this);
     stopServer();
 }
 
@@ -29,18 +54,26 @@ bool Server::isListening() const {
 
 /**
  * @brief Checks if there is an active and connected client.
- * @return True if a client is connected, false otherwise.
+ * @return True if at least one client is connected, false otherwise.
  */
 bool Server::hasActiveClient() const {
-    return m_clientSocket != nullptr && m_clientSocket->state() == QAbstractSocket::ConnectedState;
+    return m_core.sessionCount() > 0;
+}
+
+/**
+ * @brief Gets the number of connected clients.
+ * @return The number of open sessions.
+ */
+std::size_t Server::sessionCount() const {
+    return m_core.sessionCount();
 }
 
 /**
  * @brief Checks if the authentication challenge-response process is currently running.
- * @return True if the challenge timer is active, false otherwise.
+ * @return True if challenges are being sent, false otherwise.
  */
 bool Server::isAuthRunning() const {
-    return m_challengeTimer != nullptr && m_challengeTimer->isActive();
+    return m_core.isAuthRunning();
 }
 
 /**
@@ -51,7 +84,8 @@ void Server::startServer()
     quint16 serverPort = m_config.getAlicePort();
     QHostAddress serverIP(m_config.getAliceIP());
     // Attempt to listen on the configured IP and port
-    if(!this->listen(serverIP, serverPort)) {
+    bool listening = m_reusePort ? listenReusePort(serverIP, serverPort) : this->listen(serverIP, serverPort);
+    if(!listening) {
         emit newLogMessage("Server: Error - Could not start listening on port " + QString::number(serverPort));
         return;
     }
@@ -61,14 +95,50 @@ void Server::startServer()
 }
 
 /**
- * @brief Stops the server, disconnects any client, and stops listening.
+ * @brief Binds a listening socket with SO_REUSEPORT set, then adopts it.
+ * QTcpServer::listen() offers no way to set the option before bind().
+ * @param address The address to bind.
+ * @param port The port to bind.
+ * @return True on success.
+ */
+bool Server::listenReusePort(const QHostAddress& address, quint16 port)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+    addrinfo* result = nullptr;
+    std::string host = address.toString().toStdString();
+    std::string service = std::to_string(port);
+    if (getaddrinfo(host.c_str(), service.c_str(), &hints, &result) != 0) return false;
+
+    int fd = ::socket(result->ai_family, result->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, result->ai_protocol);
+    int one = 1;
+    bool ok = fd >= 0
+              && ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0
+              && ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) == 0
+              && ::bind(fd, result->ai_addr, result->ai_addrlen) == 0
+              && ::listen(fd, SOMAXCONN) == 0;
+    freeaddrinfo(result);
+
+    if (ok) ok = this->setSocketDescriptor(fd);
+    if (!ok && fd >= 0) ::close(fd);
+    return ok;
+}
+
+/**
+ * @brief Stops the server, disconnects every client, and stops listening.
  */
 void Server::stopServer() {
     stopAuthentication(); // Ensure the auth process is stopped
-    if (m_clientSocket) {
-        m_clientSocket->disconnectFromHost();
-        m_clientSocket->deleteLater();
-        m_clientSocket = nullptr;
+    std::vector<SessionId> ids;
+    m_core.forEachSession([&](SessionId id, Session&) { ids.push_back(id); });
+    for (SessionId id : ids) {
+        QTcpSocket* socket = static_cast<QTcpSocket*>(m_core.connection(id));
+        socket->disconnect(this);
+        socket->disconnectFromHost();
+        socket->deleteLater();
+        m_core.closeSession(id);
     }
     if (this->isListening()) {
         this->close();
@@ -77,129 +147,145 @@ void Server::stopServer() {
 }
 
 /**
- * @brief Starts the authentication process by initiating a timer to send challenges.
+ * @brief Starts the authentication process: every enrolled session gets its first challenge after sleepDuration.
  */
 void Server::startAuthentication() {
-    // Pre-condition checks
-    if (!hasActiveClient()) {
-        emit newLogMessage("Server: Cannot start, no client connected.");
-        return;
-    }
-    if (m_auth.getLastVerifiedHash().empty()){
-        emit newLogMessage("Server: Cannot start, initial hash (h_n) not yet received.");
-        return;
-    }
-    if (isAuthRunning()) {
-        emit newLogMessage("Server: Authentication process is already running.");
-        return;
-    }
-
-    emit newLogMessage("Server: Starting authentication process...");
-    // Set up a timer to periodically call sendChallenge
-    m_challengeTimer = new QTimer(this);
-    connect(m_challengeTimer, &QTimer::timeout, this, &Server::sendChallenge);
-    m_challengeTimer->start(m_config.getSleepTime() * 1000); // Convert seconds to ms
+    if (!m_core.startAuthentication()) return;
+    armTickTimer();
     emit authProcessStarted();
 }
 
 /**
- * @brief Stops the authentication process and cleans up the timer.
+ * @brief Stops the authentication process and drops every queued challenge.
  */
 void Server::stopAuthentication() {
-    if (isAuthRunning()) {
-        m_challengeTimer->stop();
-        m_challengeTimer->deleteLater();
-        m_challengeTimer = nullptr;
-        m_currentIteration = 1; // Reset iteration counter
-        emit newLogMessage("Server: Authentication process stopped by user.");
-        emit authProcessStopped();
-    }
+    if (!m_core.stopAuthentication()) return;
+    armTickTimer();
+    emit authProcessStopped();
 }
 
 /**
- * @brief Handles a new incoming client connection.
- * Accepts only one client at a time.
+ * @brief Accepts every pending connection, opening one session per client.
  */
 void Server::handleNewConnection()
 {
-    // If a client is already connected, reject the new one
-    if (hasActiveClient()) {
-        this->nextPendingConnection()->disconnectFromHost();
-        return;
-    }
-    // Accept the new connection
-    m_clientSocket = this->nextPendingConnection();
-    if(m_clientSocket) {
-        connect(m_clientSocket, &QTcpSocket::readyRead, this, &Server::receiveResponse);
-        connect(m_clientSocket, &QTcpSocket::disconnected, this, &Server::onClientDisconnected);
-        emit newLogMessage("Server: New connection from: " + m_clientSocket->peerAddress().toString());
+    while (QTcpSocket* socket = this->nextPendingConnection()) {
+        // IPv4 peers map to IPv4-mapped IPv6 addresses, so every source has a 16-byte key
+        Q_IPV6ADDR address = socket->peerAddress().toIPv6Address();
+        std::uint64_t source = AdmissionControl::sourceKey(address.c, sizeof(address.c));
+        if (!m_core.admitConnection(source)) {
+            emit newLogMessage("Server: Refused connection from " + socket->peerAddress().toString()
+                               + ": rate limit exceeded.");
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+        SessionId id = m_core.openSession(socket, source);
+        // The session identifier is bound into the handlers, so no per-event lookup by socket is needed
+        connect(socket, &QTcpSocket::readyRead, this, [this, id]() { receiveResponse(id); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, id]() { onClientDisconnected(id); });
+        emit newLogMessage(QString::fromStdString(ServerCore::sessionLabel(id)) + "New connection from: "
+                           + socket->peerAddress().toString());
         emit clientConnected();
     }
+    // New sessions may have brought idle timers due earlier than the armed tick
+    armTickTimer();
 }
 
 /**
- * @brief Sends the next authentication challenge (iteration number) to the client.
+ * @brief Arms the tick timer for the core's next timer, unless it is already armed to fire sooner.
  */
-void Server::sendChallenge()
+void Server::armTickTimer()
 {
-    if(hasActiveClient()) {
-        if(m_currentIteration < m_config.getNumberOfIterations()) {
-            emit newLogMessage("Server: Sent challenge #" + QString::number(m_currentIteration));
-            m_clientSocket->write(IntToArray(m_currentIteration));
-            m_clientSocket->flush();
-            m_currentIteration++;
-        } else {
-            emit newLogMessage("Server: All challenges sent. Authentication complete.");
-            stopAuthentication();
-        }
+    qint64 wait = m_core.msUntilNextTimer();
+    if (wait < 0) {
+        m_tickTimer.stop();
+        return;
     }
+    if (m_tickTimer.isActive() && m_tickTimer.remainingTime() <= wait) return;
+    m_tickTimer.start(static_cast<int>(wait));
 }
 
 /**
- * @brief Slot called when the client disconnects. Cleans up resources.
+ * @brief Fires the core's due timers, then re-arms the tick timer.
  */
-void Server::onClientDisconnected() {
-    emit newLogMessage("Server: Client has disconnected.");
-    stopAuthentication(); // Stop the auth process if it's running
-    if (m_clientSocket) {
-        m_clientSocket->deleteLater();
-        m_clientSocket = nullptr;
-    }
+void Server::processTimers()
+{
+    m_core.processTimers();
+    armTickTimer();
+}
+
+/**
+ * @brief Called when a client disconnects. Closes its session.
+ * @param id The session of the client.
+ */
+void Server::onClientDisconnected(SessionId id) {
+    QTcpSocket* socket = static_cast<QTcpSocket*>(m_core.connection(id));
+    if (!socket) return;
+    m_core.closeSession(id);
+    socket->deleteLater();
+    emit newLogMessage(QString::fromStdString(ServerCore::sessionLabel(id)) + "Client has disconnected.");
     emit clientDisconnected();
 }
 
 /**
- * @brief Slot called when data is received from the client.
- * Handles both the initial hash and subsequent OTP responses.
+ * @brief Called when data is received from a client.
+ * Everything available is read in buffer-sized pieces and handed to the core.
+ * @param id The session the data arrived on.
  */
-void Server::receiveResponse(){
-    if(!hasActiveClient()) return;
-    QByteArray content = m_clientSocket->readAll();
-    std::string latestHash = content.toStdString();
+void Server::receiveResponse(SessionId id){
+    QTcpSocket* socket = static_cast<QTcpSocket*>(m_core.connection(id));
+    if (!socket) return;
 
-    // If this is the first hash received, store it as the initial h_n
-    if(m_auth.getLastVerifiedHash().empty()){
-        m_auth.setLastHash(latestHash);
-        emit newLogMessage("Server: Received initial hash (h_n). Ready to start authentication.");
-    } else {
-        // Otherwise, verify the received OTP against the last known hash
-        bool ok = m_auth.verifyOTP(latestHash);
-        emit newLogMessage("Server: Verification Result: " + QString(ok ? "Success" : "Failure"));
-        if(!ok) {
-            emit newLogMessage("Server: Verification failed. Terminating connection.");
-            m_clientSocket->disconnectFromHost();
+    // Read into the fixed member buffer so that no memory is allocated per message
+    qint64 size;
+    while ((size = socket->read(reinterpret_cast<char*>(m_readBuffer), sizeof(m_readBuffer))) > 0) {
+        if (!m_core.receive(id, m_readBuffer, static_cast<std::size_t>(size))) {
+            socket->disconnectFromHost();
+            return;
         }
     }
+    // An enrollment or sent challenges may have scheduled timers
+    armTickTimer();
+}
+
+/**
+ * @brief Writes frames from the core to a client's socket.
+ * @param connection The client's QTcpSocket.
+ * @param data The bytes.
+ * @param len The number of bytes.
+ */
+void Server::send(void* connection, const std::uint8_t* data, std::size_t len)
+{
+    QTcpSocket* socket = static_cast<QTcpSocket*>(connection);
+    socket->write(reinterpret_cast<const char*>(data), static_cast<qint64>(len));
+    socket->flush();
+}
+
+/**
+ * @brief Disconnects a client the core has timed out; onClientDisconnected() closes its session.
+ * @param connection The client's QTcpSocket.
+ */
+void Server::drop(void* connection)
+{
+    static_cast<QTcpSocket*>(connection)->disconnectFromHost();
 }
 
 /**
- * @brief Serializes a 32-bit integer into a QByteArray for network transmission.
- * @param source The integer to serialize.
- * @return The resulting QByteArray.
+ * @brief Forwards a log message from the core to the UI.
+ * @param message The message.
  */
-QByteArray Server::IntToArray(qint32 source) {
-    QByteArray temp;
-    QDataStream data(&temp, QIODevice::ReadWrite);
-    data << source;
-    return temp;
+void Server::log(const std::string& message)
+{
+    emit newLogMessage(QString::fromStdString(message));
+}
+
+/**
+ * @brief Reads the protocol settings from the configuration.
+ * @param config The configuration.
+ * @return The settings.
+ */
+ServerSettings Server::settingsFrom(const ConfigManager& config)
+{
+    return config.snapshot().serverSettings();
 }
\ No newline at end of file
@@ -0,0 +1,726 @@
+#include "ServerCore.hpp"
+#include "LiveConfig.hpp"
+#include "Sha256.hpp"
+
+#include <algorithm>
+
+/**
+ * @brief Constructs a ServerCore.
+ * @param settings The protocol settings.
+ * @param transport The I/O layer.
+ * @param chains A registry shared with other cores, or nullptr for a private one.
+ * @param admission An admission control shared with other cores, or nullptr for a private one.
+ * @param config The configuration to follow, or nullptr.
+ */
+ServerCore::ServerCore(const ServerSettings& settings, ServerTransport& transport, ChainRegistry* chains,
+                       AdmissionControl* admission, const LiveConfig* config)
+    : m_settings(settings), m_config(config), m_transport(transport), m_chains(chains ? *chains : m_ownChains),
+      m_ownAdmission(admission ? AdmissionSettings() : settings.admission),
+      m_admission(admission ? *admission : m_ownAdmission), m_epoch(std::chrono::steady_clock::now())
+{
+    // The settings given are already those of the current snapshot
+    if (m_config) m_configVersion = m_config->version();
+    clampSettings();
+}
+
+/**
+ * @brief Clamps the settings.
+ */
+void ServerCore::clampSettings()
+{
+    m_settings.sleepDuration = std::max(0, m_settings.sleepDuration);
+    m_settings.skipWindow = std::max(1, m_settings.skipWindow);
+    m_settings.pipelineDepth = std::max(1, m_settings.pipelineDepth);
+    m_settings.responseTimeout = std::max(0, m_settings.responseTimeout);
+    m_settings.idleTimeout = std::max(0, m_settings.idleTimeout);
+}
+
+/**
+ * @brief Takes the reloadable settings from a newly published snapshot and re-arms the timers they shorten.
+ */
+void ServerCore::refreshSettings()
+{
+    if (!m_config) return;
+    std::uint64_t version = m_config->version();
+    if (version == m_configVersion) return;
+    m_configVersion = version;
+
+    // The chain length and the admission limits are fixed for the life of the core
+    ServerSettings before = m_settings;
+    ServerSettings reloaded = m_config->snapshot()->serverSettings();
+    m_settings.sleepDuration = reloaded.sleepDuration;
+    m_settings.skipWindow = reloaded.skipWindow;
+    m_settings.pipelineDepth = reloaded.pipelineDepth;
+    m_settings.responseTimeout = reloaded.responseTimeout;
+    m_settings.idleTimeout = reloaded.idleTimeout;
+    clampSettings();
+
+    bool sooner = m_settings.sleepDuration < before.sleepDuration;
+    bool newTimeout = m_settings.responseTimeout > 0
+                      && (before.responseTimeout == 0 || m_settings.responseTimeout < before.responseTimeout);
+    bool newIdle = m_settings.idleTimeout > 0 && (before.idleTimeout == 0 || m_settings.idleTimeout < before.idleTimeout);
+    if (sooner || newTimeout || newIdle) {
+        std::int64_t current = now();
+        m_sessions.forEach([&](SessionId id, Session& session) {
+            if (sooner && session.challengeTimer != TimerWheel::NONE) {
+                m_timers.cancel(session.challengeTimer);
+                session.challengeTimer = TimerWheel::NONE;
+                scheduleChallenge(id, session);
+            }
+            if (newTimeout) {
+                m_timers.cancel(session.responseTimer);
+                session.responseTimer = TimerWheel::NONE;
+                armResponseTimer(id, session);
+            }
+            if (newIdle) {
+                m_timers.cancel(session.idleTimer);
+                std::int64_t deadline = session.lastActivity + std::int64_t(m_settings.idleTimeout) * 1000;
+                session.idleTimer = m_timers.schedule(std::max(current, deadline), id, IdleTimer);
+            }
+        });
+    }
+    m_transport.log("Server: Settings reloaded: challenges every " + std::to_string(m_settings.sleepDuration)
+                    + " s, pipeline depth " + std::to_string(m_settings.pipelineDepth) + ", skip window "
+                    + std::to_string(m_settings.skipWindow) + ".");
+}
+
+/**
+ * @brief Gets the time since construction.
+ * @return Milliseconds.
+ */
+std::int64_t ServerCore::now() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+}
+
+/**
+ * @brief Charges a new connection to its source address.
+ * @param source The source key.
+ * @return True if the connection may be accepted.
+ */
+bool ServerCore::admitConnection(std::uint64_t source)
+{
+    return m_admission.admitConnection(source);
+}
+
+/**
+ * @brief Opens a session for a new connection and arms its idle timer.
+ * @param connection The transport's connection object.
+ * @param source The source key of the client's address.
+ * @return The session identifier.
+ */
+SessionId ServerCore::openSession(void* connection, std::uint64_t source)
+{
+    refreshSettings();
+    SessionId id = m_sessions.open(connection);
+    Session* session = m_sessions.find(id);
+    session->source = source;
+    session->lastActivity = now();
+    if (m_settings.idleTimeout > 0) {
+        session->idleTimer = m_timers.schedule(session->lastActivity + std::int64_t(m_settings.idleTimeout) * 1000,
+                                               id, IdleTimer);
+    }
+    return id;
+}
+
+/**
+ * @brief Closes a session and cancels its timers.
+ * @param id The session identifier.
+ */
+void ServerCore::closeSession(SessionId id)
+{
+    Session* session = m_sessions.find(id);
+    if (!session) return;
+    m_timers.cancel(session->challengeTimer);
+    m_timers.cancel(session->responseTimer);
+    m_timers.cancel(session->idleTimer);
+    // A used-up chain can never be challenged again; it stays registered as exhausted, so that
+    // forgetting it does not let the same anchor be enrolled again and its OTPs replayed
+    if (session->verifiedIteration >= m_settings.numberOfIterations - 1) {
+        m_chains.exhaust(session->chain);
+    } else {
+        m_chains.detach(session->chain);
+    }
+    m_sessions.close(id);
+}
+
+/**
+ * @brief Looks up the connection of a session.
+ * @param id The session identifier.
+ * @return The connection, or nullptr.
+ */
+void* ServerCore::connection(SessionId id)
+{
+    Session* session = m_sessions.find(id);
+    return session ? session->connection : nullptr;
+}
+
+/**
+ * @brief Gets the number of open sessions.
+ * @return The session count.
+ */
+std::size_t ServerCore::sessionCount() const
+{
+    return m_sessions.size();
+}
+
+/**
+ * @brief Gets the number of registered chains.
+ * @return The chain count.
+ */
+std::size_t ServerCore::chainCount() const
+{
+    return m_chains.size();
+}
+
+/**
+ * @brief Checks if the authentication process is running.
+ * @return True if challenges are being sent.
+ */
+bool ServerCore::isAuthRunning() const
+{
+    return m_authRunning;
+}
+
+/**
+ * @brief Starts the authentication process: every enrolled session gets its first challenge after sleepDuration.
+ * @return True if the process was started.
+ */
+bool ServerCore::startAuthentication()
+{
+    if (m_authRunning) {
+        m_transport.log("Server: Authentication process is already running.");
+        return false;
+    }
+
+    m_authRunning = true;
+    std::size_t enrolled = 0;
+    m_sessions.forEach([&](SessionId id, Session& session) {
+        if (!session.verifier.isEnrolled()) return;
+        scheduleChallenge(id, session);
+        ++enrolled;
+    });
+    m_transport.log("Server: Starting authentication process for " + std::to_string(enrolled)
+                    + " enrolled client(s) (SHA-256 backend: " + Sha256::backend()
+                    + ", multi-buffer: " + Sha256::multiBufferBackend() + ")...");
+    return true;
+}
+
+/**
+ * @brief Stops the authentication process and cancels every scheduled challenge and response timeout.
+ * @return True if the process was running.
+ */
+bool ServerCore::stopAuthentication()
+{
+    if (!m_authRunning) return false;
+    m_authRunning = false;
+    m_sessions.forEach([this](SessionId, Session& session) {
+        m_timers.cancel(session.challengeTimer);
+        m_timers.cancel(session.responseTimer);
+        session.challengeTimer = TimerWheel::NONE;
+        session.responseTimer = TimerWheel::NONE;
+        session.currentIteration = session.verifiedIteration + 1; // Resume after the last verified challenge
+    });
+    m_transport.log("Server: Authentication process stopped by user.");
+    return true;
+}
+
+/**
+ * @brief Schedules a session's challenge one sleepDuration from now.
+ * @param id The session identifier.
+ * @param session The session.
+ */
+void ServerCore::scheduleChallenge(SessionId id, Session& session)
+{
+    if (session.challengeTimer != TimerWheel::NONE) return;
+    session.challengeTimer = m_timers.schedule(now() + std::int64_t(m_settings.sleepDuration) * 1000, id, ChallengeTimer);
+}
+
+/**
+ * @brief Arms the response timeout of a session with unanswered challenges.
+ * @param id The session identifier.
+ * @param session The session.
+ */
+void ServerCore::armResponseTimer(SessionId id, Session& session)
+{
+    if (m_settings.responseTimeout == 0 || session.responseTimer != TimerWheel::NONE || outstanding(session) == 0) return;
+    session.responseTimer = m_timers.schedule(session.awaitingSince + std::int64_t(m_settings.responseTimeout) * 1000,
+                                              id, ResponseTimer);
+}
+
+/**
+ * @brief Gets the time until the wheel has work.
+ * @return Milliseconds, or -1 if no timer is scheduled.
+ */
+std::int64_t ServerCore::msUntilNextTimer() const
+{
+    std::int64_t next = m_timers.msUntilNext(now());
+    // Wake up now and then to look for a reloaded configuration
+    const std::int64_t CONFIG_CHECK_MS = 1000;
+    if (m_config && (next < 0 || next > CONFIG_CHECK_MS)) next = CONFIG_CHECK_MS;
+    return next;
+}
+
+/**
+ * @brief Fires every due timer of every session, then releases held challenges.
+ */
+void ServerCore::processTimers()
+{
+    refreshSettings();
+    m_timers.advance(now(), [this](std::uint64_t id, std::uint8_t kind) { handleTimer(id, kind); });
+    releaseHeldChallenges();
+}
+
+/**
+ * @brief Sends the challenges of held sessions whose advance is now synced; the others stay held.
+ */
+void ServerCore::releaseHeldChallenges()
+{
+    if (m_held.empty()) return;
+    // sendChallenges() holds the sessions still waiting again, so the list is walked from a copy
+    m_releasing.swap(m_held);
+    for (SessionId id : m_releasing) {
+        Session* session = m_sessions.find(id);
+        if (!session || !session->held) continue;
+        session->held = false;
+        if (m_authRunning) sendChallenges(id, *session, m_settings.pipelineDepth > 1 ? pipelineRoom(*session) : 1);
+    }
+    m_releasing.clear();
+    if (m_held.empty()) m_holding.store(false);
+}
+
+/**
+ * @brief Tells whether challenges are held; read by the store's flusher thread.
+ * @return True while any session waits for a sync.
+ */
+bool ServerCore::holdsChallenges() const
+{
+    return m_holding.load();
+}
+
+/**
+ * @brief Handles a fired timer. Response and idle timers are not moved on every
+ * read; when one fires early relative to the session's latest activity, it is
+ * simply re-armed for the remaining time.
+ * @param id The session identifier.
+ * @param kind The timer kind.
+ */
+void ServerCore::handleTimer(SessionId id, std::uint8_t kind)
+{
+    Session* session = m_sessions.find(id);
+    if (!session) return; // Timers are cancelled on close; this only guards against misuse
+
+    if (kind == ChallengeTimer) {
+        session->challengeTimer = TimerWheel::NONE;
+        if (m_authRunning) sendChallenge(id, *session);
+        return;
+    }
+
+    std::int64_t current = now();
+    if (kind == ResponseTimer) {
+        session->responseTimer = TimerWheel::NONE;
+        // The timeout may have been switched off by a reload since the timer was armed
+        if (outstanding(*session) == 0 || m_settings.responseTimeout == 0) return;
+        std::int64_t deadline = session->awaitingSince + std::int64_t(m_settings.responseTimeout) * 1000;
+        if (deadline > current) {
+            session->responseTimer = m_timers.schedule(deadline, id, ResponseTimer);
+            return;
+        }
+        m_transport.log(sessionLabel(id) + "No response within " + std::to_string(m_settings.responseTimeout)
+                        + " s. Terminating connection.");
+    } else {
+        session->idleTimer = TimerWheel::NONE;
+        if (m_settings.idleTimeout == 0) return;
+        std::int64_t deadline = session->lastActivity + std::int64_t(m_settings.idleTimeout) * 1000;
+        if (deadline > current) {
+            session->idleTimer = m_timers.schedule(deadline, id, IdleTimer);
+            return;
+        }
+        m_transport.log(sessionLabel(id) + "Idle for " + std::to_string(m_settings.idleTimeout) + " s. Evicting.");
+    }
+    // The transport closes the session, possibly from within this call
+    m_transport.drop(session->connection);
+}
+
+/**
+ * @brief Sends the next authentication challenge (iteration number) of a session.
+ * A pipelined session instead gets as many challenges as its window has room for.
+ * @param id The session identifier.
+ * @param session The session.
+ */
+void ServerCore::sendChallenge(SessionId id, Session& session)
+{
+    if (session.currentIteration < m_settings.numberOfIterations) {
+        sendChallenges(id, session, m_settings.pipelineDepth > 1 ? pipelineRoom(session) : 1);
+        scheduleChallenge(id, session);
+    } else if (m_transport.verbose()) {
+        m_transport.log(sessionLabel(id) + "All challenges sent. Authentication complete.");
+    }
+}
+
+/**
+ * @brief Encodes consecutive challenges into a stack buffer and hands them to the transport.
+ * @param id The session identifier.
+ * @param session The session.
+ * @param count The number of challenges to send.
+ */
+void ServerCore::sendChallenges(SessionId id, Session& session, int count)
+{
+    count = std::min(count, m_settings.numberOfIterations - session.currentIteration);
+    if (count <= 0) return;
+    // The client answers a challenge by revealing a link, so a challenge waits until the advance it follows
+    // is on disk: a crash then never rolls a chain back over more than pipelineDepth revealed links
+    int room = durableRoom(session);
+    if (room < count) {
+        if (!session.held) {
+            session.held = true;
+            m_held.push_back(id);
+        }
+        // The flusher moves the durable position before it reads the flag: either it wakes the
+        // transport, or the second look sees its sync
+        m_holding.store(true);
+        room = durableRoom(session);
+        if (room >= count) session.held = false;
+        count = std::min(count, room);
+        if (count <= 0) return;
+    }
+    // The response timeout runs from the first challenge a session has to answer
+    if (outstanding(session) == 0) session.awaitingSince = now();
+
+    const int CHUNK = 256;
+    std::uint8_t frames[CHUNK * Protocol::CHALLENGE_FRAME_SIZE];
+    int first = session.currentIteration;
+    for (int sent = 0; sent < count; ) {
+        int n = std::min(CHUNK, count - sent);
+        std::size_t size = 0;
+        for (int k = 0; k < n; ++k) {
+            size += Protocol::encodeChallenge(frames + size, static_cast<std::uint64_t>(session.currentIteration++));
+        }
+        m_transport.send(session.connection, frames, size);
+        sent += n;
+    }
+
+    // Formatting the message allocates, so it is only done when someone reads it
+    if (m_transport.verbose()) {
+        if (count == 1) {
+            m_transport.log(sessionLabel(id) + "Sent challenge #" + std::to_string(first));
+        } else {
+            m_transport.log(sessionLabel(id) + "Sent challenges #" + std::to_string(first) + " to #"
+                            + std::to_string(session.currentIteration - 1));
+        }
+    }
+    armResponseTimer(id, session);
+}
+
+/**
+ * @brief Moves the advances the store has synced into a session's durableIteration, and gets how many
+ * challenges that allows.
+ * @param session The session.
+ * @return The number of challenges that may be sent now.
+ */
+int ServerCore::durableRoom(Session& session)
+{
+    if (session.durableIteration < session.verifiedIteration) {
+        std::uint64_t durable = m_chains.durablePosition();
+        int settled = 0;
+        while (settled < session.pendingCount && session.pendingAdvances[settled].position <= durable) {
+            session.durableIteration = session.pendingAdvances[settled++].iteration;
+        }
+        std::copy(session.pendingAdvances + settled, session.pendingAdvances + session.pendingCount,
+                  session.pendingAdvances);
+        session.pendingCount = static_cast<std::uint8_t>(session.pendingCount - settled);
+    }
+    if (session.durableIteration >= session.verifiedIteration) return INT32_MAX;
+    // Challenge j may go out once the advance to j - pipelineDepth is synced
+    return session.durableIteration + m_settings.pipelineDepth - session.currentIteration + 1;
+}
+
+/**
+ * @brief Adds a session's latest advance to the ones waiting for the store.
+ * @param session The session.
+ * @param position The log position after the advance, or 0.
+ */
+void ServerCore::noteAdvance(Session& session, std::uint64_t position)
+{
+    if (position == 0) {
+        session.durableIteration = session.verifiedIteration;
+        session.pendingCount = 0;
+        return;
+    }
+    // Once the list is full the newest entry takes the advance: a later position only makes it wait longer
+    if (session.pendingCount == Session::MAX_PENDING_ADVANCES) --session.pendingCount;
+    session.pendingAdvances[session.pendingCount++] = LogMark{session.verifiedIteration, position};
+}
+
+/**
+ * @brief Gets the free room in a pipelined session's window.
+ * @param session The session.
+ * @return The number of challenges that may still be sent.
+ */
+int ServerCore::pipelineRoom(const Session& session) const
+{
+    return m_settings.pipelineDepth - outstanding(session);
+}
+
+/**
+ * @brief Counts a session's unanswered challenges.
+ * @param session The session.
+ * @return The number of challenges sent after the last verified one.
+ */
+int ServerCore::outstanding(const Session& session)
+{
+    return session.currentIteration - 1 - session.verifiedIteration;
+}
+
+/**
+ * @brief Processes bytes received from a client.
+ * Frames are parsed in place, responses to consecutive challenges are verified in one batch,
+ * and a pipelined session's window is topped up.
+ * @param id The session the bytes arrived on.
+ * @param data The bytes.
+ * @param len The number of bytes.
+ * @return False if the client should be dropped.
+ */
+bool ServerCore::receive(SessionId id, const std::uint8_t* data, std::size_t len)
+{
+    Session* session = m_sessions.find(id);
+    if (!session) return false;
+    session->lastActivity = now();
+
+    std::int32_t verifiedBefore = session->verifiedIteration;
+    m_batchSize = 0;
+    bool ok = session->parser.feed(data, len, [&](const Protocol::Frame& frame) { return handleFrame(id, *session, frame); })
+              && flushResponses(id, *session);
+    if (!ok) {
+        m_batchSize = 0;
+        m_transport.log(sessionLabel(id) + "Terminating connection.");
+        return false;
+    }
+
+    // Progress restarts the response timeout for the challenges still outstanding
+    if (session->verifiedIteration > verifiedBefore) session->awaitingSince = session->lastActivity;
+
+    // A pipelined session is topped up as soon as its responses are in, not on the next timer tick
+    if (m_authRunning && session->verifiedIteration > verifiedBefore && m_settings.pipelineDepth > 1) {
+        sendChallenges(id, *session, pipelineRoom(*session));
+    }
+    return true;
+}
+
+/**
+ * @brief Handles one frame of a client.
+ * The first frame must enroll the chain; every later frame must be a response.
+ * @param id The session identifier.
+ * @param session The session.
+ * @param frame The frame.
+ * @return True if the connection may continue.
+ */
+bool ServerCore::handleFrame(SessionId id, Session& session, const Protocol::Frame& frame)
+{
+    // Every frame is charged to the client's address and chain before any work is done for it
+    if (!m_admission.admitFrame(session.source) || !m_chains.admitFrame(session.chain, m_admission)) {
+        m_transport.log(sessionLabel(id) + "Rate limit exceeded.");
+        return false;
+    }
+
+    // Until a chain is enrolled or resumed, only Enroll and Resume are accepted
+    if (!session.verifier.isEnrolled()) return attachChain(id, session, frame);
+
+    // Otherwise, verify the received OTP against the last known hash
+    std::uint64_t counter = 0;
+    Digest response;
+    if (!Protocol::decodeResponse(frame, counter, response)) {
+        m_transport.log(sessionLabel(id) + "Malformed response.");
+        return false;
+    }
+    // A response to a challenge that was never sent is bogus; reject it without hashing
+    if (counter <= static_cast<std::uint64_t>(session.verifiedIteration)
+        || counter >= static_cast<std::uint64_t>(session.currentIteration)) {
+        m_transport.log(sessionLabel(id) + "Response to challenge #" + std::to_string(counter)
+                        + ", which is not outstanding.");
+        return false;
+    }
+
+    // Responses to consecutive challenges are gathered and verified together once the read is parsed
+    if (counter == static_cast<std::uint64_t>(session.verifiedIteration) + m_batchSize + 1) {
+        if (m_batchSize == ChainVerifier::MAX_SEQUENCE && !flushResponses(id, session)) return false;
+        m_responseBatch[m_batchSize++] = response;
+        return true;
+    }
+    // Anything else is checked on its own, after the responses that precede it
+    if (!flushResponses(id, session)) return false;
+
+    // The counter names the challenge answered, so exactly that many hashes lead back to the last verified link.
+    // Responses up to skipWindow links behind are accepted, so lost rounds do not force a reconnect
+    std::uint64_t expected = counter - static_cast<std::uint64_t>(session.verifiedIteration);
+    if (expected > static_cast<std::uint64_t>(m_settings.skipWindow)) {
+        m_transport.log(sessionLabel(id) + "Verification Result for challenge #" + std::to_string(counter)
+                        + ": Failure");
+        m_transport.log(sessionLabel(id) + "Verification failed: beyond the skip window.");
+        return false;
+    }
+    if (!m_admission.acquireVerify(static_cast<std::uint32_t>(expected))) {
+        m_transport.log(sessionLabel(id) + "Verification budget exhausted; shedding load.");
+        return false;
+    }
+    int offset = 0;
+    bool ok = session.verifier.verify(response, static_cast<int>(expected), offset)
+              && static_cast<std::uint64_t>(offset) == expected;
+    m_admission.releaseVerify(static_cast<std::uint32_t>(expected));
+    if (m_transport.verbose()) {
+        m_transport.log(sessionLabel(id) + "Verification Result for challenge #" + std::to_string(counter) + ": "
+                        + (ok ? "Success" : "Failure"));
+    }
+    if (!ok) {
+        m_transport.log(sessionLabel(id) + "Verification failed.");
+        return false;
+    }
+    if (offset > 1 && m_transport.verbose()) {
+        m_transport.log(sessionLabel(id) + "Resynchronised, skipped " + std::to_string(offset - 1) + " lost round(s).");
+    }
+    session.verifiedIteration += offset;
+    saveProgress(session);
+    // Never challenge for a link at or above the one just revealed
+    if (session.currentIteration <= session.verifiedIteration) {
+        session.currentIteration = session.verifiedIteration + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Enrolls a new chain or resumes a known one.
+ * @param id The session identifier.
+ * @param session The session.
+ * @param frame The first frame of the session.
+ * @return True if the connection may continue.
+ */
+bool ServerCore::attachChain(SessionId id, Session& session, const Protocol::Frame& frame)
+{
+    Digest anchor;
+    if (frame.type == Protocol::MessageType::Resume) {
+        if (!Protocol::decodeResume(frame, anchor)) {
+            m_transport.log(sessionLabel(id) + "Malformed resume request.");
+            return false;
+        }
+        // Until the chain is attached, the attempt only counts against the source: anchors travel in
+        // the clear, so charging the named chain would let anyone drain its owner's bucket
+        std::uint32_t index = m_chains.attach(anchor, id);
+        std::uint8_t ack[Protocol::RESUME_ACK_FRAME_SIZE];
+        if (index == ChainRegistry::NONE) {
+            // The client may still enroll a new chain on this connection
+            m_transport.log(sessionLabel(id) + "Resume refused: chain unknown, used up or in use.");
+            std::size_t size = Protocol::encodeResumeAck(ack, false, 0);
+            m_transport.send(session.connection, ack, size);
+            return true;
+        }
+        if (!m_chains.admitFrame(index, m_admission)) {
+            m_chains.detach(index);
+            m_transport.log(sessionLabel(id) + "Rate limit exceeded for this chain.");
+            return false;
+        }
+        ChainRecord entry = m_chains.load(index);
+        session.verifier = entry.verifier;
+        session.verifiedIteration = entry.verifiedIteration;
+        session.currentIteration = entry.verifiedIteration + 1;
+        session.chain = index;
+        // The previous session's last advance may not be synced yet
+        noteAdvance(session, m_chains.logPosition());
+        std::size_t size = Protocol::encodeResumeAck(ack, true, static_cast<std::uint64_t>(entry.verifiedIteration));
+        m_transport.send(session.connection, ack, size);
+        m_transport.log(sessionLabel(id) + "Resumed " + hashAlgorithmName(entry.verifier.chainParams().algorithm)
+                        + " chain after challenge #" + std::to_string(entry.verifiedIteration) + ".");
+        if (m_authRunning) scheduleChallenge(id, session);
+        return true;
+    }
+
+    // The anchor arrives with the chain format and hash function the client chose
+    ChainParams params;
+    if (!Protocol::decodeEnroll(frame, params, anchor)) {
+        m_transport.log(sessionLabel(id) + "Malformed enrollment or unsupported hash algorithm.");
+        return false;
+    }
+    ChainVerifier verifier;
+    verifier.enroll(params, anchor);
+    std::uint32_t index = m_chains.enroll(anchor, verifier, id);
+    if (index == ChainRegistry::NONE) {
+        // Re-enrolling would rewind the verifier and let already revealed OTPs be replayed
+        m_transport.log(sessionLabel(id) + "Chain already enrolled or used up; it cannot be enrolled again.");
+        return false;
+    }
+    session.verifier = verifier;
+    session.verifiedIteration = 0;
+    session.currentIteration = 1;
+    session.chain = index;
+    m_transport.log(sessionLabel(id) + "Received initial hash (h_n) for a " + hashAlgorithmName(params.algorithm)
+                    + " chain. Ready to start authentication.");
+    if (m_authRunning) scheduleChallenge(id, session);
+    return true;
+}
+
+/**
+ * @brief Records a session's progress in its chain record.
+ * @param session The session.
+ */
+void ServerCore::saveProgress(Session& session)
+{
+    if (session.chain == ChainRegistry::NONE) return;
+    noteAdvance(session, m_chains.save(session.chain, session.verifier, session.verifiedIteration));
+}
+
+/**
+ * @brief Verifies the gathered responses of a session, which answer the challenges
+ * right after its last verified one, in order.
+ * @param id The session identifier.
+ * @param session The session.
+ * @return True if every response verified.
+ */
+bool ServerCore::flushResponses(SessionId id, Session& session)
+{
+    if (m_batchSize == 0) return true;
+    std::size_t count = m_batchSize;
+    m_batchSize = 0;
+
+    std::int32_t first = session.verifiedIteration + 1;
+    if (!m_admission.acquireVerify(static_cast<std::uint32_t>(count))) {
+        m_transport.log(sessionLabel(id) + "Verification budget exhausted; shedding load.");
+        return false;
+    }
+    std::size_t accepted = session.verifier.verifySequence(m_responseBatch, count);
+    m_admission.releaseVerify(static_cast<std::uint32_t>(count));
+    session.verifiedIteration += static_cast<std::int32_t>(accepted);
+    if (accepted > 0) saveProgress(session);
+    // Never challenge for a link at or above the one just revealed
+    if (session.currentIteration <= session.verifiedIteration) {
+        session.currentIteration = session.verifiedIteration + 1;
+    }
+
+    // Only failures are logged unconditionally: they end the session, so they are rare
+    if (m_transport.verbose()) {
+        if (count == 1) {
+            m_transport.log(sessionLabel(id) + "Verification Result for challenge #" + std::to_string(first) + ": "
+                            + (accepted == 1 ? "Success" : "Failure"));
+        } else if (accepted > 0) {
+            m_transport.log(sessionLabel(id) + "Verification Result for challenges #" + std::to_string(first)
+                            + " to #" + std::to_string(session.verifiedIteration) + ": Success");
+        }
+    }
+    if (accepted < count) {
+        if (count > 1) {
+            m_transport.log(sessionLabel(id) + "Verification Result for challenge #"
+                            + std::to_string(session.verifiedIteration + 1) + ": Failure");
+        }
+        m_transport.log(sessionLabel(id) + "Verification failed.");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Builds the log prefix for a session from its slot number.
+ * @param id The session identifier.
+ * @return The prefix.
+ */
+std::string ServerCore::sessionLabel(SessionId id)
+{
+    return "Server: Session " + std::to_string(static_cast<std::uint32_t>(id)) + ": ";
+}
\ No newline at end of file
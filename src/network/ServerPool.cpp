@@ -0,0 +1,80 @@
+#include "ServerPool.hpp"
+#include "Server.hpp"
+
+#include <iostream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * @brief Starts the worker threads.
+ * Each Server is constructed on its own thread, so its sockets and timers belong to that thread's event loop.
+ * @param filePath Path to the configuration file.
+ * @param threads The number of event loops.
+ * @param pinThreads Whether to pin each worker to a CPU.
+ * @param chains The shared chain registry.
+ * @param liveConfig The watched configuration, or nullptr.
+ * @param parent The parent QObject.
+ */
+ServerPool::ServerPool(const QString& filePath, int threads, bool pinThreads, ChainRegistry& chains,
+                       const LiveConfig* liveConfig, QObject *parent)
+    : QObject(parent), m_chains(chains), m_liveConfig(liveConfig),
+      m_admission(Server::settingsFrom(ConfigManager(filePath)).admission)
+{
+    for (int i = 0; i < threads; ++i) {
+        QThread* thread = new QThread(this);
+        // Runs on the new thread, before its event loop starts
+        connect(thread, &QThread::started, [this, thread, filePath, i, pinThreads]() {
+            if (pinThreads && !pinCurrentThread(i)) {
+                std::cerr << "Server: could not pin event loop " << i << " to a CPU" << std::endl;
+            }
+            Server* server = new Server(filePath, nullptr, true, &m_chains, &m_admission, m_liveConfig);
+            connect(thread, &QThread::finished, server, &QObject::deleteLater);
+            if (!server->isListening()) {
+                std::cerr << "Server: event loop " << i << " could not listen" << std::endl;
+                return;
+            }
+            server->startAuthentication();
+        });
+        m_threads.push_back(thread);
+        thread->start();
+    }
+}
+
+/**
+ * @brief Stops every event loop and joins the worker threads.
+ */
+ServerPool::~ServerPool()
+{
+    for (QThread* thread : m_threads) thread->quit();
+    for (QThread* thread : m_threads) thread->wait();
+}
+
+/**
+ * @brief Gets the number of event loops.
+ * @return The number of worker threads.
+ */
+int ServerPool::threadCount() const
+{
+    return static_cast<int>(m_threads.size());
+}
+
+/**
+ * @brief Pins the calling thread to one CPU.
+ * @param cpu The CPU index, wrapped to the number of CPUs.
+ * @return True on success.
+ */
+bool ServerPool::pinCurrentThread(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % QThread::idealThreadCount(), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
@@ -0,0 +1,72 @@
+#include "SessionTable.hpp"
+
+/**
+ * @brief Packs a slot index and generation into a session identifier.
+ */
+SessionId SessionTable::makeId(std::uint32_t index, std::uint32_t generation)
+{
+    return (static_cast<SessionId>(generation) << 32) | index;
+}
+
+/**
+ * @brief Opens a session, reusing a free slot when there is one.
+ * @param connection The transport object of the session.
+ * @return The new session's identifier.
+ */
+SessionId SessionTable::open(void* connection)
+{
+    std::uint32_t index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        index = static_cast<std::uint32_t>(entries.size());
+        entries.emplace_back();
+    }
+
+    Slot& slot = entries[index];
+    slot.session = Session();
+    slot.session.connection = connection;
+    slot.inUse = true;
+    ++openCount;
+    return makeId(index, slot.generation);
+}
+
+/**
+ * @brief Closes a session and recycles its slot.
+ * @param id The session identifier.
+ */
+void SessionTable::close(SessionId id)
+{
+    if (!find(id)) return;
+    std::uint32_t index = static_cast<std::uint32_t>(id);
+    Slot& slot = entries[index];
+    slot.inUse = false;
+    ++slot.generation;
+    freeSlots.push_back(index);
+    --openCount;
+}
+
+/**
+ * @brief Looks up an open session by identifier.
+ * @param id The session identifier.
+ * @return The session, or nullptr if the identifier is stale.
+ */
+Session* SessionTable::find(SessionId id)
+{
+    std::uint32_t index = static_cast<std::uint32_t>(id);
+    std::uint32_t generation = static_cast<std::uint32_t>(id >> 32);
+    if (index >= entries.size()) return nullptr;
+    Slot& slot = entries[index];
+    if (!slot.inUse || slot.generation != generation) return nullptr;
+    return &slot.session;
+}
+
+/**
+ * @brief Gets the number of open sessions.
+ * @return The session count.
+ */
+std::size_t SessionTable::size() const
+{
+    return openCount;
+}
@@ -0,0 +1,575 @@
+#include "VerifierTable.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    const char MAGIC[8] = {'L', 'M', 'P', 'V', 'T', 'A', 'B', '\0'};
+    const std::uint32_t EMPTY_SLOT = 0;
+    const std::uint32_t REMOVED_SLOT = UINT32_MAX;
+    const std::uint64_t ANONYMOUS_CAPACITY = 1024; ///< Initial capacity of a table without a file.
+    const std::size_t HEADER_SIZE = 128;           ///< The header of the current version.
+    const std::size_t V1_HEADER_SIZE = 64;         ///< The header of version 1, without the log segment.
+
+    /**
+     * @brief Computes the size of a table.
+     * @param capacity The record capacity.
+     * @param headerSize The size of the header.
+     * @return The size in bytes: header, index of 2 * capacity slots, records.
+     */
+    std::size_t tableSize(std::uint64_t capacity, std::size_t headerSize = HEADER_SIZE)
+    {
+        return static_cast<std::size_t>(headerSize + capacity * 2 * sizeof(std::uint32_t)
+                                        + capacity * sizeof(VerifierTable::Record));
+    }
+
+    /**
+     * @brief Syncs the directory of a file, so that a file renamed into it survives a crash.
+     * @param path The file.
+     */
+    void syncParent(const std::string& path)
+    {
+        std::string::size_type slash = path.rfind('/');
+        std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) return;
+        ::fsync(fd);
+        ::close(fd);
+    }
+
+    /**
+     * @brief Rounds a capacity up to a power of two, at least 16.
+     */
+    std::uint64_t roundCapacity(std::uint64_t capacity)
+    {
+        std::uint64_t rounded = 16;
+        while (rounded < capacity) rounded <<= 1;
+        return rounded;
+    }
+}
+
+/**
+ * @struct VerifierTable::Header
+ * @brief The first 128 bytes of a table; version 1 ends before logSegment.
+ */
+struct VerifierTable::Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint64_t capacity;
+    std::uint64_t used;
+    std::uint64_t live;
+    std::uint64_t tombstones;
+    std::uint64_t seed;
+    std::uint32_t freeHead;
+    std::uint32_t reserved;
+    std::uint64_t logSegment;
+    std::uint8_t padding[56];
+};
+static_assert(sizeof(VerifierTable::Record) % 8 == 0, "records must keep the counters aligned");
+
+/**
+ * @brief Unmaps the table.
+ */
+VerifierTable::~VerifierTable()
+{
+    static_assert(sizeof(Header) == HEADER_SIZE, "the header is an on-disk format");
+    close();
+}
+
+/**
+ * @brief Maps an existing table file or creates an empty one.
+ * @param filePath The table file.
+ * @param capacity The capacity of a new file.
+ * @return True on success.
+ */
+bool VerifierTable::open(const std::string& filePath, std::uint32_t capacity)
+{
+    close();
+
+    int fd = ::open(filePath.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            std::cerr << "VerifierTable: cannot open " << filePath << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        // Built under a temporary name, so a crash never leaves a half-initialised table behind
+        std::string tmpPath = filePath + ".tmp";
+        std::uint64_t seed = (std::uint64_t(std::random_device()()) << 32) | std::random_device()();
+        if (!create(tmpPath, roundCapacity(capacity), seed, base, mappingSize, descriptor)
+            || ::msync(base, mappingSize, MS_SYNC) != 0 || std::rename(tmpPath.c_str(), filePath.c_str()) != 0) {
+            if (errno == EWOULDBLOCK) {
+                std::cerr << "VerifierTable: " << filePath << " is in use by another process." << std::endl;
+                return false;
+            }
+            std::cerr << "VerifierTable: cannot create " << filePath << ": " << std::strerror(errno) << std::endl;
+            close();
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+        syncParent(filePath);
+        path = filePath;
+        return true;
+    }
+
+    // Held until close(): a second server, a standby or lamport-rehome pointed at the same file would
+    // otherwise rewrite identities under this one
+    if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        ::close(fd);
+        std::cerr << "VerifierTable: " << filePath << " is in use by another process." << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    std::size_t size = 0;
+    void* mapped = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && static_cast<std::uint64_t>(st.st_size) >= sizeof(Header)) {
+        size = static_cast<std::size_t>(st.st_size);
+        mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (mapped == MAP_FAILED) {
+        ::close(fd);
+        std::cerr << "VerifierTable: " << filePath << " is not a verifier table." << std::endl;
+        return false;
+    }
+
+    const Header* stored = static_cast<const Header*>(mapped);
+    std::size_t headerSize = stored->version == 1 ? V1_HEADER_SIZE : HEADER_SIZE;
+    bool valid = std::memcmp(stored->magic, MAGIC, sizeof(MAGIC)) == 0
+              && (stored->version == VERSION || stored->version == 1)
+              && stored->recordSize == sizeof(Record)
+              && stored->capacity >= 16 && stored->capacity <= (std::uint64_t(1) << 31)
+              && (stored->capacity & (stored->capacity - 1)) == 0
+              && size == tableSize(stored->capacity, headerSize)
+              && stored->used <= stored->capacity
+              && stored->live <= stored->used
+              && (stored->freeHead == NONE || stored->freeHead < stored->used);
+    if (!valid) {
+        ::munmap(mapped, size);
+        ::close(fd);
+        std::cerr << "VerifierTable: " << filePath << " is not a verifier table." << std::endl;
+        return false;
+    }
+
+    // Lookups land on random identities all over the file, so readahead would be wasted
+    ::madvise(mapped, size, MADV_RANDOM);
+    base = static_cast<std::uint8_t*>(mapped);
+    mappingSize = size;
+    descriptor = fd;
+    path = filePath;
+
+    if (stored->version == 1) {
+        const Record* entries = reinterpret_cast<const Record*>(base + V1_HEADER_SIZE
+                                                                + stored->capacity * 2 * sizeof(std::uint32_t));
+        if (!relocate(stored->capacity, entries, 0)) {
+            close();
+            return false;
+        }
+        std::cout << "VerifierTable: upgraded " << filePath << " to version " << VERSION << "." << std::endl;
+    }
+    return true;
+}
+
+/**
+ * @brief Syncs a file-backed table and unmaps it.
+ */
+void VerifierTable::close()
+{
+    if (base) {
+        if (!path.empty()) ::msync(base, mappingSize, MS_SYNC);
+        ::munmap(base, mappingSize);
+    }
+    if (descriptor >= 0) ::close(descriptor);
+    base = nullptr;
+    mappingSize = 0;
+    descriptor = -1;
+    path.clear();
+}
+
+/**
+ * @brief Checks whether the table is backed by a file.
+ * @return True if a file is mapped.
+ */
+bool VerifierTable::isFile() const
+{
+    return base && !path.empty();
+}
+
+/**
+ * @brief Gets the log segment of the last checkpoint.
+ * @return The segment; 0 without a table.
+ */
+std::uint64_t VerifierTable::logSegment() const
+{
+    return base ? header()->logSegment : 0;
+}
+
+/**
+ * @brief Stores the log segment of a checkpoint in the header.
+ * @param segment The first segment still needed.
+ */
+void VerifierTable::setLogSegment(std::uint64_t segment)
+{
+    if (ensureMapped()) header()->logSegment = segment;
+}
+
+/**
+ * @brief Duplicates the descriptor of the table file.
+ * @return The new descriptor, or -1.
+ */
+int VerifierTable::duplicateFile() const
+{
+    return descriptor >= 0 ? ::fcntl(descriptor, F_DUPFD_CLOEXEC, 0) : -1;
+}
+
+/**
+ * @brief Compares a descriptor's file with the mapped one.
+ * @param other The descriptor.
+ * @return True if both are the same file.
+ */
+bool VerifierTable::mapsFile(int other) const
+{
+    struct stat mine;
+    struct stat theirs;
+    return descriptor >= 0 && ::fstat(descriptor, &mine) == 0 && ::fstat(other, &theirs) == 0
+           && mine.st_dev == theirs.st_dev && mine.st_ino == theirs.st_ino;
+}
+
+/**
+ * @brief Looks up an anchor.
+ * @param anchor The anchor.
+ * @return The record number, or NONE.
+ */
+std::uint32_t VerifierTable::find(const Digest& anchor) const
+{
+    if (!base) return NONE;
+    std::uint32_t slot = indexFind(anchor);
+    return slot == NONE ? NONE : index()[slot] - 1;
+}
+
+/**
+ * @brief Adds an anchor, reusing a removed record if there is one.
+ * @param anchor The anchor.
+ * @return The record number, or NONE.
+ */
+std::uint32_t VerifierTable::insert(const Digest& anchor)
+{
+    if (!ensureMapped() || indexFind(anchor) != NONE) return NONE;
+
+    std::uint32_t number;
+    Header* h = header();
+    if (h->freeHead != NONE) {
+        // Removed records keep the next free record number in their counter
+        number = h->freeHead;
+        h->freeHead = static_cast<std::uint32_t>(records()[number].counter);
+    } else {
+        if (h->used == h->capacity && !grow()) return NONE;
+        h = header();
+        number = static_cast<std::uint32_t>(h->used++);
+    }
+
+    Record& entry = records()[number];
+    entry = Record();
+    entry.anchor = anchor;
+    entry.flags = LIVE;
+    indexInsert(anchor, number);
+    ++h->live;
+    return number;
+}
+
+/**
+ * @brief Removes a record and puts it on the free list.
+ * @param number The record number.
+ */
+void VerifierTable::remove(std::uint32_t number)
+{
+    Header* h = header();
+    Record& entry = records()[number];
+    std::uint32_t slot = indexFind(entry.anchor);
+    if (slot == NONE) return;
+    // A tombstone, not an empty slot, so that probes for anchors stored past it still find them
+    index()[slot] = REMOVED_SLOT;
+    ++h->tombstones;
+    entry.flags = 0;
+    entry.counter = h->freeHead;
+    h->freeHead = number;
+    --h->live;
+    if (h->tombstones > h->capacity / 2) rebuildIndex();
+}
+
+/**
+ * @brief Removes every record.
+ */
+void VerifierTable::clear()
+{
+    if (!base) return;
+    Header* h = header();
+    std::memset(index(), 0, static_cast<std::size_t>(h->capacity * 2 * sizeof(std::uint32_t)));
+    h->used = 0;
+    h->live = 0;
+    h->tombstones = 0;
+    h->freeHead = NONE;
+}
+
+/**
+ * @brief Gets a record.
+ * @param number The record number.
+ * @return The record.
+ */
+VerifierTable::Record& VerifierTable::record(std::uint32_t number)
+{
+    return records()[number];
+}
+
+/**
+ * @brief Gets a record.
+ * @param number The record number.
+ * @return The record.
+ */
+const VerifierTable::Record& VerifierTable::record(std::uint32_t number) const
+{
+    return records()[number];
+}
+
+/**
+ * @brief Gets the high-water mark of record numbers.
+ * @return The number of records ever used.
+ */
+std::uint32_t VerifierTable::end() const
+{
+    return base ? static_cast<std::uint32_t>(header()->used) : 0;
+}
+
+/**
+ * @brief Gets the number of live records.
+ * @return The identity count.
+ */
+std::size_t VerifierTable::size() const
+{
+    return base ? static_cast<std::size_t>(header()->live) : 0;
+}
+
+/**
+ * @brief Creates and maps an empty table.
+ * @param filePath The file to create, or empty for anonymous memory.
+ * @param capacity The record capacity.
+ * @param seed The index hash seed.
+ * @param mapping Receives the mapping.
+ * @param size Receives its size.
+ * @return True on success.
+ */
+bool VerifierTable::create(const std::string& filePath, std::uint64_t capacity, std::uint64_t seed,
+                           std::uint8_t*& mapping, std::size_t& size, int& fd)
+{
+    size = tableSize(capacity);
+    void* mapped;
+    fd = -1;
+    if (filePath.empty()) {
+        mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    } else {
+        fd = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) return false;
+        // Locked before it is truncated, so another process still building the same file keeps it; the
+        // lock stays with the file once it is renamed into place.
+        // A sparse file: the index starts out zeroed, i.e. empty, and untouched records take no space
+        mapped = ::flock(fd, LOCK_EX | LOCK_NB) == 0 && ::ftruncate(fd, 0) == 0
+                         && ::ftruncate(fd, static_cast<off_t>(size)) == 0
+                     ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                     : MAP_FAILED;
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    if (mapped == MAP_FAILED) return false;
+    if (!filePath.empty()) ::madvise(mapped, size, MADV_RANDOM);
+
+    mapping = static_cast<std::uint8_t*>(mapped);
+    Header* h = reinterpret_cast<Header*>(mapping);
+    std::memcpy(h->magic, MAGIC, sizeof(MAGIC));
+    h->version = VERSION;
+    h->recordSize = sizeof(Record);
+    h->capacity = capacity;
+    h->seed = seed;
+    h->freeHead = NONE;
+    return true;
+}
+
+/**
+ * @brief Maps an anonymous table on first use.
+ * @return True if a table is mapped.
+ */
+bool VerifierTable::ensureMapped()
+{
+    if (base) return true;
+    std::uint64_t seed = (std::uint64_t(std::random_device()()) << 32) | std::random_device()();
+    if (!create(std::string(), ANONYMOUS_CAPACITY, seed, base, mappingSize, descriptor)) {
+        base = nullptr;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Doubles the capacity. Record numbers stay the same; the index is rebuilt for the new size.
+ * @return True on success.
+ */
+bool VerifierTable::grow()
+{
+    const Header* old = header();
+    if (old->capacity >= (std::uint64_t(1) << 31)) return false;
+    return relocate(old->capacity * 2, records(), old->logSegment);
+}
+
+/**
+ * @brief Copies the records into a new table and swaps the mappings. The new file is synced before
+ * the rename, so the log segment it inherits stays true after a power loss.
+ * @param capacity The new capacity.
+ * @param entries The records.
+ * @param segment The log segment.
+ * @return True on success.
+ */
+bool VerifierTable::relocate(std::uint64_t capacity, const Record* entries, std::uint64_t segment)
+{
+    const Header* old = header();
+    std::string tmpPath = path.empty() ? std::string() : path + ".tmp";
+    std::uint8_t* moved = nullptr;
+    std::size_t movedSize = 0;
+    int movedDescriptor = -1;
+    if (!create(tmpPath, capacity, old->seed, moved, movedSize, movedDescriptor)) {
+        std::cerr << "VerifierTable: cannot grow to " << capacity << " records: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    Header* h = reinterpret_cast<Header*>(moved);
+    h->used = old->used;
+    h->live = old->live;
+    h->freeHead = old->freeHead;
+    h->logSegment = segment;
+    std::memcpy(moved + HEADER_SIZE + h->capacity * 2 * sizeof(std::uint32_t), entries,
+                static_cast<std::size_t>(old->used * sizeof(Record)));
+
+    if (!path.empty()
+        && (::msync(moved, movedSize, MS_SYNC) != 0 || std::rename(tmpPath.c_str(), path.c_str()) != 0)) {
+        std::cerr << "VerifierTable: cannot replace " << path << ": " << std::strerror(errno) << std::endl;
+        ::munmap(moved, movedSize);
+        ::close(movedDescriptor);
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    if (!path.empty()) syncParent(path);
+    ::munmap(base, mappingSize);
+    if (descriptor >= 0) ::close(descriptor);
+    base = moved;
+    mappingSize = movedSize;
+    descriptor = movedDescriptor;
+    rebuildIndex();
+    return true;
+}
+
+/**
+ * @brief Clears the index and re-adds every live record.
+ */
+void VerifierTable::rebuildIndex()
+{
+    Header* h = header();
+    std::memset(index(), 0, static_cast<std::size_t>(h->capacity * 2 * sizeof(std::uint32_t)));
+    h->tombstones = 0;
+    const Record* entries = records();
+    for (std::uint32_t number = 0; number < h->used; ++number) {
+        if (entries[number].flags & LIVE) indexInsert(entries[number].anchor, number);
+    }
+}
+
+/**
+ * @brief Stores a record number in the first free slot of the anchor's probe sequence.
+ * @param anchor The anchor, known to be absent.
+ * @param number The record number.
+ */
+void VerifierTable::indexInsert(const Digest& anchor, std::uint32_t number)
+{
+    Header* h = header();
+    std::uint32_t* slots = index();
+    std::uint64_t mask = h->capacity * 2 - 1;
+    for (std::uint64_t slot = slotHash(anchor) & mask;; slot = (slot + 1) & mask) {
+        if (slots[slot] == EMPTY_SLOT || slots[slot] == REMOVED_SLOT) {
+            if (slots[slot] == REMOVED_SLOT) --h->tombstones;
+            slots[slot] = number + 1;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Probes the index for an anchor, up to the first empty slot.
+ * @param anchor The anchor.
+ * @return The slot, or NONE.
+ */
+std::uint32_t VerifierTable::indexFind(const Digest& anchor) const
+{
+    const std::uint32_t* slots = index();
+    const Record* entries = records();
+    std::uint64_t mask = header()->capacity * 2 - 1;
+    // The index is at most half full, so every probe sequence reaches an empty slot
+    for (std::uint64_t slot = slotHash(anchor) & mask;; slot = (slot + 1) & mask) {
+        std::uint32_t value = slots[slot];
+        if (value == EMPTY_SLOT) return NONE;
+        if (value != REMOVED_SLOT && std::memcmp(entries[value - 1].anchor.data(), anchor.data(), Digest::SIZE) == 0) {
+            return static_cast<std::uint32_t>(slot);
+        }
+    }
+}
+
+/**
+ * @brief Mixes the four words of an anchor with the table's random seed.
+ * @param anchor The anchor.
+ * @return The hash.
+ */
+std::uint64_t VerifierTable::slotHash(const Digest& anchor) const
+{
+    std::uint64_t hash = header()->seed;
+    for (std::size_t i = 0; i < Digest::SIZE; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, anchor.data() + i, sizeof(word));
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+/**
+ * @brief Gets the header.
+ * @return The header.
+ */
+VerifierTable::Header* VerifierTable::header() const
+{
+    return reinterpret_cast<Header*>(base);
+}
+
+/**
+ * @brief Gets the index, right after the header.
+ * @return The first slot.
+ */
+std::uint32_t* VerifierTable::index() const
+{
+    return reinterpret_cast<std::uint32_t*>(base + HEADER_SIZE);
+}
+
+/**
+ * @brief Gets the records, right after the index.
+ * @return The first record.
+ */
+VerifierTable::Record* VerifierTable::records() const
+{
+    return reinterpret_cast<Record*>(base + HEADER_SIZE + header()->capacity * 2 * sizeof(std::uint32_t));
+}
@@ -0,0 +1,194 @@
+#include "ChainRegistry.hpp"
+#include "HashRing.hpp"
+#include "VerifierTable.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    const std::uint32_t NEW_TABLE_CAPACITY = 65536; ///< Capacity of a table created for a new shard.
+    const char* NO_STORE = "-";                     ///< A --stores item for a table without a chain store.
+
+    /**
+     * @brief Splits a comma-separated list, dropping empty items.
+     * @param list The list.
+     * @return The items.
+     */
+    std::vector<std::string> splitList(const std::string& list)
+    {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            if (!item.empty()) items.push_back(item);
+        }
+        return items;
+    }
+
+    /**
+     * @struct Counts
+     * @brief What happened to one table.
+     */
+    struct Counts {
+        std::uint64_t before = 0;    ///< Identities before re-homing.
+        std::uint64_t movedOut = 0;  ///< Identities moved to another table.
+        std::uint64_t movedIn = 0;   ///< Identities moved here.
+    };
+}
+
+/**
+ * @brief Moves verifier records between the tables of sharded servers after shards were added or removed.
+ * Usage: lamport-rehome <shards> <tables> [retired-tables] [--stores <dirs>]
+ *
+ * <shards> is the new comma-separated shard list, as in the router's "shards" key,
+ * and <tables> the verifierTable of each of them, in the same order; a table that
+ * does not exist yet is created. [retired-tables] are the tables of shards removed
+ * from the list; they are emptied. Every identity ends up in the table of the shard
+ * the router now sends it to. The servers must be stopped while this runs.
+ *
+ * A shard with a chainStoreDir would replay its log onto the table at startup and
+ * bring back the chains moved away, so --stores gives the store of every table,
+ * shards then retired ones, with - for a table without one. Each store's log is
+ * first replayed and checkpointed into its table, which leaves nothing to replay
+ * afterwards. A table that was checkpointed by a store not given is refused.
+ */
+int main(int argc, char *argv[])
+{
+    const char* USAGE = "Usage: lamport-rehome <shards> <tables> [retired-tables] [--stores <dirs>]";
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    std::vector<std::string> stores;
+    auto option = std::find(arguments.begin(), arguments.end(), "--stores");
+    if (option != arguments.end()) {
+        if (option + 1 == arguments.end()) {
+            std::cerr << USAGE << std::endl;
+            return -1;
+        }
+        stores = splitList(*(option + 1));
+        arguments.erase(option, option + 2);
+    }
+    if (arguments.size() < 2 || arguments.size() > 3) {
+        std::cerr << USAGE << std::endl;
+        return -1;
+    }
+    std::vector<std::string> shards = splitList(arguments[0]);
+    std::vector<std::string> paths = splitList(arguments[1]);
+    std::vector<std::string> retired = arguments.size() > 2 ? splitList(arguments[2]) : std::vector<std::string>();
+    if (shards.empty() || shards.size() != paths.size()) {
+        std::cerr << "lamport-rehome: give one table per shard" << std::endl;
+        return -1;
+    }
+    if (!stores.empty() && stores.size() != paths.size() + retired.size()) {
+        std::cerr << "lamport-rehome: give one store per table, - for none" << std::endl;
+        return -1;
+    }
+
+    HashRing ring;
+    for (const std::string& shard : shards) {
+        if (!ring.addShard(shard)) {
+            std::cerr << "lamport-rehome: shard " << shard << " is listed twice" << std::endl;
+            return -1;
+        }
+    }
+    paths.insert(paths.end(), retired.begin(), retired.end());
+    std::vector<std::string> sorted = paths;
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+        std::cerr << "lamport-rehome: a table is listed twice" << std::endl;
+        return -1;
+    }
+
+    // Folding a store's log into its table checkpoints it at a fresh, empty segment
+    for (std::size_t i = 0; i < stores.size(); ++i) {
+        if (stores[i] == NO_STORE) continue;
+        ChainRegistry registry;
+        if (!registry.map(paths[i], NEW_TABLE_CAPACITY)
+            || !registry.persist(stores[i], std::numeric_limits<std::uint64_t>::max())) {
+            return 1;
+        }
+    }
+
+    std::vector<std::unique_ptr<VerifierTable>> tables;
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        tables.emplace_back(new VerifierTable());
+        if (!tables.back()->open(paths[i], NEW_TABLE_CAPACITY)) return 1;
+        if (tables.back()->logSegment() != 0 && (stores.empty() || stores[i] == NO_STORE)) {
+            std::cerr << "lamport-rehome: " << paths[i] << " belongs to a chain store; give its chainStoreDir with --stores"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Counts> counts(tables.size());
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < tables.size(); ++i) {
+        counts[i].before = tables[i]->size();
+        total += counts[i].before;
+    }
+
+    std::uint64_t conflicts = 0;
+    for (std::size_t source = 0; source < tables.size(); ++source) {
+        VerifierTable& from = *tables[source];
+        for (std::uint32_t number = 0; number < from.end(); ++number) {
+            if (!(from.record(number).flags & VerifierTable::LIVE)) continue;
+            // A copy: inserting into another table may remap it, and the record is removed below
+            VerifierTable::Record moving = from.record(number);
+            std::size_t owner = ring.shardFor(moving.anchor);
+            if (owner == source) continue;
+
+            VerifierTable& to = *tables[owner];
+            std::uint32_t target = to.find(moving.anchor);
+            if (target != VerifierTable::NONE) {
+                // Left behind by an interrupted run: the furthest chain wins, since the older
+                // link would accept passwords that were already used
+                ++conflicts;
+                if (to.record(target).counter >= moving.counter) {
+                    from.remove(number);
+                    ++counts[source].movedOut;
+                    continue;
+                }
+            } else {
+                target = to.insert(moving.anchor);
+                if (target == VerifierTable::NONE) {
+                    std::cerr << "lamport-rehome: cannot grow " << paths[owner] << "; stopped." << std::endl;
+                    return 1;
+                }
+                ++counts[owner].movedIn;
+            }
+            VerifierTable::Record& stored = to.record(target);
+            stored.link = moving.link;
+            stored.counter = moving.counter;
+            stored.format = moving.format;
+            stored.algorithm = moving.algorithm;
+            stored.flags = moving.flags;
+            from.remove(number);
+            ++counts[source].movedOut;
+        }
+    }
+
+    std::vector<double> shares = ring.shares();
+    std::uint64_t moved = 0;
+    for (std::size_t i = 0; i < tables.size(); ++i) {
+        std::cout << paths[i];
+        if (i < shards.size()) {
+            std::cout << " (" << shards[i] << ", " << static_cast<int>(shares[i] * 1000 + 0.5) / 10.0 << "% of the ring)";
+        } else {
+            std::cout << " (retired)";
+        }
+        std::cout << ": " << counts[i].before << " -> " << tables[i]->size() << " identities, moved out "
+                  << counts[i].movedOut << ", moved in " << counts[i].movedIn << std::endl;
+        moved += counts[i].movedOut;
+    }
+    std::cout << "Re-homed " << moved << " of " << total << " identities";
+    if (conflicts) std::cout << " (" << conflicts << " already present; the furthest chain was kept)";
+    std::cout << "." << std::endl;
+
+    for (auto& table : tables) table->close();
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "LiveConfig.hpp"
+#include "Router.hpp"
+
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <pthread.h>
+
+// Identity-aware front for sharded servers: clients connect here, and each is relayed to
+// the shard that holds its chain. Usage: lamport-router <config.json> [-v]
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: lamport-router <config.json> [-v]" << std::endl;
+        return -1;
+    }
+    bool verbose = argc > 2 && std::strcmp(argv[2], "-v") == 0;
+
+    LiveConfig liveConfig;
+    if (!liveConfig.load(argv[1])) return 1;
+    std::shared_ptr<const ConfigSnapshot> config = liveConfig.snapshot();
+
+    // The router only sees connections, so of the admission limits only the per-source rate applies
+    AdmissionSettings admission;
+    admission.sourceRate = config->sourceRate;
+    admission.sourceBurst = config->sourceBurst;
+    Router router(verbose, config->routerFirstFrameTimeout, admission);
+    std::stringstream shards(config->shards);
+    std::string shard;
+    while (std::getline(shards, shard, ',')) {
+        if (!shard.empty() && !router.addShard(shard)) return 1;
+    }
+    if (router.load().empty()) {
+        std::cerr << "Router: no shards; list them in the \"shards\" key as \"host:port,host:port\"." << std::endl;
+        return 1;
+    }
+    std::uint16_t port = config->alicePort;
+    if (!router.listen(config->aliceIP, port)) return 1;
+
+    // Signals are handled by the main thread alone: block them before the router inherits the mask
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    liveConfig.watch();
+
+    std::thread worker([&router]() { router.run(); });
+    std::cout << "Router: routing port " << port << " to " << router.load().size() << " shard(s)" << std::endl;
+    router.report(std::cout);
+
+    // Between signals, the load is reported every routerReportInterval seconds (0: only on exit);
+    // a reloaded interval applies from the next report on
+    for (;;) {
+        int signal;
+        int interval = liveConfig.snapshot()->routerReportInterval;
+        if (interval > 0) {
+            timespec timeout = {interval, 0};
+            signal = sigtimedwait(&signals, nullptr, &timeout);
+        } else {
+            sigwait(&signals, &signal);
+        }
+        if (signal > 0) break;
+        router.report(std::cout);
+    }
+    std::cout << "Router: Shutting down." << std::endl;
+    router.stop();
+    worker.join();
+    router.report(std::cout);
+    return 0;
+}
@@ -1,18 +1,91 @@
 #include <QCoreApplication>
+#include <QThread>
+#include "ConfigManager.hpp"
+#include "LiveConfig.hpp"
+#include "ReplicaFence.hpp"
+#include "ReplicationReceiver.hpp"
 #include "Server.hpp"
+#include "ServerPool.hpp"
+#include "Sha256.hpp"
+#include <cstring>
 #include <iostream>
 
 int main(int argc, char *argv[]) {
     QCoreApplication app(argc, argv);
 
     if (argc < 2) {
-        std::cerr << "Usage: lamport-server <config.json>" << std::endl;
+        std::cerr << "Usage: lamport-server <config.json> [--standby]" << std::endl;
         return -1;
     }
 
     QString configPath = argv[1];
+    std::cout << "Server: SHA-256 backend: " << Sha256::backend()
+              << " (multi-buffer: " << Sha256::multiBufferBackend() << ")" << std::endl;
 
-    Server server(configPath);
+    // serverThreads > 1 runs one event loop per thread sharing the port; 0 means one per core
+    ConfigManager config(configPath);
+    // The event loops follow edits to the file: challenge rate, pipeline and timeouts apply live
+    LiveConfig liveConfig;
+    if (!liveConfig.load(configPath.toStdString())) return 1;
+    int threads = config.getServerThreads();
+    if (threads <= 0) threads = QThread::idealThreadCount();
+
+    // A standby mirrors the primary's chains until the primary is gone, then takes over its port;
+    // either way the active server holds the fence and streams its changes to whichever standby
+    // listens on replicaSocket. An active server takes the fence before it opens its table and store,
+    // and the pool's SO_REUSEPORT listeners only open once the fence is held.
+    QString replicaSocket = config.getReplicaSocket();
+    ReplicaFence fence;
+    bool standby = argc > 2 && std::strcmp(argv[2], "--standby") == 0;
+    if (standby && replicaSocket.isEmpty()) {
+        std::cerr << "Server: --standby needs replicaSocket in the configuration." << std::endl;
+        return 1;
+    }
+    if (!standby && !replicaSocket.isEmpty() && !fence.acquire(replicaSocket.toStdString())) {
+        std::cerr << "Server: another server is active for " << replicaSocket.toStdString()
+                  << "; start this one with --standby." << std::endl;
+        return 1;
+    }
+
+    // With verifierTable set, chain records live in a mapped file; with chainStoreDir set,
+    // the log written since the table's last checkpoint is replayed and every change is logged there.
+    // Both are flocked, so a standby given the primary's paths stops here.
+    ChainRegistry chains;
+    QString tablePath = config.getVerifierTable();
+    if (!tablePath.isEmpty()
+        && !chains.map(tablePath.toStdString(), static_cast<std::uint32_t>(config.getVerifierTableCapacity()))) {
+        if (standby) std::cerr << "Server: a standby needs its own verifierTable and chainStoreDir." << std::endl;
+        return 1;
+    }
+    QString storeDirectory = config.getChainStoreDir();
+    if (!storeDirectory.isEmpty()
+        && !chains.persist(storeDirectory.toStdString(), static_cast<std::uint64_t>(config.getSnapshotEvery()))) {
+        if (standby) std::cerr << "Server: a standby needs its own verifierTable and chainStoreDir." << std::endl;
+        return 1;
+    }
+
+    if (standby) {
+        ReplicationReceiver receiver;
+        if (!receiver.listen(replicaSocket.toStdString())) return 1;
+        std::cout << "Server: standing by for the primary on " << replicaSocket.toStdString() << std::endl;
+        if (!receiver.follow(chains, config.getStandbyTimeout(), fence)) return 1;
+        receiver.close();
+        std::cout << "Server: primary lost; taking over with " << chains.size() << " chain(s)." << std::endl;
+    }
+    if (!replicaSocket.isEmpty()) chains.replicate(replicaSocket.toStdString());
+
+    liveConfig.watch();
+
+    if (threads > 1) {
+        ServerPool pool(configPath, threads, config.getPinThreads(), chains, &liveConfig);
+        std::cout << "Server: " << pool.threadCount() << " event loops on port " << config.getAlicePort()
+                  << (config.getPinThreads() ? " (pinned)" : "") << std::endl;
+        return app.exec();
+    }
+
+    Server server(configPath, nullptr, false, &chains, nullptr, &liveConfig);
+    // Without a UI to press Start, every client is challenged as soon as it has enrolled
+    server.startAuthentication();
 
     return app.exec();
 }
\ No newline at end of file
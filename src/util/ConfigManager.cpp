@@ -1,5 +1,5 @@
 #include "ConfigManager.hpp"
-#include <iostream>
+#include "JsonConfig.hpp"
 
 /**
  * @brief Constructs a ConfigManager and loads configuration from a file.
@@ -10,64 +10,137 @@ ConfigManager::ConfigManager(const QString& filePath) {
 }
 
 /**
- * @brief Loads and parses a JSON configuration file.
+ * @brief Loads, parses and validates a JSON configuration file.
  * @param filePath Path to the JSON file.
  */
 void ConfigManager::loadConfig(const QString& filePath) {
-    QFile configFile(filePath);
-    if (!configFile.open(QIODevice::ReadOnly)) {
-        // Log error if file cannot be opened
-        std::cerr << "ConfigManager: JSON file could not be opened: " << filePath.toStdString() << std::endl;
-        return;
-    }
-
-    // Read all data from the file
-    QByteArray data = configFile.readAll();
-    configFile.close();
-
-    // Parse the JSON data
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
-
-    // Check for parsing errors
-    if (parseError.error != QJsonParseError::NoError) {
-        std::cerr << "ConfigManager: Parse error at " << parseError.offset << ": "
-                   << parseError.errorString().toStdString() << std::endl;
-        return;
-    }
-
-    // Ensure the root of the JSON is an object
-    if (!doc.isObject()) {
-        std::cerr << "ConfigManager: Config file does not contain a valid JSON object" << std::endl;
-        return;
-    }
-
-    // Store the main JSON object
-    configObj = doc.object();
+    // Errors are printed by JsonConfig; the defaults stay in place
+    JsonConfig json;
+    if (json.load(filePath.toStdString())) config = ConfigSnapshot::from(json);
+}
+
+/**
+ * @brief Gets the parsed configuration.
+ * @return The snapshot.
+ */
+const ConfigSnapshot& ConfigManager::snapshot() const {
+    return config;
 }
 
 // --- Getters for Configuration Values ---
 
 QString ConfigManager::getAliceIP() const {
-    return configObj.value("aliceIP").toString();
+    return QString::fromStdString(config.aliceIP);
 }
 
 QString ConfigManager::getBobIP() const {
-    return configObj.value("bobIP").toString();
+    return QString::fromStdString(config.bobIP);
 }
 
 quint16 ConfigManager::getAlicePort() const {
-    return static_cast<quint16>(configObj.value("alicePort").toInt());
+    return config.alicePort;
 }
 
 quint16 ConfigManager::getBobPort() const {
-    return static_cast<quint16>(configObj.value("bobPort").toInt());
+    return config.bobPort;
 }
 
 int ConfigManager::getSleepTime() const {
-    return configObj.value("sleepDuration").toInt();
+    return config.sleepDuration;
 }
 
 int ConfigManager::getNumberOfIterations() const {
-    return configObj.value("numberOfIterations").toInt();
+    return config.numberOfIterations;
+}
+
+int ConfigManager::getChainFormat() const {
+    return config.chainFormat;
+}
+
+QString ConfigManager::getChainStorage() const {
+    return QString::fromStdString(config.chainStorage);
+}
+
+QString ConfigManager::getHashAlgorithm() const {
+    return QString::fromStdString(config.hashAlgorithm);
+}
+
+QString ConfigManager::getChainFile() const {
+    return QString::fromStdString(config.chainFile);
+}
+
+int ConfigManager::getSkipWindow() const {
+    return config.skipWindow;
+}
+
+int ConfigManager::getServerThreads() const {
+    return config.serverThreads;
+}
+
+bool ConfigManager::getPinThreads() const {
+    return config.pinThreads;
+}
+
+int ConfigManager::getPipelineDepth() const {
+    return config.pipelineDepth;
+}
+
+QString ConfigManager::getClientStateFile() const {
+    return QString::fromStdString(config.clientStateFile);
+}
+
+int ConfigManager::getReconnectDelay() const {
+    return config.reconnectDelay;
+}
+
+int ConfigManager::getResponseTimeout() const {
+    return config.responseTimeout;
+}
+
+int ConfigManager::getIdleTimeout() const {
+    return config.idleTimeout;
+}
+
+int ConfigManager::getSourceRate() const {
+    return config.sourceRate;
+}
+
+int ConfigManager::getSourceBurst() const {
+    return config.sourceBurst;
+}
+
+int ConfigManager::getIdentityRate() const {
+    return config.identityRate;
+}
+
+int ConfigManager::getIdentityBurst() const {
+    return config.identityBurst;
+}
+
+int ConfigManager::getVerifyBudget() const {
+    return config.verifyBudget;
+}
+
+QString ConfigManager::getChainStoreDir() const {
+    return QString::fromStdString(config.chainStoreDir);
+}
+
+int ConfigManager::getSnapshotEvery() const {
+    return config.snapshotEvery;
+}
+
+QString ConfigManager::getVerifierTable() const {
+    return QString::fromStdString(config.verifierTable);
+}
+
+int ConfigManager::getVerifierTableCapacity() const {
+    return config.verifierTableCapacity;
+}
+
+QString ConfigManager::getReplicaSocket() const {
+    return QString::fromStdString(config.replicaSocket);
+}
+
+int ConfigManager::getStandbyTimeout() const {
+    return config.standbyTimeout;
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "ConfigSnapshot.hpp"
+#include "JsonConfig.hpp"
+
+#include <algorithm>
+
+/**
+ * @brief Reads every key, applying its default and range.
+ * @param config The parsed file.
+ * @return The snapshot.
+ */
+ConfigSnapshot ConfigSnapshot::from(const JsonConfig& config)
+{
+    ConfigSnapshot s;
+    s.aliceIP = config.getString("aliceIP");
+    s.alicePort = static_cast<std::uint16_t>(config.getInt("alicePort"));
+    s.bobIP = config.getString("bobIP");
+    s.bobPort = static_cast<std::uint16_t>(config.getInt("bobPort"));
+    s.sleepDuration = std::max(0, config.getInt("sleepDuration"));
+    s.numberOfIterations = config.getInt("numberOfIterations");
+    // Chains default to the legacy hex-linked format so existing deployments keep working
+    s.chainFormat = config.getInt("chainFormat", s.chainFormat);
+    s.chainStorage = config.getString("chainStorage", s.chainStorage);
+    s.hashAlgorithm = config.getString("hashAlgorithm", s.hashAlgorithm);
+    s.chainFile = config.getString("chainFile");
+    s.skipWindow = std::max(1, config.getInt("skipWindow", 1));
+    s.serverThreads = config.getInt("serverThreads", 1);
+    s.pinThreads = config.getBool("pinThreads");
+    s.pipelineDepth = std::max(1, config.getInt("pipelineDepth", 1));
+    s.clientStateFile = config.getString("clientStateFile");
+    s.reconnectDelay = std::max(0, config.getInt("reconnectDelay"));
+    s.responseTimeout = std::max(0, config.getInt("responseTimeout"));
+    s.idleTimeout = std::max(0, config.getInt("idleTimeout"));
+    s.sourceRate = std::max(0, config.getInt("sourceRate"));
+    s.sourceBurst = std::max(0, config.getInt("sourceBurst"));
+    s.identityRate = std::max(0, config.getInt("identityRate"));
+    s.identityBurst = std::max(0, config.getInt("identityBurst"));
+    s.verifyBudget = std::max(0, config.getInt("verifyBudget"));
+    s.chainStoreDir = config.getString("chainStoreDir");
+    s.snapshotEvery = std::max(1, config.getInt("snapshotEvery", s.snapshotEvery));
+    s.verifierTable = config.getString("verifierTable");
+    s.verifierTableCapacity = std::max(1, config.getInt("verifierTableCapacity", s.verifierTableCapacity));
+    s.replicaSocket = config.getString("replicaSocket");
+    s.standbyTimeout = std::max(2, config.getInt("standbyTimeout", s.standbyTimeout));
+    s.shards = config.getString("shards");
+    s.routerReportInterval = std::max(0, config.getInt("routerReportInterval", s.routerReportInterval));
+    s.routerFirstFrameTimeout = std::max(0, config.getInt("routerFirstFrameTimeout", s.routerFirstFrameTimeout));
+    return s;
+}
+
+/**
+ * @brief Copies the server's protocol and admission values.
+ * @return The settings.
+ */
+ServerSettings ConfigSnapshot::serverSettings() const
+{
+    ServerSettings settings;
+    settings.sleepDuration = sleepDuration;
+    settings.numberOfIterations = numberOfIterations;
+    settings.skipWindow = skipWindow;
+    settings.pipelineDepth = pipelineDepth;
+    settings.responseTimeout = responseTimeout;
+    settings.idleTimeout = idleTimeout;
+    settings.admission.sourceRate = sourceRate;
+    settings.admission.sourceBurst = sourceBurst;
+    settings.admission.identityRate = identityRate;
+    settings.admission.identityBurst = identityBurst;
+    settings.admission.verifyBudget = verifyBudget;
+    return settings;
+}
@@ -0,0 +1,197 @@
+#include "JsonConfig.hpp"
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+    /**
+     * @brief A cursor over JSON text.
+     */
+    struct Cursor {
+        const std::string& text;
+        std::size_t pos = 0;
+
+        void skipSpace()
+        {
+            while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) ++pos;
+        }
+
+        bool consume(char c)
+        {
+            skipSpace();
+            if (pos >= text.size() || text[pos] != c) return false;
+            ++pos;
+            return true;
+        }
+
+        bool consumeWord(const char* word)
+        {
+            std::size_t len = std::char_traits<char>::length(word);
+            if (text.compare(pos, len, word) != 0) return false;
+            pos += len;
+            return true;
+        }
+
+        /**
+         * @brief Reads a string literal; \uXXXX escapes outside ASCII are not needed by config.json and are rejected.
+         */
+        bool readString(std::string& out)
+        {
+            if (!consume('"')) return false;
+            out.clear();
+            while (pos < text.size()) {
+                char c = text[pos++];
+                if (c == '"') return true;
+                if (c != '\\') {
+                    out += c;
+                    continue;
+                }
+                if (pos >= text.size()) return false;
+                char e = text[pos++];
+                switch (e) {
+                    case '"': case '\\': case '/': out += e; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        if (pos + 4 > text.size()) return false;
+                        long code = std::strtol(text.substr(pos, 4).c_str(), nullptr, 16);
+                        if (code <= 0 || code > 0x7f) return false;
+                        out += static_cast<char>(code);
+                        pos += 4;
+                        break;
+                    }
+                    default: return false;
+                }
+            }
+            return false;
+        }
+
+        bool readNumber(std::string& out)
+        {
+            std::size_t start = pos;
+            while (pos < text.size() && (std::isdigit(static_cast<unsigned char>(text[pos]))
+                                         || text[pos] == '-' || text[pos] == '+' || text[pos] == '.'
+                                         || text[pos] == 'e' || text[pos] == 'E')) ++pos;
+            out = text.substr(start, pos - start);
+            char* end = nullptr;
+            std::strtod(out.c_str(), &end);
+            return !out.empty() && end == out.c_str() + out.size();
+        }
+    };
+}
+
+/**
+ * @brief Loads and parses a JSON configuration file.
+ * @param filePath Path to the JSON file.
+ * @return True on success.
+ */
+bool JsonConfig::load(const std::string& filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file) {
+        std::cerr << "JsonConfig: JSON file could not be opened: " << filePath << std::endl;
+        return false;
+    }
+    std::ostringstream data;
+    data << file.rdbuf();
+
+    std::map<std::string, Value> parsed;
+    std::string error;
+    if (!parse(data.str(), parsed, error)) {
+        std::cerr << "JsonConfig: Parse error in " << filePath << ": " << error << std::endl;
+        return false;
+    }
+    values.swap(parsed);
+    return true;
+}
+
+/**
+ * @brief Parses a flat JSON object.
+ * @param text The JSON text.
+ * @param values Receives the values.
+ * @param error Receives the error description.
+ * @return True on success.
+ */
+bool JsonConfig::parse(const std::string& text, std::map<std::string, Value>& values, std::string& error)
+{
+    Cursor cursor{text};
+    auto fail = [&](const char* what) {
+        error = std::string(what) + " at offset " + std::to_string(cursor.pos);
+        return false;
+    };
+
+    if (!cursor.consume('{')) return fail("expected '{'");
+    if (cursor.consume('}')) return true;
+    do {
+        std::string key;
+        if (!cursor.readString(key)) return fail("expected a key");
+        if (!cursor.consume(':')) return fail("expected ':'");
+        cursor.skipSpace();
+
+        Value value;
+        if (cursor.pos < text.size() && text[cursor.pos] == '"') {
+            value.type = Value::String;
+            if (!cursor.readString(value.text)) return fail("bad string");
+        } else if (cursor.consumeWord("true")) {
+            value = {Value::Bool, "true"};
+        } else if (cursor.consumeWord("false")) {
+            value = {Value::Bool, "false"};
+        } else if (cursor.consumeWord("null")) {
+            value = {Value::Null, "null"};
+        } else {
+            value.type = Value::Number;
+            if (!cursor.readNumber(value.text)) return fail("unsupported value");
+        }
+        values[key] = value;
+    } while (cursor.consume(','));
+
+    if (!cursor.consume('}')) return fail("expected '}'");
+    cursor.skipSpace();
+    if (cursor.pos != text.size()) return fail("trailing characters");
+    return true;
+}
+
+/**
+ * @brief Gets a string value.
+ * @param key The key.
+ * @param fallback The default.
+ * @return The value.
+ */
+std::string JsonConfig::getString(const std::string& key, const std::string& fallback) const
+{
+    auto it = values.find(key);
+    return (it != values.end() && it->second.type == Value::String) ? it->second.text : fallback;
+}
+
+/**
+ * @brief Gets an integer value.
+ * @param key The key.
+ * @param fallback The default.
+ * @return The value.
+ */
+int JsonConfig::getInt(const std::string& key, int fallback) const
+{
+    auto it = values.find(key);
+    if (it == values.end() || it->second.type != Value::Number) return fallback;
+    return static_cast<int>(std::strtod(it->second.text.c_str(), nullptr));
+}
+
+/**
+ * @brief Gets a boolean value.
+ * @param key The key.
+ * @param fallback The default.
+ * @return The value.
+ */
+bool JsonConfig::getBool(const std::string& key, bool fallback) const
+{
+    auto it = values.find(key);
+    if (it == values.end() || it->second.type != Value::Bool) return fallback;
+    return it->second.text == "true";
+}
\ No newline at end of file
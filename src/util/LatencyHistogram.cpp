@@ -0,0 +1,111 @@
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Allocates every bucket up front.
+ */
+LatencyHistogram::LatencyHistogram()
+    : counts(indexOf(MAX_VALUE) + 1, 0)
+{
+}
+
+/**
+ * @brief Counts a value in its bucket.
+ * @param micros The latency in microseconds; clamped to MAX_VALUE.
+ */
+void LatencyHistogram::record(std::uint64_t micros)
+{
+    micros = std::min(micros, MAX_VALUE);
+    ++counts[indexOf(micros)];
+    ++total;
+    sum += static_cast<double>(micros);
+}
+
+/**
+ * @brief Adds another histogram's counts to this one.
+ * @param other The histogram to add.
+ */
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for (std::size_t i = 0; i < counts.size(); ++i) counts[i] += other.counts[i];
+    total += other.total;
+    sum += other.sum;
+}
+
+/**
+ * @brief Clears every bucket.
+ */
+void LatencyHistogram::reset()
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    sum = 0;
+}
+
+/**
+ * @brief Walks the buckets until the requested share of the values is covered.
+ * @param percent The percentile.
+ * @return The value.
+ */
+std::uint64_t LatencyHistogram::percentile(double percent) const
+{
+    if (total == 0) return 0;
+    percent = std::min(100.0, std::max(0.0, percent));
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(percent / 100.0 * static_cast<double>(total)));
+    rank = std::max<std::uint64_t>(rank, 1);
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) return highestValueAt(i);
+    }
+    return highestValueAt(counts.size() - 1);
+}
+
+/**
+ * @brief Finds the highest non-empty bucket.
+ * @return The value.
+ */
+std::uint64_t LatencyHistogram::max() const
+{
+    for (std::size_t i = counts.size(); i-- > 0; ) {
+        if (counts[i] > 0) return highestValueAt(i);
+    }
+    return 0;
+}
+
+/**
+ * @brief Divides the sum by the count.
+ * @return The mean.
+ */
+double LatencyHistogram::mean() const
+{
+    return total > 0 ? sum / static_cast<double>(total) : 0;
+}
+
+/**
+ * @brief Maps a value to its bucket: exact below SUB_BUCKETS, then HALF buckets per power of two.
+ * @param value The value.
+ * @return The index.
+ */
+std::size_t LatencyHistogram::indexOf(std::uint64_t value)
+{
+    if (value < SUB_BUCKETS) return static_cast<std::size_t>(value);
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - (SUB_BUCKET_BITS - 1);
+    return static_cast<std::size_t>(HALF * static_cast<std::uint64_t>(shift) + (value >> shift));
+}
+
+/**
+ * @brief Maps a bucket back to the top of the value range it covers.
+ * @param index The index.
+ * @return The value.
+ */
+std::uint64_t LatencyHistogram::highestValueAt(std::size_t index)
+{
+    if (index < SUB_BUCKETS) return index;
+    int shift = static_cast<int>(index / HALF) - 1;
+    std::uint64_t sub = index - HALF * static_cast<std::uint64_t>(shift);
+    return ((sub + 1) << shift) - 1;
+}
@@ -0,0 +1,204 @@
+#include "LiveConfig.hpp"
+#include "JsonConfig.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/**
+ * @brief Publishes a snapshot of defaults.
+ */
+LiveConfig::LiveConfig()
+    : current(std::make_shared<const ConfigSnapshot>())
+{
+}
+
+/**
+ * @brief Stops the watching thread.
+ */
+LiveConfig::~LiveConfig()
+{
+    stop();
+}
+
+/**
+ * @brief Publishes a file and remembers it for watch().
+ * @param filePath The path to the JSON file.
+ * @return True on success.
+ */
+bool LiveConfig::load(const std::string& filePath)
+{
+    if (!publish(filePath)) return false;
+    path = filePath;
+    return true;
+}
+
+/**
+ * @brief Parses a file and, if it is valid, publishes it.
+ * @param filePath The path to the JSON file.
+ * @return True on success.
+ */
+bool LiveConfig::publish(const std::string& filePath)
+{
+    JsonConfig config;
+    if (!config.load(filePath)) return false;
+
+    std::shared_ptr<const ConfigSnapshot> next = std::make_shared<const ConfigSnapshot>(ConfigSnapshot::from(config));
+    std::shared_ptr<const ConfigSnapshot> previous = std::atomic_exchange(&current, next);
+    // Readers polling version() find the new snapshot in place once they see the increment
+    std::uint64_t version = published.fetch_add(1, std::memory_order_release) + 1;
+    if (version > 1) {
+        std::cout << "Config: reloaded " << filePath << "." << std::endl;
+        reportChanges(*previous, *next);
+    }
+    return true;
+}
+
+/**
+ * @brief Gets the current snapshot.
+ * @return The snapshot.
+ */
+std::shared_ptr<const ConfigSnapshot> LiveConfig::snapshot() const
+{
+    return std::atomic_load(&current);
+}
+
+/**
+ * @brief Gets the number of publications.
+ * @return The version.
+ */
+std::uint64_t LiveConfig::version() const
+{
+    return published.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Watches the directory of the loaded file and starts the watching thread.
+ * @return True if watching.
+ */
+bool LiveConfig::watch()
+{
+    if (path.empty() || watcher.joinable()) return false;
+
+    std::size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify < 0 || ::inotify_add_watch(inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cerr << "Config: cannot watch " << path << ": " << std::strerror(errno) << std::endl;
+        if (inotify >= 0) ::close(inotify);
+        return false;
+    }
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    watcher = std::thread([this, inotify]() { run(inotify, wakeFd); });
+    return true;
+}
+
+/**
+ * @brief Wakes and joins the watching thread.
+ */
+void LiveConfig::stop()
+{
+    if (!watcher.joinable()) return;
+    std::uint64_t one = 1;
+    ssize_t written = ::write(wakeFd, &one, sizeof(one));
+    (void)written;
+    watcher.join();
+    ::close(wakeFd);
+    wakeFd = -1;
+}
+
+/**
+ * @brief Reloads the file after every write or rename that lands on its name, until stop() is called.
+ * @param inotify The inotify descriptor; closed on return.
+ * @param wake The eventfd.
+ */
+void LiveConfig::run(int inotify, int wake)
+{
+    std::size_t slash = path.rfind('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    alignas(inotify_event) char buffer[4096];
+
+    for (;;) {
+        pollfd fds[2] = {{inotify, POLLIN, 0}, {wake, POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+
+        bool changed = false;
+        ssize_t size;
+        while ((size = ::read(inotify, buffer, sizeof(buffer))) > 0) {
+            for (ssize_t offset = 0; offset < size; ) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                if (event->len > 0 && name == event->name) changed = true;
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+        }
+        // Several events for one save (an editor's write and rename) make one reload
+        if (changed) publish(path);
+    }
+    ::close(inotify);
+}
+
+/**
+ * @brief Prints each changed key, noting the ones read only at startup.
+ * @param before The previous snapshot.
+ * @param after The new snapshot.
+ */
+void LiveConfig::reportChanges(const ConfigSnapshot& before, const ConfigSnapshot& after)
+{
+    std::vector<std::string> live;
+    std::vector<std::string> onRestart;
+    auto compare = [&](const char* key, bool changed, bool appliedLive) {
+        if (changed) (appliedLive ? live : onRestart).push_back(key);
+    };
+    // Only the challenge schedule, the timeouts and the router's report interval are read after startup
+    compare("sleepDuration", before.sleepDuration != after.sleepDuration, true);
+    compare("skipWindow", before.skipWindow != after.skipWindow, true);
+    compare("pipelineDepth", before.pipelineDepth != after.pipelineDepth, true);
+    compare("responseTimeout", before.responseTimeout != after.responseTimeout, true);
+    compare("idleTimeout", before.idleTimeout != after.idleTimeout, true);
+    compare("routerReportInterval", before.routerReportInterval != after.routerReportInterval, true);
+    compare("aliceIP", before.aliceIP != after.aliceIP, false);
+    compare("alicePort", before.alicePort != after.alicePort, false);
+    compare("bobIP", before.bobIP != after.bobIP, false);
+    compare("bobPort", before.bobPort != after.bobPort, false);
+    compare("numberOfIterations", before.numberOfIterations != after.numberOfIterations, false);
+    compare("chainFormat", before.chainFormat != after.chainFormat, false);
+    compare("chainStorage", before.chainStorage != after.chainStorage, false);
+    compare("hashAlgorithm", before.hashAlgorithm != after.hashAlgorithm, false);
+    compare("chainFile", before.chainFile != after.chainFile, false);
+    compare("serverThreads", before.serverThreads != after.serverThreads, false);
+    compare("pinThreads", before.pinThreads != after.pinThreads, false);
+    compare("clientStateFile", before.clientStateFile != after.clientStateFile, false);
+    compare("reconnectDelay", before.reconnectDelay != after.reconnectDelay, false);
+    compare("sourceRate", before.sourceRate != after.sourceRate, false);
+    compare("sourceBurst", before.sourceBurst != after.sourceBurst, false);
+    compare("identityRate", before.identityRate != after.identityRate, false);
+    compare("identityBurst", before.identityBurst != after.identityBurst, false);
+    compare("verifyBudget", before.verifyBudget != after.verifyBudget, false);
+    compare("chainStoreDir", before.chainStoreDir != after.chainStoreDir, false);
+    compare("snapshotEvery", before.snapshotEvery != after.snapshotEvery, false);
+    compare("verifierTable", before.verifierTable != after.verifierTable, false);
+    compare("verifierTableCapacity", before.verifierTableCapacity != after.verifierTableCapacity, false);
+    compare("replicaSocket", before.replicaSocket != after.replicaSocket, false);
+    compare("standbyTimeout", before.standbyTimeout != after.standbyTimeout, false);
+    compare("shards", before.shards != after.shards, false);
+    compare("routerFirstFrameTimeout", before.routerFirstFrameTimeout != after.routerFirstFrameTimeout, false);
+
+    auto print = [](std::ostream& out, const char* what, const std::vector<std::string>& keys) {
+        if (keys.empty()) return;
+        out << "Config: " << what;
+        for (std::size_t i = 0; i < keys.size(); ++i) out << (i ? ", " : " ") << keys[i];
+        out << std::endl;
+    };
+    print(std::cout, "applied", live);
+    print(std::cerr, "changed but only read at startup (restart to apply):", onRestart);
+}
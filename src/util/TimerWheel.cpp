@@ -0,0 +1,173 @@
+#include "TimerWheel.hpp"
+
+#include <algorithm>
+
+namespace {
+    const std::int64_t HORIZON = std::int64_t(1) << 31; ///< The furthest a timer may be scheduled ahead, in ms.
+}
+
+/**
+ * @brief Constructs an empty wheel.
+ * @param now The current time in ms.
+ */
+TimerWheel::TimerWheel(std::int64_t now)
+    : current(now)
+{
+    std::fill(heads, heads + LEVELS * SLOTS, NONE);
+    std::fill(&occupied[0][0], &occupied[0][0] + LEVELS * WORDS, std::uint64_t(0));
+}
+
+/**
+ * @brief Schedules a timer in O(1).
+ * @param due When it fires, in ms.
+ * @param key The caller's key.
+ * @param kind The caller's kind.
+ * @return The timer.
+ */
+TimerWheel::TimerId TimerWheel::schedule(std::int64_t due, std::uint64_t key, std::uint8_t kind)
+{
+    TimerId id;
+    if (freeList != NONE) {
+        id = freeList;
+        freeList = nodes[id].next;
+    } else {
+        id = static_cast<TimerId>(nodes.size());
+        nodes.emplace_back();
+    }
+
+    Node& node = nodes[id];
+    node.due = std::min(due, current + HORIZON);
+    node.key = key;
+    node.kind = kind;
+    node.live = true;
+    place(id);
+    ++count;
+    return id;
+}
+
+/**
+ * @brief Unlinks a timer in O(1) and recycles its node.
+ * @param id The timer.
+ */
+void TimerWheel::cancel(TimerId id)
+{
+    if (id == NONE || id >= nodes.size() || !nodes[id].live) return;
+
+    Node& node = nodes[id];
+    if (node.prev != NONE) nodes[node.prev].next = node.next;
+    else heads[node.slot] = node.next;
+    if (node.next != NONE) nodes[node.next].prev = node.prev;
+    if (heads[node.slot] == NONE) {
+        occupied[node.slot / SLOTS][(node.slot % SLOTS) / 64] &= ~(std::uint64_t(1) << (node.slot % 64));
+    }
+
+    node.live = false;
+    node.prev = NONE;
+    node.next = freeList;
+    freeList = id;
+    --count;
+}
+
+/**
+ * @brief Gets the time until the next tick that needs processing.
+ * @param now The current time in ms.
+ * @return Milliseconds, or -1 if empty.
+ */
+std::int64_t TimerWheel::msUntilNext(std::int64_t now) const
+{
+    std::int64_t tick = nextTick();
+    if (tick < 0) return -1;
+    return std::max<std::int64_t>(0, tick - now);
+}
+
+/**
+ * @brief Links a node into a slot: the lowest level whose span, starting from the
+ * current tick's block, contains the due tick.
+ * @param id The node.
+ */
+void TimerWheel::place(TimerId id)
+{
+    Node& node = nodes[id];
+    std::int64_t tick = std::max(node.due, current);
+    int level = 0;
+    while (level < LEVELS - 1 && (tick >> (SLOT_BITS * (level + 1))) != (current >> (SLOT_BITS * (level + 1)))) {
+        ++level;
+    }
+    std::uint32_t index = static_cast<std::uint32_t>(tick >> (SLOT_BITS * level)) & SLOT_MASK;
+    std::uint16_t slot = static_cast<std::uint16_t>(level * SLOTS + index);
+
+    node.slot = slot;
+    node.prev = NONE;
+    node.next = heads[slot];
+    if (node.next != NONE) nodes[node.next].prev = id;
+    heads[slot] = id;
+    occupied[level][index / 64] |= std::uint64_t(1) << (index % 64);
+}
+
+/**
+ * @brief Re-places the timers of each higher-level slot whose span starts at the current tick,
+ * highest level first, so that they end up in the level matching their remaining time.
+ */
+void TimerWheel::cascade()
+{
+    for (int level = LEVELS - 1; level > 0; --level) {
+        int shift = SLOT_BITS * level;
+        if ((current & ((std::int64_t(1) << shift) - 1)) != 0) continue;
+
+        std::uint32_t index = static_cast<std::uint32_t>(current >> shift) & SLOT_MASK;
+        std::uint16_t slot = static_cast<std::uint16_t>(level * SLOTS + index);
+        TimerId id = heads[slot];
+        heads[slot] = NONE;
+        occupied[level][index / 64] &= ~(std::uint64_t(1) << (index % 64));
+        while (id != NONE) {
+            TimerId next = nodes[id].next;
+            place(id);
+            id = next;
+        }
+    }
+}
+
+/**
+ * @brief Finds the earliest tick with work: the first non-empty slot at or after the
+ * current tick on any level. Occupancy bitmaps make this a few word scans regardless
+ * of the number of timers.
+ * @return The tick, or -1 if empty.
+ */
+std::int64_t TimerWheel::nextTick() const
+{
+    if (count == 0) return -1;
+
+    // Index of the first occupied slot at or after start, or SLOTS
+    auto firstOccupied = [this](int level, std::uint32_t start) -> std::uint32_t {
+        for (std::uint32_t word = start / 64; word < WORDS; ++word) {
+            std::uint64_t bits = occupied[level][word];
+            if (word == start / 64) bits &= ~std::uint64_t(0) << (start % 64);
+            if (bits) return word * 64 + static_cast<std::uint32_t>(__builtin_ctzll(bits));
+        }
+        return SLOTS;
+    };
+
+    // A slot found on a higher level starts after any on a lower one, except for a
+    // higher-level slot starting right at the current tick, so the minimum is taken
+    std::int64_t earliest = -1;
+    for (int level = 0; level < LEVELS; ++level) {
+        int shift = SLOT_BITS * level;
+        std::uint32_t index = static_cast<std::uint32_t>(current >> shift) & SLOT_MASK;
+        // The current slot of level 0 is always still to come; that of a higher level only at the very start of its span
+        bool pending = level == 0 || (current & ((std::int64_t(1) << shift) - 1)) == 0;
+        std::uint32_t start = pending ? index : index + 1;
+        std::int64_t block = current & ~((std::int64_t(1) << (shift + SLOT_BITS)) - 1);
+
+        std::int64_t tick = -1;
+        std::uint32_t found = start < SLOTS ? firstOccupied(level, start) : SLOTS;
+        if (found < SLOTS) {
+            tick = std::max(current, block + (std::int64_t(found) << shift));
+        } else if (level == LEVELS - 1) {
+            // The top level wraps around: slots before the current one belong to the next block
+            found = firstOccupied(level, 0);
+            if (found < SLOTS) tick = block + (std::int64_t(1) << (shift + SLOT_BITS)) + (std::int64_t(found) << shift);
+        }
+        if (tick >= 0 && (earliest < 0 || tick < earliest)) earliest = tick;
+    }
+    return earliest;
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "CountingAllocator.hpp"
+#include "LamportAuth.hpp"
+#include "Protocol.hpp"
+#include "ServerCore.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+    /**
+     * @class QuietTransport
+     * @brief A transport like the headless server's without -v: it counts what is sent and reads no log message.
+     */
+    class QuietTransport : public ServerTransport {
+    public:
+        void send(void*, const std::uint8_t*, std::size_t len) override { bytesSent += len; }
+        void log(const std::string&) override { ++messages; }
+        bool verbose() const override { return false; }
+        void drop(void*) override { ++drops; }
+
+        std::uint64_t bytesSent = 0;  ///< Bytes handed to send().
+        std::uint64_t messages = 0;   ///< Log messages received.
+        std::uint64_t drops = 0;      ///< Connections dropped.
+    };
+
+    /**
+     * @brief Feeds responses to a session and counts the allocations made meanwhile.
+     * @param core The core.
+     * @param session The session.
+     * @param frames The response frames, one per challenge, in order.
+     * @param first The index of the first frame to send.
+     * @param count The number of frames to send.
+     * @param perRead How many frames each receive() call carries.
+     * @return The number of allocations, or UINT64_MAX if a response was refused.
+     */
+    std::uint64_t countAllocations(ServerCore& core, SessionId session, const std::vector<std::uint8_t>& frames,
+                                   std::size_t first, std::size_t count, std::size_t perRead)
+    {
+        std::uint64_t before = allocationCount.load(std::memory_order_relaxed);
+        for (std::size_t sent = 0; sent < count; sent += perRead) {
+            const std::uint8_t* data = frames.data() + (first + sent) * Protocol::RESPONSE_FRAME_SIZE;
+            if (!core.receive(session, data, perRead * Protocol::RESPONSE_FRAME_SIZE)) return UINT64_MAX;
+        }
+        return allocationCount.load(std::memory_order_relaxed) - before;
+    }
+}
+
+/**
+ * @brief Checks that verifying a response makes no heap allocation once a session is running.
+ *
+ * Drives a ServerCore on a quiet transport through receive(), the verification of the
+ * responses and saveProgress() into the chain registry, with responses arriving one per
+ * read and eight per read (batched verification), and a pipeline that is topped up
+ * after every read. Setup and warm-up may allocate; the rounds after them must not.
+ * Exits with 1 if any of them allocated.
+ */
+int main()
+{
+    const int CHAIN_LENGTH = 20000;
+    const std::size_t WARM_UP = 64;
+    const std::size_t ROUNDS = 4096;
+
+    LamportAuth client;
+    client.initChain("allocation-test-seed", CHAIN_LENGTH);
+    std::vector<std::uint8_t> frames((WARM_UP + 2 * ROUNDS) * Protocol::RESPONSE_FRAME_SIZE);
+    for (std::size_t c = 1; c <= WARM_UP + 2 * ROUNDS; ++c) {
+        Protocol::encodeResponse(frames.data() + (c - 1) * Protocol::RESPONSE_FRAME_SIZE, c,
+                                 client.getOTPForChallenge(static_cast<int>(c)));
+    }
+
+    ServerSettings settings;
+    settings.sleepDuration = 0;
+    settings.numberOfIterations = CHAIN_LENGTH;
+    settings.pipelineDepth = 8;
+    QuietTransport transport;
+    ServerCore core(settings, transport);
+
+    int connection = 0;
+    SessionId session = core.openSession(&connection);
+    std::uint8_t enroll[Protocol::ENROLL_FRAME_SIZE];
+    std::size_t size = Protocol::encodeEnroll(enroll, client.getChainParams(), client.getLastHash());
+    if (!core.receive(session, enroll, size)) {
+        std::cerr << "verify_allocation_test: enrollment refused" << std::endl;
+        return 1;
+    }
+    core.startAuthentication();
+    core.processTimers(); // Fills the pipeline with the first challenges
+
+    if (countAllocations(core, session, frames, 0, WARM_UP, 1) == UINT64_MAX) {
+        std::cerr << "verify_allocation_test: a warm-up response was refused" << std::endl;
+        return 1;
+    }
+    std::uint64_t single = countAllocations(core, session, frames, WARM_UP, ROUNDS, 1);
+    std::uint64_t batched = countAllocations(core, session, frames, WARM_UP + ROUNDS, ROUNDS, 8);
+
+    if (single == UINT64_MAX || batched == UINT64_MAX || transport.drops > 0) {
+        std::cerr << "verify_allocation_test: a valid response was refused" << std::endl;
+        return 1;
+    }
+    std::cout << "verify_allocation_test: " << single << " allocation(s) in " << ROUNDS << " single responses, "
+              << batched << " in " << ROUNDS << " responses batched by 8" << std::endl;
+    bool ok = single == 0 && batched == 0;
+    if (!ok) std::cerr << "verify_allocation_test: the verify path allocated" << std::endl;
+    return ok ? 0 : 1;
+}